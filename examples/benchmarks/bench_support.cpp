@@ -0,0 +1,137 @@
+#include "bench_support.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <string>
+#include <sys/resource.h>
+
+namespace {
+
+std::atomic<uint64_t> allocations{0};
+
+constexpr int64_t MIN_ROWS = 1000;
+constexpr int64_t DEFAULT_MAX_ROWS = 1000000;
+constexpr int64_t LIMIT_ROWS = 100000000;
+
+// A "VmRSS:"-style line of /proc/self/status, in bytes; 0 if there is none
+size_t statusBytes(const std::string& key) {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, key.size(), key) == 0) {
+            return std::stoull(line.substr(key.size())) * 1024;
+        }
+    }
+    return 0;
+}
+
+void* allocate(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void* memory = std::malloc(size ? size : 1);
+    if (!memory) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void* allocateAligned(std::size_t size, std::align_val_t alignment) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    size_t align = static_cast<size_t>(alignment);
+    // aligned_alloc wants a multiple of the alignment
+    void* memory = std::aligned_alloc(align, std::max((size + align - 1) / align * align, align));
+    if (!memory) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+}  // namespace
+
+// Every allocation in the process goes through these, so allocs_per_row
+// covers the code under test and the standard library alike
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return allocate(size);
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment); }
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept { std::free(memory); }
+
+uint64_t allocationCount() {
+    return allocations.load(std::memory_order_relaxed);
+}
+
+size_t currentRssBytes() {
+    return statusBytes("VmRSS:");
+}
+
+size_t peakRssBytes() {
+    if (size_t peak = statusBytes("VmHWM:")) {
+        return peak;
+    }
+    struct rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+}
+
+void resetPeakRss() {
+    // "5" resets the peak RSS to the current RSS
+    std::ofstream clear("/proc/self/clear_refs");
+    clear << "5";
+}
+
+std::vector<int64_t> rowCounts() {
+    int64_t max_rows = DEFAULT_MAX_ROWS;
+    if (const char* text = std::getenv("BENCH_MAX_ROWS")) {
+        max_rows = std::clamp<int64_t>(std::atoll(text), MIN_ROWS, LIMIT_ROWS);
+    }
+    std::vector<int64_t> counts;
+    for (int64_t rows = MIN_ROWS; rows <= max_rows; rows *= 10) {
+        counts.push_back(rows);
+    }
+    return counts;
+}
+
+void addRowCounts(benchmark::internal::Benchmark* bench, const std::vector<int64_t>& extra) {
+    for (int64_t rows : rowCounts()) {
+        if (extra.empty()) {
+            bench->Arg(rows);
+        }
+        for (int64_t value : extra) {
+            bench->Args({rows, value});
+        }
+    }
+}
+
+RunStats::RunStats() : start_allocations_(allocationCount()) {
+    resetPeakRss();
+    start_rss_ = currentRssBytes();
+}
+
+void RunStats::finish(benchmark::State& state, size_t rows_per_iteration, size_t bytes_per_iteration) {
+    auto iterations = static_cast<int64_t>(state.iterations());
+    state.SetItemsProcessed(iterations * static_cast<int64_t>(rows_per_iteration));
+    state.SetBytesProcessed(iterations * static_cast<int64_t>(bytes_per_iteration));
+    double rows = static_cast<double>(iterations) * std::max<size_t>(rows_per_iteration, 1);
+    state.counters["allocs_per_row"] = static_cast<double>(allocationCount() - start_allocations_) / rows;
+    size_t peak = peakRssBytes();
+    state.counters["peak_rss_growth_mb"] = (peak > start_rss_ ? peak - start_rss_ : 0) / (1024.0 * 1024.0);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Shared by the benchmark executables: allocation counting, peak RSS and
+// the data sizes every benchmark runs at.
+
+// operator new calls the process has made so far
+uint64_t allocationCount();
+
+// Resident set size and its high-water mark, in bytes. resetPeakRss()
+// lowers the mark to the current RSS where the kernel allows it (Linux
+// /proc/self/clear_refs); otherwise the peak covers the whole process.
+size_t currentRssBytes();
+size_t peakRssBytes();
+void resetPeakRss();
+
+// 1K, 10K, ... rows up to BENCH_MAX_ROWS from the environment (default
+// 1M, at most 100M)
+std::vector<int64_t> rowCounts();
+
+// One run per row count, or per row count and each of extra
+void addRowCounts(benchmark::internal::Benchmark* bench, const std::vector<int64_t>& extra = {});
+
+// Measures the timed loop of one run: construct it just before the loop,
+// after the run's input is set up, and call finish() after it. Reports
+// items_per_second (rows), bytes_per_second, allocs_per_row and
+// peak_rss_growth_mb: how far the resident set rose above what it was at
+// construction, so memory held by inputs and earlier runs is left out.
+class RunStats {
+public:
+    RunStats();
+    void finish(benchmark::State& state, size_t rows_per_iteration, size_t bytes_per_iteration);
+
+private:
+    uint64_t start_allocations_;
+    size_t start_rss_;
+};
+
+// The last value make(rows) returned, made again only when rows changes.
+// Google Benchmark calls a benchmark several times per size while it
+// settles on an iteration count, and inputs of millions of rows take
+// longer to generate than to process. One value is kept per Make type, so
+// every call site holds at most one input.
+template <typename T, typename Make>
+const T& cachedInput(size_t rows, Make make) {
+    static size_t cached_rows = SIZE_MAX;
+    static T value;
+    if (rows != cached_rows) {
+        value = T();            // Free the old input before making the new one
+        value = make(rows);
+        cached_rows = rows;
+    }
+    return value;
+}
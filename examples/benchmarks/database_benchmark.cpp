@@ -0,0 +1,158 @@
+// Database benchmarks: row inserts, WHERE scans at several selectivities,
+// with and without an index, and query parsing.
+
+#include "bench_support.h"
+#include "query_parser.h"
+#include "table.h"
+#include "table_index.h"
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+// Column storage bytes of one row: id, bucket, amount, customer code, active
+constexpr size_t ROW_BYTES = sizeof(int) + sizeof(int) + sizeof(double) + sizeof(uint32_t) + sizeof(uint8_t);
+constexpr size_t CUSTOMERS = 1000;
+
+const std::vector<std::string>& customerNames() {
+    static const std::vector<std::string> names = [] {
+        std::vector<std::string> names;
+        for (size_t i = 0; i < CUSTOMERS; ++i) {
+            names.push_back("customer-" + std::to_string(i));
+        }
+        return names;
+    }();
+    return names;
+}
+
+// bucket is uniform over [0, 1000), so "bucket < n" selects n per mille
+// of the rows
+void addSchema(Table& table) {
+    table.addColumn("id", "int");
+    table.addColumn("bucket", "int");
+    table.addColumn("amount", "double");
+    table.addColumn("customer", "string");
+    table.addColumn("active", "bool");
+}
+
+void fillRow(Row& row, size_t i, std::mt19937_64& rng) {
+    row[0] = static_cast<int>(i);
+    row[1] = static_cast<int>(rng() % 1000);
+    row[2] = static_cast<double>(rng() % 100000) / 100;
+    row[3] = customerNames()[rng() % CUSTOMERS];
+    row[4] = (rng() & 1) != 0;
+}
+
+std::unique_ptr<Table> makeOrders(size_t rows, bool indexed) {
+    auto table = std::make_unique<Table>("orders");
+    addSchema(*table);
+    std::mt19937_64 rng(42);
+    Row row(5);
+    std::vector<std::string> text(5);
+    size_t next = 0;
+    table->loadRows([&](std::vector<std::string_view>& fields) {
+        if (next == rows) {
+            return false;
+        }
+        fillRow(row, next++, rng);
+        for (size_t c = 0; c < row.size(); ++c) {
+            text[c] = table->valueToString(row[c]);
+        }
+        fields.assign(text.begin(), text.end());
+        return true;
+    }, rows);
+    if (indexed) {
+        table->createIndex("idx_bucket", "bucket", IndexType::BTREE);
+    }
+    return table;
+}
+
+// One table is kept at a time, indexed or not
+const Table& orders(size_t rows, bool indexed) {
+    return *cachedInput<std::unique_ptr<Table>>(rows * 2 + indexed, [](size_t key) {
+        return makeOrders(key / 2, key % 2 != 0);
+    });
+}
+
+void BM_TableInsertRow(benchmark::State& state) {
+    size_t rows = state.range(0);
+    std::mt19937_64 rng(42);
+    Row row(5);
+    RunStats stats;
+    for (auto _ : state) {
+        Table table("orders");
+        addSchema(table);
+        for (size_t i = 0; i < rows; ++i) {
+            fillRow(row, i, rng);
+            table.insertRow(row);
+        }
+        benchmark::DoNotOptimize(table.size());
+    }
+    stats.finish(state, rows, rows * ROW_BYTES);
+}
+
+// Predicate compilation, the scan (or index lookup) and collecting row ids
+void selectRows(benchmark::State& state, bool indexed) {
+    size_t rows = state.range(0);
+    const Table& table = orders(rows, indexed);
+    std::string where = "bucket < " + std::to_string(state.range(1));
+    size_t selected = 0;
+    RunStats stats;
+    for (auto _ : state) {
+        std::vector<size_t> result = table.selectRows(where);
+        selected = result.size();
+        benchmark::DoNotOptimize(result.data());
+    }
+    stats.finish(state, rows, rows * sizeof(int));
+    state.counters["selectivity"] = static_cast<double>(selected) / rows;
+}
+
+void BM_TableSelectRows(benchmark::State& state) {
+    selectRows(state, false);
+}
+
+// A B+-tree on bucket; past 1/16 of the table the lookup gives way to a scan
+void BM_TableSelectRowsIndexed(benchmark::State& state) {
+    selectRows(state, true);
+}
+
+void BM_QueryParserParse(benchmark::State& state, const char* query) {
+    QueryParser parser;
+    std::string text = query;
+    RunStats stats;
+    for (auto _ : state) {
+        ParsedQuery parsed = parser.parse(text);
+        benchmark::DoNotOptimize(parsed.type);
+    }
+    stats.finish(state, 1, text.size());
+}
+
+// Selectivities in per mille: 0.1%, 1%, 10%, 50% and every row
+const std::vector<int64_t> SELECTIVITIES = {1, 10, 100, 500, 1000};
+
+}  // namespace
+
+BENCHMARK(BM_TableInsertRow)->Apply([](auto* bench) { addRowCounts(bench); })->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TableSelectRows)
+    ->Apply([](auto* bench) { addRowCounts(bench, SELECTIVITIES); })
+    ->ArgNames({"rows", "permille"})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TableSelectRowsIndexed)
+    ->Apply([](auto* bench) { addRowCounts(bench, SELECTIVITIES); })
+    ->ArgNames({"rows", "permille"})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_CAPTURE(BM_QueryParserParse, create_table,
+                  "CREATE TABLE orders (id int, bucket int, amount double, customer string, active bool)");
+BENCHMARK_CAPTURE(BM_QueryParserParse, insert, "INSERT INTO orders VALUES (1, 42, 19.99, customer-42, true)");
+BENCHMARK_CAPTURE(BM_QueryParserParse, select_where,
+                  "SELECT id, amount FROM orders WHERE bucket < 100 AND active = true OR amount >= 500.0");
+BENCHMARK_CAPTURE(BM_QueryParserParse, select_join_group_by,
+                  "SELECT orders.customer, COUNT(*), SUM(orders.amount) FROM orders "
+                  "JOIN customers ON orders.customer = customers.name WHERE orders.amount > 50 "
+                  "GROUP BY orders.customer");
+
+BENCHMARK_MAIN();
@@ -0,0 +1,248 @@
+// ETL benchmarks: CSV/JSON conversion, the transformation pipeline, and
+// batch and streaming file output, over synthetic order records.
+
+#include "bench_support.h"
+#include "processors/data_transformer.h"
+#include "loaders/file_writer.h"
+#include <nlohmann/json.hpp>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace etl;
+
+namespace {
+
+const char* const REGIONS[] = {"north", "south", "east", "west", "central", "coastal", "mountain", "island"};
+
+// Records cycled through by StreamWriter runs, so a run of any size
+// needs no more input than this
+constexpr size_t RECORD_POOL = 1024;
+
+// An order record. About one in ten orders is a resend of an earlier id,
+// for deduplicate to drop, and one in sixteen has no note.
+nlohmann::json makeRecord(size_t i, std::mt19937_64& rng) {
+    size_t id = rng() % 10 == 0 && i > 0 ? rng() % i : i;
+    nlohmann::json record = {
+        {"id", id},
+        {"customer", "customer-" + std::to_string(rng() % 100000)},
+        {"region", REGIONS[rng() % 8]},
+        {"amount", static_cast<double>(rng() % 50000) / 100},
+        {"quantity", static_cast<int>(rng() % 10 + 1)},
+        {"note", nullptr}
+    };
+    if (rng() % 16 != 0) {
+        record["note"] = "order " + std::to_string(i);
+    }
+    return record;
+}
+
+std::string makeCsv(size_t rows) {
+    std::mt19937_64 rng(42);
+    std::string csv = "id,customer,region,amount,quantity,note\n";
+    for (size_t i = 0; i < rows; ++i) {
+        nlohmann::json record = makeRecord(i, rng);
+        csv += std::to_string(record["id"].get<size_t>()) + "," + record["customer"].get<std::string>() + "," +
+               record["region"].get<std::string>() + "," + record["amount"].dump() + "," +
+               record["quantity"].dump() + "," + (record["note"].is_null() ? "" : record["note"].get<std::string>()) +
+               "\n";
+    }
+    return csv;
+}
+
+std::vector<std::string> makeJsonItems(size_t rows) {
+    std::mt19937_64 rng(42);
+    std::vector<std::string> items;
+    items.reserve(rows);
+    for (size_t i = 0; i < rows; ++i) {
+        items.push_back(makeRecord(i, rng).dump());
+    }
+    return items;
+}
+
+std::string makeJsonArray(size_t rows) {
+    std::string json = "[";
+    for (const auto& item : makeJsonItems(rows)) {
+        if (json.size() > 1) json += ",";
+        json += item;
+    }
+    return json + "]";
+}
+
+const std::string& csvInput(size_t rows) {
+    return cachedInput<std::string>(rows, makeCsv);
+}
+
+const std::string& jsonInput(size_t rows) {
+    return cachedInput<std::string>(rows, makeJsonArray);
+}
+
+const std::string& outputDirectory() {
+    static const std::string directory = [] {
+        auto path = std::filesystem::temp_directory_path() / "etl_benchmark";
+        std::filesystem::create_directories(path);
+        return path.string();
+    }();
+    return directory;
+}
+
+const char* formatName(OutputFormat format) {
+    switch (format) {
+        case OutputFormat::JSON: return "json";
+        case OutputFormat::CSV: return "csv";
+        case OutputFormat::XML: return "xml";
+        case OutputFormat::PARQUET: return "parquet";
+        case OutputFormat::BINARY: return "binary";
+    }
+    return "";
+}
+
+void BM_CsvToJson(benchmark::State& state) {
+    size_t rows = state.range(0);
+    const std::string& csv = csvInput(rows);
+    DataTransformer transformer;
+    RunStats stats;
+    for (auto _ : state) {
+        TransformationResult result = transformer.csvToJson(csv);
+        if (!result.success) {
+            state.SkipWithError(result.error_message.c_str());
+            break;
+        }
+        benchmark::DoNotOptimize(result.output_data.data());
+    }
+    stats.finish(state, rows, csv.size());
+}
+
+void BM_JsonToCsv(benchmark::State& state) {
+    size_t rows = state.range(0);
+    const std::string& json = jsonInput(rows);
+    DataTransformer transformer;
+    RunStats stats;
+    for (auto _ : state) {
+        TransformationResult result = transformer.jsonToCsv(json);
+        if (!result.success) {
+            state.SkipWithError(result.error_message.c_str());
+            break;
+        }
+        benchmark::DoNotOptimize(result.output_data.data());
+    }
+    stats.finish(state, rows, json.size());
+}
+
+// Parse, three steps and serialize, on range(1) threads
+void BM_ProcessDataPipeline(benchmark::State& state) {
+    size_t rows = state.range(0);
+    const std::string& json = jsonInput(rows);
+    DataTransformer transformer;
+    transformer.setPipelineParallelism(state.range(1));
+    const std::vector<std::string> steps = {
+        "remove_nulls",
+        "deduplicate:id",
+        "aggregate:region;amount=sum,quantity=avg"
+    };
+    RunStats stats;
+    for (auto _ : state) {
+        TransformationResult result = transformer.processDataPipeline(json, steps);
+        if (!result.success) {
+            state.SkipWithError(result.error_message.c_str());
+            break;
+        }
+        benchmark::DoNotOptimize(result.output_data.data());
+    }
+    stats.finish(state, rows, json.size());
+}
+
+// range(1) is the OutputFormat: each JSON item is reformatted for it
+void BM_WriteDataBatch(benchmark::State& state) {
+    size_t rows = state.range(0);
+    auto format = static_cast<OutputFormat>(state.range(1));
+    const auto& items = cachedInput<std::vector<std::string>>(rows, makeJsonItems);
+    FileWriter writer;
+    writer.setOutputDirectory(outputDirectory());
+    writer.setOutputFormat(format);
+    std::string filename = std::string("batch.") + formatName(format);
+    size_t bytes = 0;
+    RunStats stats;
+    for (auto _ : state) {
+        LoadResult result = writer.writeDataBatch(items, filename);
+        if (!result.success) {
+            state.SkipWithError(result.error_message.c_str());
+            break;
+        }
+        bytes = result.bytes_written;
+    }
+    stats.finish(state, rows, bytes);
+    state.SetLabel(formatName(format));
+    std::filesystem::remove(std::filesystem::path(outputDirectory()) / filename);
+}
+
+// range(1) is the OutputFormat; bytes are the encoded output
+void BM_StreamWriter(benchmark::State& state) {
+    size_t rows = state.range(0);
+    auto format = static_cast<OutputFormat>(state.range(1));
+    const auto& records = cachedInput<std::vector<nlohmann::json>>(RECORD_POOL, [](size_t count) {
+        std::mt19937_64 rng(42);
+        std::vector<nlohmann::json> records;
+        for (size_t i = 0; i < count; ++i) {
+            records.push_back(makeRecord(i, rng));
+        }
+        return records;
+    });
+    FileWriter writer;
+    writer.setOutputDirectory(outputDirectory());
+    writer.setOutputFormat(format);
+    std::string filename = std::string("stream.") + formatName(format);
+    size_t bytes = 0;
+    RunStats stats;
+    for (auto _ : state) {
+        auto stream = writer.createStreamWriter(filename);
+        for (size_t i = 0; i < rows; ++i) {
+            if (!stream->writeJsonRecord(records[i % RECORD_POOL])) {
+                state.SkipWithError("writeJsonRecord failed");
+                break;
+            }
+        }
+        stream->close();
+        bytes = stream->getBytesWritten();
+    }
+    stats.finish(state, rows, bytes);
+    state.SetLabel(formatName(format));
+    std::filesystem::remove(std::filesystem::path(outputDirectory()) / filename);
+}
+
+}  // namespace
+
+BENCHMARK(BM_CsvToJson)->Apply([](auto* bench) { addRowCounts(bench); })->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_JsonToCsv)->Apply([](auto* bench) { addRowCounts(bench); })->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ProcessDataPipeline)
+    ->Apply([](auto* bench) { addRowCounts(bench, {1, 4}); })
+    ->ArgNames({"rows", "threads"})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(BM_WriteDataBatch)
+    ->Apply([](auto* bench) {
+        addRowCounts(bench, {static_cast<int64_t>(OutputFormat::JSON), static_cast<int64_t>(OutputFormat::CSV)});
+    })
+    ->ArgNames({"rows", "format"})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(BM_StreamWriter)
+    ->Apply([](auto* bench) {
+        addRowCounts(bench, {static_cast<int64_t>(OutputFormat::JSON), static_cast<int64_t>(OutputFormat::CSV),
+                             static_cast<int64_t>(OutputFormat::BINARY), static_cast<int64_t>(OutputFormat::PARQUET)});
+    })
+    ->ArgNames({"rows", "format"})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    std::filesystem::remove_all(outputDirectory());
+    return 0;
+}
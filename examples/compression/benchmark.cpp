@@ -0,0 +1,435 @@
+// Compression benchmark: runs every codec / level / block size / thread
+// count combination over a corpus and reports compression and
+// decompression throughput, ratio and peak memory.
+//
+// Data is split into independent blocks exactly as the block-indexed
+// format does, so the numbers carry over to `compression -f indexed`.
+// Each combination runs in a forked child process; peak RSS is that
+// child's maximum resident set and includes the corpus (once) plus the
+// compressed and restored copies.
+
+#include "codec.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+struct Corpus {
+    std::string name;
+    std::string data;
+};
+
+struct BenchmarkCase {
+    const Codec* codec;
+    int level;
+    size_t blockSize;
+    size_t threads;
+};
+
+struct BenchmarkResult {
+    double compressMBps = 0;
+    double decompressMBps = 0;
+    double ratio = 0;                 // compressed / original
+    long peakRssKB = 0;
+    bool ok = false;
+    char error[128] = {};
+};
+
+struct Options {
+    std::vector<std::string> corpusKinds = {"csv", "json", "binary"};
+    std::vector<std::string> corpusFiles;
+    size_t corpusBytes = 64u << 20;
+    std::vector<std::string> codecs;
+    std::vector<int> levels;          // Empty: a few per codec
+    std::vector<size_t> blockSizes = {64u << 10, 256u << 10, 1u << 20, 4u << 20};
+    std::vector<size_t> threadCounts;
+    int repeat = 3;
+    bool csv = false;
+};
+
+// Synthetic corpora are seeded so runs are comparable across machines
+Corpus generateCsv(size_t bytes) {
+    std::mt19937_64 rng(42);
+    const char* cities[] = {"London", "Paris", "Berlin", "Madrid", "Rome", "Vienna", "Prague", "Dublin"};
+    std::uniform_int_distribution<int> city(0, 7);
+    std::uniform_int_distribution<int> age(18, 90);
+    std::uniform_real_distribution<double> amount(0, 10000);
+    std::string data = "id,name,age,city,amount,active\n";
+    data.reserve(bytes + 128);
+    char line[160];
+    for (uint64_t id = 1; data.size() < bytes; ++id) {
+        int n = std::snprintf(line, sizeof(line), "%llu,user_%llu,%d,%s,%.2f,%s\n",
+                              static_cast<unsigned long long>(id),
+                              static_cast<unsigned long long>(rng() % 100000), age(rng),
+                              cities[city(rng)], amount(rng), (rng() & 1) ? "true" : "false");
+        data.append(line, static_cast<size_t>(n));
+    }
+    data.resize(bytes);
+    return {"csv", std::move(data)};
+}
+
+Corpus generateJson(size_t bytes) {
+    std::mt19937_64 rng(43);
+    const char* events[] = {"click", "view", "purchase", "signup", "logout"};
+    std::uniform_int_distribution<int> event(0, 4);
+    std::string data;
+    data.reserve(bytes + 256);
+    char line[256];
+    for (uint64_t id = 1; data.size() < bytes; ++id) {
+        int n = std::snprintf(line, sizeof(line),
+                              "{\"id\":%llu,\"event\":\"%s\",\"user\":{\"id\":%llu,\"session\":\"%016llx\"},"
+                              "\"ts\":%llu,\"value\":%.3f}\n",
+                              static_cast<unsigned long long>(id), events[event(rng)],
+                              static_cast<unsigned long long>(rng() % 50000),
+                              static_cast<unsigned long long>(rng()),
+                              static_cast<unsigned long long>(1700000000000ull + id * 37),
+                              static_cast<double>(rng() % 100000) / 1000.0);
+        data.append(line, static_cast<size_t>(n));
+    }
+    data.resize(bytes);
+    return {"json", std::move(data)};
+}
+
+// Columnar-style binary: slowly increasing int64 keys, small ints and
+// doubles, the kind of data segment and record files hold
+Corpus generateBinary(size_t bytes) {
+    std::mt19937_64 rng(44);
+    std::normal_distribution<double> price(100.0, 15.0);
+    std::string data(bytes, '\0');
+    size_t records = bytes / 24;
+    uint64_t key = 1000000;
+    for (size_t i = 0; i < records; ++i) {
+        key += rng() % 8;
+        int64_t quantity = static_cast<int64_t>(rng() % 1000);
+        double p = price(rng);
+        std::memcpy(&data[i * 24], &key, 8);
+        std::memcpy(&data[i * 24 + 8], &quantity, 8);
+        std::memcpy(&data[i * 24 + 16], &p, 8);
+    }
+    return {"binary", std::move(data)};
+}
+
+Corpus loadCorpus(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Cannot open corpus file: " + path);
+    }
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    std::string name = path.substr(path.find_last_of('/') + 1);
+    return {name, contents.str()};
+}
+
+// Runs fn(block) for every block on the given number of threads
+void forEachBlock(size_t blocks, size_t threads, const std::function<void(size_t)>& fn) {
+    std::atomic<size_t> next{0};
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    auto worker = [&] {
+        try {
+            for (size_t b = next++; b < blocks; b = next++) {
+                fn(b);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            error = std::current_exception();
+            next = blocks;
+        }
+    };
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < threads; ++t) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+BenchmarkResult runCase(const Corpus& corpus, const BenchmarkCase& bench, int repeat) {
+    const std::string& data = corpus.data;
+    const Codec& codec = *bench.codec;
+    size_t blocks = std::max<size_t>(1, (data.size() + bench.blockSize - 1) / bench.blockSize);
+    auto blockLength = [&](size_t b) { return std::min(bench.blockSize, data.size() - b * bench.blockSize); };
+
+    std::vector<std::string> compressed(blocks);
+    for (size_t b = 0; b < blocks; ++b) {
+        compressed[b].resize(codec.maxCompressedSize(blockLength(b)));
+    }
+    std::string restored(data.size(), '\0');
+
+    BenchmarkResult result;
+    double bestCompress = 1e30;
+    double bestDecompress = 1e30;
+    size_t compressedBytes = 0;
+    for (int r = 0; r < repeat; ++r) {
+        std::vector<size_t> sizes(blocks);
+        auto start = std::chrono::steady_clock::now();
+        forEachBlock(blocks, bench.threads, [&](size_t b) {
+            size_t offset = b * bench.blockSize;
+            sizes[b] = codec.compress(data.data() + offset, blockLength(b), &compressed[b][0],
+                                      compressed[b].size(), bench.level);
+        });
+        bestCompress = std::min(bestCompress, secondsSince(start));
+
+        start = std::chrono::steady_clock::now();
+        forEachBlock(blocks, bench.threads, [&](size_t b) {
+            codec.decompress(compressed[b].data(), sizes[b], &restored[b * bench.blockSize], blockLength(b));
+        });
+        bestDecompress = std::min(bestDecompress, secondsSince(start));
+
+        compressedBytes = 0;
+        for (size_t size : sizes) {
+            compressedBytes += size;
+        }
+    }
+    if (restored != data) {
+        throw std::runtime_error("round trip mismatch");
+    }
+
+    double megabytes = static_cast<double>(data.size()) / (1 << 20);
+    result.compressMBps = megabytes / bestCompress;
+    result.decompressMBps = megabytes / bestDecompress;
+    result.ratio = data.empty() ? 1.0 : static_cast<double>(compressedBytes) / data.size();
+    result.ok = true;
+    return result;
+}
+
+// Runs one case in a child process so that its peak RSS is its own
+BenchmarkResult runIsolated(const Corpus& corpus, const BenchmarkCase& bench, int repeat) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        throw std::runtime_error("pipe failed");
+    }
+    std::cout.flush();
+    pid_t pid = fork();
+    if (pid < 0) {
+        throw std::runtime_error("fork failed");
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        BenchmarkResult result;
+        try {
+            result = runCase(corpus, bench, repeat);
+        } catch (const std::exception& e) {
+            std::strncpy(result.error, e.what(), sizeof(result.error) - 1);
+        }
+        ssize_t written = write(fds[1], &result, sizeof(result));
+        _exit(written == static_cast<ssize_t>(sizeof(result)) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    BenchmarkResult result;
+    ssize_t got = read(fds[0], &result, sizeof(result));
+    close(fds[0]);
+    int status = 0;
+    struct rusage usage {};
+    wait4(pid, &status, 0, &usage);
+    if (got != static_cast<ssize_t>(sizeof(result))) {
+        result = BenchmarkResult{};
+        std::strncpy(result.error, "benchmark process died", sizeof(result.error) - 1);
+    }
+    result.peakRssKB = usage.ru_maxrss;
+    return result;
+}
+
+std::vector<int> levelsFor(const Codec& codec, const Options& options) {
+    std::vector<int> levels;
+    if (!options.levels.empty()) {
+        for (int level : options.levels) {
+            if (level >= codec.minLevel() && level <= codec.maxLevel()) {
+                levels.push_back(level);
+            }
+        }
+        return levels;
+    }
+    switch (codec.type()) {
+        case CodecType::ZLIB:
+        case CodecType::GZIP: return {1, 6, 9};
+        case CodecType::ZSTD: return {1, 3, 9, 19};
+        case CodecType::LZ4: return {0, 9};
+        case CodecType::NONE: return {0};
+    }
+    return {codec.defaultLevel()};
+}
+
+template <typename T>
+std::vector<T> parseList(const std::string& text, const std::function<T(const std::string&)>& parse) {
+    std::vector<T> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            values.push_back(parse(item));
+        }
+    }
+    return values;
+}
+
+void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --corpus <kinds>     csv,json,binary (synthetic, default all three)\n"
+              << "  --file <path>        benchmark a file instead (repeatable)\n"
+              << "  --size <MB>          synthetic corpus size (default 64)\n"
+              << "  --codecs <list>      default: every compiled-in codec except gzip\n"
+              << "  --levels <list>      default: a few per codec\n"
+              << "  --blocks <KB list>   default 64,256,1024,4096\n"
+              << "  --threads <list>     default 1 and all cores\n"
+              << "  --repeat <n>         best of n runs (default 3)\n"
+              << "  --csv                machine-readable output\n";
+}
+
+Options parseOptions(int argc, char* argv[]) {
+    Options options;
+    auto toString = [](const std::string& s) { return s; };
+    auto toSize = [](const std::string& s) { return static_cast<size_t>(std::stoul(s)); };
+    auto toInt = [](const std::string& s) { return std::stoi(s); };
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--csv") {
+            options.csv = true;
+            continue;
+        }
+        if (arg == "--help" || arg == "-h" || i + 1 >= argc) {
+            printUsage(argv[0]);
+            std::exit(arg == "--help" || arg == "-h" ? 0 : 1);
+        }
+        std::string value = argv[++i];
+        if (arg == "--corpus") {
+            options.corpusKinds = parseList<std::string>(value, toString);
+        } else if (arg == "--file") {
+            options.corpusFiles.push_back(value);
+        } else if (arg == "--size") {
+            options.corpusBytes = toSize(value) << 20;
+        } else if (arg == "--codecs") {
+            options.codecs = parseList<std::string>(value, toString);
+        } else if (arg == "--levels") {
+            options.levels = parseList<int>(value, toInt);
+        } else if (arg == "--blocks") {
+            options.blockSizes = parseList<size_t>(value, [&](const std::string& s) { return toSize(s) << 10; });
+        } else if (arg == "--threads") {
+            options.threadCounts = parseList<size_t>(value, toSize);
+        } else if (arg == "--repeat") {
+            options.repeat = std::max(1, toInt(value));
+        } else {
+            printUsage(argv[0]);
+            std::exit(1);
+        }
+    }
+    if (options.codecs.empty()) {
+        for (const auto& name : availableCodecs()) {
+            if (name != "gzip") {  // Same deflate engine as zlib
+                options.codecs.push_back(name);
+            }
+        }
+    }
+    if (options.threadCounts.empty()) {
+        size_t cores = std::max(std::thread::hardware_concurrency(), 1u);
+        options.threadCounts = {1};
+        if (cores > 1) {
+            options.threadCounts.push_back(cores);
+        }
+    }
+    return options;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        Options options = parseOptions(argc, argv);
+
+        // Corpora are built one at a time so each child only maps the one it measures
+        std::vector<std::function<Corpus()>> corpora;
+        if (!options.corpusFiles.empty()) {
+            for (const auto& path : options.corpusFiles) {
+                corpora.push_back([path] { return loadCorpus(path); });
+            }
+        } else {
+            size_t bytes = options.corpusBytes;
+            for (const auto& kind : options.corpusKinds) {
+                if (kind == "csv") {
+                    corpora.push_back([bytes] { return generateCsv(bytes); });
+                } else if (kind == "json") {
+                    corpora.push_back([bytes] { return generateJson(bytes); });
+                } else if (kind == "binary") {
+                    corpora.push_back([bytes] { return generateBinary(bytes); });
+                } else {
+                    throw std::runtime_error("Unknown corpus kind '" + kind + "'");
+                }
+            }
+        }
+        for (const auto& name : options.codecs) {
+            getCodec(name);  // Fail before any work for unknown codecs
+        }
+
+        if (options.csv) {
+            std::cout << "corpus,bytes,codec,level,block_kb,threads,compress_mbps,decompress_mbps,ratio,peak_rss_kb\n";
+        } else {
+            std::cout << std::left << std::setw(10) << "corpus" << std::setw(6) << "codec" << std::right
+                      << std::setw(6) << "level" << std::setw(9) << "block KB" << std::setw(8) << "threads"
+                      << std::setw(12) << "comp MB/s" << std::setw(12) << "decomp MB/s" << std::setw(9) << "ratio"
+                      << std::setw(11) << "peak MB" << "\n";
+        }
+
+        for (const auto& makeCorpus : corpora) {
+            Corpus corpus = makeCorpus();
+            for (const auto& name : options.codecs) {
+                const Codec& codec = getCodec(name);
+                for (int level : levelsFor(codec, options)) {
+                    for (size_t blockSize : options.blockSizes) {
+                        for (size_t threads : options.threadCounts) {
+                            BenchmarkResult r = runIsolated(corpus, {&codec, level, blockSize, threads},
+                                                            options.repeat);
+                            if (!r.ok) {
+                                std::cerr << corpus.name << " " << name << " -" << level << ": " << r.error << "\n";
+                                continue;
+                            }
+                            if (options.csv) {
+                                std::cout << corpus.name << "," << corpus.data.size() << "," << name << ","
+                                          << level << "," << (blockSize >> 10) << "," << threads << ","
+                                          << std::fixed << std::setprecision(1) << r.compressMBps << ","
+                                          << r.decompressMBps << "," << std::setprecision(4) << r.ratio << ","
+                                          << r.peakRssKB << "\n";
+                            } else {
+                                std::cout << std::left << std::setw(10) << corpus.name << std::setw(6) << name
+                                          << std::right << std::setw(6) << level << std::setw(9) << (blockSize >> 10)
+                                          << std::setw(8) << threads << std::fixed << std::setprecision(1)
+                                          << std::setw(12) << r.compressMBps << std::setw(12) << r.decompressMBps
+                                          << std::setprecision(3) << std::setw(9) << r.ratio << std::setprecision(1)
+                                          << std::setw(11) << r.peakRssKB / 1024.0 << "\n";
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,37 @@
+# Adds the shared compression codecs (codec.h/cpp) to a target. zlib is
+# required; zstd and lz4 are compiled in when their headers and libraries
+# are found, which defines HAVE_ZSTD / HAVE_LZ4.
+#
+#   include(path/to/compression/codec.cmake)
+#   target_add_codecs(my_target)
+
+find_package(ZLIB REQUIRED)
+find_path(ZSTD_INCLUDE_DIR zstd.h)
+find_library(ZSTD_LIBRARY zstd)
+find_path(LZ4_INCLUDE_DIR lz4frame.h)
+find_library(LZ4_LIBRARY lz4)
+
+set(CODEC_SOURCE_DIR ${CMAKE_CURRENT_LIST_DIR})
+
+function(target_add_codecs target)
+    target_sources(${target} PRIVATE ${CODEC_SOURCE_DIR}/codec.cpp)
+    target_include_directories(${target} PRIVATE ${CODEC_SOURCE_DIR})
+    target_link_libraries(${target} ZLIB::ZLIB)
+    if(ZSTD_INCLUDE_DIR AND ZSTD_LIBRARY)
+        target_compile_definitions(${target} PRIVATE HAVE_ZSTD)
+        target_include_directories(${target} PRIVATE ${ZSTD_INCLUDE_DIR})
+        target_link_libraries(${target} ${ZSTD_LIBRARY})
+    endif()
+    if(LZ4_INCLUDE_DIR AND LZ4_LIBRARY)
+        target_compile_definitions(${target} PRIVATE HAVE_LZ4)
+        target_include_directories(${target} PRIVATE ${LZ4_INCLUDE_DIR})
+        target_link_libraries(${target} ${LZ4_LIBRARY})
+    endif()
+endfunction()
+
+if(NOT ZSTD_INCLUDE_DIR OR NOT ZSTD_LIBRARY)
+    message(STATUS "zstd not found: codec 'zstd' disabled")
+endif()
+if(NOT LZ4_INCLUDE_DIR OR NOT LZ4_LIBRARY)
+    message(STATUS "lz4 not found: codec 'lz4' disabled")
+endif()
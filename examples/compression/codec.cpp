@@ -0,0 +1,436 @@
+#include "codec.h"
+#include <zlib.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef HAVE_LZ4
+#include <lz4frame.h>
+#endif
+
+namespace {
+
+constexpr size_t STREAM_CHUNK = 256 * 1024;   // Output growth step for unknown sizes
+constexpr size_t ZLIB_MAX_INPUT = 1u << 30;   // Per-call cap; avail_in is 32-bit
+
+void checkLevel(const Codec& codec, int level) {
+    if (level < codec.minLevel() || level > codec.maxLevel()) {
+        throw std::runtime_error(std::string(codec.name()) + " level must be between " +
+                                 std::to_string(codec.minLevel()) + " and " + std::to_string(codec.maxLevel()));
+    }
+}
+
+class NoneCodec : public Codec {
+public:
+    CodecType type() const override { return CodecType::NONE; }
+    const char* name() const override { return "none"; }
+    const char* fileExtension() const override { return ""; }
+    int minLevel() const override { return 0; }
+    int maxLevel() const override { return 0; }
+    int defaultLevel() const override { return 0; }
+    size_t maxCompressedSize(size_t size) const override { return size; }
+
+    size_t compress(const char* src, size_t size, char* dst, size_t, int) const override {
+        std::memcpy(dst, src, size);
+        return size;
+    }
+
+    void decompress(const char* src, size_t size, char* dst, size_t originalSize) const override {
+        if (size != originalSize) {
+            throw std::runtime_error("none: size mismatch");
+        }
+        std::memcpy(dst, src, size);
+    }
+
+    std::string decompress(std::string_view compressed) const override {
+        return std::string(compressed);
+    }
+};
+
+// zlib and gzip differ only in the wrapper deflate writes around the data
+class DeflateCodec : public Codec {
+private:
+    bool gzip;
+
+    int windowBits() const { return gzip ? 15 + 16 : 15; }
+
+    [[noreturn]] void fail(const char* what) const {
+        throw std::runtime_error(std::string(name()) + ": " + what);
+    }
+
+public:
+    explicit DeflateCodec(bool gzip_wrapper) : gzip(gzip_wrapper) {}
+
+    CodecType type() const override { return gzip ? CodecType::GZIP : CodecType::ZLIB; }
+    const char* name() const override { return gzip ? "gzip" : "zlib"; }
+    const char* fileExtension() const override { return gzip ? ".gz" : ".zz"; }
+    int minLevel() const override { return 1; }
+    int maxLevel() const override { return 9; }
+    int defaultLevel() const override { return 6; }
+
+    size_t maxCompressedSize(size_t size) const override {
+        // compressBound covers the 6-byte zlib wrapper; gzip's is 18 bytes.
+        // Inputs fed in several calls add a few bytes per call.
+        return compressBound(size) + 32 + (size / ZLIB_MAX_INPUT) * 8;
+    }
+
+    size_t compress(const char* src, size_t size, char* dst, size_t capacity, int level) const override {
+        checkLevel(*this, level);
+        z_stream zs{};
+        if (deflateInit2(&zs, level, Z_DEFLATED, windowBits(), 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            fail("deflateInit failed");
+        }
+        zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(src));
+        zs.next_out = reinterpret_cast<Bytef*>(dst);
+        size_t inLeft = size;
+        size_t outLeft = capacity;
+        int ret = Z_OK;
+        while (ret == Z_OK) {
+            zs.avail_in = static_cast<uInt>(std::min(inLeft, ZLIB_MAX_INPUT));
+            zs.avail_out = static_cast<uInt>(std::min(outLeft, ZLIB_MAX_INPUT));
+            uInt givenIn = zs.avail_in;
+            uInt givenOut = zs.avail_out;
+            ret = deflate(&zs, zs.avail_in == inLeft ? Z_FINISH : Z_NO_FLUSH);
+            inLeft -= givenIn - zs.avail_in;
+            outLeft -= givenOut - zs.avail_out;
+            if (ret == Z_BUF_ERROR && outLeft > 0) {
+                ret = Z_OK;  // No progress possible this round, more room follows
+            }
+        }
+        deflateEnd(&zs);
+        if (ret != Z_STREAM_END) {
+            fail("output buffer too small");
+        }
+        return capacity - outLeft;
+    }
+
+    void decompress(const char* src, size_t size, char* dst, size_t originalSize) const override {
+        char empty;
+        if (!dst) {
+            dst = &empty;  // inflate rejects a null output pointer even with no room
+        }
+        z_stream zs{};
+        if (inflateInit2(&zs, windowBits()) != Z_OK) {
+            fail("inflateInit failed");
+        }
+        zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(src));
+        zs.next_out = reinterpret_cast<Bytef*>(dst);
+        size_t inLeft = size;
+        size_t outLeft = originalSize;
+        int ret = Z_OK;
+        while (ret == Z_OK) {
+            zs.avail_in = static_cast<uInt>(std::min(inLeft, ZLIB_MAX_INPUT));
+            zs.avail_out = static_cast<uInt>(std::min(outLeft, ZLIB_MAX_INPUT));
+            uInt givenIn = zs.avail_in;
+            uInt givenOut = zs.avail_out;
+            ret = inflate(&zs, Z_NO_FLUSH);
+            inLeft -= givenIn - zs.avail_in;
+            outLeft -= givenOut - zs.avail_out;
+            if (ret == Z_BUF_ERROR && givenIn != zs.avail_in) {
+                ret = Z_OK;
+            }
+        }
+        inflateEnd(&zs);
+        if (ret != Z_STREAM_END || outLeft != 0) {
+            fail("corrupt or truncated data");
+        }
+    }
+
+    std::string decompress(std::string_view compressed) const override {
+        z_stream zs{};
+        if (inflateInit2(&zs, windowBits()) != Z_OK) {
+            fail("inflateInit failed");
+        }
+        std::string result;
+        const char* in = compressed.data();
+        size_t inLeft = compressed.size();
+        int ret = Z_OK;
+        while (true) {
+            if (ret == Z_STREAM_END) {
+                if (!gzip || inLeft == 0) {
+                    break;
+                }
+                inflateReset(&zs);  // Next gzip member
+            }
+            size_t used = result.size();
+            result.resize(used + STREAM_CHUNK);
+            zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in));
+            zs.avail_in = static_cast<uInt>(std::min(inLeft, ZLIB_MAX_INPUT));
+            zs.next_out = reinterpret_cast<Bytef*>(&result[used]);
+            zs.avail_out = static_cast<uInt>(STREAM_CHUNK);
+            uInt givenIn = zs.avail_in;
+            ret = inflate(&zs, Z_NO_FLUSH);
+            size_t consumed = givenIn - zs.avail_in;
+            size_t produced = STREAM_CHUNK - zs.avail_out;
+            result.resize(used + produced);
+            in += consumed;
+            inLeft -= consumed;
+            if (ret == Z_BUF_ERROR && consumed == 0 && produced == 0) {
+                inflateEnd(&zs);
+                fail("truncated data");
+            }
+            if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+                inflateEnd(&zs);
+                fail("corrupt data");
+            }
+        }
+        inflateEnd(&zs);
+        return result;
+    }
+};
+
+#ifdef HAVE_ZSTD
+class ZstdCodec : public Codec {
+private:
+    static size_t check(size_t ret) {
+        if (ZSTD_isError(ret)) {
+            throw std::runtime_error(std::string("zstd: ") + ZSTD_getErrorName(ret));
+        }
+        return ret;
+    }
+
+public:
+    CodecType type() const override { return CodecType::ZSTD; }
+    const char* name() const override { return "zstd"; }
+    const char* fileExtension() const override { return ".zst"; }
+    int minLevel() const override { return 1; }
+    int maxLevel() const override { return ZSTD_maxCLevel(); }
+    int defaultLevel() const override { return 3; }
+    size_t maxCompressedSize(size_t size) const override { return ZSTD_compressBound(size); }
+
+    size_t compress(const char* src, size_t size, char* dst, size_t capacity, int level) const override {
+        checkLevel(*this, level);
+        return check(ZSTD_compress(dst, capacity, src, size, level));
+    }
+
+    void decompress(const char* src, size_t size, char* dst, size_t originalSize) const override {
+        if (check(ZSTD_decompress(dst, originalSize, src, size)) != originalSize) {
+            throw std::runtime_error("zstd: size mismatch");
+        }
+    }
+
+    std::string decompress(std::string_view compressed) const override {
+        ZSTD_DStream* stream = ZSTD_createDStream();
+        if (!stream) {
+            throw std::runtime_error("zstd: out of memory");
+        }
+        std::string result;
+        ZSTD_inBuffer in{compressed.data(), compressed.size(), 0};
+        size_t ret = 1;
+        try {
+            check(ZSTD_initDStream(stream));
+            while (in.pos < in.size || ret != 0) {
+                size_t used = result.size();
+                result.resize(used + STREAM_CHUNK);
+                ZSTD_outBuffer out{&result[used], STREAM_CHUNK, 0};
+                size_t before = in.pos;
+                ret = check(ZSTD_decompressStream(stream, &out, &in));
+                result.resize(used + out.pos);
+                if (ret != 0 && in.pos == in.size && in.pos == before && out.pos == 0) {
+                    throw std::runtime_error("zstd: truncated data");
+                }
+            }
+        } catch (...) {
+            ZSTD_freeDStream(stream);
+            throw;
+        }
+        ZSTD_freeDStream(stream);
+        return result;
+    }
+};
+#endif
+
+#ifdef HAVE_LZ4
+class Lz4Codec : public Codec {
+private:
+    static size_t check(size_t ret) {
+        if (LZ4F_isError(ret)) {
+            throw std::runtime_error(std::string("lz4: ") + LZ4F_getErrorName(ret));
+        }
+        return ret;
+    }
+
+    static LZ4F_preferences_t preferences(size_t size, int level) {
+        LZ4F_preferences_t prefs;
+        std::memset(&prefs, 0, sizeof(prefs));
+        prefs.frameInfo.blockSizeID = LZ4F_max4MB;
+        prefs.frameInfo.contentSize = size;
+        prefs.compressionLevel = level;  // 3 and above select LZ4-HC
+        return prefs;
+    }
+
+    // Runs LZ4F_decompress until it stops making progress: the input is
+    // consumed and everything decoded so far fits in dst
+    static size_t decompressInto(LZ4F_dctx* ctx, const char*& src, size_t& size, char* dst, size_t capacity,
+                                 size_t& hint) {
+        size_t written = 0;
+        while (true) {
+            size_t outSize = capacity - written;
+            size_t inSize = size;
+            size_t next = check(LZ4F_decompress(ctx, dst + written, &outSize, src, &inSize, nullptr));
+            if (inSize == 0 && outSize == 0) {
+                return written;  // Keep the hint of the last call that did something
+            }
+            hint = next;  // 0 once a frame is complete
+            src += inSize;
+            size -= inSize;
+            written += outSize;
+        }
+    }
+
+public:
+    CodecType type() const override { return CodecType::LZ4; }
+    const char* name() const override { return "lz4"; }
+    const char* fileExtension() const override { return ".lz4"; }
+    int minLevel() const override { return 0; }
+    int maxLevel() const override { return 12; }
+    int defaultLevel() const override { return 0; }
+
+    size_t maxCompressedSize(size_t size) const override {
+        LZ4F_preferences_t prefs = preferences(size, 0);
+        return LZ4F_compressFrameBound(size, &prefs);
+    }
+
+    size_t compress(const char* src, size_t size, char* dst, size_t capacity, int level) const override {
+        checkLevel(*this, level);
+        LZ4F_preferences_t prefs = preferences(size, level);
+        return check(LZ4F_compressFrame(dst, capacity, src, size, &prefs));
+    }
+
+    void decompress(const char* src, size_t size, char* dst, size_t originalSize) const override {
+        LZ4F_dctx* ctx;
+        check(LZ4F_createDecompressionContext(&ctx, LZ4F_VERSION));
+        size_t hint = 0;
+        size_t written;
+        try {
+            written = decompressInto(ctx, src, size, dst, originalSize, hint);
+        } catch (...) {
+            LZ4F_freeDecompressionContext(ctx);
+            throw;
+        }
+        LZ4F_freeDecompressionContext(ctx);
+        if (written != originalSize || hint != 0 || size != 0) {
+            throw std::runtime_error("lz4: corrupt or truncated data");
+        }
+    }
+
+    std::string decompress(std::string_view compressed) const override {
+        LZ4F_dctx* ctx;
+        check(LZ4F_createDecompressionContext(&ctx, LZ4F_VERSION));
+        std::string result;
+        const char* src = compressed.data();
+        size_t size = compressed.size();
+        size_t hint = 0;
+        try {
+            size_t produced = STREAM_CHUNK;
+            while (produced == STREAM_CHUNK) {
+                size_t used = result.size();
+                result.resize(used + STREAM_CHUNK);
+                produced = decompressInto(ctx, src, size, &result[used], STREAM_CHUNK, hint);
+                result.resize(used + produced);
+            }
+        } catch (...) {
+            LZ4F_freeDecompressionContext(ctx);
+            throw;
+        }
+        LZ4F_freeDecompressionContext(ctx);
+        if (hint != 0 || size != 0) {
+            throw std::runtime_error("lz4: truncated data");
+        }
+        return result;
+    }
+};
+#endif
+
+const NoneCodec NONE_CODEC;
+const DeflateCodec ZLIB_CODEC(false);
+const DeflateCodec GZIP_CODEC(true);
+#ifdef HAVE_ZSTD
+const ZstdCodec ZSTD_CODEC;
+#endif
+#ifdef HAVE_LZ4
+const Lz4Codec LZ4_CODEC;
+#endif
+
+const Codec* findCodec(const std::string& name) {
+    if (name == "none") return &NONE_CODEC;
+    if (name == "zlib" || name == "deflate") return &ZLIB_CODEC;
+    if (name == "gzip" || name == "gz") return &GZIP_CODEC;
+#ifdef HAVE_ZSTD
+    if (name == "zstd" || name == "zst") return &ZSTD_CODEC;
+#endif
+#ifdef HAVE_LZ4
+    if (name == "lz4") return &LZ4_CODEC;
+#endif
+    return nullptr;
+}
+
+} // namespace
+
+std::string Codec::compress(std::string_view data, int level) const {
+    std::string result(maxCompressedSize(data.size()), '\0');
+    result.resize(compress(data.data(), data.size(), &result[0], result.size(), level));
+    return result;
+}
+
+const Codec& getCodec(const std::string& name) {
+    const Codec* codec = findCodec(name);
+    if (!codec) {
+        bool known = name == "zstd" || name == "zst" || name == "lz4";
+        throw std::runtime_error(known ? "Codec '" + name + "' was not compiled in"
+                                       : "Unknown codec '" + name + "'");
+    }
+    return *codec;
+}
+
+const Codec& getCodec(CodecType type) {
+    switch (type) {
+        case CodecType::NONE: return NONE_CODEC;
+        case CodecType::ZLIB: return ZLIB_CODEC;
+        case CodecType::GZIP: return GZIP_CODEC;
+        case CodecType::ZSTD: return getCodec("zstd");
+        case CodecType::LZ4: return getCodec("lz4");
+    }
+    throw std::runtime_error("Unknown codec id " + std::to_string(static_cast<int>(type)));
+}
+
+bool isCodecAvailable(const std::string& name) {
+    return findCodec(name) != nullptr;
+}
+
+std::vector<std::string> availableCodecs() {
+    std::vector<std::string> names = {"none", "zlib", "gzip"};
+#ifdef HAVE_ZSTD
+    names.push_back("zstd");
+#endif
+#ifdef HAVE_LZ4
+    names.push_back("lz4");
+#endif
+    return names;
+}
+
+CodecChoice recommendedCodec(CompressionProfile profile) {
+    switch (profile) {
+        case CompressionProfile::FAST:
+#ifdef HAVE_LZ4
+            return {&LZ4_CODEC, 0};
+#else
+            return {&ZLIB_CODEC, 1};
+#endif
+        case CompressionProfile::BALANCED:
+#ifdef HAVE_ZSTD
+            return {&ZSTD_CODEC, 3};
+#else
+            return {&ZLIB_CODEC, 6};
+#endif
+        case CompressionProfile::ARCHIVE:
+#ifdef HAVE_ZSTD
+            return {&ZSTD_CODEC, 19};
+#else
+            return {&ZLIB_CODEC, 9};
+#endif
+    }
+    return {&ZLIB_CODEC, 6};
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Codec ids are stored in block-indexed files; never renumber them
+enum class CodecType : uint8_t {
+    NONE = 0,
+    ZLIB = 1,   // zlib stream (RFC 1950)
+    GZIP = 2,   // gzip member (RFC 1952), readable by gunzip
+    ZSTD = 3,   // zstd frame, readable by `zstd -d`; needs HAVE_ZSTD
+    LZ4 = 4     // LZ4 frame, readable by `lz4 -d`; needs HAVE_LZ4
+};
+
+// Which end of the speed/ratio trade-off a particular output sits on
+enum class CompressionProfile {
+    FAST,       // Hot intermediate files: GB/s matters, ratio does not
+    BALANCED,
+    ARCHIVE     // Cold storage: ratio matters, compression speed does not
+};
+
+// One-shot compression of a buffer into a self-describing frame of the
+// codec's standard format. Codec objects are stateless and shared; all
+// methods are safe to call from several threads at once.
+class Codec {
+public:
+    virtual ~Codec() = default;
+
+    virtual CodecType type() const = 0;
+    virtual const char* name() const = 0;
+    virtual const char* fileExtension() const = 0;  // ".gz", ".zst", ...
+    virtual int minLevel() const = 0;
+    virtual int maxLevel() const = 0;
+    virtual int defaultLevel() const = 0;
+
+    // Worst-case output size for size input bytes
+    virtual size_t maxCompressedSize(size_t size) const = 0;
+    // Compresses into dst (capacity at least maxCompressedSize) and
+    // returns the number of bytes written
+    virtual size_t compress(const char* src, size_t size, char* dst, size_t capacity, int level) const = 0;
+    // Decompresses a frame whose original size is known exactly
+    virtual void decompress(const char* src, size_t size, char* dst, size_t originalSize) const = 0;
+    // Decompresses one or more concatenated frames of unknown size
+    virtual std::string decompress(std::string_view compressed) const = 0;
+
+    std::string compress(std::string_view data, int level) const;
+    std::string compress(std::string_view data) const { return compress(data, defaultLevel()); }
+};
+
+// Looks up a codec by type or by name ("zlib", "gzip", "zstd", "lz4",
+// "none"); throws std::runtime_error if the codec is unknown or was not
+// compiled in
+const Codec& getCodec(CodecType type);
+const Codec& getCodec(const std::string& name);
+bool isCodecAvailable(const std::string& name);
+std::vector<std::string> availableCodecs();
+
+struct CodecChoice {
+    const Codec* codec;
+    int level;
+};
+
+// Best available codec and level for a profile: lz4 / zstd -3 / zstd -19
+// when compiled in, otherwise zlib at levels 1 / 6 / 9
+CodecChoice recommendedCodec(CompressionProfile profile);
@@ -3,130 +3,612 @@
 #include <vector>
 #include <memory>
 #include <zlib.h>
+#include "codec.h"
 #include <stdexcept>
+#include <string>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <queue>
+#include <deque>
+#include <future>
+#include <functional>
+#include <algorithm>
+#include <cstring>
+
+// Fixed set of threads running submitted tasks in FIFO order
+class WorkerPool {
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable available;
+    bool stopping = false;
+
+public:
+    explicit WorkerPool(size_t num_threads) {
+        for (size_t i = 0; i < num_threads; ++i) {
+            workers.emplace_back([this] {
+                while (true) {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        available.wait(lock, [this] { return stopping || !tasks.empty(); });
+                        if (tasks.empty()) {
+                            return;
+                        }
+                        task = std::move(tasks.front());
+                        tasks.pop();
+                    }
+                    task();
+                }
+            });
+        }
+    }
+    
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        available.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+    
+    template <typename F>
+    auto submit(F fn) -> std::future<decltype(fn())> {
+        auto task = std::make_shared<std::packaged_task<decltype(fn())()>>(std::move(fn));
+        auto result = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.emplace([task] { (*task)(); });
+        }
+        available.notify_one();
+        return result;
+    }
+};
+
+// Seekable block-indexed format: independently compressed blocks
+// followed by an index, so any byte range can be decompressed without
+// touching the blocks before it. Integers are native little-endian.
+//
+//   BlockFileHeader                 magic, version, block size, codec
+//   block[block_count]              codec frames, each blockSize input bytes (last may be shorter)
+//   BlockIndexEntry[block_count]    where each block starts in both spaces
+//   BlockFileFooter                 index location; read first when opening
+constexpr char BLOCK_FILE_MAGIC[8] = {'C', 'Z', 'B', 'L', 'K', 'I', 'D', 'X'};
+constexpr uint32_t BLOCK_FILE_VERSION = 2;  // Version 1 had no codec field and was always zlib
+
+struct BlockFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t block_size;
+    uint8_t codec;          // CodecType
+    uint8_t reserved[7];
+};
+
+struct BlockIndexEntry {
+    uint64_t uncompressed_offset;
+    uint64_t compressed_offset;
+    uint32_t uncompressed_size;
+    uint32_t compressed_size;
+};
+
+struct BlockFileFooter {
+    uint64_t index_offset;
+    uint64_t block_count;
+    uint64_t original_size;
+    char magic[8];
+};
+
+static_assert(sizeof(BlockFileHeader) == 24, "BlockFileHeader must stay 24 bytes");
+static_assert(sizeof(BlockIndexEntry) == 24, "BlockIndexEntry must stay 24 bytes");
+static_assert(sizeof(BlockFileFooter) == 32, "BlockFileFooter must stay 32 bytes");
+
+// Random access into a block-indexed file. The index is loaded once on
+// open; read() inflates only the blocks overlapping the requested range.
+class BlockIndexedReader {
+private:
+    std::string path;
+    std::ifstream file;
+    std::vector<BlockIndexEntry> index;
+    uint64_t originalSize = 0;
+    const Codec* codec = nullptr;
+
+public:
+    explicit BlockIndexedReader(const std::string& filename) : path(filename), file(filename, std::ios::binary) {
+        if (!file) {
+            throw std::runtime_error("Cannot open input file: " + filename);
+        }
+        BlockFileHeader header{};
+        BlockFileFooter footer;
+        file.seekg(0, std::ios::end);
+        uint64_t fileSize = static_cast<uint64_t>(file.tellg());
+        file.seekg(0);
+        if (fileSize < sizeof(header) + sizeof(footer) ||
+            !file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            std::memcmp(header.magic, BLOCK_FILE_MAGIC, sizeof(header.magic)) != 0) {
+            throw std::runtime_error(filename + " is not a block-indexed file");
+        }
+        if (header.version == 1) {
+            codec = &getCodec(CodecType::ZLIB);
+        } else if (header.version == BLOCK_FILE_VERSION) {
+            codec = &getCodec(static_cast<CodecType>(header.codec));
+        } else {
+            throw std::runtime_error("Unsupported block file version " + std::to_string(header.version));
+        }
+        file.seekg(static_cast<std::streamoff>(fileSize - sizeof(footer)));
+        if (!file.read(reinterpret_cast<char*>(&footer), sizeof(footer)) ||
+            std::memcmp(footer.magic, BLOCK_FILE_MAGIC, sizeof(footer.magic)) != 0 ||
+            footer.index_offset + footer.block_count * sizeof(BlockIndexEntry) + sizeof(footer) != fileSize) {
+            throw std::runtime_error(filename + " has a missing or damaged block index");
+        }
+        index.resize(footer.block_count);
+        file.seekg(static_cast<std::streamoff>(footer.index_offset));
+        if (!file.read(reinterpret_cast<char*>(index.data()),
+                       static_cast<std::streamsize>(index.size() * sizeof(BlockIndexEntry)))) {
+            throw std::runtime_error("Error reading block index of " + filename);
+        }
+        originalSize = footer.original_size;
+    }
+    
+    uint64_t size() const { return originalSize; }
+    const std::vector<BlockIndexEntry>& blocks() const { return index; }
+    const Codec& blockCodec() const { return *codec; }
+    
+    // Reads the compressed bytes of one block
+    std::vector<char> readBlock(size_t block) {
+        const BlockIndexEntry& entry = index[block];
+        std::vector<char> compressed(entry.compressed_size);
+        file.seekg(static_cast<std::streamoff>(entry.compressed_offset));
+        if (!file.read(compressed.data(), static_cast<std::streamsize>(compressed.size()))) {
+            throw std::runtime_error("Error reading block " + std::to_string(block) + " of " + path);
+        }
+        return compressed;
+    }
+    
+    // Safe to call from several threads for blocks read beforehand
+    std::vector<char> decompressBlock(const std::vector<char>& compressed, const BlockIndexEntry& entry) const {
+        std::vector<char> block(entry.uncompressed_size);
+        try {
+            codec->decompress(compressed.data(), compressed.size(), block.data(), block.size());
+        } catch (const std::exception& e) {
+            throw std::runtime_error("Corrupt block at offset " + std::to_string(entry.compressed_offset) +
+                                     ": " + e.what());
+        }
+        return block;
+    }
+    
+    // Returns up to length bytes starting at offset (fewer at end of file)
+    std::string read(uint64_t offset, size_t length) {
+        std::string result;
+        if (offset >= originalSize || length == 0) {
+            return result;
+        }
+        uint64_t end = std::min<uint64_t>(originalSize, offset + length);
+        result.reserve(static_cast<size_t>(end - offset));
+        
+        // First block whose range contains offset
+        auto it = std::upper_bound(index.begin(), index.end(), offset,
+                                   [](uint64_t value, const BlockIndexEntry& entry) {
+                                       return value < entry.uncompressed_offset;
+                                   }) - 1;
+        for (; it != index.end() && it->uncompressed_offset < end; ++it) {
+            std::vector<char> block = decompressBlock(readBlock(static_cast<size_t>(it - index.begin())), *it);
+            uint64_t from = std::max(offset, it->uncompressed_offset) - it->uncompressed_offset;
+            uint64_t to = std::min<uint64_t>(end, it->uncompressed_offset + it->uncompressed_size) -
+                          it->uncompressed_offset;
+            result.append(block.data() + from, static_cast<size_t>(to - from));
+        }
+        return result;
+    }
+};
 
 class CompressionHandler {
 private:
-    static constexpr size_t CHUNK_SIZE = 16384; // 16KB chunks for streaming
-    static constexpr int COMPRESSION_LEVEL = Z_BEST_COMPRESSION;
+    static constexpr size_t CHUNK_SIZE = 256 * 1024; // 256KB buffers for streaming
+    static constexpr size_t BLOCKS_PER_THREAD = 2;   // Blocks in flight per worker
     
-    // Helper function to read file into chunks
-    static std::vector<char> readFileInChunks(const std::string& filename) {
-        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    static std::ifstream openInput(const std::string& filename) {
+        std::ifstream file(filename, std::ios::binary);
         if (!file) {
             throw std::runtime_error("Cannot open input file: " + filename);
         }
+        return file;
+    }
+    
+    static std::ofstream openOutput(const std::string& filename) {
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            throw std::runtime_error("Cannot open output file: " + filename);
+        }
+        return file;
+    }
+    
+    // Reads up to buffer.size() bytes; returns 0 at end of file
+    static size_t readChunk(std::ifstream& input, std::vector<char>& buffer, const std::string& filename) {
+        input.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        if (input.bad()) {
+            throw std::runtime_error("Error reading file: " + filename);
+        }
+        return static_cast<size_t>(input.gcount());
+    }
+    
+    static void writeChunk(std::ofstream& output, const char* data, size_t size, const std::string& filename) {
+        if (!output.write(data, static_cast<std::streamsize>(size))) {
+            throw std::runtime_error("Error writing file: " + filename);
+        }
+    }
+    
+    static void closeOutput(std::ofstream& output, const std::string& filename) {
+        output.close();
+        if (!output) {
+            throw std::runtime_error("Error writing file: " + filename);
+        }
+    }
+    
+    // Compresses one block into a self-contained frame of the codec
+    static std::vector<char> compressBlock(const std::vector<char>& block, const Codec& codec, int level) {
+        std::vector<char> frame(codec.maxCompressedSize(block.size()));
+        frame.resize(codec.compress(block.data(), block.size(), frame.data(), frame.size(), level));
+        return frame;
+    }
+    
+    // Inflates from input to output through CHUNK_SIZE buffers. With
+    // multiMember set, a stream end followed by more input starts the next
+    // gzip member, as gunzip does. Returns the number of bytes written.
+    static uint64_t inflateStream(std::ifstream& input, const std::string& inputFile,
+                                  std::ofstream& output, const std::string& outputFile,
+                                  int windowBits, bool multiMember) {
+        z_stream zs{};
+        if (inflateInit2(&zs, windowBits) != Z_OK) {
+            throw std::runtime_error("inflateInit failed");
+        }
         
-        std::streamsize size = file.tellg();
-        file.seekg(0, std::ios::beg);
+        std::vector<char> in(CHUNK_SIZE);
+        std::vector<char> out(CHUNK_SIZE);
+        uint64_t decompressedSize = 0;
+        int ret = Z_OK;
+        try {
+            while (true) {
+                if (zs.avail_in == 0) {
+                    size_t bytesRead = readChunk(input, in, inputFile);
+                    if (bytesRead == 0) {
+                        if (ret != Z_STREAM_END) {
+                            throw std::runtime_error("truncated input");
+                        }
+                        break;
+                    }
+                    zs.avail_in = static_cast<uInt>(bytesRead);
+                    zs.next_in = reinterpret_cast<Bytef*>(in.data());
+                }
+                if (ret == Z_STREAM_END) {
+                    if (!multiMember) {
+                        break;  // Trailing bytes after the stream are ignored
+                    }
+                    inflateReset(&zs);
+                }
+                
+                zs.avail_out = static_cast<uInt>(out.size());
+                zs.next_out = reinterpret_cast<Bytef*>(out.data());
+                ret = inflate(&zs, Z_NO_FLUSH);
+                if (ret == Z_NEED_DICT || ret == Z_DATA_ERROR ||
+                    ret == Z_MEM_ERROR || ret == Z_STREAM_ERROR) {
+                    throw std::runtime_error("inflate failed");
+                }
+                size_t produced = out.size() - zs.avail_out;
+                writeChunk(output, out.data(), produced, outputFile);
+                decompressedSize += produced;
+            }
+        } catch (...) {
+            inflateEnd(&zs);
+            throw;
+        }
+        inflateEnd(&zs);
+        return decompressedSize;
+    }
+    
+    static size_t resolveThreads(size_t numThreads) {
+        return numThreads == 0 ? std::max(std::thread::hardware_concurrency(), 1u) : numThreads;
+    }
+    
+    // Reads input in blockSize blocks, compresses them on numThreads
+    // workers and writes them to output in input order; at most
+    // BLOCKS_PER_THREAD blocks per worker are in memory at once. If index
+    // is given, an entry is recorded per block, with compressed offsets
+    // counted from baseOffset. Returns the original size.
+    static uint64_t compressBlocks(std::ifstream& input, const std::string& inputFile,
+                                   std::ofstream& output, const std::string& outputFile,
+                                   size_t numThreads, size_t blockSize, const Codec& codec, int level,
+                                   uint64_t baseOffset, std::vector<BlockIndexEntry>* index) {
+        if (blockSize == 0 || blockSize > UINT32_MAX / 2) {
+            throw std::runtime_error("Block size must be between 1 byte and 2GB");
+        }
         
-        std::vector<char> buffer(size);
-        if (!file.read(buffer.data(), size)) {
-            throw std::runtime_error("Error reading file: " + filename);
+        WorkerPool pool(numThreads);
+        std::deque<std::pair<std::future<std::vector<char>>, size_t>> inFlight;
+        uint64_t originalSize = 0;
+        uint64_t writtenOriginal = 0;
+        uint64_t compressedOffset = baseOffset;
+        auto writeOldest = [&] {
+            auto oldest = std::move(inFlight.front());
+            inFlight.pop_front();
+            std::vector<char> compressed = oldest.first.get();
+            size_t rawSize = oldest.second;
+            writeChunk(output, compressed.data(), compressed.size(), outputFile);
+            if (index) {
+                index->push_back({writtenOriginal, compressedOffset, static_cast<uint32_t>(rawSize),
+                                  static_cast<uint32_t>(compressed.size())});
+            }
+            writtenOriginal += rawSize;
+            compressedOffset += compressed.size();
+        };
+        
+        try {
+            while (true) {
+                std::vector<char> block(blockSize);
+                size_t bytesRead = readChunk(input, block, inputFile);
+                if (bytesRead == 0 && originalSize > 0) {
+                    break;
+                }
+                block.resize(bytesRead);
+                originalSize += bytesRead;
+                inFlight.emplace_back(pool.submit([block = std::move(block), &codec, level] {
+                    return compressBlock(block, codec, level);
+                }), bytesRead);
+                if (inFlight.size() >= numThreads * BLOCKS_PER_THREAD) {
+                    writeOldest();
+                }
+                if (bytesRead < blockSize) {
+                    break;  // Short read: end of file
+                }
+            }
+            while (!inFlight.empty()) {
+                writeOldest();
+            }
+        } catch (...) {
+            for (auto& pending : inFlight) {
+                pending.first.wait();
+            }
+            throw;
         }
+        return originalSize;
+    }
+    
+    // Decompresses every block of a block-indexed file on numThreads workers,
+    // reading and writing in order on the calling thread
+    static uint64_t inflateIndexed(const std::string& inputFile, std::ofstream& output,
+                                   const std::string& outputFile, size_t numThreads) {
+        BlockIndexedReader reader(inputFile);
+        const auto& blocks = reader.blocks();
+        WorkerPool pool(numThreads);
+        std::deque<std::future<std::vector<char>>> inFlight;
+        uint64_t decompressedSize = 0;
+        auto writeOldest = [&] {
+            auto oldest = std::move(inFlight.front());
+            inFlight.pop_front();
+            std::vector<char> block = oldest.get();
+            writeChunk(output, block.data(), block.size(), outputFile);
+            decompressedSize += block.size();
+        };
         
-        return buffer;
+        try {
+            for (size_t i = 0; i < blocks.size(); ++i) {
+                BlockIndexEntry entry = blocks[i];
+                inFlight.push_back(pool.submit([compressed = reader.readBlock(i), entry, &reader] {
+                    return reader.decompressBlock(compressed, entry);
+                }));
+                if (inFlight.size() >= numThreads * BLOCKS_PER_THREAD) {
+                    writeOldest();
+                }
+            }
+            while (!inFlight.empty()) {
+                writeOldest();
+            }
+        } catch (...) {
+            for (auto& pending : inFlight) {
+                pending.wait();
+            }
+            throw;
+        }
+        if (decompressedSize != reader.size()) {
+            throw std::runtime_error("size mismatch: index says " + std::to_string(reader.size()) +
+                                     " bytes, blocks hold " + std::to_string(decompressedSize));
+        }
+        return decompressedSize;
+    }
+    
+    static void printCompressionSummary(uint64_t originalSize, uint64_t compressedSize) {
+        std::cout << "Compression successful!\n"
+                  << "Original size: " << originalSize << " bytes\n"
+                  << "Compressed size: " << compressedSize << " bytes\n"
+                  << "Compression ratio: "
+                  << (originalSize ? (double)compressedSize / originalSize * 100 : 0.0) << "%\n";
     }
 
 public:
-    static void compressFile(const std::string& inputFile, const std::string& outputFile) {
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 1024 * 1024; // 1MB blocks for parallel mode
+    static constexpr int COMPRESSION_LEVEL = Z_BEST_COMPRESSION; // Default for the zlib and gzip formats
+    
+    // Output format: 8-byte original size followed by one zlib stream.
+    // Both directions pump fixed CHUNK_SIZE buffers, so memory use does not
+    // depend on the file size.
+    static void compressFile(const std::string& inputFile, const std::string& outputFile,
+                             int level = COMPRESSION_LEVEL) {
         try {
-            // Read input file in chunks
-            std::vector<char> inputData = readFileInChunks(inputFile);
+            std::ifstream input = openInput(inputFile);
+            std::ofstream output = openOutput(outputFile);
             
-            // Calculate maximum compressed size
-            uLongf maxCompressedSize = compressBound(inputData.size());
-            std::vector<Bytef> compressedData(maxCompressedSize);
+            // The size is patched in once the input has been read
+            uint64_t originalSize = 0;
+            writeChunk(output, reinterpret_cast<const char*>(&originalSize), sizeof(originalSize), outputFile);
             
-            // Compress with best compression level
-            z_stream zs;
-            zs.zalloc = Z_NULL;
-            zs.zfree = Z_NULL;
-            zs.opaque = Z_NULL;
-            
-            if (deflateInit(&zs, COMPRESSION_LEVEL) != Z_OK) {
+            z_stream zs{};
+            if (deflateInit(&zs, level) != Z_OK) {
                 throw std::runtime_error("deflateInit failed");
             }
             
-            // Set up compression streams
-            zs.avail_in = static_cast<uInt>(inputData.size());
-            zs.next_in = reinterpret_cast<Bytef*>(inputData.data());
-            zs.avail_out = static_cast<uInt>(maxCompressedSize);
-            zs.next_out = compressedData.data();
-            
-            // Perform compression
-            if (deflate(&zs, Z_FINISH) != Z_STREAM_END) {
+            std::vector<char> in(CHUNK_SIZE);
+            std::vector<char> out(CHUNK_SIZE);
+            uint64_t compressedSize = 0;
+            int flush = Z_NO_FLUSH;
+            try {
+                do {
+                    size_t bytesRead = readChunk(input, in, inputFile);
+                    originalSize += bytesRead;
+                    flush = bytesRead == 0 ? Z_FINISH : Z_NO_FLUSH;
+                    zs.avail_in = static_cast<uInt>(bytesRead);
+                    zs.next_in = reinterpret_cast<Bytef*>(in.data());
+                    
+                    // Drain deflate until it has consumed the whole chunk
+                    do {
+                        zs.avail_out = static_cast<uInt>(out.size());
+                        zs.next_out = reinterpret_cast<Bytef*>(out.data());
+                        if (deflate(&zs, flush) == Z_STREAM_ERROR) {
+                            throw std::runtime_error("deflate failed");
+                        }
+                        size_t produced = out.size() - zs.avail_out;
+                        writeChunk(output, out.data(), produced, outputFile);
+                        compressedSize += produced;
+                    } while (zs.avail_out == 0);
+                } while (flush != Z_FINISH);
+            } catch (...) {
                 deflateEnd(&zs);
-                throw std::runtime_error("deflate failed");
+                throw;
             }
-            
-            uLongf compressedSize = zs.total_out;
             deflateEnd(&zs);
             
-            // Write compressed data
-            std::ofstream output(outputFile, std::ios::binary);
-            if (!output) {
-                throw std::runtime_error("Cannot open output file: " + outputFile);
-            }
+            output.seekp(0);
+            writeChunk(output, reinterpret_cast<const char*>(&originalSize), sizeof(originalSize), outputFile);
+            closeOutput(output, outputFile);
             
-            // Write original size first (needed for decompression)
-            uint64_t originalSize = inputData.size();
-            output.write(reinterpret_cast<const char*>(&originalSize), sizeof(originalSize));
-            output.write(reinterpret_cast<const char*>(compressedData.data()), compressedSize);
+            printCompressionSummary(originalSize, compressedSize);
             
-            std::cout << "Compression successful!\n"
-                      << "Original size: " << inputData.size() << " bytes\n"
-                      << "Compressed size: " << compressedSize << " bytes\n"
-                      << "Compression ratio: " << (float)compressedSize / inputData.size() * 100 << "%\n";
+        } catch (const std::exception& e) {
+            throw std::runtime_error("Compression error: " + std::string(e.what()));
+        }
+    }
+    
+    // Output format: concatenated gzip members, one per blockSize bytes of
+    // input, readable by gunzip. Blocks are compressed independently on
+    // numThreads workers (0 = one per core).
+    static void compressFileParallel(const std::string& inputFile, const std::string& outputFile,
+                                     size_t numThreads, size_t blockSize = DEFAULT_BLOCK_SIZE,
+                                     int level = COMPRESSION_LEVEL) {
+        try {
+            std::ifstream input = openInput(inputFile);
+            std::ofstream output = openOutput(outputFile);
+            
+            uint64_t originalSize = compressBlocks(input, inputFile, output, outputFile,
+                                                   resolveThreads(numThreads), blockSize,
+                                                   getCodec(CodecType::GZIP), level, 0, nullptr);
+            uint64_t compressedSize = static_cast<uint64_t>(output.tellp());
+            closeOutput(output, outputFile);
+            
+            printCompressionSummary(originalSize, compressedSize);
             
         } catch (const std::exception& e) {
             throw std::runtime_error("Compression error: " + std::string(e.what()));
         }
     }
     
-    static void decompressFile(const std::string& inputFile, const std::string& outputFile) {
+    // Output format: block-indexed (see BlockFileHeader). Compresses like
+    // compressFileParallel, with any codec, then appends the index so
+    // BlockIndexedReader can serve arbitrary ranges and decompression can
+    // run in parallel.
+    static void compressFileIndexed(const std::string& inputFile, const std::string& outputFile,
+                                    size_t numThreads, size_t blockSize, const Codec& codec, int level) {
         try {
-            // Read compressed file
-            std::vector<char> compressedData = readFileInChunks(inputFile);
+            std::ifstream input = openInput(inputFile);
+            std::ofstream output = openOutput(outputFile);
             
-            // Read original size
-            uint64_t originalSize;
-            std::memcpy(&originalSize, compressedData.data(), sizeof(originalSize));
+            BlockFileHeader header{};
+            std::memcpy(header.magic, BLOCK_FILE_MAGIC, sizeof(header.magic));
+            header.version = BLOCK_FILE_VERSION;
+            header.block_size = static_cast<uint32_t>(blockSize);
+            header.codec = static_cast<uint8_t>(codec.type());
+            writeChunk(output, reinterpret_cast<const char*>(&header), sizeof(header), outputFile);
             
-            // Prepare decompression
-            std::vector<char> decompressedData(originalSize);
+            std::vector<BlockIndexEntry> index;
+            uint64_t originalSize = compressBlocks(input, inputFile, output, outputFile,
+                                                   resolveThreads(numThreads), blockSize, codec, level,
+                                                   sizeof(header), &index);
             
-            z_stream zs;
-            zs.zalloc = Z_NULL;
-            zs.zfree = Z_NULL;
-            zs.opaque = Z_NULL;
-            zs.avail_in = static_cast<uInt>(compressedData.size() - sizeof(originalSize));
-            zs.next_in = reinterpret_cast<Bytef*>(compressedData.data() + sizeof(originalSize));
-            zs.avail_out = static_cast<uInt>(originalSize);
-            zs.next_out = reinterpret_cast<Bytef*>(decompressedData.data());
+            BlockFileFooter footer{};
+            footer.index_offset = static_cast<uint64_t>(output.tellp());
+            footer.block_count = index.size();
+            footer.original_size = originalSize;
+            std::memcpy(footer.magic, BLOCK_FILE_MAGIC, sizeof(footer.magic));
+            writeChunk(output, reinterpret_cast<const char*>(index.data()),
+                       index.size() * sizeof(BlockIndexEntry), outputFile);
+            writeChunk(output, reinterpret_cast<const char*>(&footer), sizeof(footer), outputFile);
+            uint64_t compressedSize = static_cast<uint64_t>(output.tellp());
+            closeOutput(output, outputFile);
             
-            if (inflateInit(&zs) != Z_OK) {
-                throw std::runtime_error("inflateInit failed");
-            }
+            printCompressionSummary(originalSize, compressedSize);
             
-            // Perform decompression
-            if (inflate(&zs, Z_FINISH) != Z_STREAM_END) {
-                inflateEnd(&zs);
-                throw std::runtime_error("inflate failed");
-            }
+        } catch (const std::exception& e) {
+            throw std::runtime_error("Compression error: " + std::string(e.what()));
+        }
+    }
+    
+    // Reads length bytes at offset of the original data from a
+    // block-indexed file, inflating only the blocks that overlap the range
+    static std::string readRange(const std::string& inputFile, uint64_t offset, size_t length) {
+        try {
+            BlockIndexedReader reader(inputFile);
+            return reader.read(offset, length);
+        } catch (const std::exception& e) {
+            throw std::runtime_error("Read error: " + std::string(e.what()));
+        }
+    }
+    
+    // Accepts the size-prefixed zlib format, gzip (including the
+    // multi-member output of compressFileParallel) and block-indexed files;
+    // the latter are inflated on numThreads workers (0 = one per core)
+    static void decompressFile(const std::string& inputFile, const std::string& outputFile,
+                               size_t numThreads = 0) {
+        try {
+            std::ifstream input = openInput(inputFile);
             
-            inflateEnd(&zs);
+            char magic[sizeof(BLOCK_FILE_MAGIC)] = {};
+            input.read(magic, sizeof(magic));
+            bool gzip = input.gcount() >= 2 && static_cast<unsigned char>(magic[0]) == 0x1f &&
+                        static_cast<unsigned char>(magic[1]) == 0x8b;
+            bool indexed = input.gcount() == sizeof(magic) &&
+                           std::memcmp(magic, BLOCK_FILE_MAGIC, sizeof(magic)) == 0;
+            input.clear();
+            input.seekg(0);
             
-            // Write decompressed data
-            std::ofstream output(outputFile, std::ios::binary);
-            if (!output) {
-                throw std::runtime_error("Cannot open output file: " + outputFile);
+            uint64_t decompressedSize;
+            if (indexed) {
+                input.close();
+                std::ofstream output = openOutput(outputFile);
+                decompressedSize = inflateIndexed(inputFile, output, outputFile, resolveThreads(numThreads));
+                closeOutput(output, outputFile);
+            } else if (gzip) {
+                std::ofstream output = openOutput(outputFile);
+                decompressedSize = inflateStream(input, inputFile, output, outputFile, 15 + 16, true);
+                closeOutput(output, outputFile);
+            } else {
+                uint64_t originalSize;
+                if (!input.read(reinterpret_cast<char*>(&originalSize), sizeof(originalSize))) {
+                    throw std::runtime_error("Missing size header in " + inputFile);
+                }
+                std::ofstream output = openOutput(outputFile);
+                decompressedSize = inflateStream(input, inputFile, output, outputFile, 15, false);
+                if (decompressedSize != originalSize) {
+                    throw std::runtime_error("size mismatch: header says " + std::to_string(originalSize) +
+                                             " bytes, stream holds " + std::to_string(decompressedSize));
+                }
+                closeOutput(output, outputFile);
             }
             
-            output.write(decompressedData.data(), originalSize);
-            
             std::cout << "Decompression successful!\n"
-                      << "Decompressed size: " << originalSize << " bytes\n";
+                      << "Decompressed size: " << decompressedSize << " bytes\n";
             
         } catch (const std::exception& e) {
             throw std::runtime_error("Decompression error: " + std::string(e.what()));
@@ -134,25 +616,139 @@ public:
     }
 };
 
+static std::string codecList() {
+    std::string list;
+    for (const auto& name : availableCodecs()) {
+        list += (list.empty() ? "" : ", ") + name;
+    }
+    return list;
+}
+
+static void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [c/d/r] [options] input_file output_file\n"
+              << "  c - compress\n"
+              << "  d - decompress\n"
+              << "  r - read a byte range of a block-indexed file\n"
+              << "Options:\n"
+              << "  -f <format>    stream (default), gzip or indexed\n"
+              << "  -a <codec>     codec for indexed: " << codecList() << " (default zlib)\n"
+              << "  -l <level>     compression level (default 9 for zlib/gzip, else the codec's)\n"
+              << "  -p <profile>   fast, balanced or archive: pick codec and level for indexed\n"
+              << "  -t <threads>   workers for gzip/indexed (0 = all cores, the default);\n"
+              << "                 -t alone selects gzip\n"
+              << "  -b <KB>        block size for gzip/indexed (default "
+              << CompressionHandler::DEFAULT_BLOCK_SIZE / 1024 << ")\n"
+              << "  -o <offset>    first byte for r\n"
+              << "  -n <bytes>     number of bytes for r\n";
+}
+
 int main(int argc, char* argv[]) {
     try {
-        if (argc != 4) {
-            std::cout << "Usage: " << argv[0] << " [c/d] input_file output_file\n"
-                      << "  c - compress\n"
-                      << "  d - decompress\n";
+        if (argc < 4) {
+            printUsage(argv[0]);
             return 1;
         }
         
         std::string operation = argv[1];
-        std::string inputFile = argv[2];
-        std::string outputFile = argv[3];
+        std::string format;
+        std::string codecName;
+        std::string profile;
+        int level = -1;
+        size_t numThreads = 0;
+        size_t blockSize = CompressionHandler::DEFAULT_BLOCK_SIZE;
+        uint64_t offset = 0;
+        size_t length = 0;
+        int arg = 2;
+        while (arg < argc - 2) {
+            std::string option = argv[arg];
+            if (option == "-f") {
+                format = argv[arg + 1];
+            } else if (option == "-t") {
+                numThreads = std::stoul(argv[arg + 1]);
+                if (format.empty()) {
+                    format = "gzip";
+                }
+            } else if (option == "-a") {
+                codecName = argv[arg + 1];
+            } else if (option == "-l") {
+                level = std::stoi(argv[arg + 1]);
+            } else if (option == "-p") {
+                profile = argv[arg + 1];
+            } else if (option == "-b") {
+                blockSize = std::stoul(argv[arg + 1]) * 1024;
+            } else if (option == "-o") {
+                offset = std::stoull(argv[arg + 1]);
+            } else if (option == "-n") {
+                length = std::stoul(argv[arg + 1]);
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+            arg += 2;
+        }
+        if (arg != argc - 2) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        std::string inputFile = argv[arg];
+        std::string outputFile = argv[arg + 1];
         
         if (operation == "c") {
-            CompressionHandler::compressFile(inputFile, outputFile);
+            // Only the indexed format can carry a codec other than deflate
+            const Codec* codec = &getCodec(CodecType::ZLIB);
+            if (!profile.empty()) {
+                CompressionProfile p = profile == "fast"     ? CompressionProfile::FAST
+                                     : profile == "balanced" ? CompressionProfile::BALANCED
+                                     : profile == "archive"  ? CompressionProfile::ARCHIVE
+                                     : throw std::runtime_error("Unknown profile '" + profile + "'");
+                CodecChoice choice = recommendedCodec(p);
+                codec = choice.codec;
+                if (level < 0) {
+                    level = choice.level;
+                }
+                if (format.empty()) {
+                    format = "indexed";
+                }
+            }
+            if (!codecName.empty()) {
+                codec = &getCodec(codecName);
+                if (format.empty()) {
+                    format = "indexed";
+                }
+            }
+            bool deflate = codec->type() == CodecType::ZLIB || codec->type() == CodecType::GZIP;
+            if (format != "indexed" && !deflate) {
+                throw std::runtime_error(std::string("Codec '") + codec->name() + "' needs -f indexed");
+            }
+            if (level < 0) {
+                level = deflate ? CompressionHandler::COMPRESSION_LEVEL : codec->defaultLevel();
+            }
+            if (deflate && (level < 1 || level > 9)) {
+                throw std::runtime_error("zlib level must be between 1 and 9");
+            }
+            
+            if (format.empty() || format == "stream") {
+                CompressionHandler::compressFile(inputFile, outputFile, level);
+            } else if (format == "gzip") {
+                CompressionHandler::compressFileParallel(inputFile, outputFile, numThreads, blockSize, level);
+            } else if (format == "indexed") {
+                CompressionHandler::compressFileIndexed(inputFile, outputFile, numThreads, blockSize,
+                                                        *codec, level);
+            } else {
+                std::cerr << "Unknown format '" << format << "'. Use stream, gzip or indexed.\n";
+                return 1;
+            }
         } else if (operation == "d") {
-            CompressionHandler::decompressFile(inputFile, outputFile);
+            CompressionHandler::decompressFile(inputFile, outputFile, numThreads);
+        } else if (operation == "r") {
+            std::string range = CompressionHandler::readRange(inputFile, offset, length);
+            std::ofstream output(outputFile, std::ios::binary | std::ios::trunc);
+            if (!output.write(range.data(), static_cast<std::streamsize>(range.size()))) {
+                throw std::runtime_error("Error writing file: " + outputFile);
+            }
+            std::cout << "Read " << range.size() << " bytes at offset " << offset << "\n";
         } else {
-            std::cerr << "Invalid operation. Use 'c' for compression or 'd' for decompression.\n";
+            std::cerr << "Invalid operation. Use 'c' to compress, 'd' to decompress or 'r' to read a range.\n";
             return 1;
         }
         
@@ -162,4 +758,4 @@ int main(int argc, char* argv[]) {
     }
     
     return 0;
-}
\ No newline at end of file
+}
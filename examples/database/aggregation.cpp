@@ -0,0 +1,622 @@
+#include "aggregation.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+constexpr size_t BATCH_ROWS = 1024;
+constexpr size_t MORSEL_ROWS = 16384;         // Multiple of 64: morsels own whole bitmap words
+constexpr uint64_t DIRECT_MAX_GROUPS = 65536;  // Largest key domain aggregated without hashing
+constexpr uint32_t EMPTY_SLOT = UINT32_MAX;
+constexpr uint64_t NULL_KEY = UINT64_MAX;      // Key code of a NULL group key; no value codes to it
+
+std::string toLower(const std::string& str) {
+    std::string lower = str;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    return lower;
+}
+
+std::string toUpper(const std::string& str) {
+    std::string upper = str;
+    std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+    return upper;
+}
+
+inline uint64_t mixHash(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+// Parses "FUNC(arg)"; returns false if the item is not an aggregate call
+bool parseAggregateCall(const std::string& item, AggregateFunction& function, std::string& argument) {
+    size_t open = item.find('(');
+    if (open == std::string::npos || item.back() != ')') {
+        return false;
+    }
+
+    std::string name = toLower(item.substr(0, open));
+    if (name == "count") {
+        function = AggregateFunction::COUNT;
+    } else if (name == "sum") {
+        function = AggregateFunction::SUM;
+    } else if (name == "avg") {
+        function = AggregateFunction::AVG;
+    } else if (name == "min") {
+        function = AggregateFunction::MIN;
+    } else if (name == "max") {
+        function = AggregateFunction::MAX;
+    } else {
+        return false;
+    }
+
+    argument = item.substr(open + 1, item.length() - open - 2);
+    return true;
+}
+
+// Group keys as 64-bit codes: equal values give equal codes, and NULLs
+// form one group of their own
+inline uint64_t keyCode(const ColumnVector& column, size_t row) {
+    if (column.isNull(row)) {
+        return NULL_KEY;
+    }
+    switch (column.getType()) {
+        case ColumnType::INT:
+            return static_cast<uint32_t>(column.intData()[row]);
+        case ColumnType::DOUBLE: {
+            double value = column.doubleData()[row];
+            if (value == 0.0) {
+                value = 0.0;  // Fold -0.0 into 0.0
+            }
+            uint64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            return bits;
+        }
+        case ColumnType::BOOL:
+            return column.boolData()[row];
+        case ColumnType::STRING:
+            return column.stringCodes()[row];
+    }
+    return 0;
+}
+
+// NULL_KEY gives the type's default value; the caller flags it NULL
+Value keyValue(const ColumnVector& column, uint64_t code) {
+    if (code == NULL_KEY) {
+        if (column.getType() == ColumnType::STRING) {
+            return std::string();
+        }
+        code = 0;
+    }
+    switch (column.getType()) {
+        case ColumnType::INT:
+            return static_cast<int>(static_cast<uint32_t>(code));
+        case ColumnType::DOUBLE: {
+            double value;
+            std::memcpy(&value, &code, sizeof(value));
+            return value;
+        }
+        case ColumnType::BOOL:
+            return code != 0;
+        case ColumnType::STRING:
+            return std::string(column.getDictionary().lookup(static_cast<uint32_t>(code)));
+    }
+    return Value();
+}
+
+// Open-addressing map from a tuple of key codes to a dense group id
+class GroupTable {
+private:
+    size_t key_width;
+    std::vector<uint64_t> keys;    // key_width codes per group
+    std::vector<uint32_t> slots;   // Group id or EMPTY_SLOT
+    size_t num_groups;
+
+    uint64_t hashKey(const uint64_t* key) const {
+        uint64_t hash = 0x9e3779b97f4a7c15ULL;
+        for (size_t i = 0; i < key_width; ++i) {
+            hash = mixHash(hash ^ key[i]);
+        }
+        return hash;
+    }
+
+    void grow() {
+        std::vector<uint32_t> bigger(slots.size() * 2, EMPTY_SLOT);
+        size_t mask = bigger.size() - 1;
+        for (size_t gid = 0; gid < num_groups; ++gid) {
+            size_t pos = hashKey(&keys[gid * key_width]) & mask;
+            while (bigger[pos] != EMPTY_SLOT) {
+                pos = (pos + 1) & mask;
+            }
+            bigger[pos] = static_cast<uint32_t>(gid);
+        }
+        slots.swap(bigger);
+    }
+
+public:
+    explicit GroupTable(size_t width) : key_width(width), slots(1024, EMPTY_SLOT), num_groups(0) {}
+
+    uint32_t findOrInsert(const uint64_t* key) {
+        if ((num_groups + 1) * 2 > slots.size()) {
+            grow();
+        }
+
+        size_t mask = slots.size() - 1;
+        size_t pos = hashKey(key) & mask;
+        while (true) {
+            uint32_t gid = slots[pos];
+            if (gid == EMPTY_SLOT) {
+                slots[pos] = static_cast<uint32_t>(num_groups);
+                keys.insert(keys.end(), key, key + key_width);
+                return static_cast<uint32_t>(num_groups++);
+            }
+            if (std::equal(key, key + key_width, &keys[gid * key_width])) {
+                return gid;
+            }
+            pos = (pos + 1) & mask;
+        }
+    }
+
+    size_t size() const { return num_groups; }
+    const uint64_t* key(size_t gid) const { return &keys[gid * key_width]; }
+};
+
+struct AggregateState {
+    std::vector<double> values;      // Running SUM, or MIN/MAX of numeric input
+    std::vector<uint32_t> codes;     // MIN/MAX of string input (dictionary codes)
+    std::vector<uint8_t> has_value;  // MIN/MAX: group has seen a value
+    std::vector<int64_t> counts;     // Non-NULL input rows, for COUNT(col) and AVG
+};
+
+// Thread-local aggregation result for the morsels one worker processed
+struct PartialAggregate {
+    GroupTable groups;
+    std::vector<int64_t> row_counts;
+    std::vector<AggregateState> states;
+
+    PartialAggregate(size_t key_width, size_t num_aggregates)
+        : groups(key_width), states(num_aggregates) {}
+
+    void ensureGroups(size_t num_groups) {
+        if (row_counts.size() >= num_groups) {
+            return;
+        }
+        size_t capacity = std::max(num_groups, row_counts.size() * 2);
+        row_counts.resize(capacity, 0);
+        for (auto& state : states) {
+            state.values.resize(capacity, 0.0);
+            state.codes.resize(capacity, 0);
+            state.has_value.resize(capacity, 0);
+            state.counts.resize(capacity, 0);
+        }
+    }
+};
+
+template <typename T>
+void updateNumeric(AggregateFunction function, const T* data, const uint32_t* rows,
+                   const uint32_t* gids, size_t n, AggregateState& state) {
+    double* values = state.values.data();
+    uint8_t* has_value = state.has_value.data();
+
+    switch (function) {
+        case AggregateFunction::SUM:
+        case AggregateFunction::AVG:
+            for (size_t i = 0; i < n; ++i) {
+                values[gids[i]] += data[rows[i]];
+            }
+            break;
+        case AggregateFunction::MIN:
+            for (size_t i = 0; i < n; ++i) {
+                double v = data[rows[i]];
+                if (!has_value[gids[i]] || v < values[gids[i]]) {
+                    values[gids[i]] = v;
+                    has_value[gids[i]] = 1;
+                }
+            }
+            break;
+        case AggregateFunction::MAX:
+            for (size_t i = 0; i < n; ++i) {
+                double v = data[rows[i]];
+                if (!has_value[gids[i]] || v > values[gids[i]]) {
+                    values[gids[i]] = v;
+                    has_value[gids[i]] = 1;
+                }
+            }
+            break;
+        case AggregateFunction::COUNT:
+            break;  // Derived from row_counts
+    }
+}
+
+void updateString(AggregateFunction function, const ColumnVector& column, const uint32_t* rows,
+                  const uint32_t* gids, size_t n, AggregateState& state) {
+    const uint32_t* data = column.stringCodes();
+    const StringDictionary& dictionary = column.getDictionary();
+    bool want_min = function == AggregateFunction::MIN;
+
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t gid = gids[i];
+        uint32_t code = data[rows[i]];
+        if (!state.has_value[gid]) {
+            state.codes[gid] = code;
+            state.has_value[gid] = 1;
+        } else if (code != state.codes[gid]) {
+            bool less = dictionary.lookup(code) < dictionary.lookup(state.codes[gid]);
+            if (less == want_min) {
+                state.codes[gid] = code;
+            }
+        }
+    }
+}
+
+} // namespace
+
+bool AggregatePlan::isAggregateQuery(const std::vector<std::string>& select_items,
+                                     const std::vector<std::string>& group_by) {
+    if (!group_by.empty()) {
+        return true;
+    }
+    AggregateFunction function;
+    std::string argument;
+    for (const auto& item : select_items) {
+        if (parseAggregateCall(item, function, argument)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+AggregatePlan AggregatePlan::compile(const std::vector<std::string>& select_items,
+                                     const std::vector<std::string>& group_by,
+                                     const Table& table) {
+    AggregatePlan plan;
+    for (const auto& name : group_by) {
+        plan.group_columns.push_back(table.getColumnIndex(name));
+    }
+
+    if (select_items.empty()) {
+        throw std::runtime_error("SELECT * cannot be combined with GROUP BY or aggregates");
+    }
+
+    for (const auto& item : select_items) {
+        AggregateFunction function;
+        std::string argument;
+
+        if (!parseAggregateCall(item, function, argument)) {
+            // Plain columns must be grouping keys
+            auto it = std::find(group_by.begin(), group_by.end(), item);
+            if (it == group_by.end()) {
+                throw std::runtime_error("Column '" + item + "' must appear in GROUP BY or be aggregated");
+            }
+            plan.outputs.push_back({true, static_cast<size_t>(it - group_by.begin())});
+            continue;
+        }
+
+        AggregateSpec spec;
+        spec.function = function;
+        spec.count_star = (argument == "*");
+        spec.column_index = 0;
+        spec.input_type = ColumnType::INT;
+        spec.label = toUpper(item.substr(0, item.find('('))) + "(" + argument + ")";
+
+        if (spec.count_star) {
+            if (function != AggregateFunction::COUNT) {
+                throw std::runtime_error("Only COUNT accepts '*'");
+            }
+        } else {
+            spec.column_index = table.getColumnIndex(argument);
+            spec.input_type = table.getColumnData(spec.column_index).getType();
+            if (spec.input_type == ColumnType::STRING &&
+                (function == AggregateFunction::SUM || function == AggregateFunction::AVG)) {
+                throw std::runtime_error(spec.label + " requires a numeric column");
+            }
+        }
+
+        plan.outputs.push_back({false, plan.aggregates.size()});
+        plan.aggregates.push_back(spec);
+    }
+
+    return plan;
+}
+
+std::vector<size_t> AggregatePlan::inputColumns() const {
+    std::vector<size_t> columns = group_columns;
+    for (const auto& spec : aggregates) {
+        if (!spec.count_star) {
+            columns.push_back(spec.column_index);
+        }
+    }
+    std::sort(columns.begin(), columns.end());
+    columns.erase(std::unique(columns.begin(), columns.end()), columns.end());
+    return columns;
+}
+
+Table AggregatePlan::execute(const Table& table, const SelectionBitmap& selection, ThreadPool* pool) const {
+    std::vector<const ColumnVector*> key_columns;
+    for (size_t col : group_columns) {
+        key_columns.push_back(&table.getColumnData(col));
+    }
+
+    // A single key from a small domain is used as the group id directly;
+    // a key with NULLs is hashed, as NULL falls outside the domain
+    bool direct = false;
+    uint64_t direct_base = 0;
+    uint64_t direct_groups = 0;
+    if (key_columns.empty()) {
+        direct = true;
+        direct_groups = 1;
+    } else if (key_columns.size() == 1 && !key_columns[0]->hasNulls()) {
+        const ColumnVector& key = *key_columns[0];
+        if (key.getType() == ColumnType::BOOL) {
+            direct = true;
+            direct_groups = 2;
+        } else if (key.getType() == ColumnType::STRING) {
+            direct = key.getDictionary().size() <= DIRECT_MAX_GROUPS;
+            direct_groups = key.getDictionary().size();
+        } else if (key.getType() == ColumnType::INT && key.size() > 0) {
+            auto [min_it, max_it] = std::minmax_element(key.intData(), key.intData() + key.size());
+            uint64_t range = static_cast<uint64_t>(int64_t(*max_it) - int64_t(*min_it)) + 1;
+            if (range <= DIRECT_MAX_GROUPS) {
+                direct = true;
+                direct_base = static_cast<uint32_t>(*min_it);
+                direct_groups = range;
+            }
+        }
+    }
+
+    auto process_batch = [&](const uint32_t* rows, size_t n, PartialAggregate& partial) {
+        uint32_t gids[BATCH_ROWS];
+
+        // Resolve group ids for the whole batch first...
+        if (key_columns.empty()) {
+            std::fill(gids, gids + n, 0);
+        } else if (direct) {
+            for (size_t i = 0; i < n; ++i) {
+                gids[i] = static_cast<uint32_t>(keyCode(*key_columns[0], rows[i]) - direct_base);
+            }
+        } else {
+            uint64_t key[16];
+            std::vector<uint64_t> wide_key(key_columns.size());
+            uint64_t* key_buffer = key_columns.size() <= 16 ? key : wide_key.data();
+            for (size_t i = 0; i < n; ++i) {
+                for (size_t c = 0; c < key_columns.size(); ++c) {
+                    key_buffer[c] = keyCode(*key_columns[c], rows[i]);
+                }
+                gids[i] = partial.groups.findOrInsert(key_buffer);
+            }
+            partial.ensureGroups(partial.groups.size());
+        }
+
+        // ...then update each aggregate column-at-a-time
+        for (size_t i = 0; i < n; ++i) {
+            partial.row_counts[gids[i]]++;
+        }
+
+        uint32_t kept_rows[BATCH_ROWS];
+        uint32_t kept_gids[BATCH_ROWS];
+        for (size_t a = 0; a < aggregates.size(); ++a) {
+            const AggregateSpec& spec = aggregates[a];
+            if (spec.count_star) {
+                continue;
+            }
+            const ColumnVector& column = table.getColumnData(spec.column_index);
+            AggregateState& state = partial.states[a];
+
+            // NULL inputs are skipped
+            const uint32_t* input_rows = rows;
+            const uint32_t* input_gids = gids;
+            size_t kept = n;
+            if (column.hasNulls()) {
+                kept = 0;
+                for (size_t i = 0; i < n; ++i) {
+                    if (!column.isNull(rows[i])) {
+                        kept_rows[kept] = rows[i];
+                        kept_gids[kept++] = gids[i];
+                    }
+                }
+                input_rows = kept_rows;
+                input_gids = kept_gids;
+            }
+            for (size_t i = 0; i < kept; ++i) {
+                state.counts[input_gids[i]]++;
+            }
+            if (spec.function == AggregateFunction::COUNT) {
+                continue;
+            }
+
+            switch (spec.input_type) {
+                case ColumnType::INT:
+                    updateNumeric(spec.function, column.intData(), input_rows, input_gids, kept, state);
+                    break;
+                case ColumnType::DOUBLE:
+                    updateNumeric(spec.function, column.doubleData(), input_rows, input_gids, kept, state);
+                    break;
+                case ColumnType::BOOL:
+                    updateNumeric(spec.function, column.boolData(), input_rows, input_gids, kept, state);
+                    break;
+                case ColumnType::STRING:
+                    updateString(spec.function, column, input_rows, input_gids, kept, state);
+                    break;
+            }
+        }
+    };
+
+    auto process_morsel = [&](size_t morsel, PartialAggregate& partial) {
+        size_t begin_word = morsel * MORSEL_ROWS / 64;
+        size_t end_word = std::min(selection.wordCount(), (morsel + 1) * MORSEL_ROWS / 64);
+        const uint64_t* words = selection.data();
+
+        uint32_t rows[BATCH_ROWS];
+        size_t n = 0;
+        for (size_t w = begin_word; w < end_word; ++w) {
+            uint64_t word = words[w];
+            while (word) {
+                rows[n++] = static_cast<uint32_t>(w * 64 + __builtin_ctzll(word));
+                word &= word - 1;
+                if (n == BATCH_ROWS) {
+                    process_batch(rows, n, partial);
+                    n = 0;
+                }
+            }
+        }
+        if (n > 0) {
+            process_batch(rows, n, partial);
+        }
+    };
+
+    size_t num_workers = pool ? pool->size() : 1;
+    std::vector<PartialAggregate> partials;
+    for (size_t w = 0; w < num_workers; ++w) {
+        partials.emplace_back(key_columns.size(), aggregates.size());
+        if (direct) {
+            partials.back().ensureGroups(direct_groups);
+        }
+    }
+
+    size_t num_morsels = (table.size() + MORSEL_ROWS - 1) / MORSEL_ROWS;
+    if (pool && num_workers > 1 && num_morsels > 1) {
+        pool->parallelFor(num_morsels, [&](size_t morsel, size_t worker) {
+            process_morsel(morsel, partials[worker]);
+        });
+    } else {
+        for (size_t morsel = 0; morsel < num_morsels; ++morsel) {
+            process_morsel(morsel, partials[0]);
+        }
+    }
+
+    // Merge the per-worker partials into the first one
+    PartialAggregate& result = partials[0];
+    auto combine = [&](size_t into, const PartialAggregate& other, size_t from) {
+        result.row_counts[into] += other.row_counts[from];
+        for (size_t a = 0; a < aggregates.size(); ++a) {
+            const AggregateSpec& spec = aggregates[a];
+            AggregateState& target = result.states[a];
+            const AggregateState& source = other.states[a];
+            target.counts[into] += source.counts[from];
+            if (spec.function == AggregateFunction::SUM || spec.function == AggregateFunction::AVG) {
+                target.values[into] += source.values[from];
+            } else if (spec.function == AggregateFunction::MIN || spec.function == AggregateFunction::MAX) {
+                if (!source.has_value[from]) {
+                    continue;
+                }
+                bool replace = !target.has_value[into];
+                if (!replace && spec.input_type == ColumnType::STRING) {
+                    const StringDictionary& dictionary = table.getColumnData(spec.column_index).getDictionary();
+                    bool less = dictionary.lookup(source.codes[from]) < dictionary.lookup(target.codes[into]);
+                    replace = (less == (spec.function == AggregateFunction::MIN)) &&
+                              source.codes[from] != target.codes[into];
+                } else if (!replace) {
+                    replace = spec.function == AggregateFunction::MIN ? source.values[from] < target.values[into]
+                                                                     : source.values[from] > target.values[into];
+                }
+                if (replace) {
+                    target.values[into] = source.values[from];
+                    target.codes[into] = source.codes[from];
+                    target.has_value[into] = 1;
+                }
+            }
+        }
+    };
+
+    for (size_t w = 1; w < partials.size(); ++w) {
+        const PartialAggregate& other = partials[w];
+        if (direct) {
+            for (size_t g = 0; g < direct_groups; ++g) {
+                if (other.row_counts[g] > 0) {
+                    combine(g, other, g);
+                }
+            }
+        } else {
+            for (size_t g = 0; g < other.groups.size(); ++g) {
+                size_t into = result.groups.findOrInsert(other.groups.key(g));
+                result.ensureGroups(result.groups.size());
+                combine(into, other, g);
+            }
+        }
+    }
+
+    // Build the result table
+    Table output("result");
+    for (const auto& out : outputs) {
+        if (out.is_group_key) {
+            const Column& column = table.getColumns()[group_columns[out.index]];
+            output.addColumn(column.name, column.type);
+        } else {
+            const AggregateSpec& spec = aggregates[out.index];
+            if (spec.function == AggregateFunction::COUNT) {
+                output.addColumn(spec.label, "int");
+            } else if (spec.function == AggregateFunction::SUM || spec.function == AggregateFunction::AVG) {
+                output.addColumn(spec.label, "double");
+            } else {
+                output.addColumn(spec.label, table.getColumns()[spec.column_index].type);
+            }
+        }
+    }
+
+    size_t num_groups = direct ? direct_groups : result.groups.size();
+    for (size_t g = 0; g < num_groups; ++g) {
+        // Without GROUP BY there is always exactly one output row
+        if (result.row_counts[g] == 0 && !key_columns.empty()) {
+            continue;
+        }
+
+        Row row;
+        std::vector<size_t> null_columns;  // NULL keys, and aggregates over no values
+        for (const auto& out : outputs) {
+            if (out.is_group_key) {
+                uint64_t code = direct ? static_cast<uint32_t>(g + direct_base) : result.groups.key(g)[out.index];
+                if (code == NULL_KEY) {
+                    null_columns.push_back(row.size());
+                }
+                row.push_back(keyValue(*key_columns[out.index], code));
+                continue;
+            }
+
+            const AggregateSpec& spec = aggregates[out.index];
+            const AggregateState& state = result.states[out.index];
+            int64_t count = spec.count_star ? result.row_counts[g] : state.counts[g];
+            switch (spec.function) {
+                case AggregateFunction::COUNT:
+                    row.push_back(static_cast<int>(count));
+                    break;
+                case AggregateFunction::SUM:
+                    row.push_back(state.values[g]);
+                    if (count == 0) null_columns.push_back(row.size() - 1);
+                    break;
+                case AggregateFunction::AVG:
+                    row.push_back(count > 0 ? state.values[g] / count : 0.0);
+                    if (count == 0) null_columns.push_back(row.size() - 1);
+                    break;
+                case AggregateFunction::MIN:
+                case AggregateFunction::MAX:
+                    if (!state.has_value[g]) {
+                        null_columns.push_back(row.size());
+                    }
+                    if (spec.input_type == ColumnType::STRING) {
+                        const ColumnVector& column = table.getColumnData(spec.column_index);
+                        row.push_back(state.has_value[g] ? std::string(column.getDictionary().lookup(state.codes[g]))
+                                                         : std::string());
+                    } else if (spec.input_type == ColumnType::INT) {
+                        row.push_back(static_cast<int>(state.values[g]));
+                    } else if (spec.input_type == ColumnType::BOOL) {
+                        row.push_back(state.values[g] != 0.0);
+                    } else {
+                        row.push_back(state.values[g]);
+                    }
+                    break;
+            }
+        }
+        output.insertRow(row);
+        for (size_t column : null_columns) {
+            output.setNull(output.size() - 1, column);
+        }
+    }
+
+    return output;
+}
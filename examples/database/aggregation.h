@@ -0,0 +1,62 @@
+#pragma once
+
+#include "table.h"
+#include "selection_bitmap.h"
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+enum class AggregateFunction {
+    COUNT,
+    SUM,
+    AVG,
+    MIN,
+    MAX
+};
+
+// One aggregate call from the select list, e.g. SUM(salary)
+struct AggregateSpec {
+    AggregateFunction function;
+    bool count_star;       // COUNT(*): no input column
+    size_t column_index;
+    ColumnType input_type;
+    std::string label;     // Output column name
+};
+
+// A GROUP BY / aggregate query compiled against a table schema.
+// Execution is a hash aggregation over batches of selected rows: group
+// keys are packed into 64-bit codes (dictionary codes for strings), a
+// batch of group ids is resolved first, then each aggregate is updated
+// column-at-a-time. A single int/bool/string key with a small domain
+// skips hashing and indexes groups directly by key.
+// As in SQL, SUM, AVG, MIN and MAX skip NULL inputs and yield NULL for a
+// group with no non-NULL values; COUNT(col) counts non-NULL values and
+// COUNT(*) counts rows.
+class AggregatePlan {
+public:
+    // True if the select list contains an aggregate call or a GROUP BY is given
+    static bool isAggregateQuery(const std::vector<std::string>& select_items,
+                                 const std::vector<std::string>& group_by);
+
+    static AggregatePlan compile(const std::vector<std::string>& select_items,
+                                 const std::vector<std::string>& group_by,
+                                 const Table& table);
+
+    // Aggregates the selected rows; returns one row per group with the
+    // columns in select-list order
+    Table execute(const Table& table, const SelectionBitmap& selection, ThreadPool* pool = nullptr) const;
+
+    // Table columns execute() reads: the group keys and aggregate inputs
+    std::vector<size_t> inputColumns() const;
+
+private:
+    struct OutputColumn {
+        bool is_group_key;
+        size_t index;      // Into group_columns or aggregates
+    };
+
+    std::vector<size_t> group_columns;
+    std::vector<AggregateSpec> aggregates;
+    std::vector<OutputColumn> outputs;
+};
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <tuple>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+// Insert-only B+-tree mapping keys to row ids, duplicates allowed.
+// Nodes live in one vector and hold their keys inline in fixed-size
+// arrays, so a lookup touches one contiguous block per level. Leaves are
+// chained left to right for range scans.
+template <typename Key>
+class BPlusTree {
+private:
+    static constexpr size_t NODE_CAPACITY = 64;
+    static constexpr uint32_t NO_NODE = UINT32_MAX;
+
+    // Arrays have one spare slot: a node is allowed to overflow by one
+    // entry and is split right after the insert that overflowed it
+    struct Node {
+        bool leaf;
+        uint32_t count;                      // Number of keys
+        uint32_t next;                       // Next leaf (leaves only)
+        Key keys[NODE_CAPACITY + 1];
+        uint32_t values[NODE_CAPACITY + 2];  // Row ids (leaf) or child node ids
+    };
+
+    struct Split {
+        bool happened;
+        Key separator;
+        uint32_t right;
+    };
+
+    std::vector<Node> nodes;
+    uint32_t root;
+    size_t entry_count;
+
+    uint32_t newNode(bool leaf) {
+        nodes.emplace_back();
+        Node& node = nodes.back();
+        node.leaf = leaf;
+        node.count = 0;
+        node.next = NO_NODE;
+        return static_cast<uint32_t>(nodes.size() - 1);
+    }
+
+    Split insertInto(uint32_t node_id, const Key& key, uint32_t row) {
+        if (nodes[node_id].leaf) {
+            Node& leaf = nodes[node_id];
+            // upper_bound keeps duplicates in insertion order
+            size_t pos = std::upper_bound(leaf.keys, leaf.keys + leaf.count, key) - leaf.keys;
+            std::move_backward(leaf.keys + pos, leaf.keys + leaf.count, leaf.keys + leaf.count + 1);
+            std::move_backward(leaf.values + pos, leaf.values + leaf.count, leaf.values + leaf.count + 1);
+            leaf.keys[pos] = key;
+            leaf.values[pos] = row;
+            leaf.count++;
+
+            if (leaf.count <= NODE_CAPACITY) {
+                return {false, Key(), NO_NODE};
+            }
+            return splitLeaf(node_id);
+        }
+
+        size_t child_pos;
+        {
+            const Node& inner = nodes[node_id];
+            child_pos = std::upper_bound(inner.keys, inner.keys + inner.count, key) - inner.keys;
+        }
+        Split child_split = insertInto(nodes[node_id].values[child_pos], key, row);
+        if (!child_split.happened) {
+            return child_split;
+        }
+
+        // Re-fetch: the recursive call may have grown the node vector
+        Node& inner = nodes[node_id];
+        std::move_backward(inner.keys + child_pos, inner.keys + inner.count, inner.keys + inner.count + 1);
+        std::move_backward(inner.values + child_pos + 1, inner.values + inner.count + 1,
+                           inner.values + inner.count + 2);
+        inner.keys[child_pos] = child_split.separator;
+        inner.values[child_pos + 1] = child_split.right;
+        inner.count++;
+
+        if (inner.count <= NODE_CAPACITY) {
+            return {false, Key(), NO_NODE};
+        }
+        return splitInner(node_id);
+    }
+
+    Split splitLeaf(uint32_t node_id) {
+        uint32_t right_id = newNode(true);
+        Node& left = nodes[node_id];
+        Node& right = nodes[right_id];
+
+        uint32_t keep = left.count / 2;
+        right.count = left.count - keep;
+        std::copy(left.keys + keep, left.keys + left.count, right.keys);
+        std::copy(left.values + keep, left.values + left.count, right.values);
+        left.count = keep;
+
+        right.next = left.next;
+        left.next = right_id;
+        return {true, right.keys[0], right_id};
+    }
+
+    Split splitInner(uint32_t node_id) {
+        uint32_t right_id = newNode(false);
+        Node& left = nodes[node_id];
+        Node& right = nodes[right_id];
+
+        // The middle key moves up; it is not kept in either half
+        uint32_t mid = left.count / 2;
+        Key separator = left.keys[mid];
+        right.count = left.count - mid - 1;
+        std::copy(left.keys + mid + 1, left.keys + left.count, right.keys);
+        std::copy(left.values + mid + 1, left.values + left.count + 1, right.values);
+        left.count = mid;
+        return {true, separator, right_id};
+    }
+
+    // First leaf position whose key is >= key
+    std::pair<uint32_t, size_t> lowerBound(const Key& key) const {
+        uint32_t node_id = root;
+        while (!nodes[node_id].leaf) {
+            const Node& inner = nodes[node_id];
+            size_t child_pos = std::lower_bound(inner.keys, inner.keys + inner.count, key) - inner.keys;
+            node_id = inner.values[child_pos];
+        }
+        const Node& leaf = nodes[node_id];
+        return {node_id, static_cast<size_t>(std::lower_bound(leaf.keys, leaf.keys + leaf.count, key) - leaf.keys)};
+    }
+
+public:
+    BPlusTree() : entry_count(0) {
+        root = newNode(true);
+    }
+
+    void insert(const Key& key, uint32_t row) {
+        Split split = insertInto(root, key, row);
+        if (split.happened) {
+            uint32_t new_root = newNode(false);
+            Node& node = nodes[new_root];
+            node.count = 1;
+            node.keys[0] = split.separator;
+            node.values[0] = root;
+            node.values[1] = split.right;
+            root = new_root;
+        }
+        entry_count++;
+    }
+
+    // Calls fn(row) for every entry with low <(=) key <(=) high in key order.
+    // A null bound is unbounded. Stops early if fn returns false.
+    template <typename Fn>
+    void scan(const Key* low, bool low_inclusive, const Key* high, bool high_inclusive, Fn&& fn) const {
+        uint32_t node_id;
+        size_t pos;
+        if (low) {
+            std::tie(node_id, pos) = lowerBound(*low);
+        } else {
+            node_id = root;
+            while (!nodes[node_id].leaf) {
+                node_id = nodes[node_id].values[0];
+            }
+            pos = 0;
+        }
+
+        while (node_id != NO_NODE) {
+            const Node& leaf = nodes[node_id];
+            for (; pos < leaf.count; ++pos) {
+                const Key& key = leaf.keys[pos];
+                if (low && !low_inclusive && !(*low < key)) {
+                    continue;
+                }
+                if (high && (high_inclusive ? *high < key : !(key < *high))) {
+                    return;
+                }
+                if (!fn(leaf.values[pos])) {
+                    return;
+                }
+            }
+            node_id = leaf.next;
+            pos = 0;
+        }
+    }
+
+    size_t size() const { return entry_count; }
+};
@@ -0,0 +1,418 @@
+#include "column_store.h"
+#include <stdexcept>
+#include <charconv>
+#include <cctype>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+ColumnType columnTypeFromString(const std::string& type) {
+    if (type == "int") {
+        return ColumnType::INT;
+    } else if (type == "double") {
+        return ColumnType::DOUBLE;
+    } else if (type == "bool") {
+        return ColumnType::BOOL;
+    }
+    return ColumnType::STRING;  // Unknown types are stored as strings
+}
+
+StringDictionary::StringDictionary(const StringDictionary& other)
+    : strings(other.strings), mapped_offsets(other.mapped_offsets), mapped_blob(other.mapped_blob),
+      mapped_sorted(other.mapped_sorted), mapped_count(other.mapped_count) {
+    codes.reserve(strings.size());
+    for (uint32_t code = 0; code < strings.size(); ++code) {
+        codes.emplace(strings[code], code);
+    }
+}
+
+StringDictionary& StringDictionary::operator=(const StringDictionary& other) {
+    if (this != &other) {
+        *this = StringDictionary(other);
+    }
+    return *this;
+}
+
+void StringDictionary::attachMapped(const uint64_t* offsets, const char* blob,
+                                    const uint32_t* sorted, size_t count) {
+    strings.clear();
+    codes.clear();
+    mapped_offsets = offsets;
+    mapped_blob = blob;
+    mapped_sorted = sorted;
+    mapped_count = count;
+}
+
+void StringDictionary::materialize() {
+    if (!mapped_offsets) {
+        return;
+    }
+    size_t count = mapped_count;
+    for (uint32_t code = 0; code < count; ++code) {
+        strings.emplace_back(lookup(code));
+    }
+    mapped_offsets = nullptr;
+    mapped_blob = nullptr;
+    mapped_sorted = nullptr;
+    mapped_count = 0;
+    for (uint32_t code = 0; code < strings.size(); ++code) {
+        codes.emplace(strings[code], code);
+    }
+}
+
+uint32_t StringDictionary::intern(std::string_view value) {
+    materialize();
+    auto it = codes.find(value);
+    if (it != codes.end()) {
+        return it->second;
+    }
+
+    uint32_t code = static_cast<uint32_t>(strings.size());
+    strings.emplace_back(value);
+    codes.emplace(strings.back(), code);
+    return code;
+}
+
+bool StringDictionary::find(std::string_view value, uint32_t& code) const {
+    if (mapped_offsets) {
+        const uint32_t* end = mapped_sorted + mapped_count;
+        const uint32_t* it = std::lower_bound(mapped_sorted, end, value, [this](uint32_t c, std::string_view v) {
+            return lookup(c) < v;
+        });
+        if (it == end || lookup(*it) != value) {
+            return false;
+        }
+        code = *it;
+        return true;
+    }
+
+    auto it = codes.find(value);
+    if (it == codes.end()) {
+        return false;
+    }
+    code = it->second;
+    return true;
+}
+
+size_t ColumnVector::size() const {
+    if (mapped_data) {
+        return mapped_rows;
+    }
+    switch (type) {
+        case ColumnType::INT:    return int_values.size();
+        case ColumnType::DOUBLE: return double_values.size();
+        case ColumnType::BOOL:   return bool_values.size();
+        case ColumnType::STRING: return string_codes.size();
+    }
+    return 0;
+}
+
+void ColumnVector::materialize() {
+    if (!mapped_data) {
+        return;
+    }
+    switch (type) {
+        case ColumnType::INT:    int_values.assign(intData(), intData() + mapped_rows); break;
+        case ColumnType::DOUBLE: double_values.assign(doubleData(), doubleData() + mapped_rows); break;
+        case ColumnType::BOOL:   bool_values.assign(boolData(), boolData() + mapped_rows); break;
+        case ColumnType::STRING:
+            string_codes.assign(stringCodes(), stringCodes() + mapped_rows);
+            dictionary.materialize();
+            break;
+    }
+    mapped_data = nullptr;
+    mapped_rows = 0;
+    mapping.reset();
+}
+
+void ColumnVector::attachMapped(const void* data, size_t rows, std::shared_ptr<const void> keep_alive) {
+    int_values.clear();
+    double_values.clear();
+    bool_values.clear();
+    string_codes.clear();
+    mapped_data = data;
+    mapped_rows = rows;
+    mapping = std::move(keep_alive);
+}
+
+void ColumnVector::attachMappedDictionary(const uint64_t* offsets, const char* blob,
+                                          const uint32_t* sorted, size_t count) {
+    dictionary.attachMapped(offsets, blob, sorted, count);
+}
+
+void ColumnVector::setZoneMaps(std::vector<double> min, std::vector<double> max, size_t covered_rows) {
+    zone_min = std::move(min);
+    zone_max = std::move(max);
+    zone_rows_covered = covered_rows;
+}
+
+void ColumnVector::computeZoneMaps(const ColumnVector& column, std::vector<double>& min, std::vector<double>& max) {
+    min.clear();
+    max.clear();
+    if (column.type != ColumnType::INT && column.type != ColumnType::DOUBLE) {
+        return;  // Bool zones would rarely prune; string codes carry no order
+    }
+
+    size_t rows = column.size();
+    for (size_t begin = 0; begin < rows; begin += ZONE_ROWS) {
+        size_t end = std::min(rows, begin + ZONE_ROWS);
+        double lo = std::numeric_limits<double>::infinity();
+        double hi = -lo;
+        if (column.type == ColumnType::INT) {
+            auto [min_it, max_it] = std::minmax_element(column.intData() + begin, column.intData() + end);
+            lo = *min_it;
+            hi = *max_it;
+        } else {
+            const double* data = column.doubleData();
+            for (size_t row = begin; row < end; ++row) {
+                if (std::isnan(data[row])) {
+                    lo = -std::numeric_limits<double>::infinity();
+                    hi = std::numeric_limits<double>::infinity();
+                    break;
+                }
+                lo = std::min(lo, data[row]);
+                hi = std::max(hi, data[row]);
+            }
+        }
+        min.push_back(lo);
+        max.push_back(hi);
+    }
+}
+
+bool ColumnVector::zoneRange(size_t begin, size_t count, double& min, double& max) const {
+    size_t zone = begin / ZONE_ROWS;
+    if (zone >= zone_min.size() || begin + count > std::min((zone + 1) * ZONE_ROWS, zone_rows_covered)) {
+        return false;
+    }
+    min = zone_min[zone];
+    max = zone_max[zone];
+    return true;
+}
+
+void ColumnVector::reserve(size_t capacity) {
+    materialize();
+    switch (type) {
+        case ColumnType::INT:    int_values.reserve(capacity); break;
+        case ColumnType::DOUBLE: double_values.reserve(capacity); break;
+        case ColumnType::BOOL:   bool_values.reserve(capacity); break;
+        case ColumnType::STRING: string_codes.reserve(capacity); break;
+    }
+}
+
+void ColumnVector::truncate(size_t rows) {
+    materialize();
+    // Zones keep their bounds: a superset's min/max still bounds the rest
+    zone_rows_covered = std::min(zone_rows_covered, rows);
+    null_flags.resize(std::min(rows, null_flags.size()));
+    switch (type) {
+        case ColumnType::INT:    int_values.resize(std::min(rows, int_values.size())); break;
+        case ColumnType::DOUBLE: double_values.resize(std::min(rows, double_values.size())); break;
+        case ColumnType::BOOL:   bool_values.resize(std::min(rows, bool_values.size())); break;
+        case ColumnType::STRING: string_codes.resize(std::min(rows, string_codes.size())); break;
+    }
+}
+
+namespace {
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front()))) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back()))) {
+        text.remove_suffix(1);
+    }
+    if (!text.empty() && text.front() == '+') {
+        text.remove_prefix(1);  // from_chars rejects an explicit plus sign
+    }
+    return text;
+}
+
+bool equalsIgnoreCase(std::string_view text, std::string_view word) {
+    if (text.size() != word.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(text[i])) != word[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename T>
+bool parseNumber(std::string_view text, T& value) {
+    text = trim(text);
+    const char* end = text.data() + text.size();
+    auto result = std::from_chars(text.data(), end, value);
+    return result.ec == std::errc() && result.ptr == end && !text.empty();
+}
+
+} // namespace
+
+bool ColumnVector::appendParsed(std::string_view text) {
+    materialize();
+    switch (type) {
+        case ColumnType::INT: {
+            int value;
+            if (!parseNumber(text, value)) {
+                return false;
+            }
+            int_values.push_back(value);
+            return true;
+        }
+        case ColumnType::DOUBLE: {
+            double value;
+            if (!parseNumber(text, value)) {
+                return false;
+            }
+            double_values.push_back(value);
+            return true;
+        }
+        case ColumnType::BOOL: {
+            std::string_view word = trim(text);
+            if (equalsIgnoreCase(word, "true") || word == "1") {
+                bool_values.push_back(1);
+            } else if (equalsIgnoreCase(word, "false") || word == "0") {
+                bool_values.push_back(0);
+            } else {
+                return false;
+            }
+            return true;
+        }
+        case ColumnType::STRING:
+            string_codes.push_back(dictionary.intern(text));
+            return true;
+    }
+    return false;
+}
+
+void ColumnVector::append(const Value& value) {
+    materialize();
+    switch (type) {
+        case ColumnType::INT:
+            if (auto v = std::get_if<int>(&value)) {
+                int_values.push_back(*v);
+                return;
+            }
+            break;
+        case ColumnType::DOUBLE:
+            if (auto v = std::get_if<double>(&value)) {
+                double_values.push_back(*v);
+                return;
+            } else if (auto i = std::get_if<int>(&value)) {
+                double_values.push_back(*i);
+                return;
+            }
+            break;
+        case ColumnType::BOOL:
+            if (auto v = std::get_if<bool>(&value)) {
+                bool_values.push_back(*v ? 1 : 0);
+                return;
+            }
+            break;
+        case ColumnType::STRING:
+            if (auto v = std::get_if<std::string>(&value)) {
+                string_codes.push_back(dictionary.intern(*v));
+                return;
+            }
+            break;
+    }
+    throw std::runtime_error("Value type doesn't match column type");
+}
+
+bool ColumnVector::accepts(const Value& value) const {
+    switch (type) {
+        case ColumnType::INT:
+            return std::holds_alternative<int>(value);
+        case ColumnType::DOUBLE:
+            return std::holds_alternative<double>(value) || std::holds_alternative<int>(value);
+        case ColumnType::BOOL:
+            return std::holds_alternative<bool>(value);
+        case ColumnType::STRING:
+            return std::holds_alternative<std::string>(value);
+    }
+    return false;
+}
+
+void ColumnVector::appendRows(const ColumnVector& source, const uint32_t* rows, size_t count) {
+    if (source.type != type) {
+        throw std::runtime_error("Value type doesn't match column type");
+    }
+    materialize();
+    size_t start = size();
+
+    switch (type) {
+        case ColumnType::INT:
+            for (size_t i = 0; i < count; ++i) {
+                int_values.push_back(rows[i] == NO_ROW ? 0 : source.intData()[rows[i]]);
+            }
+            break;
+        case ColumnType::DOUBLE:
+            for (size_t i = 0; i < count; ++i) {
+                double_values.push_back(rows[i] == NO_ROW ? 0.0 : source.doubleData()[rows[i]]);
+            }
+            break;
+        case ColumnType::BOOL:
+            for (size_t i = 0; i < count; ++i) {
+                bool_values.push_back(rows[i] == NO_ROW ? 0 : source.boolData()[rows[i]]);
+            }
+            break;
+        case ColumnType::STRING: {
+            // Translate source codes into this dictionary once per distinct code
+            std::vector<uint32_t> code_map(source.dictionary.size(), NO_ROW);
+            uint32_t empty_code = NO_ROW;
+            for (size_t i = 0; i < count; ++i) {
+                if (rows[i] == NO_ROW) {
+                    if (empty_code == NO_ROW) {
+                        empty_code = dictionary.intern("");
+                    }
+                    string_codes.push_back(empty_code);
+                    continue;
+                }
+                uint32_t source_code = source.stringCodes()[rows[i]];
+                if (code_map[source_code] == NO_ROW) {
+                    code_map[source_code] = dictionary.intern(source.dictionary.lookup(source_code));
+                }
+                string_codes.push_back(code_map[source_code]);
+            }
+            break;
+        }
+    }
+    
+    bool source_nulls = source.hasNulls();
+    for (size_t i = 0; i < count; ++i) {
+        if (rows[i] == NO_ROW || (source_nulls && source.isNull(rows[i]))) {
+            setNull(start + i);
+        }
+    }
+}
+
+void ColumnVector::setNull(size_t row) {
+    if (null_flags.size() <= row) {
+        null_flags.resize(row + 1, 0);
+    }
+    null_flags[row] = 1;
+}
+
+Value ColumnVector::get(size_t row) const {
+    switch (type) {
+        case ColumnType::INT:    return intData()[row];
+        case ColumnType::DOUBLE: return doubleData()[row];
+        case ColumnType::BOOL:   return boolData()[row] != 0;
+        case ColumnType::STRING: return std::string(dictionary.lookup(stringCodes()[row]));
+    }
+    return Value();
+}
+
+std::string ColumnVector::toString(size_t row) const {
+    if (isNull(row)) {
+        return "NULL";
+    }
+    switch (type) {
+        case ColumnType::INT:    return std::to_string(intData()[row]);
+        case ColumnType::DOUBLE: return std::to_string(doubleData()[row]);
+        case ColumnType::BOOL:   return boolData()[row] ? "true" : "false";
+        case ColumnType::STRING: return std::string(dictionary.lookup(stringCodes()[row]));
+    }
+    return "";
+}
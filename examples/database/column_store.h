@@ -0,0 +1,156 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <variant>
+#include <memory>
+#include <cstdint>
+
+// Data types supported by our database
+using Value = std::variant<int, double, std::string, bool>;
+
+// Physical type of a column, resolved once from the schema type name
+enum class ColumnType {
+    INT,
+    DOUBLE,
+    STRING,
+    BOOL
+};
+
+ColumnType columnTypeFromString(const std::string& type);
+
+// Interns string values so a string column can be stored as a dense
+// vector of 32-bit codes. Strings are kept in a deque so the views used
+// as hash keys stay valid as the dictionary grows.
+//
+// A dictionary can instead be attached to the arrays of a mapped segment
+// file; it is then read in place (find() binary-searches the stored sort
+// order) until the first intern() copies it into the owned structures.
+class StringDictionary {
+private:
+    std::deque<std::string> strings;
+    std::unordered_map<std::string_view, uint32_t> codes;
+
+    const uint64_t* mapped_offsets = nullptr;  // mapped_count + 1 offsets into mapped_blob
+    const char* mapped_blob = nullptr;
+    const uint32_t* mapped_sorted = nullptr;   // Codes in string order
+    size_t mapped_count = 0;
+
+public:
+    StringDictionary() = default;
+    // The keys of codes view into strings, so a copy rebuilds them over its
+    // own strings; a move keeps the deque's elements where they are
+    StringDictionary(const StringDictionary& other);
+    StringDictionary& operator=(const StringDictionary& other);
+    StringDictionary(StringDictionary&&) noexcept = default;
+    StringDictionary& operator=(StringDictionary&&) noexcept = default;
+
+    void attachMapped(const uint64_t* offsets, const char* blob, const uint32_t* sorted, size_t count);
+    bool isMapped() const { return mapped_offsets != nullptr; }
+    void materialize();  // Copies a mapped dictionary into owned storage
+
+    uint32_t intern(std::string_view value);
+    bool find(std::string_view value, uint32_t& code) const;
+    std::string_view lookup(uint32_t code) const {
+        if (mapped_offsets) {
+            return std::string_view(mapped_blob + mapped_offsets[code],
+                                    mapped_offsets[code + 1] - mapped_offsets[code]);
+        }
+        return strings[code];
+    }
+    size_t size() const { return mapped_offsets ? mapped_count : strings.size(); }
+};
+
+// Contiguous typed storage for a single column. Only the vector matching
+// the column type is populated; scans read it through the typed accessors.
+//
+// A column loaded from a segment file points straight at its mapped page
+// instead; the first write copies the page into the owned vector. Mapped
+// columns also carry zone maps (min/max per ZONE_ROWS rows) that let scans
+// skip zones a comparison can't match.
+//
+// Rows of a query result can be NULL (an aggregate over no rows, or the
+// right side of an unmatched LEFT JOIN row). A NULL row stores the type's
+// default value and is flagged; segment files don't store the flags, as
+// stored tables have no NULLs.
+class ColumnVector {
+private:
+    ColumnType type;
+    std::vector<int> int_values;
+    std::vector<double> double_values;
+    std::vector<uint8_t> bool_values;
+    std::vector<uint32_t> string_codes;
+    StringDictionary dictionary;
+    std::vector<uint8_t> null_flags;  // Up to the last NULL row; empty if none
+
+    const void* mapped_data = nullptr;
+    size_t mapped_rows = 0;
+    std::shared_ptr<const void> mapping;  // Keeps the mapped file alive
+
+    std::vector<double> zone_min;
+    std::vector<double> zone_max;
+    size_t zone_rows_covered = 0;  // Rows the zone maps are valid for
+
+    void materialize();
+
+public:
+    static constexpr uint32_t NO_ROW = UINT32_MAX;
+    static constexpr size_t ZONE_ROWS = 65536;
+
+    explicit ColumnVector(ColumnType t) : type(t) {}
+
+    ColumnType getType() const { return type; }
+    size_t size() const;
+    void reserve(size_t capacity);
+    void truncate(size_t rows);
+
+    // Throws std::runtime_error unless accepts(value)
+    void append(const Value& value);
+    // True if append(value) would store it: the column's type, or an int
+    // for a double column
+    bool accepts(const Value& value) const;
+    // Parses text as this column's type and appends it; returns false
+    // (appending nothing) if it isn't a valid value. Used by bulk loads.
+    bool appendParsed(std::string_view text);
+    // Appends source[rows[i]] for each i (source must have the same type).
+    // NO_ROW appends NULL; source rows that are NULL stay NULL.
+    void appendRows(const ColumnVector& source, const uint32_t* rows, size_t count);
+    // get() returns a NULL row's default value; toString() prints "NULL"
+    Value get(size_t row) const;
+    std::string toString(size_t row) const;
+
+    void setNull(size_t row);
+    bool isNull(size_t row) const { return row < null_flags.size() && null_flags[row] != 0; }
+    bool hasNulls() const { return !null_flags.empty(); }
+
+    // Points the column at rows values of its type inside a mapped file
+    void attachMapped(const void* data, size_t rows, std::shared_ptr<const void> keep_alive);
+    void attachMappedDictionary(const uint64_t* offsets, const char* blob, const uint32_t* sorted, size_t count);
+    bool isMapped() const { return mapped_data != nullptr; }
+    // The mapped file while the column reads from it, else null
+    const std::shared_ptr<const void>& getMapping() const { return mapping; }
+
+    // Zone maps: zone z covers rows [z * ZONE_ROWS, (z + 1) * ZONE_ROWS)
+    // of the first covered_rows rows. NaN widens a zone to +/-infinity.
+    void setZoneMaps(std::vector<double> min, std::vector<double> max, size_t covered_rows);
+    static void computeZoneMaps(const ColumnVector& column, std::vector<double>& min, std::vector<double>& max);
+    // Min/max over rows [begin, begin + count); false if no zone map covers them
+    bool zoneRange(size_t begin, size_t count, double& min, double& max) const;
+
+    const int* intData() const {
+        return mapped_data ? static_cast<const int*>(mapped_data) : int_values.data();
+    }
+    const double* doubleData() const {
+        return mapped_data ? static_cast<const double*>(mapped_data) : double_values.data();
+    }
+    const uint8_t* boolData() const {
+        return mapped_data ? static_cast<const uint8_t*>(mapped_data) : bool_values.data();
+    }
+    const uint32_t* stringCodes() const {
+        return mapped_data ? static_cast<const uint32_t*>(mapped_data) : string_codes.data();
+    }
+    const StringDictionary& getDictionary() const { return dictionary; }
+};
@@ -0,0 +1,246 @@
+#include "csv_loader.h"
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <stdexcept>
+
+namespace {
+
+constexpr size_t READ_BLOCK_BYTES = 4 << 20;
+
+// Splits a CSV file into records. Field views point into the read
+// buffer (or into scratch storage for unescaped quoted fields) and stay
+// valid until the next call to next().
+class CsvReader {
+private:
+    enum class ParseResult { COMPLETE, NEED_MORE, END };
+
+    FILE* file;
+    char delimiter;
+    std::vector<char> buffer;
+    size_t pos;            // Start of the unparsed data
+    size_t end;            // End of the valid data
+    bool eof;
+    size_t line;           // Line number at pos
+    size_t record_line;    // First line of the last record returned
+    std::deque<std::string> scratch;  // Deque: growing it never moves strings already viewed
+
+    bool refill() {
+        if (eof) {
+            return false;
+        }
+        if (pos > 0) {
+            std::memmove(buffer.data(), buffer.data() + pos, end - pos);
+            end -= pos;
+            pos = 0;
+        }
+        if (end == buffer.size()) {
+            buffer.resize(buffer.size() * 2);  // A single record larger than the buffer
+        }
+        size_t n = std::fread(buffer.data() + end, 1, buffer.size() - end, file);
+        end += n;
+        if (n == 0) {
+            if (std::ferror(file)) {
+                throw std::runtime_error("Error reading CSV file");
+            }
+            eof = true;
+        }
+        return true;
+    }
+
+    std::string_view unescape(size_t begin, size_t finish, size_t field) {
+        while (scratch.size() <= field) {
+            scratch.emplace_back();
+        }
+        std::string& out = scratch[field];
+        out.clear();
+        for (size_t i = begin; i < finish; ++i) {
+            out += buffer[i];
+            if (buffer[i] == '"') {
+                ++i;  // Skip the second quote of ""
+            }
+        }
+        return out;
+    }
+
+    ParseResult tryParse(std::vector<std::string_view>& fields) {
+        fields.clear();
+        const char* data = buffer.data();
+        size_t p = pos;
+        size_t newlines = 0;
+
+        // Blank lines between records are ignored
+        while (p < end && (data[p] == '\n' || data[p] == '\r')) {
+            newlines += data[p] == '\n';
+            p++;
+        }
+        if (p == end) {
+            if (!eof) {
+                return ParseResult::NEED_MORE;
+            }
+            pos = p;
+            line += newlines;
+            return ParseResult::END;
+        }
+        size_t first_line = line + newlines;
+
+        while (true) {
+            if (data[p] == '"') {
+                size_t q = p + 1;
+                bool escaped = false;
+                size_t close;
+                while (true) {
+                    const void* quote = q < end ? std::memchr(data + q, '"', end - q) : nullptr;
+                    if (!quote) {
+                        if (eof) {
+                            throw std::runtime_error("Line " + std::to_string(first_line) +
+                                                     ": Unterminated quoted field");
+                        }
+                        return ParseResult::NEED_MORE;
+                    }
+                    close = static_cast<const char*>(quote) - data;
+                    if (close + 1 == end && !eof) {
+                        return ParseResult::NEED_MORE;  // Can't tell "" from a closing quote yet
+                    }
+                    if (close + 1 < end && data[close + 1] == '"') {
+                        escaped = true;
+                        q = close + 2;
+                        continue;
+                    }
+                    break;
+                }
+                for (size_t i = p + 1; i < close; ++i) {
+                    newlines += data[i] == '\n';
+                }
+                fields.push_back(escaped ? unescape(p + 1, close, fields.size())
+                                         : std::string_view(data + p + 1, close - p - 1));
+                p = close + 1;
+            } else {
+                size_t q = p;
+                while (q < end && data[q] != delimiter && data[q] != '\n') {
+                    q++;
+                }
+                if (q == end && !eof) {
+                    return ParseResult::NEED_MORE;
+                }
+                size_t field_end = q;
+                if (field_end > p && data[field_end - 1] == '\r' && (q == end || data[q] == '\n')) {
+                    field_end--;
+                }
+                fields.push_back(std::string_view(data + p, field_end - p));
+                p = q;
+            }
+
+            // Field separator or end of record
+            if (p == end) {
+                break;  // Last record without a trailing newline
+            }
+            char c = data[p];
+            if (c == delimiter) {
+                p++;
+                if (p == end && !eof) {
+                    return ParseResult::NEED_MORE;
+                }
+                if (p == end) {
+                    fields.push_back(std::string_view());  // Trailing empty field
+                    break;
+                }
+                continue;
+            }
+            if (c == '\r') {
+                if (p + 1 == end && !eof) {
+                    return ParseResult::NEED_MORE;
+                }
+                p++;
+                if (p < end && data[p] == '\n') {
+                    p++;
+                    newlines++;
+                }
+                break;
+            }
+            if (c == '\n') {
+                p++;
+                newlines++;
+                break;
+            }
+            throw std::runtime_error("Line " + std::to_string(first_line) +
+                                     ": Unexpected character after quoted field");
+        }
+
+        pos = p;
+        line += newlines;
+        record_line = first_line;
+        return ParseResult::COMPLETE;
+    }
+
+public:
+    CsvReader(FILE* f, char delim)
+        : file(f), delimiter(delim), buffer(READ_BLOCK_BYTES), pos(0), end(0),
+          eof(false), line(1), record_line(1) {}
+
+    ~CsvReader() { std::fclose(file); }
+
+    CsvReader(const CsvReader&) = delete;
+    CsvReader& operator=(const CsvReader&) = delete;
+
+    bool next(std::vector<std::string_view>& fields) {
+        while (true) {
+            ParseResult result = tryParse(fields);
+            if (result == ParseResult::COMPLETE) {
+                return true;
+            }
+            if (result == ParseResult::END) {
+                return false;
+            }
+            refill();
+        }
+    }
+
+    size_t recordLine() const { return record_line; }
+
+    // Record count extrapolated from the newlines in the first block
+    size_t estimateRecords(uintmax_t file_size) {
+        if (end == 0) {
+            refill();
+        }
+        size_t newlines = 0;
+        for (size_t i = pos; i < end; ++i) {
+            newlines += buffer[i] == '\n';
+        }
+        if (end == 0 || newlines == 0) {
+            return 0;
+        }
+        return static_cast<size_t>(static_cast<double>(file_size) * newlines / end);
+    }
+};
+
+} // namespace
+
+size_t loadCsv(Table& table, const std::string& path, const CsvOptions& options) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        throw std::runtime_error("Cannot open file '" + path + "'");
+    }
+    CsvReader reader(file, options.delimiter);
+
+    std::error_code ec;
+    uintmax_t file_size = std::filesystem::file_size(path, ec);
+    size_t expected_rows = ec ? 0 : reader.estimateRecords(file_size);
+
+    std::vector<std::string_view> fields;
+    if (options.header) {
+        reader.next(fields);
+    }
+
+    try {
+        return table.loadRows([&](std::vector<std::string_view>& row) { return reader.next(row); },
+                              expected_rows);
+    } catch (const std::runtime_error& e) {
+        std::string message = e.what();
+        if (message.compare(0, 5, "Line ") == 0) {
+            throw;
+        }
+        throw std::runtime_error("Line " + std::to_string(reader.recordLine()) + ": " + message);
+    }
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "table.h"
+#include <string>
+
+struct CsvOptions {
+    bool header = false;    // Skip the first record
+    char delimiter = ',';
+};
+
+// Loads an RFC 4180 CSV file into a table through Table::loadRows. The
+// file is read in large blocks and fields are handed over as views into
+// the read buffer; only quoted fields containing "" escapes are copied.
+// Errors report the line of the offending record and leave the table
+// unchanged. Returns the number of rows loaded.
+size_t loadCsv(Table& table, const std::string& path, const CsvOptions& options = CsvOptions());
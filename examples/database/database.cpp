@@ -27,14 +27,40 @@ private:
         std::cout << "  - Supported types: int, double, string, bool\n";
         std::cout << "  - Example: CREATE TABLE users (id int, name string, age int)\n\n";
         
-        std::cout << "INSERT INTO <table> VALUES (<val1>, <val2>, ...)\n";
-        std::cout << "  - Inserts a new row into the table\n";
-        std::cout << "  - Example: INSERT INTO users VALUES (1, John, 25)\n\n";
+        std::cout << "INSERT INTO <table> VALUES (<val1>, <val2>, ...) [, (<val1>, <val2>, ...) ...]\n";
+        std::cout << "  - Inserts rows into the table; several rows are logged and synced as one batch\n";
+        std::cout << "  - Example: INSERT INTO users VALUES (1, John, 25), (2, Jane, 31)\n\n";
+        
+        std::cout << "BEGIN ... COMMIT\n";
+        std::cout << "  - Changes in between share one write-ahead log sync at COMMIT\n";
+        std::cout << "  - There is no rollback; a crash before COMMIT may keep some of them\n\n";
+        
+        std::cout << "COPY <table> FROM '<file.csv>' [WITH HEADER] [DELIMITER '<c>']\n";
+        std::cout << "  - Bulk loads a CSV file; a bad row rejects the whole file\n";
+        std::cout << "  - Not logged: the table's segment is written when the load finishes\n";
+        std::cout << "  - Example: COPY users FROM 'users.csv' WITH HEADER\n\n";
         
         std::cout << "SELECT * FROM <table> [WHERE <condition>]\n";
         std::cout << "SELECT <col1>, <col2> FROM <table> [WHERE <condition>]\n";
         std::cout << "  - Selects data from a table\n";
-        std::cout << "  - Example: SELECT * FROM users WHERE age > 20\n\n";
+        std::cout << "  - Conditions can be combined with AND / OR\n";
+        std::cout << "  - Example: SELECT * FROM users WHERE age > 20 AND active = true\n\n";
+        
+        std::cout << "SELECT <col>, COUNT(*), SUM(<col>), ... FROM <table> [WHERE <condition>] [GROUP BY <col>, ...]\n";
+        std::cout << "  - Aggregates COUNT, SUM, AVG, MIN, MAX over the selected rows\n";
+        std::cout << "  - Example: SELECT active, COUNT(*), AVG(age) FROM users GROUP BY active\n\n";
+        
+        std::cout << "SELECT ... FROM <left> [INNER|LEFT] JOIN <right> ON <left>.<col> = <right>.<col>\n";
+        std::cout << "  - Equi-joins two tables; columns are named table.column\n";
+        std::cout << "  - Example: SELECT users.name, orders.item FROM users JOIN orders ON users.id = orders.user_id\n\n";
+        
+        std::cout << "EXPLAIN [ANALYZE] SELECT ...\n";
+        std::cout << "  - Shows the query plan; ANALYZE runs the query and reports rows, time and bytes per operator\n";
+        std::cout << "  - Example: EXPLAIN ANALYZE SELECT active, COUNT(*) FROM users WHERE age > 20 GROUP BY active\n\n";
+        
+        std::cout << "CREATE INDEX <name> ON <table> (<column>) [USING HASH|BTREE]\n";
+        std::cout << "  - Creates an index used automatically by WHERE lookups\n";
+        std::cout << "  - Example: CREATE INDEX idx_age ON users (age)\n\n";
         
         std::cout << "DROP TABLE <table>\n";
         std::cout << "  - Removes a table and all its data\n\n";
@@ -45,6 +71,18 @@ private:
         std::cout << "DESCRIBE <table> or DESC <table>\n";
         std::cout << "  - Shows the structure of a table\n\n";
         
+        std::cout << "SAVE [<table>] or CHECKPOINT\n";
+        std::cout << "  - Writes changed tables (or one table) to the data directory\n";
+        std::cout << "  - Saving all tables also empties the write-ahead log\n";
+        std::cout << "  - Changed tables are also saved on exit\n\n";
+        
+        std::cout << "SET PARALLELISM <n>\n";
+        std::cout << "  - Caps the number of threads used per query (0 = all cores)\n\n";
+        
+        std::cout << "SET SYNCHRONOUS_COMMIT ON|OFF\n";
+        std::cout << "  - OFF returns before the log is on disk; a crash may lose the last\n";
+        std::cout << "    WAL_MAX_LATENCY_US microseconds of changes (default 2000)\n\n";
+        
         std::cout << "Other Commands:\n";
         std::cout << "  help     - Show this help message\n";
         std::cout << "  info     - Show database information\n";
@@ -70,13 +108,33 @@ private:
 public:
     SimpleDatabase() : running(true) {}
     
+    void setParallelism(size_t num_threads) {
+        engine.setParallelism(num_threads);
+    }
+    
+    void openDatabase(const std::string& directory) {
+        engine.openDatabase(directory);
+        std::cout << "Opened " << engine.getTableCount() << " tables from " << directory << "\n";
+    }
+    
+    void saveChanges() {
+        if (!engine.getDataDirectory().empty()) {
+            std::cout << engine.saveAll() << " tables saved.\n";
+        }
+    }
+    
     void run() {
         printWelcome();
         
         std::string input;
         while (running) {
             std::cout << "simpledb> ";
-            std::getline(std::cin, input);
+            if (!std::getline(std::cin, input)) {
+                // End of input behaves like exit
+                running = false;
+                saveChanges();
+                break;
+            }
             
             input = trim(input);
             if (input.empty()) {
@@ -89,6 +147,7 @@ public:
             
             if (lower_input == "exit" || lower_input == "quit") {
                 running = false;
+                saveChanges();
                 std::cout << "Goodbye!\n";
                 break;
             } else if (lower_input == "help") {
@@ -138,21 +197,41 @@ public:
 
 int main(int argc, char* argv[]) {
     SimpleDatabase db;
+    bool load_sample = false;
+    std::string data_dir;
     
     // Check for command line arguments
-    if (argc > 1) {
-        std::string arg = argv[1];
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
         if (arg == "--sample" || arg == "-s") {
-            db.loadSampleData();
+            load_sample = true;
+        } else if ((arg == "--threads" || arg == "-t") && i + 1 < argc) {
+            db.setParallelism(std::stoul(argv[++i]));
+        } else if ((arg == "--data-dir" || arg == "-d") && i + 1 < argc) {
+            data_dir = argv[++i];
         } else if (arg == "--help" || arg == "-h") {
             std::cout << "Usage: " << argv[0] << " [options]\n";
             std::cout << "Options:\n";
-            std::cout << "  --sample, -s  Load sample data\n";
-            std::cout << "  --help, -h    Show this help\n";
+            std::cout << "  --sample, -s       Load sample data\n";
+            std::cout << "  --threads, -t N    Cap query parallelism at N threads (0 = all cores)\n";
+            std::cout << "  --data-dir, -d DIR Open tables saved in DIR and save changes there\n";
+            std::cout << "  --help, -h         Show this help\n";
             return 0;
         }
     }
     
+    try {
+        if (!data_dir.empty()) {
+            db.openDatabase(data_dir);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error opening database: " << e.what() << std::endl;
+        return 1;
+    }
+    if (load_sample) {
+        db.loadSampleData();
+    }
+    
     db.run();
     return 0;
-}
\ No newline at end of file
+}
@@ -1,14 +1,302 @@
 #include "database_engine.h"
 #include "query_parser.h"
+#include "predicate.h"
+#include "aggregation.h"
+#include "hash_join.h"
+#include "csv_loader.h"
+#include "segment_file.h"
+#include "table_index.h"
+#include "query_profile.h"
 #include <iostream>
 #include <algorithm>
+#include <chrono>
+#include <functional>
 #include <iomanip>
+#include <filesystem>
+#include <numeric>
+#include <streambuf>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Bytes one value takes in column storage; strings count their dictionary code
+size_t valueBytes(ColumnType type) {
+    switch (type) {
+        case ColumnType::INT: return sizeof(int);
+        case ColumnType::DOUBLE: return sizeof(double);
+        case ColumnType::STRING: return sizeof(uint32_t);
+        case ColumnType::BOOL: return sizeof(uint8_t);
+    }
+    return 0;
+}
+
+size_t rowBytes(const Table& table, const std::vector<size_t>& columns) {
+    size_t bytes = 0;
+    for (size_t col : columns) {
+        bytes += valueBytes(table.getColumnData(col).getType());
+    }
+    return bytes;
+}
+
+size_t rowBytes(const Table& table) {
+    std::vector<size_t> columns(table.getColumns().size());
+    std::iota(columns.begin(), columns.end(), 0);
+    return rowBytes(table, columns);
+}
+
+std::vector<size_t> predicateColumns(const Predicate& predicate) {
+    std::vector<size_t> columns;
+    for (const auto& group : predicate.getDisjuncts()) {
+        for (const auto& cmp : group) {
+            columns.push_back(cmp.column_index);
+        }
+    }
+    std::sort(columns.begin(), columns.end());
+    columns.erase(std::unique(columns.begin(), columns.end()), columns.end());
+    return columns;
+}
+
+std::string joinList(const std::vector<std::string>& items) {
+    std::string text;
+    for (const auto& item : items) {
+        text += (text.empty() ? "" : ", ") + item;
+    }
+    return text;
+}
+
+// Counts what is written to it and throws it away, so EXPLAIN ANALYZE
+// pays for formatting the result without printing it
+class CountingBuffer : public std::streambuf {
+public:
+    size_t bytes = 0;
+
+protected:
+    int overflow(int c) override {
+        if (c != traits_type::eof()) {
+            bytes++;
+        }
+        return traits_type::not_eof(c);
+    }
+    std::streamsize xsputn(const char*, std::streamsize count) override {
+        bytes += count;
+        return count;
+    }
+};
+
+// Points a stream at another buffer until destroyed
+class StreamRedirect {
+public:
+    StreamRedirect(std::ostream& stream, std::streambuf* buffer) : stream(stream), saved(stream.rdbuf(buffer)) {}
+    ~StreamRedirect() { stream.rdbuf(saved); }
+
+private:
+    std::ostream& stream;
+    std::streambuf* saved;
+};
+
+// An empty table with the same schema, to plan a join without running it
+Table emptyCopy(const Table& table) {
+    Table copy(table.getName());
+    for (const auto& column : table.getColumns()) {
+        copy.addColumn(column.name, column.type);
+    }
+    return copy;
+}
+
+}  // namespace
+
+DatabaseEngine::DatabaseEngine() : parallelism(1) {
+    setParallelism(0);
+}
+
+void DatabaseEngine::setParallelism(size_t num_threads) {
+    if (num_threads == 0) {
+        num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    if (num_threads != parallelism) {
+        thread_pool.reset();  // Recreated lazily with the new size
+    }
+    parallelism = num_threads;
+}
+
+ThreadPool* DatabaseEngine::getThreadPool() const {
+    if (parallelism <= 1) {
+        return nullptr;
+    }
+    if (!thread_pool) {
+        thread_pool = std::make_unique<ThreadPool>(parallelism);
+    }
+    return thread_pool.get();
+}
+
+std::string DatabaseEngine::segmentPath(const std::string& table_name) const {
+    return (std::filesystem::path(data_dir) / (table_name + SEGMENT_EXTENSION)).string();
+}
+
+void DatabaseEngine::logChange(WalRecordType type, const std::vector<std::string>& fields) {
+    if (wal && !replaying) {
+        uint64_t lsn = wal->append(type, fields);
+        if (in_transaction) {
+            pending_lsn = lsn;  // Made durable by COMMIT
+        } else {
+            wal->commit(lsn);
+        }
+    }
+}
+
+void DatabaseEngine::openDatabase(const std::string& directory) {
+    std::filesystem::create_directories(directory);
+    
+    // Segments are mapped, not read: opening costs a few syscalls per table
+    std::vector<std::unique_ptr<Table>> opened;
+    std::unordered_map<std::string, uint64_t> segment_lsns;
+    uint64_t last_lsn = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        if (entry.is_regular_file() && entry.path().extension() == SEGMENT_EXTENSION) {
+            uint64_t lsn = 0;
+            opened.push_back(std::make_unique<Table>(openSegment(entry.path().string(), &lsn)));
+            segment_lsns[opened.back()->getName()] = lsn;
+            last_lsn = std::max(last_lsn, lsn);
+        }
+    }
+    for (const auto& table : opened) {
+        if (hasTable(table->getName())) {
+            throw std::runtime_error("Table '" + table->getName() + "' already exists");
+        }
+    }
+    
+    data_dir = directory;
+    for (auto& table : opened) {
+        std::string name = table->getName();
+        tables[name] = std::move(table);
+    }
+    
+    // Redo the log on top of the segments. A record is already in a segment
+    // if its LSN is at most that segment's checkpoint LSN; anything logged
+    // for a table before its last DROP is dead and skipped outright.
+    std::string log_path = (std::filesystem::path(directory) / WAL_FILE_NAME).string();
+    std::unordered_map<std::string, uint64_t> drop_lsns;
+    WriteAheadLog::replay(log_path, [&](const WalRecord& record) {
+        if (record.type == WalRecordType::DROP_TABLE && !record.fields.empty()) {
+            drop_lsns[record.fields[0]] = record.lsn;
+        }
+    });
+    
+    replaying = true;
+    try {
+        last_lsn = std::max(last_lsn, WriteAheadLog::replay(log_path, [&](const WalRecord& record) {
+            if (record.fields.empty()) {
+                throw std::runtime_error("empty record");
+            }
+            const std::string& table_name = record.fields[0];
+            auto segment = segment_lsns.find(table_name);
+            if (segment != segment_lsns.end() && record.lsn <= segment->second) {
+                return;
+            }
+            auto drop = drop_lsns.find(table_name);
+            if (drop != drop_lsns.end() && record.lsn < drop->second) {
+                return;
+            }
+            try {
+                applyLogRecord(record);
+            } catch (const std::exception& e) {
+                throw std::runtime_error("Cannot replay write-ahead log record " +
+                                         std::to_string(record.lsn) + ": " + e.what());
+            }
+        }));
+    } catch (...) {
+        replaying = false;
+        throw;
+    }
+    replaying = false;
+    
+    wal = std::make_unique<WriteAheadLog>(log_path, last_lsn, wal_config);
+}
+
+void DatabaseEngine::applyLogRecord(const WalRecord& record) {
+    const auto& f = record.fields;
+    auto require = [&](size_t count) {
+        if (f.size() < count) {
+            throw std::runtime_error("truncated record");
+        }
+    };
+    switch (record.type) {
+        case WalRecordType::CREATE_TABLE:
+            createTable(f[0]);
+            break;
+        case WalRecordType::ADD_COLUMN:
+            require(3);
+            addColumn(f[0], f[1], f[2]);
+            break;
+        case WalRecordType::CREATE_INDEX:
+            require(4);
+            createIndex(f[0], f[1], f[2], f[3]);
+            break;
+        case WalRecordType::INSERT:
+            insertInto(f[0], std::vector<std::string>(f.begin() + 1, f.end()));
+            break;
+        case WalRecordType::INSERT_BATCH: {
+            require(2);
+            size_t width = std::stoul(f[1]);
+            if (width == 0 || (f.size() - 2) % width != 0) {
+                throw std::runtime_error("malformed batch");
+            }
+            std::vector<std::vector<std::string>> rows;
+            for (size_t i = 2; i < f.size(); i += width) {
+                rows.emplace_back(f.begin() + i, f.begin() + i + width);
+            }
+            insertBatch(f[0], rows);
+            break;
+        }
+        case WalRecordType::DROP_TABLE:
+            if (hasTable(f[0])) {
+                dropTable(f[0]);
+            }
+            break;
+        default:
+            throw std::runtime_error("unknown record type");
+    }
+}
+
+void DatabaseEngine::saveTable(const std::string& table_name) {
+    if (data_dir.empty()) {
+        throw std::runtime_error("No data directory (start with --data-dir <dir>)");
+    }
+    auto it = tables.find(table_name);
+    if (it == tables.end()) {
+        throw std::runtime_error("Table '" + table_name + "' not found");
+    }
+    // Every change to the table has been logged by now, so the whole log
+    // up to its last record is reflected in the segment
+    writeSegment(*it->second, segmentPath(table_name), wal ? wal->lastLsn() : 0);
+    dirty_tables.erase(table_name);
+}
+
+size_t DatabaseEngine::saveAll() {
+    std::vector<std::string> names(dirty_tables.begin(), dirty_tables.end());
+    for (const auto& name : names) {
+        saveTable(name);
+    }
+    if (wal) {
+        // Segment files removed by DROP TABLE must stay removed too
+        syncDirectory(data_dir);
+        wal->truncate();  // Every table's segment now covers the whole log
+    }
+    return names.size();
+}
 
 void DatabaseEngine::createTable(const std::string& table_name) {
     if (hasTable(table_name)) {
         throw std::runtime_error("Table '" + table_name + "' already exists");
     }
     tables[table_name] = std::make_unique<Table>(table_name);
+    dirty_tables.insert(table_name);
+    logChange(WalRecordType::CREATE_TABLE, {table_name});
 }
 
 bool DatabaseEngine::hasTable(const std::string& table_name) const {
@@ -20,6 +308,8 @@ Table* DatabaseEngine::getTable(const std::string& table_name) {
     if (it == tables.end()) {
         throw std::runtime_error("Table '" + table_name + "' not found");
     }
+    // Callers may modify the table through the returned pointer
+    dirty_tables.insert(table_name);
     return it->second.get();
 }
 
@@ -27,7 +317,13 @@ void DatabaseEngine::dropTable(const std::string& table_name) {
     if (!hasTable(table_name)) {
         throw std::runtime_error("Table '" + table_name + "' not found");
     }
+    // Logged first: a crash before the file is gone must still drop it
+    logChange(WalRecordType::DROP_TABLE, {table_name});
     tables.erase(table_name);
+    dirty_tables.erase(table_name);
+    if (!data_dir.empty()) {
+        std::filesystem::remove(segmentPath(table_name));
+    }
 }
 
 std::vector<std::string> DatabaseEngine::listTables() const {
@@ -42,24 +338,227 @@ std::vector<std::string> DatabaseEngine::listTables() const {
 void DatabaseEngine::addColumn(const std::string& table_name, const std::string& column_name, const std::string& type) {
     Table* table = getTable(table_name);
     table->addColumn(column_name, type);
+    logChange(WalRecordType::ADD_COLUMN, {table_name, column_name, type});
+}
+
+void DatabaseEngine::createIndex(const std::string& table_name, const std::string& index_name,
+                                 const std::string& column_name, const std::string& index_type) {
+    Table* table = getTable(table_name);
+    table->createIndex(index_name, column_name, indexTypeFromString(index_type));
+    logChange(WalRecordType::CREATE_INDEX, {table_name, index_name, column_name, index_type});
 }
 
 void DatabaseEngine::insertInto(const std::string& table_name, const std::vector<std::string>& values) {
     Table* table = getTable(table_name);
     table->insertRow(values);
+    if (wal && !replaying) {
+        std::vector<std::string> fields;
+        fields.reserve(values.size() + 1);
+        fields.push_back(table_name);
+        fields.insert(fields.end(), values.begin(), values.end());
+        logChange(WalRecordType::INSERT, fields);
+    }
+}
+
+size_t DatabaseEngine::insertBatch(const std::string& table_name,
+                                   const std::vector<std::vector<std::string>>& rows) {
+    Table* table = getTable(table_name);
+    size_t next = 0;
+    size_t added = table->loadRows([&](std::vector<std::string_view>& fields) {
+        if (next == rows.size()) {
+            return false;
+        }
+        fields.assign(rows[next].begin(), rows[next].end());
+        next++;
+        return true;
+    }, rows.size());
+    if (wal && !replaying && added > 0) {
+        std::vector<std::string> fields{table_name, std::to_string(rows[0].size())};
+        fields.reserve(2 + rows.size() * rows[0].size());
+        for (const auto& row : rows) {
+            fields.insert(fields.end(), row.begin(), row.end());
+        }
+        logChange(WalRecordType::INSERT_BATCH, fields);
+    }
+    return added;
+}
+
+size_t DatabaseEngine::copyFrom(const std::string& table_name, const std::string& path,
+                                bool header, char delimiter) {
+    Table* table = getTable(table_name);
+    CsvOptions options;
+    options.header = header;
+    options.delimiter = delimiter;
+    size_t rows = loadCsv(*table, path, options);
+    // Bulk loads bypass the log: the table goes straight to its segment,
+    // which is as durable as a commit once saveTable returns
+    if (wal) {
+        saveTable(table_name);
+    }
+    return rows;
 }
 
 void DatabaseEngine::select(const std::string& table_name, 
                             const std::vector<std::string>& columns,
-                            const std::string& where_clause) const {
+                            const std::string& where_clause,
+                            const std::vector<std::string>& group_by,
+                            QueryProfile* profile) const {
     auto it = tables.find(table_name);
     if (it == tables.end()) {
         throw std::runtime_error("Table '" + table_name + "' not found");
     }
+    selectFrom(*it->second, columns, where_clause, group_by, profile);
+}
+
+void DatabaseEngine::selectJoin(const std::string& left_table, const std::string& right_table,
+                                const std::string& join_type,
+                                const std::string& left_column, const std::string& right_column,
+                                const std::vector<std::string>& columns,
+                                const std::string& where_clause,
+                                const std::vector<std::string>& group_by,
+                                QueryProfile* profile) const {
+    auto left_it = tables.find(left_table);
+    if (left_it == tables.end()) {
+        throw std::runtime_error("Table '" + left_table + "' not found");
+    }
+    auto right_it = tables.find(right_table);
+    if (right_it == tables.end()) {
+        throw std::runtime_error("Table '" + right_table + "' not found");
+    }
     
-    const Table* table = it->second.get();
-    std::vector<size_t> row_indices = table->selectRows(where_clause);
-    table->printRows(row_indices, columns);
+    // ON columns may be qualified and written in either order
+    auto split = [&](const std::string& name, std::string& qualifier, std::string& column) {
+        size_t dot = name.find('.');
+        qualifier = dot == std::string::npos ? "" : name.substr(0, dot);
+        column = dot == std::string::npos ? name : name.substr(dot + 1);
+        if (!qualifier.empty() && qualifier != left_table && qualifier != right_table) {
+            throw std::runtime_error("Unknown table '" + qualifier + "' in JOIN condition");
+        }
+    };
+    std::string first_table, first_column, second_table, second_column;
+    split(left_column, first_table, first_column);
+    split(right_column, second_table, second_column);
+    if (left_table != right_table && (first_table == right_table || second_table == left_table)) {
+        std::swap(first_column, second_column);
+    }
+    
+    JoinType type = joinTypeFromString(join_type);
+    if (!profile) {
+        Table joined = hashJoin(*left_it->second, first_column, *right_it->second, second_column,
+                                type, getThreadPool());
+        selectFrom(joined, columns, where_clause, group_by, nullptr);
+        return;
+    }
+    
+    std::string detail = std::string(type == JoinType::LEFT ? "LEFT" : "INNER") + " JOIN " + right_table +
+                         " ON " + left_column + " = " + right_column;
+    if (!profile->analyze) {
+        // Joining empty copies checks the ON columns and gives the joined schema
+        Table joined = hashJoin(emptyCopy(*left_it->second), first_column, emptyCopy(*right_it->second),
+                                second_column, type);
+        profile->add("Hash Join", detail);
+        selectFrom(joined, columns, where_clause, group_by, profile);
+        return;
+    }
+    
+    auto start = Clock::now();
+    Table joined = hashJoin(*left_it->second, first_column, *right_it->second, second_column,
+                            type, getThreadPool());
+    OperatorProfile& join = profile->add("Hash Join", detail);
+    join.time_ms = millisecondsSince(start);
+    join.rows_in = left_it->second->size() + right_it->second->size();
+    join.rows_out = joined.size();
+    join.bytes = left_it->second->size() * rowBytes(*left_it->second) +
+                 right_it->second->size() * rowBytes(*right_it->second);
+    selectFrom(joined, columns, where_clause, group_by, profile);
+}
+
+void DatabaseEngine::selectFrom(const Table& table,
+                                const std::vector<std::string>& columns,
+                                const std::string& where_clause,
+                                const std::vector<std::string>& group_by,
+                                QueryProfile* profile) const {
+    if (!profile) {
+        // Compile the WHERE clause once instead of re-parsing it per row
+        Predicate predicate = Predicate::compile(where_clause, table);
+        SelectionBitmap selection = table.filter(predicate, getThreadPool());
+        
+        if (AggregatePlan::isAggregateQuery(columns, group_by)) {
+            AggregatePlan plan = AggregatePlan::compile(columns, group_by, table);
+            plan.execute(table, selection, getThreadPool()).printTable();
+            return;
+        }
+        table.printRows(selection, columns);
+        return;
+    }
+    
+    // The same steps, each timed and counted
+    auto start = Clock::now();
+    Predicate predicate = Predicate::compile(where_clause, table);
+    bool aggregate = AggregatePlan::isAggregateQuery(columns, group_by);
+    AggregatePlan plan;
+    if (aggregate) {
+        plan = AggregatePlan::compile(columns, group_by, table);
+    }
+    profile->planning_ms += millisecondsSince(start);
+    
+    // A join result has no name of its own; the Hash Join step names its inputs
+    auto stored = tables.find(table.getName());
+    std::string scan_detail = stored != tables.end() && stored->second.get() == &table ? table.getName() : "";
+    if (!where_clause.empty()) {
+        scan_detail += (scan_detail.empty() ? "WHERE " : " WHERE ") + where_clause;
+    }
+    std::string aggregate_detail = group_by.empty() ? "no GROUP BY" : "GROUP BY " + joinList(group_by);
+    std::string output_detail = columns.empty() ? "*" : joinList(columns);
+    if (!profile->analyze) {
+        // Whether an index answers the WHERE clause is only decided at run
+        // time, from how many rows the lookup returns
+        profile->add(predicate.matchesAll() ? "Seq Scan" : "Filter", scan_detail);
+        if (aggregate) {
+            profile->add("Hash Aggregate", aggregate_detail);
+        }
+        profile->add("Output", output_detail);
+        return;
+    }
+    
+    start = Clock::now();
+    bool used_index = false;
+    SelectionBitmap selection = table.filter(predicate, getThreadPool(), &used_index);
+    size_t selected = selection.count();
+    OperatorProfile& scan = profile->add(used_index ? "Index Scan" : predicate.matchesAll() ? "Seq Scan" : "Filter",
+                                         scan_detail);
+    scan.time_ms = millisecondsSince(start);
+    scan.rows_in = table.size();
+    scan.rows_out = selected;
+    // An index lookup re-checks only the rows it returned
+    scan.bytes = (used_index ? selected : table.size()) * rowBytes(table, predicateColumns(predicate));
+    
+    auto output = [&](size_t rows, const std::function<void()>& print) {
+        CountingBuffer counter;
+        auto output_start = Clock::now();
+        {
+            StreamRedirect redirect(std::cout, &counter);
+            print();
+        }
+        OperatorProfile& op = profile->add("Output", output_detail);
+        op.time_ms = millisecondsSince(output_start);
+        op.rows_in = rows;
+        op.rows_out = rows;
+        op.bytes = counter.bytes;
+    };
+    
+    if (aggregate) {
+        start = Clock::now();
+        Table result = plan.execute(table, selection, getThreadPool());
+        OperatorProfile& op = profile->add("Hash Aggregate", aggregate_detail);
+        op.time_ms = millisecondsSince(start);
+        op.rows_in = selected;
+        op.rows_out = result.size();
+        op.bytes = selected * rowBytes(table, plan.inputColumns());
+        output(result.size(), [&] { result.printTable(); });
+        return;
+    }
+    output(selected, [&] { table.printRows(selection, columns); });
 }
 
 void DatabaseEngine::showTables() const {
@@ -102,6 +601,11 @@ void DatabaseEngine::describeTable(const std::string& table_name) const {
     
     std::cout << "+----------------+----------------+\n";
     std::cout << "(" << columns.size() << " columns, " << table->size() << " rows)\n";
+    
+    for (const auto& entry : table->getIndexes()) {
+        std::cout << "Index " << entry.name << " on " << columns[entry.column_index].name
+                  << " (" << indexTypeToString(entry.index->getType()) << ")\n";
+    }
 }
 
 void DatabaseEngine::executeQuery(const std::string& query) {
@@ -116,12 +620,59 @@ void DatabaseEngine::executeQuery(const std::string& query) {
             }
             std::cout << "Table '" << parsed_query.table_name << "' created successfully.\n";
             
+        } else if (parsed_query.type == QueryType::CREATE_INDEX) {
+            createIndex(parsed_query.table_name, parsed_query.index_name,
+                        parsed_query.index_column, parsed_query.index_type);
+            std::cout << "Index '" << parsed_query.index_name << "' created successfully.\n";
+            
         } else if (parsed_query.type == QueryType::INSERT) {
-            insertInto(parsed_query.table_name, parsed_query.values);
-            std::cout << "1 row inserted.\n";
+            if (parsed_query.rows.size() > 1) {
+                // One batch: one log record and one sync for every row
+                size_t rows = insertBatch(parsed_query.table_name, parsed_query.rows);
+                std::cout << rows << " rows inserted.\n";
+            } else {
+                insertInto(parsed_query.table_name, parsed_query.values);
+                std::cout << "1 row inserted.\n";
+            }
+            
+        } else if (parsed_query.type == QueryType::COPY) {
+            size_t rows = copyFrom(parsed_query.table_name, parsed_query.file_path,
+                                   parsed_query.csv_header, parsed_query.csv_delimiter);
+            std::cout << rows << " rows copied.\n";
+            
+        } else if (parsed_query.type == QueryType::SAVE) {
+            if (parsed_query.table_name.empty()) {
+                if (data_dir.empty()) {
+                    throw std::runtime_error("No data directory (start with --data-dir <dir>)");
+                }
+                std::cout << saveAll() << " tables saved.\n";
+            } else {
+                saveTable(parsed_query.table_name);
+                std::cout << "Table '" << parsed_query.table_name << "' saved.\n";
+            }
             
         } else if (parsed_query.type == QueryType::SELECT) {
-            select(parsed_query.table_name, parsed_query.selected_columns, parsed_query.where_clause);
+            QueryProfile profile;
+            profile.analyze = parsed_query.analyze;
+            QueryProfile* explain = parsed_query.explain ? &profile : nullptr;
+            auto start = Clock::now();
+            if (parsed_query.join_table.empty()) {
+                select(parsed_query.table_name, parsed_query.selected_columns, parsed_query.where_clause,
+                       parsed_query.group_by, explain);
+            } else {
+                selectJoin(parsed_query.table_name, parsed_query.join_table, parsed_query.join_type,
+                           parsed_query.join_left_column, parsed_query.join_right_column,
+                           parsed_query.selected_columns, parsed_query.where_clause, parsed_query.group_by,
+                           explain);
+            }
+            if (explain) {
+                profile.execution_ms = millisecondsSince(start) - profile.planning_ms;
+                profile.toTable().printTable();
+                std::cout << "Planning time: " << QueryProfile::fixed(profile.planning_ms, 3) << " ms\n";
+                if (profile.analyze) {
+                    std::cout << "Execution time: " << QueryProfile::fixed(profile.execution_ms, 3) << " ms\n";
+                }
+            }
             
         } else if (parsed_query.type == QueryType::DROP_TABLE) {
             dropTable(parsed_query.table_name);
@@ -132,6 +683,17 @@ void DatabaseEngine::executeQuery(const std::string& query) {
             
         } else if (parsed_query.type == QueryType::DESCRIBE) {
             describeTable(parsed_query.table_name);
+            
+        } else if (parsed_query.type == QueryType::SET) {
+            applySetting(parsed_query.setting_name, parsed_query.setting_value);
+            
+        } else if (parsed_query.type == QueryType::BEGIN) {
+            beginTransaction();
+            std::cout << "BEGIN\n";
+            
+        } else if (parsed_query.type == QueryType::COMMIT) {
+            commitTransaction();
+            std::cout << "COMMIT\n";
         }
         
     } catch (const std::exception& e) {
@@ -139,6 +701,70 @@ void DatabaseEngine::executeQuery(const std::string& query) {
     }
 }
 
+void DatabaseEngine::beginTransaction() {
+    if (in_transaction) {
+        throw std::runtime_error("A transaction is already in progress");
+    }
+    in_transaction = true;
+    pending_lsn = 0;
+}
+
+void DatabaseEngine::commitTransaction() {
+    if (!in_transaction) {
+        throw std::runtime_error("No transaction in progress");
+    }
+    in_transaction = false;
+    if (wal && pending_lsn > 0) {
+        wal->commit(pending_lsn);
+    }
+    pending_lsn = 0;
+}
+
+void DatabaseEngine::applySetting(const std::string& name, const std::string& value) {
+    if (name == "parallelism" || name == "threads") {
+        size_t num_threads;
+        try {
+            num_threads = std::stoul(value);
+        } catch (const std::exception&) {
+            throw std::runtime_error("Invalid value '" + value + "' for " + name);
+        }
+        setParallelism(num_threads);
+        std::cout << "Parallelism set to " << parallelism << " threads.\n";
+    } else if (name == "synchronous_commit") {
+        std::string flag = value;
+        std::transform(flag.begin(), flag.end(), flag.begin(), ::tolower);
+        if (flag == "on" || flag == "true" || flag == "1") {
+            wal_config.sync_commit = true;
+        } else if (flag == "off" || flag == "false" || flag == "0") {
+            wal_config.sync_commit = false;
+        } else {
+            throw std::runtime_error("Invalid value '" + value + "' for " + name);
+        }
+        if (wal) {
+            wal->setConfig(wal_config);
+        }
+        std::cout << "Synchronous commit " << (wal_config.sync_commit ? "on" : "off") << ".\n";
+    } else if (name == "wal_max_latency_us" || name == "wal_max_batch_bytes") {
+        size_t amount;
+        try {
+            amount = std::stoul(value);
+        } catch (const std::exception&) {
+            throw std::runtime_error("Invalid value '" + value + "' for " + name);
+        }
+        if (name == "wal_max_latency_us") {
+            wal_config.max_latency = std::chrono::microseconds(amount);
+        } else {
+            wal_config.max_batch_bytes = std::max<size_t>(amount, 1);
+        }
+        if (wal) {
+            wal->setConfig(wal_config);
+        }
+        std::cout << "Setting " << name << " = " << amount << ".\n";
+    } else {
+        throw std::runtime_error("Unknown setting '" + name + "'");
+    }
+}
+
 void DatabaseEngine::printDatabaseInfo() const {
     std::cout << "\n=== SimpleDB Database Information ===\n";
     std::cout << "Total tables: " << tables.size() << "\n";
@@ -148,5 +774,11 @@ void DatabaseEngine::printDatabaseInfo() const {
         total_rows += pair.second->size();
     }
     std::cout << "Total rows: " << total_rows << "\n";
+    std::cout << "Parallelism: " << parallelism << " threads\n";
+    std::cout << "Data directory: " << (data_dir.empty() ? "(in-memory)" : data_dir) << "\n";
+    if (wal) {
+        std::cout << "Write-ahead log: LSN " << wal->lastLsn() << ", synchronous commit "
+                  << (wal_config.sync_commit ? "on" : "off") << "\n";
+    }
     std::cout << "====================================\n\n";
 }
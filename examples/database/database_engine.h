@@ -1,35 +1,95 @@
 #pragma once
 
 #include "table.h"
+#include "thread_pool.h"
+#include "wal.h"
 #include <unordered_map>
+#include <unordered_set>
 #include <memory>
 
+struct QueryProfile;
+
 class DatabaseEngine {
 private:
     std::unordered_map<std::string, std::unique_ptr<Table>> tables;
+    size_t parallelism;
+    mutable std::unique_ptr<ThreadPool> thread_pool;  // Created on first parallel query
+    std::string data_dir;                              // Empty: purely in-memory
+    std::unordered_set<std::string> dirty_tables;      // Changed since last save
+    std::unique_ptr<WriteAheadLog> wal;                // Open while data_dir is set
+    WalConfig wal_config;
+    bool replaying = false;                            // Suppresses logging during recovery
+    bool in_transaction = false;                       // Between BEGIN and COMMIT
+    uint64_t pending_lsn = 0;                          // Last record logged in the open transaction
+    
+    ThreadPool* getThreadPool() const;
+    std::string segmentPath(const std::string& table_name) const;
+    void logChange(WalRecordType type, const std::vector<std::string>& fields);
+    void applyLogRecord(const WalRecord& record);
+    void selectFrom(const Table& table,
+                    const std::vector<std::string>& columns,
+                    const std::string& where_clause,
+                    const std::vector<std::string>& group_by,
+                    QueryProfile* profile) const;
     
 public:
-    DatabaseEngine() = default;
+    DatabaseEngine();
     ~DatabaseEngine() = default;
     
+    // Execution settings
+    void setParallelism(size_t num_threads);  // 0 = one thread per core
+    size_t getParallelism() const { return parallelism; }
+    
+    // Persistence: one memory-mapped segment file per table in data_dir,
+    // plus a write-ahead log of every change made since the last checkpoint
+    void openDatabase(const std::string& directory);
+    const std::string& getDataDirectory() const { return data_dir; }
+    void saveTable(const std::string& table_name);
+    size_t saveAll();  // Checkpoint: saves every changed table, then empties the log
+    
     // Table management
     void createTable(const std::string& table_name);
     bool hasTable(const std::string& table_name) const;
-    Table* getTable(const std::string& table_name);
+    Table* getTable(const std::string& table_name);  // Marks the table as changed
     void dropTable(const std::string& table_name);
     std::vector<std::string> listTables() const;
     
     // Database operations
     void addColumn(const std::string& table_name, const std::string& column_name, const std::string& type);
+    void createIndex(const std::string& table_name, const std::string& index_name,
+                     const std::string& column_name, const std::string& index_type);
     void insertInto(const std::string& table_name, const std::vector<std::string>& values);
+    // Bulk loads: values are parsed straight into column storage; a bad
+    // row rejects the whole batch. Both return the number of rows added.
+    size_t insertBatch(const std::string& table_name, const std::vector<std::vector<std::string>>& rows);
+    size_t copyFrom(const std::string& table_name, const std::string& path,
+                    bool header = false, char delimiter = ',');
+    // With a profile, the plan's operators are recorded into it; unless
+    // profile->analyze is set the query is only planned, not run, and
+    // when it is the result is formatted but not printed
     void select(const std::string& table_name, 
                 const std::vector<std::string>& columns = {},
-                const std::string& where_clause = "") const;
+                const std::string& where_clause = "",
+                const std::vector<std::string>& group_by = {},
+                QueryProfile* profile = nullptr) const;
+    void selectJoin(const std::string& left_table, const std::string& right_table,
+                    const std::string& join_type,
+                    const std::string& left_column, const std::string& right_column,
+                    const std::vector<std::string>& columns = {},
+                    const std::string& where_clause = "",
+                    const std::vector<std::string>& group_by = {},
+                    QueryProfile* profile = nullptr) const;
     
     // Utility functions
     void showTables() const;
     void describeTable(const std::string& table_name) const;
     void executeQuery(const std::string& query);
+    // Changes between BEGIN and COMMIT wait for one log sync at COMMIT
+    // instead of one each. There is no rollback: every change is applied
+    // as it runs, and a crash before COMMIT keeps a prefix of them.
+    void beginTransaction();
+    void commitTransaction();
+    void applySetting(const std::string& name, const std::string& value);
     
     // Database info
     size_t getTableCount() const { return tables.size(); }
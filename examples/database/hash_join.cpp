@@ -0,0 +1,297 @@
+#include "hash_join.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+constexpr uint32_t NO_ROW = ColumnVector::NO_ROW;
+
+// Build rows per partition: head and chain arrays for this many rows
+// (~100 KB with the keys) stay resident in L2 while the partition is probed
+constexpr size_t PARTITION_ROWS = 8192;
+constexpr unsigned MAX_RADIX_BITS = 12;
+
+inline uint64_t mixHash(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+// Join keys of one input; rows whose key can never match (NaN, or a
+// string missing from the build dictionary) are kept aside in no_key
+struct KeyedRows {
+    std::vector<uint64_t> keys;
+    std::vector<uint32_t> rows;
+    std::vector<uint32_t> no_key;
+};
+
+// Probe-side strings are translated into the build column's dictionary
+// codes so both sides compare as integers
+KeyedRows extractKeys(const ColumnVector& column, const ColumnVector& build_column) {
+    KeyedRows out;
+    size_t n = column.size();
+    out.keys.reserve(n);
+    out.rows.reserve(n);
+
+    auto add = [&](size_t row, uint64_t key) {
+        out.keys.push_back(key);
+        out.rows.push_back(static_cast<uint32_t>(row));
+    };
+
+    switch (column.getType()) {
+        case ColumnType::INT:
+            for (size_t row = 0; row < n; ++row) {
+                add(row, static_cast<uint32_t>(column.intData()[row]));
+            }
+            break;
+        case ColumnType::DOUBLE:
+            for (size_t row = 0; row < n; ++row) {
+                double value = column.doubleData()[row];
+                if (std::isnan(value)) {
+                    out.no_key.push_back(static_cast<uint32_t>(row));
+                    continue;
+                }
+                if (value == 0.0) {
+                    value = 0.0;  // Fold -0.0 into 0.0
+                }
+                uint64_t bits;
+                std::memcpy(&bits, &value, sizeof(bits));
+                add(row, bits);
+            }
+            break;
+        case ColumnType::BOOL:
+            for (size_t row = 0; row < n; ++row) {
+                add(row, column.boolData()[row]);
+            }
+            break;
+        case ColumnType::STRING: {
+            if (&column == &build_column) {
+                for (size_t row = 0; row < n; ++row) {
+                    add(row, column.stringCodes()[row]);
+                }
+                break;
+            }
+            const StringDictionary& dictionary = column.getDictionary();
+            std::vector<uint32_t> code_map(dictionary.size());
+            for (uint32_t code = 0; code < dictionary.size(); ++code) {
+                if (!build_column.getDictionary().find(dictionary.lookup(code), code_map[code])) {
+                    code_map[code] = NO_ROW;
+                }
+            }
+            for (size_t row = 0; row < n; ++row) {
+                uint32_t code = code_map[column.stringCodes()[row]];
+                if (code == NO_ROW) {
+                    out.no_key.push_back(static_cast<uint32_t>(row));
+                } else {
+                    add(row, code);
+                }
+            }
+            break;
+        }
+    }
+    return out;
+}
+
+inline size_t partitionOf(uint64_t key, unsigned radix_bits) {
+    return radix_bits == 0 ? 0 : mixHash(key) >> (64 - radix_bits);
+}
+
+// Stable scatter of keys/rows into 2^radix_bits contiguous partitions;
+// offsets[p]..offsets[p + 1] delimits partition p
+void radixPartition(KeyedRows& input, unsigned radix_bits, std::vector<size_t>& offsets) {
+    size_t num_partitions = size_t(1) << radix_bits;
+    offsets.assign(num_partitions + 1, 0);
+    if (radix_bits == 0) {
+        offsets[1] = input.keys.size();
+        return;
+    }
+
+    for (uint64_t key : input.keys) {
+        offsets[partitionOf(key, radix_bits) + 1]++;
+    }
+    for (size_t p = 0; p < num_partitions; ++p) {
+        offsets[p + 1] += offsets[p];
+    }
+
+    std::vector<size_t> cursor(offsets.begin(), offsets.end() - 1);
+    std::vector<uint64_t> keys(input.keys.size());
+    std::vector<uint32_t> rows(input.rows.size());
+    for (size_t i = 0; i < input.keys.size(); ++i) {
+        size_t pos = cursor[partitionOf(input.keys[i], radix_bits)]++;
+        keys[pos] = input.keys[i];
+        rows[pos] = input.rows[i];
+    }
+    input.keys.swap(keys);
+    input.rows.swap(rows);
+}
+
+inline uint64_t packPair(uint32_t left_row, uint32_t right_row) {
+    return (uint64_t(left_row) << 32) | right_row;
+}
+
+// Joins one build partition against the matching probe partition; emits
+// (left row, right row) pairs
+void joinPartition(const uint64_t* build_keys, const uint32_t* build_rows, size_t build_count,
+                   const uint64_t* probe_keys, const uint32_t* probe_rows, size_t probe_count,
+                   bool build_is_left, bool keep_unmatched_probe, bool keep_unmatched_build,
+                   std::vector<uint64_t>& out) {
+    size_t capacity = 16;
+    while (capacity < build_count * 2) {
+        capacity <<= 1;
+    }
+    size_t mask = capacity - 1;
+
+    // Chains are threaded back to front so each walks build rows in order
+    std::vector<uint32_t> heads(capacity, NO_ROW);
+    std::vector<uint32_t> next(build_count);
+    for (size_t i = build_count; i-- > 0;) {
+        size_t slot = mixHash(build_keys[i]) & mask;
+        next[i] = heads[slot];
+        heads[slot] = static_cast<uint32_t>(i);
+    }
+
+    auto emit = [&](uint32_t build_row, uint32_t probe_row) {
+        out.push_back(build_is_left ? packPair(build_row, probe_row) : packPair(probe_row, build_row));
+    };
+
+    std::vector<uint8_t> matched(keep_unmatched_build ? build_count : 0, 0);
+    for (size_t j = 0; j < probe_count; ++j) {
+        uint64_t key = probe_keys[j];
+        bool found = false;
+        for (uint32_t e = heads[mixHash(key) & mask]; e != NO_ROW; e = next[e]) {
+            if (build_keys[e] == key) {
+                emit(build_rows[e], probe_rows[j]);
+                found = true;
+                if (keep_unmatched_build) {
+                    matched[e] = 1;
+                }
+            }
+        }
+        if (!found && keep_unmatched_probe) {
+            out.push_back(packPair(probe_rows[j], NO_ROW));
+        }
+    }
+
+    if (keep_unmatched_build) {
+        for (size_t i = 0; i < build_count; ++i) {
+            if (!matched[i]) {
+                out.push_back(packPair(build_rows[i], NO_ROW));
+            }
+        }
+    }
+}
+
+} // namespace
+
+JoinType joinTypeFromString(const std::string& type) {
+    std::string lower = type;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    if (lower.empty() || lower == "inner") {
+        return JoinType::INNER;
+    } else if (lower == "left") {
+        return JoinType::LEFT;
+    }
+    throw std::runtime_error("Unknown join type '" + type + "' (expected INNER or LEFT)");
+}
+
+Table hashJoin(const Table& left, const std::string& left_column,
+               const Table& right, const std::string& right_column,
+               JoinType type, ThreadPool* pool) {
+    size_t left_key = left.getColumnIndex(left_column);
+    size_t right_key = right.getColumnIndex(right_column);
+    const ColumnVector& left_data = left.getColumnData(left_key);
+    const ColumnVector& right_data = right.getColumnData(right_key);
+    if (left_data.getType() != right_data.getType()) {
+        throw std::runtime_error("Cannot join " + left.getColumns()[left_key].type + " column '" + left_column +
+                                 "' with " + right.getColumns()[right_key].type + " column '" + right_column + "'");
+    }
+
+    // Build on the smaller input; LEFT joins keep whichever side is left
+    bool build_is_left = left.size() < right.size();
+    const ColumnVector& build_data = build_is_left ? left_data : right_data;
+    const ColumnVector& probe_data = build_is_left ? right_data : left_data;
+    bool keep_unmatched_build = type == JoinType::LEFT && build_is_left;
+    bool keep_unmatched_probe = type == JoinType::LEFT && !build_is_left;
+
+    KeyedRows build = extractKeys(build_data, build_data);
+    KeyedRows probe = extractKeys(probe_data, build_data);
+
+    unsigned radix_bits = 0;
+    while (radix_bits < MAX_RADIX_BITS && (build.keys.size() >> radix_bits) > PARTITION_ROWS) {
+        radix_bits++;
+    }
+
+    std::vector<size_t> build_offsets;
+    std::vector<size_t> probe_offsets;
+    radixPartition(build, radix_bits, build_offsets);
+    radixPartition(probe, radix_bits, probe_offsets);
+
+    size_t num_partitions = size_t(1) << radix_bits;
+    std::vector<std::vector<uint64_t>> partition_pairs(num_partitions);
+    auto run_partition = [&](size_t p, size_t) {
+        size_t b = build_offsets[p];
+        size_t q = probe_offsets[p];
+        joinPartition(build.keys.data() + b, build.rows.data() + b, build_offsets[p + 1] - b,
+                      probe.keys.data() + q, probe.rows.data() + q, probe_offsets[p + 1] - q,
+                      build_is_left, keep_unmatched_probe, keep_unmatched_build, partition_pairs[p]);
+    };
+    if (pool && num_partitions > 1) {
+        pool->parallelFor(num_partitions, run_partition);
+    } else {
+        for (size_t p = 0; p < num_partitions; ++p) {
+            run_partition(p, 0);
+        }
+    }
+
+    size_t total = 0;
+    for (const auto& pairs : partition_pairs) {
+        total += pairs.size();
+    }
+    std::vector<uint64_t> pairs;
+    pairs.reserve(total + (type == JoinType::LEFT ? left.size() : 0));
+    for (auto& partition : partition_pairs) {
+        pairs.insert(pairs.end(), partition.begin(), partition.end());
+        std::vector<uint64_t>().swap(partition);
+    }
+    if (type == JoinType::LEFT) {
+        const std::vector<uint32_t>& unmatched = build_is_left ? build.no_key : probe.no_key;
+        for (uint32_t row : unmatched) {
+            pairs.push_back(packPair(row, NO_ROW));
+        }
+    }
+    if (!std::is_sorted(pairs.begin(), pairs.end())) {
+        std::sort(pairs.begin(), pairs.end());
+    }
+
+    std::vector<uint32_t> left_rows(pairs.size());
+    std::vector<uint32_t> right_rows(pairs.size());
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        left_rows[i] = static_cast<uint32_t>(pairs[i] >> 32);
+        right_rows[i] = static_cast<uint32_t>(pairs[i]);
+    }
+
+    Table result("result");
+    std::vector<const ColumnVector*> sources;
+    std::vector<const uint32_t*> rows;
+    for (size_t i = 0; i < left.getColumns().size(); ++i) {
+        const Column& column = left.getColumns()[i];
+        result.addColumn(left.getName() + "." + column.name, column.type);
+        sources.push_back(&left.getColumnData(i));
+        rows.push_back(left_rows.data());
+    }
+    for (size_t i = 0; i < right.getColumns().size(); ++i) {
+        const Column& column = right.getColumns()[i];
+        result.addColumn(right.getName() + "." + column.name, column.type);
+        sources.push_back(&right.getColumnData(i));
+        rows.push_back(right_rows.data());
+    }
+    result.appendRows(sources, rows, pairs.size());
+    return result;
+}
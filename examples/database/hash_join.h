@@ -0,0 +1,23 @@
+#pragma once
+
+#include "table.h"
+#include <string>
+
+class ThreadPool;
+
+enum class JoinType {
+    INNER,
+    LEFT   // Unmatched left rows get default values for the right columns
+};
+
+JoinType joinTypeFromString(const std::string& type);
+
+// Equi-join of two tables on one column each. The smaller table is the
+// build side; once it outgrows a cache-sized hash table both inputs are
+// radix-partitioned on the key hash and each partition pair is joined on
+// its own (in parallel when a pool is given). The result has every left
+// column followed by every right column, named "table.column", with rows
+// ordered by left row.
+Table hashJoin(const Table& left, const std::string& left_column,
+               const Table& right, const std::string& right_column,
+               JoinType type, ThreadPool* pool = nullptr);
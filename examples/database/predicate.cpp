@@ -0,0 +1,272 @@
+#include "predicate.h"
+#include "scan_kernels.h"
+#include <sstream>
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+namespace {
+
+template <typename T, typename U>
+inline bool compareValues(const T& lhs, const U& rhs, CompareOp op) {
+    switch (op) {
+        case CompareOp::EQ: return lhs == rhs;
+        case CompareOp::NE: return lhs != rhs;
+        case CompareOp::LT: return lhs < rhs;
+        case CompareOp::GT: return lhs > rhs;
+        case CompareOp::LE: return lhs <= rhs;
+        case CompareOp::GE: return lhs >= rhs;
+    }
+    return false;
+}
+
+std::string toLower(const std::string& str) {
+    std::string lower = str;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    return lower;
+}
+
+std::string stripQuotes(const std::string& value) {
+    if (value.length() >= 2 &&
+        ((value.front() == '"' && value.back() == '"') ||
+         (value.front() == '\'' && value.back() == '\''))) {
+        return value.substr(1, value.length() - 2);
+    }
+    return value;
+}
+
+Comparison compileComparison(const std::string& column_name, const std::string& op,
+                             const std::string& literal, const Table& table) {
+    Comparison cmp;
+    cmp.column_index = table.getColumnIndex(column_name);
+    cmp.op = parseCompareOp(op);
+
+    const ColumnVector& column = table.getColumnData(cmp.column_index);
+    cmp.type = column.getType();
+    cmp.int_value = 0;
+    cmp.double_value = 0.0;
+    cmp.bool_value = false;
+    cmp.string_code = 0;
+    cmp.code_found = false;
+
+    std::string value_str = stripQuotes(literal);
+    Value constant;
+    try {
+        constant = table.parseValue(value_str, table.getColumns()[cmp.column_index].type);
+    } catch (const std::logic_error&) {
+        throw std::runtime_error("Invalid value '" + value_str + "' for column '" + column_name + "'");
+    }
+
+    switch (cmp.type) {
+        case ColumnType::INT:
+            cmp.int_value = std::get<int>(constant);
+            break;
+        case ColumnType::DOUBLE:
+            cmp.double_value = std::get<double>(constant);
+            break;
+        case ColumnType::BOOL:
+            cmp.bool_value = std::get<bool>(constant);
+            break;
+        case ColumnType::STRING:
+            cmp.string_value = std::get<std::string>(constant);
+            cmp.code_found = column.getDictionary().find(cmp.string_value, cmp.string_code);
+            if (cmp.op != CompareOp::EQ && cmp.op != CompareOp::NE) {
+                // Compare each distinct string once; scans then just index by code
+                const StringDictionary& dictionary = column.getDictionary();
+                cmp.code_matches.resize(dictionary.size());
+                for (size_t code = 0; code < dictionary.size(); ++code) {
+                    cmp.code_matches[code] = compareValues(dictionary.lookup(static_cast<uint32_t>(code)),
+                                                           std::string_view(cmp.string_value), cmp.op);
+                }
+            }
+            break;
+    }
+    return cmp;
+}
+
+} // namespace
+
+CompareOp parseCompareOp(const std::string& op) {
+    if (op == "=" || op == "==") {
+        return CompareOp::EQ;
+    } else if (op == "!=" || op == "<>") {
+        return CompareOp::NE;
+    } else if (op == "<") {
+        return CompareOp::LT;
+    } else if (op == ">") {
+        return CompareOp::GT;
+    } else if (op == "<=") {
+        return CompareOp::LE;
+    } else if (op == ">=") {
+        return CompareOp::GE;
+    }
+    throw std::runtime_error("Unknown operator '" + op + "' in WHERE clause");
+}
+
+bool Comparison::matches(const Table& table, size_t row_idx) const {
+    const ColumnVector& column = table.getColumnData(column_index);
+    if (column.isNull(row_idx)) {
+        return false;
+    }
+
+    switch (type) {
+        case ColumnType::INT:
+            return compareValues(column.intData()[row_idx], int_value, op);
+        case ColumnType::DOUBLE:
+            return compareValues(column.doubleData()[row_idx], double_value, op);
+        case ColumnType::BOOL:
+            return compareValues(column.boolData()[row_idx] != 0, bool_value, op);
+        case ColumnType::STRING:
+            // Equality only needs the code; ordering uses the per-code results
+            if (op == CompareOp::EQ) {
+                return code_found && column.stringCodes()[row_idx] == string_code;
+            } else if (op == CompareOp::NE) {
+                return !code_found || column.stringCodes()[row_idx] != string_code;
+            }
+            return code_matches[column.stringCodes()[row_idx]] != 0;
+    }
+    return false;
+}
+
+bool Comparison::mayMatch(double min, double max) const {
+    double value;
+    if (type == ColumnType::INT) {
+        value = int_value;
+    } else if (type == ColumnType::DOUBLE) {
+        value = double_value;
+    } else {
+        return true;
+    }
+
+    switch (op) {
+        case CompareOp::EQ: return min <= value && value <= max;
+        case CompareOp::NE: return !(min == value && max == value);
+        case CompareOp::LT: return min < value;
+        case CompareOp::GT: return max > value;
+        case CompareOp::LE: return min <= value;
+        case CompareOp::GE: return max >= value;
+    }
+    return true;
+}
+
+Predicate Predicate::compile(const std::string& where_clause, const Table& table) {
+    // Grammar: comparison { (AND | OR) comparison }
+    // where comparison is: column operator value
+    Predicate predicate;
+    std::istringstream iss(where_clause);
+    std::vector<std::string> tokens;
+    std::string token;
+    while (iss >> token) {
+        tokens.push_back(token);
+    }
+
+    if (tokens.empty()) {
+        return predicate;
+    }
+
+    std::vector<Comparison> group;
+    size_t i = 0;
+    while (true) {
+        if (i + 2 >= tokens.size()) {
+            throw std::runtime_error("Invalid WHERE clause: " + where_clause);
+        }
+        group.push_back(compileComparison(tokens[i], tokens[i + 1], tokens[i + 2], table));
+        i += 3;
+
+        if (i == tokens.size()) {
+            break;
+        }
+
+        std::string conjunction = toLower(tokens[i]);
+        if (conjunction == "or") {
+            predicate.disjuncts.push_back(std::move(group));
+            group.clear();
+        } else if (conjunction != "and") {
+            throw std::runtime_error("Expected AND/OR in WHERE clause, got '" + tokens[i] + "'");
+        }
+        i++;
+    }
+    predicate.disjuncts.push_back(std::move(group));
+
+    return predicate;
+}
+
+bool Predicate::matches(const Table& table, size_t row_idx) const {
+    if (disjuncts.empty()) {
+        return true;
+    }
+
+    for (const auto& group : disjuncts) {
+        bool group_matches = true;
+        for (const auto& cmp : group) {
+            if (!cmp.matches(table, row_idx)) {
+                group_matches = false;
+                break;
+            }
+        }
+        if (group_matches) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Predicate::evaluate(const Table& table, size_t begin, size_t count, uint64_t* out_words) const {
+    size_t num_words = (count + 63) / 64;
+    if (disjuncts.empty()) {
+        for (size_t w = 0; w < num_words; ++w) {
+            out_words[w] = ~uint64_t(0);
+        }
+        if (count % 64) {
+            out_words[num_words - 1] = (uint64_t(1) << (count % 64)) - 1;
+        }
+        return;
+    }
+
+    std::vector<uint64_t> group_bits(num_words);
+    std::vector<uint64_t> cmp_bits(num_words);
+
+    for (size_t g = 0; g < disjuncts.size(); ++g) {
+        // The first group is written straight into the output
+        uint64_t* target = (g == 0) ? out_words : group_bits.data();
+        const auto& group = disjuncts[g];
+
+        // Skip the group if a zone map rules out one of its comparisons
+        bool may_match = true;
+        for (size_t c = 0; c < group.size() && may_match; ++c) {
+            double min, max;
+            if (table.getColumnData(group[c].column_index).zoneRange(begin, count, min, max)) {
+                may_match = group[c].mayMatch(min, max);
+            }
+        }
+        if (!may_match) {
+            if (g == 0) {
+                std::fill(out_words, out_words + num_words, 0);
+            }
+            continue;
+        }
+
+        scan::filterColumn(table.getColumnData(group[0].column_index), begin, count, group[0], target);
+        for (size_t c = 1; c < group.size(); ++c) {
+            uint64_t any = 0;
+            for (size_t w = 0; w < num_words; ++w) {
+                any |= target[w];
+            }
+            if (!any) {
+                break;  // Nothing left for the remaining comparisons to reject
+            }
+
+            const Comparison& cmp = group[c];
+            scan::filterColumn(table.getColumnData(cmp.column_index), begin, count, cmp, cmp_bits.data());
+            for (size_t w = 0; w < num_words; ++w) {
+                target[w] &= cmp_bits[w];
+            }
+        }
+
+        if (g > 0) {
+            for (size_t w = 0; w < num_words; ++w) {
+                out_words[w] |= group_bits[w];
+            }
+        }
+    }
+}
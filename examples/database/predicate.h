@@ -0,0 +1,58 @@
+#pragma once
+
+#include "table.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Comparison operators supported in WHERE clauses
+enum class CompareOp {
+    EQ,  // =
+    NE,  // !=
+    LT,  // <
+    GT,  // >
+    LE,  // <=
+    GE   // >=
+};
+
+// A single "column operator constant" test with the column resolved to an
+// index and the constant already parsed into the column's type
+struct Comparison {
+    size_t column_index;
+    ColumnType type;
+    CompareOp op;
+    int int_value;
+    double double_value;
+    bool bool_value;
+    std::string string_value;
+    uint32_t string_code;    // Dictionary code of string_value...
+    bool code_found;         // ...valid only if the string is in the dictionary
+    std::vector<uint8_t> code_matches;  // For string ordering: result per dictionary code
+
+    bool matches(const Table& table, size_t row_idx) const;
+    // False if no value in [min, max] can satisfy the comparison (zone maps)
+    bool mayMatch(double min, double max) const;
+};
+
+// A WHERE clause compiled against a table schema. Stored in disjunctive
+// normal form: the predicate holds if any group holds, and a group holds
+// if all of its comparisons hold (AND binds tighter than OR).
+class Predicate {
+private:
+    std::vector<std::vector<Comparison>> disjuncts;
+
+public:
+    Predicate() = default;  // Matches every row
+
+    static Predicate compile(const std::string& where_clause, const Table& table);
+
+    bool matchesAll() const { return disjuncts.empty(); }
+    bool matches(const Table& table, size_t row_idx) const;
+
+    // Vectorized evaluation of rows [begin, begin + count) into a bitmap
+    // (one bit per row, begin must be a multiple of 64)
+    void evaluate(const Table& table, size_t begin, size_t count, uint64_t* out_words) const;
+    const std::vector<std::vector<Comparison>>& getDisjuncts() const { return disjuncts; }
+};
+
+CompareOp parseCompareOp(const std::string& op);
@@ -12,32 +12,27 @@ std::vector<std::string> QueryParser::tokenize(const std::string& query) const {
         // Handle parentheses and commas
         std::string current = token;
         
+        // Split off leading parentheses
+        while (!current.empty() && current.front() == '(') {
+            tokens.push_back("(");
+            current = current.substr(1);
+        }
+        
         // Remove trailing punctuation but keep track of it
+        std::vector<std::string> trailing;
         while (!current.empty() && (current.back() == ',' || current.back() == ';' || current.back() == ')')) {
             char punct = current.back();
             current = current.substr(0, current.length() - 1);
             
-            if (!current.empty()) {
-                tokens.push_back(current);
-            }
-            
             if (punct == ',' || punct == ')') {
-                tokens.push_back(std::string(1, punct));
+                trailing.insert(trailing.begin(), std::string(1, punct));
             }
-            
-            current = "";
-            break;
-        }
-        
-        // Handle leading parentheses
-        if (!current.empty() && current.front() == '(') {
-            tokens.push_back("(");
-            current = current.substr(1);
         }
         
         if (!current.empty()) {
             tokens.push_back(current);
         }
+        tokens.insert(tokens.end(), trailing.begin(), trailing.end());
     }
     
     return tokens;
@@ -57,16 +52,35 @@ ParsedQuery QueryParser::parse(const std::string& query) const {
         return parsed_query;
     }
     
+    // EXPLAIN [ANALYZE] SELECT ...: the SELECT is parsed as usual
+    if (toLower(tokens[0]) == "explain") {
+        parsed_query.explain = true;
+        tokens.erase(tokens.begin());
+        if (!tokens.empty() && toLower(tokens[0]) == "analyze") {
+            parsed_query.analyze = true;
+            tokens.erase(tokens.begin());
+        }
+        if (tokens.empty() || toLower(tokens[0]) != "select") {
+            throw std::runtime_error("EXPLAIN supports SELECT only");
+        }
+    }
+    
     std::string first_token = toLower(tokens[0]);
     
     if (first_token == "create") {
         if (tokens.size() > 1 && toLower(tokens[1]) == "table") {
             parsed_query.type = QueryType::CREATE_TABLE;
             parseCreateTable(tokens, parsed_query);
+        } else if (tokens.size() > 1 && toLower(tokens[1]) == "index") {
+            parsed_query.type = QueryType::CREATE_INDEX;
+            parseCreateIndex(tokens, parsed_query);
         }
     } else if (first_token == "insert") {
         parsed_query.type = QueryType::INSERT;
         parseInsert(tokens, parsed_query);
+    } else if (first_token == "copy") {
+        parsed_query.type = QueryType::COPY;
+        parseCopy(tokens, parsed_query);
     } else if (first_token == "select") {
         parsed_query.type = QueryType::SELECT;
         parseSelect(tokens, parsed_query);
@@ -82,6 +96,23 @@ ParsedQuery QueryParser::parse(const std::string& query) const {
     } else if (first_token == "describe" || first_token == "desc") {
         parsed_query.type = QueryType::DESCRIBE;
         parseDescribe(tokens, parsed_query);
+    } else if (first_token == "save") {
+        // SAVE [table_name]
+        parsed_query.type = QueryType::SAVE;
+        if (tokens.size() > 1) {
+            parsed_query.table_name = tokens[1];
+        }
+    } else if (first_token == "checkpoint") {
+        // CHECKPOINT: save every changed table and empty the log
+        parsed_query.type = QueryType::SAVE;
+    } else if (first_token == "begin" || first_token == "start") {
+        // BEGIN [TRANSACTION] / START TRANSACTION
+        parsed_query.type = QueryType::BEGIN;
+    } else if (first_token == "commit" || first_token == "end") {
+        parsed_query.type = QueryType::COMMIT;
+    } else if (first_token == "set") {
+        parsed_query.type = QueryType::SET;
+        parseSet(tokens, parsed_query);
     }
     
     return parsed_query;
@@ -124,8 +155,37 @@ void QueryParser::parseCreateTable(const std::vector<std::string>& tokens, Parse
     }
 }
 
+void QueryParser::parseCreateIndex(const std::vector<std::string>& tokens, ParsedQuery& query) const {
+    // CREATE INDEX index_name ON table_name (column) [USING HASH|BTREE]
+    if (tokens.size() < 7) {
+        throw std::runtime_error("Invalid CREATE INDEX syntax");
+    }
+    
+    query.index_name = tokens[2];
+    
+    if (toLower(tokens[3]) != "on") {
+        throw std::runtime_error("Expected 'ON' in CREATE INDEX statement");
+    }
+    
+    query.table_name = tokens[4];
+    
+    if (tokens[5] != "(" || tokens.size() < 8 || tokens[7] != ")") {
+        throw std::runtime_error("Expected '(column)' in CREATE INDEX statement");
+    }
+    
+    query.index_column = tokens[6];
+    query.index_type = "btree";
+    
+    if (tokens.size() > 8) {
+        if (toLower(tokens[8]) != "using" || tokens.size() < 10) {
+            throw std::runtime_error("Expected 'USING HASH' or 'USING BTREE' after index column");
+        }
+        query.index_type = toLower(tokens[9]);
+    }
+}
+
 void QueryParser::parseInsert(const std::vector<std::string>& tokens, ParsedQuery& query) const {
-    // INSERT INTO table_name VALUES (val1, val2, ...)
+    // INSERT INTO table_name VALUES (val1, val2, ...) [, (val1, val2, ...) ...]
     if (tokens.size() < 5) {
         throw std::runtime_error("Invalid INSERT syntax");
     }
@@ -140,40 +200,90 @@ void QueryParser::parseInsert(const std::vector<std::string>& tokens, ParsedQuer
         throw std::runtime_error("Expected 'VALUES' in INSERT statement");
     }
     
-    // Find values in parentheses
-    size_t start = 4;
-    while (start < tokens.size() && tokens[start] != "(") {
-        start++;
+    // One or more parenthesized tuples: (v1, v2, ...), (v1, v2, ...)
+    size_t i = 4;
+    while (i < tokens.size()) {
+        if (tokens[i] == ",") {
+            i++;
+            continue;
+        }
+        if (tokens[i] != "(") {
+            throw std::runtime_error("Expected '(' in INSERT values");
+        }
+        
+        std::vector<std::string> row;
+        for (i++; i < tokens.size() && tokens[i] != ")"; ++i) {
+            if (tokens[i] == ",") {
+                continue;
+            }
+            
+            // Remove quotes if present
+            std::string value = tokens[i];
+            if (value.length() >= 2 && 
+                ((value.front() == '"' && value.back() == '"') ||
+                 (value.front() == '\'' && value.back() == '\''))) {
+                value = value.substr(1, value.length() - 2);
+            }
+            
+            row.push_back(value);
+        }
+        if (i >= tokens.size()) {
+            throw std::runtime_error("Missing ')' in INSERT values");
+        }
+        i++;
+        query.rows.push_back(std::move(row));
     }
     
-    if (start >= tokens.size()) {
+    if (query.rows.empty()) {
         throw std::runtime_error("Missing values in INSERT statement");
     }
+    query.values = query.rows[0];
+}
+
+void QueryParser::parseCopy(const std::vector<std::string>& tokens, ParsedQuery& query) const {
+    // COPY table_name FROM 'file.csv' [WITH] [HEADER] [DELIMITER 'c']
+    if (tokens.size() < 4 || toLower(tokens[2]) != "from") {
+        throw std::runtime_error("Invalid COPY syntax (expected COPY <table> FROM '<file>')");
+    }
     
-    start++; // Skip opening parenthesis
-    for (size_t i = start; i < tokens.size(); ++i) {
-        if (tokens[i] == ")") {
-            break;
-        }
-        if (tokens[i] == ",") {
-            continue;
-        }
-        
-        // Remove quotes if present
-        std::string value = tokens[i];
-        if (value.length() >= 2 && 
+    auto unquote = [](std::string value) {
+        if (value.length() >= 2 &&
             ((value.front() == '"' && value.back() == '"') ||
              (value.front() == '\'' && value.back() == '\''))) {
             value = value.substr(1, value.length() - 2);
         }
-        
-        query.values.push_back(value);
+        return value;
+    };
+    
+    query.table_name = tokens[1];
+    query.file_path = unquote(tokens[3]);
+    
+    for (size_t i = 4; i < tokens.size(); ++i) {
+        std::string option = toLower(tokens[i]);
+        if (option == "with" || option == "(" || option == ")" || option == ",") {
+            continue;
+        } else if (option == "header") {
+            query.csv_header = true;
+        } else if (option == "delimiter" && i + 1 < tokens.size()) {
+            std::string delimiter = unquote(tokens[++i]);
+            if (delimiter == "\\t") {
+                delimiter = "\t";
+            }
+            if (delimiter.length() != 1) {
+                throw std::runtime_error("DELIMITER must be a single character");
+            }
+            query.csv_delimiter = delimiter[0];
+        } else {
+            throw std::runtime_error("Unknown COPY option '" + tokens[i] + "'");
+        }
     }
 }
 
 void QueryParser::parseSelect(const std::vector<std::string>& tokens, ParsedQuery& query) const {
     // SELECT col1, col2, ... FROM table_name [WHERE condition]
     // SELECT * FROM table_name [WHERE condition]
+    // SELECT col, AGG(col), ... FROM table_name [WHERE condition] [GROUP BY col, ...]
+    // SELECT ... FROM left [INNER|LEFT] JOIN right ON left.col = right.col [WHERE ...] [GROUP BY ...]
     
     if (tokens.size() < 4) {
         throw std::runtime_error("Invalid SELECT syntax");
@@ -191,40 +301,130 @@ void QueryParser::parseSelect(const std::vector<std::string>& tokens, ParsedQuer
         throw std::runtime_error("Missing 'FROM' in SELECT statement");
     }
     
-    // Parse selected columns
+    // Parse selected columns. Aggregate calls may have been split by the
+    // tokenizer ("COUNT(*" ")"), so rejoin the select list and split it on
+    // commas outside parentheses.
+    std::string select_list;
     for (size_t i = 1; i < from_pos; ++i) {
-        if (tokens[i] == ",") {
-            continue;
+        select_list += tokens[i];
+    }
+    
+    std::string item;
+    int depth = 0;
+    for (char c : select_list) {
+        if (c == '(') {
+            depth++;
+        } else if (c == ')') {
+            depth--;
         }
-        if (tokens[i] == "*") {
-            query.selected_columns.clear(); // Empty means select all
-            break;
+        if (c == ',' && depth == 0) {
+            if (!item.empty()) {
+                query.selected_columns.push_back(item);
+            }
+            item.clear();
         } else {
-            query.selected_columns.push_back(tokens[i]);
+            item += c;
         }
     }
+    if (!item.empty()) {
+        query.selected_columns.push_back(item);
+    }
+    
+    if (std::find(query.selected_columns.begin(), query.selected_columns.end(), "*") !=
+        query.selected_columns.end()) {
+        query.selected_columns.clear(); // Empty means select all
+    }
     
     // Parse table name
     if (from_pos + 1 >= tokens.size()) {
         throw std::runtime_error("Missing table name after 'FROM'");
     }
     query.table_name = tokens[from_pos + 1];
+    size_t clause_pos = from_pos + 2;
+    
+    // Optional [INNER | LEFT [OUTER]] JOIN table ON a.col = b.col
+    if (clause_pos < tokens.size()) {
+        std::string keyword = toLower(tokens[clause_pos]);
+        if (keyword == "inner" || keyword == "left") {
+            query.join_type = keyword;
+            clause_pos++;
+            if (keyword == "left" && clause_pos < tokens.size() && toLower(tokens[clause_pos]) == "outer") {
+                clause_pos++;
+            }
+            if (clause_pos >= tokens.size() || toLower(tokens[clause_pos]) != "join") {
+                throw std::runtime_error("Expected 'JOIN' after '" + tokens[clause_pos - 1] + "'");
+            }
+        }
+        if (clause_pos < tokens.size() && toLower(tokens[clause_pos]) == "join") {
+            if (query.join_type.empty()) {
+                query.join_type = "inner";
+            }
+            clause_pos = parseJoin(tokens, clause_pos + 1, query);
+        }
+    }
     
-    // Parse WHERE clause if present
+    // Locate the optional WHERE and GROUP BY clauses
     size_t where_pos = 0;
-    for (size_t i = from_pos + 2; i < tokens.size(); ++i) {
-        if (toLower(tokens[i]) == "where") {
+    size_t group_pos = tokens.size();
+    for (size_t i = clause_pos; i < tokens.size(); ++i) {
+        std::string keyword = toLower(tokens[i]);
+        if (keyword == "where" && where_pos == 0) {
             where_pos = i;
+        } else if (keyword == "group" && i + 1 < tokens.size() && toLower(tokens[i + 1]) == "by") {
+            group_pos = i;
             break;
         }
     }
     
-    if (where_pos > 0 && where_pos + 3 < tokens.size()) {
-        // Simple WHERE clause: column operator value
-        query.where_clause = tokens[where_pos + 1] + " " + 
-                            tokens[where_pos + 2] + " " + 
-                            tokens[where_pos + 3];
+    if (where_pos > 0) {
+        // WHERE clause: column operator value [AND|OR column operator value ...]
+        // Validation happens when the engine compiles it against the table
+        for (size_t i = where_pos + 1; i < group_pos; ++i) {
+            if (!query.where_clause.empty()) {
+                query.where_clause += " ";
+            }
+            query.where_clause += tokens[i];
+        }
+        if (query.where_clause.empty()) {
+            throw std::runtime_error("Missing condition after 'WHERE'");
+        }
     }
+    
+    if (group_pos < tokens.size()) {
+        // GROUP BY col1, col2, ...
+        for (size_t i = group_pos + 2; i < tokens.size(); ++i) {
+            if (tokens[i] != ",") {
+                query.group_by.push_back(tokens[i]);
+            }
+        }
+        if (query.group_by.empty()) {
+            throw std::runtime_error("Missing column list after 'GROUP BY'");
+        }
+    }
+}
+
+size_t QueryParser::parseJoin(const std::vector<std::string>& tokens, size_t pos, ParsedQuery& query) const {
+    // JOIN table_name ON column = column; returns the position after the condition
+    if (pos + 1 >= tokens.size() || toLower(tokens[pos + 1]) != "on") {
+        throw std::runtime_error("Expected 'JOIN <table> ON <condition>'");
+    }
+    query.join_table = tokens[pos];
+    
+    // The condition may be written with or without spaces around '='
+    std::string condition;
+    size_t end = pos + 2;
+    while (end < tokens.size() && toLower(tokens[end]) != "where" && toLower(tokens[end]) != "group") {
+        condition += tokens[end++];
+    }
+    
+    size_t eq = condition.find('=');
+    if (eq == std::string::npos || eq == 0 || eq + 1 >= condition.length() ||
+        condition.find('=', eq + 1) != std::string::npos) {
+        throw std::runtime_error("JOIN condition must be '<column> = <column>'");
+    }
+    query.join_left_column = condition.substr(0, eq);
+    query.join_right_column = condition.substr(eq + 1);
+    return end;
 }
 
 void QueryParser::parseDropTable(const std::vector<std::string>& tokens, ParsedQuery& query) const {
@@ -244,3 +444,14 @@ void QueryParser::parseDescribe(const std::vector<std::string>& tokens, ParsedQu
     
     query.table_name = tokens[1];
 }
+
+void QueryParser::parseSet(const std::vector<std::string>& tokens, ParsedQuery& query) const {
+    // SET setting value or SET setting = value
+    size_t value_pos = (tokens.size() > 2 && tokens[2] == "=") ? 3 : 2;
+    if (tokens.size() <= value_pos) {
+        throw std::runtime_error("Invalid SET syntax");
+    }
+    
+    query.setting_name = toLower(tokens[1]);
+    query.setting_value = tokens[value_pos];
+}
@@ -6,11 +6,17 @@
 
 enum class QueryType {
     CREATE_TABLE,
+    CREATE_INDEX,
     INSERT,
+    COPY,
     SELECT,
     DROP_TABLE,
     SHOW_TABLES,
     DESCRIBE,
+    SET,
+    SAVE,
+    BEGIN,
+    COMMIT,
     UNKNOWN
 };
 
@@ -19,10 +25,26 @@ struct ParsedQuery {
     std::string table_name;
     std::vector<Column> columns;
     std::vector<std::string> selected_columns;
-    std::vector<std::string> values;
+    std::vector<std::string> values;             // The first VALUES tuple
+    std::vector<std::vector<std::string>> rows;  // Every VALUES tuple
     std::string where_clause;
+    std::vector<std::string> group_by;
+    std::string join_type;          // Empty when the query has no JOIN
+    std::string join_table;
+    std::string join_left_column;   // As written in ON, possibly table-qualified
+    std::string join_right_column;
+    std::string index_name;
+    std::string index_column;
+    std::string index_type;
+    std::string file_path;
+    bool csv_header;
+    char csv_delimiter;
+    std::string setting_name;
+    std::string setting_value;
+    bool explain;                   // EXPLAIN: print the plan instead of the result
+    bool analyze;                   // EXPLAIN ANALYZE: run it and print per-operator counters
     
-    ParsedQuery() : type(QueryType::UNKNOWN) {}
+    ParsedQuery() : type(QueryType::UNKNOWN), csv_header(false), csv_delimiter(','), explain(false), analyze(false) {}
 };
 
 class QueryParser {
@@ -30,10 +52,14 @@ private:
     std::vector<std::string> tokenize(const std::string& query) const;
     std::string toLower(const std::string& str) const;
     void parseCreateTable(const std::vector<std::string>& tokens, ParsedQuery& query) const;
+    void parseCreateIndex(const std::vector<std::string>& tokens, ParsedQuery& query) const;
     void parseInsert(const std::vector<std::string>& tokens, ParsedQuery& query) const;
+    void parseCopy(const std::vector<std::string>& tokens, ParsedQuery& query) const;
     void parseSelect(const std::vector<std::string>& tokens, ParsedQuery& query) const;
+    size_t parseJoin(const std::vector<std::string>& tokens, size_t pos, ParsedQuery& query) const;
     void parseDropTable(const std::vector<std::string>& tokens, ParsedQuery& query) const;
     void parseDescribe(const std::vector<std::string>& tokens, ParsedQuery& query) const;
+    void parseSet(const std::vector<std::string>& tokens, ParsedQuery& query) const;
     
 public:
     ParsedQuery parse(const std::string& query) const;
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "table.h"
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// One step of a query plan. The counters are filled in only when the
+// query is run (EXPLAIN ANALYZE); bytes are the column bytes the step
+// read, or for the final Output step the bytes of formatted result.
+struct OperatorProfile {
+    std::string name;      // "Hash Join", "Seq Scan", "Filter", ...
+    std::string detail;
+    size_t rows_in = 0;
+    size_t rows_out = 0;
+    double time_ms = 0;
+    size_t bytes = 0;
+};
+
+// The plan of one SELECT, in execution order, with per-operator counters
+struct QueryProfile {
+    bool analyze = false;     // Run the query; otherwise only plan it
+    std::vector<OperatorProfile> operators;
+    double planning_ms = 0;   // Compiling the WHERE clause and aggregates
+    double execution_ms = 0;
+
+    OperatorProfile& add(const std::string& name, const std::string& detail) {
+        operators.push_back({name, detail});
+        return operators.back();
+    }
+
+    // One row per operator, for printing as a result table
+    Table toTable() const {
+        Table table("query_plan");
+        table.addColumn("operator", "string");
+        table.addColumn("detail", "string");
+        if (analyze) {
+            for (const char* column : {"rows_in", "rows_out", "time_ms", "rows_per_sec", "bytes"}) {
+                table.addColumn(column, "string");
+            }
+        }
+
+        for (const auto& op : operators) {
+            std::vector<std::string> values = {op.name, op.detail};
+            if (analyze) {
+                double per_sec = op.time_ms > 0 ? op.rows_in / (op.time_ms / 1000) : 0;
+                values.push_back(std::to_string(op.rows_in));
+                values.push_back(std::to_string(op.rows_out));
+                values.push_back(fixed(op.time_ms, 3));
+                values.push_back(fixed(per_sec, 0));
+                values.push_back(std::to_string(op.bytes));
+            }
+            table.insertRow(values);
+        }
+        return table;
+    }
+
+    static std::string fixed(double value, int precision) {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(precision) << value;
+        return out.str();
+    }
+};
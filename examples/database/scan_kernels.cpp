@@ -0,0 +1,324 @@
+#include "scan_kernels.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define SIMPLEDB_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace scan {
+
+namespace {
+
+enum class InstructionSet {
+    SCALAR,
+    SSE2,
+    AVX2
+};
+
+InstructionSet detectInstructionSet() {
+#ifdef SIMPLEDB_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return InstructionSet::AVX2;
+    }
+    return InstructionSet::SSE2;  // Always available on x86-64
+#else
+    return InstructionSet::SCALAR;
+#endif
+}
+
+InstructionSet instructionSet() {
+    static const InstructionSet isa = detectInstructionSet();
+    return isa;
+}
+
+template <CompareOp Op, typename T>
+inline bool compareScalar(T value, T constant) {
+    if constexpr (Op == CompareOp::EQ) return value == constant;
+    if constexpr (Op == CompareOp::NE) return value != constant;
+    if constexpr (Op == CompareOp::LT) return value < constant;
+    if constexpr (Op == CompareOp::GT) return value > constant;
+    if constexpr (Op == CompareOp::LE) return value <= constant;
+    if constexpr (Op == CompareOp::GE) return value >= constant;
+}
+
+// Branch-free scalar loop; also handles the tails of the SIMD kernels
+template <CompareOp Op, typename T>
+void filterScalar(const T* values, size_t count, T constant, uint64_t* out_words) {
+    size_t full_words = count / 64;
+    for (size_t w = 0; w < full_words; ++w) {
+        const T* block = values + w * 64;
+        uint64_t word = 0;
+        for (size_t bit = 0; bit < 64; ++bit) {
+            word |= uint64_t(compareScalar<Op>(block[bit], constant)) << bit;
+        }
+        out_words[w] = word;
+    }
+
+    size_t remaining = count % 64;
+    if (remaining) {
+        const T* block = values + full_words * 64;
+        uint64_t word = 0;
+        for (size_t bit = 0; bit < remaining; ++bit) {
+            word |= uint64_t(compareScalar<Op>(block[bit], constant)) << bit;
+        }
+        out_words[full_words] = word;
+    }
+}
+
+#ifdef SIMPLEDB_X86_SIMD
+
+// Integer SIMD only has == and >, the other operators are derived from them
+template <CompareOp Op>
+__attribute__((target("avx2")))
+void filterIntAvx2(const int* values, size_t count, int constant, uint64_t* out_words) {
+    const __m256i c = _mm256_set1_epi32(constant);
+    size_t full_words = count / 64;
+
+    for (size_t w = 0; w < full_words; ++w) {
+        const int* block = values + w * 64;
+        uint64_t word = 0;
+        for (size_t g = 0; g < 8; ++g) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + g * 8));
+            __m256i m;
+            if constexpr (Op == CompareOp::EQ || Op == CompareOp::NE) {
+                m = _mm256_cmpeq_epi32(v, c);
+            } else if constexpr (Op == CompareOp::GT || Op == CompareOp::LE) {
+                m = _mm256_cmpgt_epi32(v, c);
+            } else {
+                m = _mm256_cmpgt_epi32(c, v);
+            }
+            uint64_t bits = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(m)));
+            if constexpr (Op == CompareOp::NE || Op == CompareOp::LE || Op == CompareOp::GE) {
+                bits ^= 0xFF;
+            }
+            word |= bits << (g * 8);
+        }
+        out_words[w] = word;
+    }
+
+    filterScalar<Op>(values + full_words * 64, count % 64, constant, out_words + full_words);
+}
+
+template <CompareOp Op>
+__attribute__((target("avx2")))
+void filterDoubleAvx2(const double* values, size_t count, double constant, uint64_t* out_words) {
+    // Ordered predicates are false for NaN, != is true, matching scalar C++
+    constexpr int predicate =
+        Op == CompareOp::EQ ? _CMP_EQ_OQ :
+        Op == CompareOp::NE ? _CMP_NEQ_UQ :
+        Op == CompareOp::LT ? _CMP_LT_OQ :
+        Op == CompareOp::GT ? _CMP_GT_OQ :
+        Op == CompareOp::LE ? _CMP_LE_OQ : _CMP_GE_OQ;
+
+    const __m256d c = _mm256_set1_pd(constant);
+    size_t full_words = count / 64;
+
+    for (size_t w = 0; w < full_words; ++w) {
+        const double* block = values + w * 64;
+        uint64_t word = 0;
+        for (size_t g = 0; g < 16; ++g) {
+            __m256d v = _mm256_loadu_pd(block + g * 4);
+            uint64_t bits = static_cast<uint32_t>(_mm256_movemask_pd(_mm256_cmp_pd(v, c, predicate)));
+            word |= bits << (g * 4);
+        }
+        out_words[w] = word;
+    }
+
+    filterScalar<Op>(values + full_words * 64, count % 64, constant, out_words + full_words);
+}
+
+template <CompareOp Op>
+void filterIntSse2(const int* values, size_t count, int constant, uint64_t* out_words) {
+    const __m128i c = _mm_set1_epi32(constant);
+    size_t full_words = count / 64;
+
+    for (size_t w = 0; w < full_words; ++w) {
+        const int* block = values + w * 64;
+        uint64_t word = 0;
+        for (size_t g = 0; g < 16; ++g) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + g * 4));
+            __m128i m;
+            if constexpr (Op == CompareOp::EQ || Op == CompareOp::NE) {
+                m = _mm_cmpeq_epi32(v, c);
+            } else if constexpr (Op == CompareOp::GT || Op == CompareOp::LE) {
+                m = _mm_cmpgt_epi32(v, c);
+            } else {
+                m = _mm_cmplt_epi32(v, c);
+            }
+            uint64_t bits = static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(m)));
+            if constexpr (Op == CompareOp::NE || Op == CompareOp::LE || Op == CompareOp::GE) {
+                bits ^= 0xF;
+            }
+            word |= bits << (g * 4);
+        }
+        out_words[w] = word;
+    }
+
+    filterScalar<Op>(values + full_words * 64, count % 64, constant, out_words + full_words);
+}
+
+template <CompareOp Op>
+void filterDoubleSse2(const double* values, size_t count, double constant, uint64_t* out_words) {
+    const __m128d c = _mm_set1_pd(constant);
+    size_t full_words = count / 64;
+
+    for (size_t w = 0; w < full_words; ++w) {
+        const double* block = values + w * 64;
+        uint64_t word = 0;
+        for (size_t g = 0; g < 32; ++g) {
+            __m128d v = _mm_loadu_pd(block + g * 2);
+            __m128d m;
+            if constexpr (Op == CompareOp::EQ) m = _mm_cmpeq_pd(v, c);
+            if constexpr (Op == CompareOp::NE) m = _mm_cmpneq_pd(v, c);
+            if constexpr (Op == CompareOp::LT) m = _mm_cmplt_pd(v, c);
+            if constexpr (Op == CompareOp::GT) m = _mm_cmpgt_pd(v, c);
+            if constexpr (Op == CompareOp::LE) m = _mm_cmple_pd(v, c);
+            if constexpr (Op == CompareOp::GE) m = _mm_cmpge_pd(v, c);
+            uint64_t bits = static_cast<uint32_t>(_mm_movemask_pd(m));
+            word |= bits << (g * 2);
+        }
+        out_words[w] = word;
+    }
+
+    filterScalar<Op>(values + full_words * 64, count % 64, constant, out_words + full_words);
+}
+
+#endif // SIMPLEDB_X86_SIMD
+
+template <CompareOp Op>
+void filterIntDispatch(const int* values, size_t count, int constant, uint64_t* out_words) {
+#ifdef SIMPLEDB_X86_SIMD
+    switch (instructionSet()) {
+        case InstructionSet::AVX2: return filterIntAvx2<Op>(values, count, constant, out_words);
+        case InstructionSet::SSE2: return filterIntSse2<Op>(values, count, constant, out_words);
+        case InstructionSet::SCALAR: break;
+    }
+#endif
+    filterScalar<Op>(values, count, constant, out_words);
+}
+
+template <CompareOp Op>
+void filterDoubleDispatch(const double* values, size_t count, double constant, uint64_t* out_words) {
+#ifdef SIMPLEDB_X86_SIMD
+    switch (instructionSet()) {
+        case InstructionSet::AVX2: return filterDoubleAvx2<Op>(values, count, constant, out_words);
+        case InstructionSet::SSE2: return filterDoubleSse2<Op>(values, count, constant, out_words);
+        case InstructionSet::SCALAR: break;
+    }
+#endif
+    filterScalar<Op>(values, count, constant, out_words);
+}
+
+void fillWords(size_t count, bool value, uint64_t* out_words) {
+    size_t full_words = count / 64;
+    for (size_t w = 0; w < full_words; ++w) {
+        out_words[w] = value ? ~uint64_t(0) : 0;
+    }
+    if (count % 64) {
+        out_words[full_words] = value ? (uint64_t(1) << (count % 64)) - 1 : 0;
+    }
+}
+
+} // namespace
+
+void filterInt(const int* values, size_t count, CompareOp op, int constant, uint64_t* out_words) {
+    switch (op) {
+        case CompareOp::EQ: return filterIntDispatch<CompareOp::EQ>(values, count, constant, out_words);
+        case CompareOp::NE: return filterIntDispatch<CompareOp::NE>(values, count, constant, out_words);
+        case CompareOp::LT: return filterIntDispatch<CompareOp::LT>(values, count, constant, out_words);
+        case CompareOp::GT: return filterIntDispatch<CompareOp::GT>(values, count, constant, out_words);
+        case CompareOp::LE: return filterIntDispatch<CompareOp::LE>(values, count, constant, out_words);
+        case CompareOp::GE: return filterIntDispatch<CompareOp::GE>(values, count, constant, out_words);
+    }
+}
+
+void filterDouble(const double* values, size_t count, CompareOp op, double constant, uint64_t* out_words) {
+    switch (op) {
+        case CompareOp::EQ: return filterDoubleDispatch<CompareOp::EQ>(values, count, constant, out_words);
+        case CompareOp::NE: return filterDoubleDispatch<CompareOp::NE>(values, count, constant, out_words);
+        case CompareOp::LT: return filterDoubleDispatch<CompareOp::LT>(values, count, constant, out_words);
+        case CompareOp::GT: return filterDoubleDispatch<CompareOp::GT>(values, count, constant, out_words);
+        case CompareOp::LE: return filterDoubleDispatch<CompareOp::LE>(values, count, constant, out_words);
+        case CompareOp::GE: return filterDoubleDispatch<CompareOp::GE>(values, count, constant, out_words);
+    }
+}
+
+void filterBool(const uint8_t* values, size_t count, CompareOp op, bool constant, uint64_t* out_words) {
+    uint8_t c = constant ? 1 : 0;
+    switch (op) {
+        case CompareOp::EQ: return filterScalar<CompareOp::EQ>(values, count, c, out_words);
+        case CompareOp::NE: return filterScalar<CompareOp::NE>(values, count, c, out_words);
+        case CompareOp::LT: return filterScalar<CompareOp::LT>(values, count, c, out_words);
+        case CompareOp::GT: return filterScalar<CompareOp::GT>(values, count, c, out_words);
+        case CompareOp::LE: return filterScalar<CompareOp::LE>(values, count, c, out_words);
+        case CompareOp::GE: return filterScalar<CompareOp::GE>(values, count, c, out_words);
+    }
+}
+
+void filterStringCodes(const uint32_t* codes, size_t count, const Comparison& cmp, uint64_t* out_words) {
+    if (cmp.op == CompareOp::EQ || cmp.op == CompareOp::NE) {
+        if (!cmp.code_found) {
+            // The literal never occurs in this column
+            fillWords(count, cmp.op == CompareOp::NE, out_words);
+            return;
+        }
+        // Codes are just 32-bit patterns here, so the int kernel applies
+        filterInt(reinterpret_cast<const int*>(codes), count, cmp.op,
+                  static_cast<int>(cmp.string_code), out_words);
+        return;
+    }
+
+    const uint8_t* code_matches = cmp.code_matches.data();
+    size_t full_words = count / 64;
+    for (size_t w = 0; w <= full_words; ++w) {
+        size_t bits = (w < full_words) ? 64 : count % 64;
+        if (bits == 0) {
+            break;
+        }
+        const uint32_t* block = codes + w * 64;
+        uint64_t word = 0;
+        for (size_t bit = 0; bit < bits; ++bit) {
+            word |= uint64_t(code_matches[block[bit]]) << bit;
+        }
+        out_words[w] = word;
+    }
+}
+
+void filterColumn(const ColumnVector& column, size_t begin, size_t count,
+                  const Comparison& cmp, uint64_t* out_words) {
+    switch (cmp.type) {
+        case ColumnType::INT:
+            filterInt(column.intData() + begin, count, cmp.op, cmp.int_value, out_words);
+            break;
+        case ColumnType::DOUBLE:
+            filterDouble(column.doubleData() + begin, count, cmp.op, cmp.double_value, out_words);
+            break;
+        case ColumnType::BOOL:
+            filterBool(column.boolData() + begin, count, cmp.op, cmp.bool_value, out_words);
+            break;
+        case ColumnType::STRING:
+            filterStringCodes(column.stringCodes() + begin, count, cmp, out_words);
+            break;
+    }
+
+    // A comparison with NULL is never true
+    if (column.hasNulls()) {
+        for (size_t i = 0; i < count; ++i) {
+            if (column.isNull(begin + i)) {
+                out_words[i / 64] &= ~(uint64_t(1) << (i % 64));
+            }
+        }
+    }
+}
+
+const char* activeInstructionSet() {
+    switch (instructionSet()) {
+        case InstructionSet::AVX2: return "avx2";
+        case InstructionSet::SSE2: return "sse2";
+        case InstructionSet::SCALAR: break;
+    }
+    return "scalar";
+}
+
+} // namespace scan
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "predicate.h"
+#include "column_store.h"
+#include <cstdint>
+#include <cstddef>
+
+// Filter kernels comparing a column against a constant. Each kernel writes
+// one bit per input value into out_words (bit i of word i / 64 is value i),
+// so callers scanning a sub-range must start at a multiple of 64 rows.
+// Full words are overwritten; the last partial word has its high bits cleared.
+//
+// The int and double kernels use AVX2 or SSE2 when the CPU supports them
+// and fall back to a branch-free scalar loop otherwise.
+namespace scan {
+
+void filterInt(const int* values, size_t count, CompareOp op, int constant, uint64_t* out_words);
+void filterDouble(const double* values, size_t count, CompareOp op, double constant, uint64_t* out_words);
+void filterBool(const uint8_t* values, size_t count, CompareOp op, bool constant, uint64_t* out_words);
+
+// String columns: equality runs on dictionary codes, ordering goes through
+// the comparison's per-code lookup table built at compile time
+void filterStringCodes(const uint32_t* codes, size_t count, const Comparison& cmp, uint64_t* out_words);
+
+// Evaluates one comparison for rows [begin, begin + count) of a column;
+// NULL rows never match
+void filterColumn(const ColumnVector& column, size_t begin, size_t count,
+                  const Comparison& cmp, uint64_t* out_words);
+
+// Name of the instruction set picked at runtime ("avx2", "sse2" or "scalar")
+const char* activeInstructionSet();
+
+} // namespace scan
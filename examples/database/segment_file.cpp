@@ -0,0 +1,383 @@
+#include "segment_file.h"
+#include "table_index.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t PAGE_ALIGNMENT = 64;
+
+size_t valueBytes(ColumnType type) {
+    switch (type) {
+        case ColumnType::INT:    return sizeof(int);
+        case ColumnType::DOUBLE: return sizeof(double);
+        case ColumnType::BOOL:   return sizeof(uint8_t);
+        case ColumnType::STRING: return sizeof(uint32_t);
+    }
+    return 0;
+}
+
+const void* columnValues(const ColumnVector& column) {
+    switch (column.getType()) {
+        case ColumnType::INT:    return column.intData();
+        case ColumnType::DOUBLE: return column.doubleData();
+        case ColumnType::BOOL:   return column.boolData();
+        case ColumnType::STRING: return column.stringCodes();
+    }
+    return nullptr;
+}
+
+// Buffered sequential writer that knows its file offset
+class FileWriter {
+private:
+    FILE* file;
+    std::string path;
+    uint64_t offset;
+
+public:
+    explicit FileWriter(const std::string& p) : file(std::fopen(p.c_str(), "wb")), path(p), offset(0) {
+        if (!file) {
+            throw std::runtime_error("Cannot create file '" + path + "'");
+        }
+        std::setvbuf(file, nullptr, _IOFBF, 1 << 20);
+    }
+
+    ~FileWriter() {
+        if (file) {
+            std::fclose(file);
+        }
+    }
+
+    uint64_t position() const { return offset; }
+
+    void write(const void* data, size_t bytes) {
+        if (bytes > 0 && std::fwrite(data, 1, bytes, file) != bytes) {
+            throw std::runtime_error("Error writing '" + path + "'");
+        }
+        offset += bytes;
+    }
+
+    void align() {
+        static const char zeros[PAGE_ALIGNMENT] = {};
+        write(zeros, (PAGE_ALIGNMENT - offset % PAGE_ALIGNMENT) % PAGE_ALIGNMENT);
+    }
+
+    void writeAt(uint64_t at, const void* data, size_t bytes) {
+        if (std::fseek(file, static_cast<long>(at), SEEK_SET) != 0 ||
+            std::fwrite(data, 1, bytes, file) != bytes) {
+            throw std::runtime_error("Error writing '" + path + "'");
+        }
+        std::fseek(file, 0, SEEK_END);
+    }
+
+    // Flushes and fsyncs, so a rename afterwards publishes complete data
+    void close() {
+        bool ok = std::fflush(file) == 0 && ::fsync(fileno(file)) == 0;
+        ok = (std::fclose(file) == 0) && ok;
+        file = nullptr;
+        if (!ok) {
+            throw std::runtime_error("Error writing '" + path + "'");
+        }
+    }
+};
+
+void putString(std::string& out, const std::string& value) {
+    uint32_t length = static_cast<uint32_t>(value.size());
+    out.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    out += value;
+}
+
+void putUint32(std::string& out, uint32_t value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+struct MappedFile {
+    void* data = MAP_FAILED;
+    size_t size = 0;
+
+    ~MappedFile() {
+        if (data != MAP_FAILED) {
+            munmap(data, size);
+        }
+    }
+};
+
+// Bounds-checked reads from the mapping
+class SegmentReader {
+private:
+    const char* base;
+    size_t size;
+    std::string path;
+
+public:
+    SegmentReader(const char* b, size_t s, const std::string& p) : base(b), size(s), path(p) {}
+
+    [[noreturn]] void corrupt(const std::string& what) const {
+        throw std::runtime_error("Corrupt segment file '" + path + "': " + what);
+    }
+
+    const char* section(uint64_t offset, uint64_t bytes, const char* what) const {
+        if (offset > size || bytes > size - offset) {
+            corrupt(std::string(what) + " out of bounds");
+        }
+        return base + offset;
+    }
+
+    // Cursor over the variable-length schema section
+    struct Cursor {
+        const SegmentReader& reader;
+        const char* at;
+        const char* end;
+
+        uint32_t getUint32() {
+            if (end - at < static_cast<ptrdiff_t>(sizeof(uint32_t))) {
+                reader.corrupt("truncated schema");
+            }
+            uint32_t value;
+            std::memcpy(&value, at, sizeof(value));
+            at += sizeof(value);
+            return value;
+        }
+
+        std::string getString() {
+            uint32_t length = getUint32();
+            if (static_cast<size_t>(end - at) < length) {
+                reader.corrupt("truncated schema");
+            }
+            std::string value(at, length);
+            at += length;
+            return value;
+        }
+    };
+};
+
+} // namespace
+
+void writeSegment(const Table& table, const std::string& path, uint64_t checkpoint_lsn) {
+    const auto& columns = table.getColumns();
+    const auto& indexes = table.getIndexes();
+    std::string temp_path = path + ".tmp";
+
+    std::string schema;
+    putString(schema, table.getName());
+    for (const auto& column : columns) {
+        putString(schema, column.name);
+        putString(schema, column.type);
+    }
+    for (const auto& entry : indexes) {
+        putString(schema, entry.name);
+        putUint32(schema, static_cast<uint32_t>(entry.column_index));
+        putString(schema, indexTypeToString(entry.index->getType()));
+    }
+
+    SegmentHeader header = {};
+    std::memcpy(header.magic, SEGMENT_MAGIC, sizeof(header.magic));
+    header.version = SEGMENT_VERSION;
+    header.column_count = static_cast<uint32_t>(columns.size());
+    header.row_count = table.size();
+    header.zone_rows = static_cast<uint32_t>(ColumnVector::ZONE_ROWS);
+    header.index_count = static_cast<uint32_t>(indexes.size());
+    header.schema_offset = sizeof(SegmentHeader);
+    header.schema_bytes = schema.size();
+    header.checkpoint_lsn = checkpoint_lsn;
+
+    FileWriter out(temp_path);
+    try {
+        out.write(&header, sizeof(header));
+        out.write(schema.data(), schema.size());
+        out.align();
+        header.columns_offset = out.position();
+
+        // Directory placeholder, rewritten once page offsets are known
+        std::vector<SegmentColumn> directory(columns.size(), SegmentColumn());
+        out.write(directory.data(), directory.size() * sizeof(SegmentColumn));
+
+        for (size_t i = 0; i < columns.size(); ++i) {
+            const ColumnVector& column = table.getColumnData(i);
+            SegmentColumn& entry = directory[i];
+            entry.type = static_cast<uint32_t>(column.getType());
+
+            out.align();
+            entry.data_offset = out.position();
+            entry.data_bytes = column.size() * valueBytes(column.getType());
+            out.write(columnValues(column), entry.data_bytes);
+
+            if (column.getType() == ColumnType::STRING) {
+                const StringDictionary& dictionary = column.getDictionary();
+                size_t count = dictionary.size();
+                std::vector<uint64_t> offsets(count + 1, 0);
+                for (uint32_t code = 0; code < count; ++code) {
+                    offsets[code + 1] = offsets[code] + dictionary.lookup(code).size();
+                }
+                std::vector<uint32_t> sorted(count);
+                for (uint32_t code = 0; code < count; ++code) {
+                    sorted[code] = code;
+                }
+                std::sort(sorted.begin(), sorted.end(), [&](uint32_t a, uint32_t b) {
+                    return dictionary.lookup(a) < dictionary.lookup(b);
+                });
+
+                entry.dict_count = count;
+                out.align();
+                entry.dict_offsets_offset = out.position();
+                out.write(offsets.data(), offsets.size() * sizeof(uint64_t));
+                entry.dict_blob_offset = out.position();
+                entry.dict_blob_bytes = offsets[count];
+                for (uint32_t code = 0; code < count; ++code) {
+                    std::string_view value = dictionary.lookup(code);
+                    out.write(value.data(), value.size());
+                }
+                out.align();
+                entry.dict_sorted_offset = out.position();
+                out.write(sorted.data(), sorted.size() * sizeof(uint32_t));
+            }
+
+            std::vector<double> zone_min;
+            std::vector<double> zone_max;
+            ColumnVector::computeZoneMaps(column, zone_min, zone_max);
+            if (!zone_min.empty()) {
+                out.align();
+                entry.zone_count = zone_min.size();
+                entry.zone_offset = out.position();
+                for (size_t z = 0; z < zone_min.size(); ++z) {
+                    double bounds[2] = {zone_min[z], zone_max[z]};
+                    out.write(bounds, sizeof(bounds));
+                }
+            }
+        }
+
+        out.writeAt(0, &header, sizeof(header));
+        out.writeAt(header.columns_offset, directory.data(), directory.size() * sizeof(SegmentColumn));
+        out.close();
+    } catch (...) {
+        std::remove(temp_path.c_str());
+        throw;
+    }
+
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        std::remove(temp_path.c_str());
+        throw std::runtime_error("Cannot replace '" + path + "'");
+    }
+    // The rename is only durable once the directory entry is
+    size_t slash = path.find_last_of('/');
+    syncDirectory(slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash));
+}
+
+void syncDirectory(const std::string& dir) {
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open directory '" + dir + "'");
+    }
+    bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    if (!ok) {
+        throw std::runtime_error("Cannot sync directory '" + dir + "'");
+    }
+}
+
+Table openSegment(const std::string& path, uint64_t* checkpoint_lsn) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open file '" + path + "'");
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot open file '" + path + "'");
+    }
+
+    auto mapped = std::make_shared<MappedFile>();
+    mapped->size = static_cast<size_t>(st.st_size);
+    if (mapped->size >= sizeof(SegmentHeader)) {
+        mapped->data = mmap(nullptr, mapped->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    if (mapped->data == MAP_FAILED) {
+        throw std::runtime_error("Cannot map segment file '" + path + "'");
+    }
+
+    const char* base = static_cast<const char*>(mapped->data);
+    SegmentReader reader(base, mapped->size, path);
+
+    SegmentHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, SEGMENT_MAGIC, sizeof(header.magic)) != 0) {
+        reader.corrupt("bad magic");
+    }
+    if (header.version != SEGMENT_VERSION) {
+        reader.corrupt("unsupported version " + std::to_string(header.version));
+    }
+    if (checkpoint_lsn) {
+        *checkpoint_lsn = header.checkpoint_lsn;
+    }
+
+    const char* schema = reader.section(header.schema_offset, header.schema_bytes, "schema");
+    SegmentReader::Cursor cursor{reader, schema, schema + header.schema_bytes};
+
+    Table table(cursor.getString());
+    for (uint32_t i = 0; i < header.column_count; ++i) {
+        std::string name = cursor.getString();
+        std::string type = cursor.getString();
+        table.addColumn(name, type);
+    }
+
+    auto directory = reinterpret_cast<const SegmentColumn*>(
+        reader.section(header.columns_offset, uint64_t(header.column_count) * sizeof(SegmentColumn), "column directory"));
+
+    std::vector<ColumnVector> data;
+    for (uint32_t i = 0; i < header.column_count; ++i) {
+        const SegmentColumn& entry = directory[i];
+        ColumnType type = columnTypeFromString(table.getColumns()[i].type);
+        if (entry.type != static_cast<uint32_t>(type) ||
+            entry.data_bytes != header.row_count * valueBytes(type)) {
+            reader.corrupt("column '" + table.getColumns()[i].name + "' doesn't match the schema");
+        }
+
+        ColumnVector column(type);
+        column.attachMapped(reader.section(entry.data_offset, entry.data_bytes, "column data"),
+                            header.row_count, mapped);
+
+        if (type == ColumnType::STRING) {
+            auto offsets = reinterpret_cast<const uint64_t*>(
+                reader.section(entry.dict_offsets_offset, (entry.dict_count + 1) * sizeof(uint64_t), "dictionary"));
+            const char* blob = reader.section(entry.dict_blob_offset, entry.dict_blob_bytes, "dictionary");
+            auto sorted = reinterpret_cast<const uint32_t*>(
+                reader.section(entry.dict_sorted_offset, entry.dict_count * sizeof(uint32_t), "dictionary"));
+            if (offsets[entry.dict_count] != entry.dict_blob_bytes) {
+                reader.corrupt("dictionary size mismatch");
+            }
+            column.attachMappedDictionary(offsets, blob, sorted, entry.dict_count);
+        }
+
+        if (entry.zone_count > 0 && header.zone_rows == ColumnVector::ZONE_ROWS) {
+            auto bounds = reinterpret_cast<const double*>(
+                reader.section(entry.zone_offset, entry.zone_count * 2 * sizeof(double), "zone map"));
+            std::vector<double> zone_min(entry.zone_count);
+            std::vector<double> zone_max(entry.zone_count);
+            for (size_t z = 0; z < entry.zone_count; ++z) {
+                zone_min[z] = bounds[2 * z];
+                zone_max[z] = bounds[2 * z + 1];
+            }
+            column.setZoneMaps(std::move(zone_min), std::move(zone_max), header.row_count);
+        }
+        data.push_back(std::move(column));
+    }
+    table.setColumnData(std::move(data));
+
+    for (uint32_t i = 0; i < header.index_count; ++i) {
+        std::string name = cursor.getString();
+        uint32_t column = cursor.getUint32();
+        std::string type = cursor.getString();
+        if (column >= header.column_count) {
+            reader.corrupt("index '" + name + "' on unknown column");
+        }
+        table.createIndex(name, table.getColumns()[column].name, indexTypeFromString(type));
+    }
+    return table;
+}
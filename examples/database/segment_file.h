@@ -0,0 +1,64 @@
+#pragma once
+
+#include "table.h"
+#include <string>
+
+// On-disk table format: one segment file per table, laid out so that
+// opening it is a single mmap and columns are read in place.
+//
+//   SegmentHeader                          fixed 64 bytes
+//   schema                                 table name, columns, index definitions
+//   SegmentColumn[column_count]            per-column page directory
+//   pages, each 64-byte aligned:
+//     column values                        int32 / double / uint8 / uint32 codes
+//     dictionary offsets, blob, sort order strings only
+//     zone map                             (min, max) doubles per ZONE_ROWS rows
+//
+// All integers are little-endian (native); the format is not portable
+// across byte orders. Indexes are stored as definitions and rebuilt on open.
+// checkpoint_lsn tells recovery which write-ahead log records are already
+// contained in the file.
+
+constexpr char SEGMENT_MAGIC[8] = {'S', 'D', 'B', 'S', 'E', 'G', '0', '1'};
+constexpr uint32_t SEGMENT_VERSION = 1;
+constexpr const char* SEGMENT_EXTENSION = ".seg";
+
+struct SegmentHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t column_count;
+    uint64_t row_count;
+    uint32_t zone_rows;
+    uint32_t index_count;
+    uint64_t schema_offset;
+    uint64_t schema_bytes;
+    uint64_t columns_offset;
+    uint64_t checkpoint_lsn;    // Last WAL record reflected in this file
+};
+
+struct SegmentColumn {
+    uint32_t type;              // ColumnType
+    uint32_t reserved;
+    uint64_t data_offset;
+    uint64_t data_bytes;
+    uint64_t dict_count;
+    uint64_t dict_offsets_offset;  // dict_count + 1 uint64 offsets into the blob
+    uint64_t dict_blob_offset;
+    uint64_t dict_blob_bytes;
+    uint64_t dict_sorted_offset;   // dict_count uint32 codes in string order
+    uint64_t zone_count;
+    uint64_t zone_offset;
+};
+
+static_assert(sizeof(SegmentHeader) == 64, "SegmentHeader must stay 64 bytes");
+
+// Writes the table to path atomically (temporary file, fsync, rename,
+// fsync of the directory)
+void writeSegment(const Table& table, const std::string& path, uint64_t checkpoint_lsn = 0);
+// fsyncs a directory, making renames and unlinks in it durable; throws
+// std::runtime_error on failure
+void syncDirectory(const std::string& dir);
+
+// Maps a segment file; the returned table reads its columns from the
+// mapping until it is first modified
+Table openSegment(const std::string& path, uint64_t* checkpoint_lsn = nullptr);
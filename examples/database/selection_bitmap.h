@@ -0,0 +1,86 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// One bit per row marking which rows of a table a filter selected.
+// Bits past size() are always zero so whole words can be combined freely.
+class SelectionBitmap {
+private:
+    std::vector<uint64_t> words;
+    size_t num_bits;
+
+    void clearTail() {
+        if (num_bits % 64 != 0) {
+            words.back() &= (uint64_t(1) << (num_bits % 64)) - 1;
+        }
+    }
+
+public:
+    explicit SelectionBitmap(size_t bits = 0, bool value = false)
+        : words((bits + 63) / 64, value ? ~uint64_t(0) : 0), num_bits(bits) {
+        clearTail();
+    }
+
+    size_t size() const { return num_bits; }
+    size_t wordCount() const { return words.size(); }
+    uint64_t* data() { return words.data(); }
+    const uint64_t* data() const { return words.data(); }
+
+    bool test(size_t bit) const { return (words[bit / 64] >> (bit % 64)) & 1; }
+    void set(size_t bit) { words[bit / 64] |= uint64_t(1) << (bit % 64); }
+
+    void setAll() {
+        for (auto& word : words) {
+            word = ~uint64_t(0);
+        }
+        clearTail();
+    }
+
+    void andWith(const SelectionBitmap& other) {
+        for (size_t i = 0; i < words.size(); ++i) {
+            words[i] &= other.words[i];
+        }
+    }
+
+    void orWith(const SelectionBitmap& other) {
+        for (size_t i = 0; i < words.size(); ++i) {
+            words[i] |= other.words[i];
+        }
+    }
+
+    size_t count() const {
+        size_t total = 0;
+        for (uint64_t word : words) {
+            if (word) {
+                total += popcount(word);
+            }
+        }
+        return total;
+    }
+
+    static unsigned popcount(uint64_t word) {
+#ifdef __POPCNT__
+        return __builtin_popcountll(word);
+#else
+        // Without -mpopcnt the builtin is a library call; SWAR is faster
+        word = word - ((word >> 1) & 0x5555555555555555ULL);
+        word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+        word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+        return static_cast<unsigned>((word * 0x0101010101010101ULL) >> 56);
+#endif
+    }
+
+    // Calls fn(row) for every selected row in ascending order
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (size_t w = 0; w < words.size(); ++w) {
+            uint64_t word = words[w];
+            while (word) {
+                fn(w * 64 + __builtin_ctzll(word));
+                word &= word - 1;
+            }
+        }
+    }
+};
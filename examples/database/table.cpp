@@ -1,34 +1,121 @@
 #include "table.h"
+#include "predicate.h"
+#include "table_index.h"
+#include "thread_pool.h"
 #include <iostream>
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
 #include <cctype>
 
-Table::Table(const std::string& name) : table_name(name) {}
+Table::Table(const std::string& name) : table_name(name), row_count(0) {}
+
+Table::~Table() = default;
+Table::Table(Table&&) noexcept = default;
+Table& Table::operator=(Table&&) noexcept = default;
 
 void Table::addColumn(const std::string& name, const std::string& type) {
+    if (row_count > 0) {
+        throw std::runtime_error("Cannot add column '" + name + "' to a non-empty table");
+    }
     columns.emplace_back(name, type);
+    column_data.emplace_back(columnTypeFromString(type));
     column_index_map[name] = columns.size() - 1;
 }
 
 bool Table::hasColumn(const std::string& name) const {
-    return column_index_map.find(name) != column_index_map.end();
+    return findColumn(name) != columns.size();
 }
 
-size_t Table::getColumnIndex(const std::string& name) const {
+void Table::createIndex(const std::string& index_name, const std::string& column_name, IndexType type) {
+    if (hasIndex(index_name)) {
+        throw std::runtime_error("Index '" + index_name + "' already exists");
+    }
+    
+    size_t col_idx = getColumnIndex(column_name);
+    IndexEntry entry{index_name, col_idx, createColumnIndex(type, column_data[col_idx].getType())};
+    for (size_t row = 0; row < row_count; ++row) {
+        entry.index->insert(column_data[col_idx], static_cast<uint32_t>(row));
+    }
+    indexes.push_back(std::move(entry));
+}
+
+bool Table::hasIndex(const std::string& index_name) const {
+    for (const auto& entry : indexes) {
+        if (entry.name == index_name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Table::appendToIndexes(size_t row_idx) {
+    for (auto& entry : indexes) {
+        entry.index->insert(column_data[entry.column_index], static_cast<uint32_t>(row_idx));
+    }
+}
+
+const ColumnIndex* Table::findIndex(size_t column_index, CompareOp op) const {
+    // Prefer a hash index for equality, otherwise take any index that can answer
+    const ColumnIndex* found = nullptr;
+    for (const auto& entry : indexes) {
+        if (entry.column_index == column_index && entry.index->supports(op)) {
+            if (!found || entry.index->getType() == IndexType::HASH) {
+                found = entry.index.get();
+            }
+        }
+    }
+    return found;
+}
+
+size_t Table::findColumn(const std::string& name) const {
     auto it = column_index_map.find(name);
-    if (it == column_index_map.end()) {
+    if (it != column_index_map.end()) {
+        return it->second;
+    }
+    
+    // Join results qualify columns as "table.column"; accept the bare
+    // column name when exactly one table provides it
+    size_t found = columns.size();
+    if (name.find('.') == std::string::npos) {
+        for (size_t i = 0; i < columns.size(); ++i) {
+            const std::string& qualified = columns[i].name;
+            if (qualified.size() > name.size() &&
+                qualified[qualified.size() - name.size() - 1] == '.' &&
+                qualified.compare(qualified.size() - name.size(), name.size(), name) == 0) {
+                if (found != columns.size()) {
+                    throw std::runtime_error("Column '" + name + "' is ambiguous");
+                }
+                found = i;
+            }
+        }
+    }
+    return found;
+}
+
+size_t Table::getColumnIndex(const std::string& name) const {
+    size_t index = findColumn(name);
+    if (index == columns.size()) {
         throw std::runtime_error("Column '" + name + "' not found");
     }
-    return it->second;
+    return index;
 }
 
 void Table::insertRow(const Row& row) {
     if (row.size() != columns.size()) {
         throw std::runtime_error("Row size doesn't match number of columns");
     }
-    rows.push_back(row);
+    // Checked before any column is appended to, as in the string overload
+    for (size_t i = 0; i < row.size(); ++i) {
+        if (!column_data[i].accepts(row[i])) {
+            throw std::runtime_error("Value type doesn't match type of column '" + columns[i].name + "'");
+        }
+    }
+    for (size_t i = 0; i < row.size(); ++i) {
+        column_data[i].append(row[i]);
+    }
+    appendToIndexes(row_count);
+    row_count++;
 }
 
 void Table::insertRow(const std::vector<std::string>& values) {
@@ -36,11 +123,102 @@ void Table::insertRow(const std::vector<std::string>& values) {
         throw std::runtime_error("Number of values doesn't match number of columns");
     }
     
+    // Parse every value before touching storage so a bad value can't
+    // leave the columns with different lengths
     Row row;
+    row.reserve(values.size());
     for (size_t i = 0; i < values.size(); ++i) {
         row.push_back(parseValue(values[i], columns[i].type));
     }
-    rows.push_back(row);
+    for (size_t i = 0; i < row.size(); ++i) {
+        column_data[i].append(row[i]);
+    }
+    appendToIndexes(row_count);
+    row_count++;
+}
+
+size_t Table::loadRows(const RowSource& next_row, size_t expected_rows) {
+    size_t start = row_count;
+    reserve(row_count + expected_rows);
+    
+    std::vector<std::string_view> fields;
+    fields.reserve(columns.size());
+    try {
+        while (next_row(fields)) {
+            if (fields.size() != columns.size()) {
+                throw std::runtime_error("Number of values doesn't match number of columns");
+            }
+            for (size_t i = 0; i < fields.size(); ++i) {
+                if (!column_data[i].appendParsed(fields[i])) {
+                    throw std::runtime_error("Invalid value '" + std::string(fields[i]) +
+                                             "' for column '" + columns[i].name + "'");
+                }
+            }
+            row_count++;
+        }
+    } catch (...) {
+        for (auto& column : column_data) {
+            column.truncate(start);
+        }
+        row_count = start;
+        throw;
+    }
+    
+    for (size_t row = start; row < row_count; ++row) {
+        appendToIndexes(row);
+    }
+    return row_count - start;
+}
+
+void Table::reserve(size_t rows) {
+    for (auto& column : column_data) {
+        column.reserve(rows);
+    }
+}
+
+void Table::setColumnData(std::vector<ColumnVector> data) {
+    if (data.size() != columns.size()) {
+        throw std::runtime_error("Column count doesn't match table schema");
+    }
+    size_t rows = data.empty() ? 0 : data[0].size();
+    for (size_t i = 0; i < data.size(); ++i) {
+        if (data[i].getType() != column_data[i].getType() || data[i].size() != rows) {
+            throw std::runtime_error("Column data doesn't match table schema");
+        }
+    }
+    
+    column_data = std::move(data);
+    row_count = rows;
+    for (auto& entry : indexes) {
+        entry.index = createColumnIndex(entry.index->getType(), column_data[entry.column_index].getType());
+        for (size_t row = 0; row < row_count; ++row) {
+            entry.index->insert(column_data[entry.column_index], static_cast<uint32_t>(row));
+        }
+    }
+}
+
+void Table::appendRows(const std::vector<const ColumnVector*>& sources,
+                       const std::vector<const uint32_t*>& rows, size_t count) {
+    if (sources.size() != columns.size() || rows.size() != columns.size()) {
+        throw std::runtime_error("Row size doesn't match number of columns");
+    }
+    reserve(row_count + count);
+    for (size_t i = 0; i < columns.size(); ++i) {
+        column_data[i].appendRows(*sources[i], rows[i], count);
+    }
+    for (size_t row = row_count; row < row_count + count; ++row) {
+        appendToIndexes(row);
+    }
+    row_count += count;
+}
+
+Row Table::getRow(size_t row_idx) const {
+    Row row;
+    row.reserve(column_data.size());
+    for (const auto& column : column_data) {
+        row.push_back(column.get(row_idx));
+    }
+    return row;
 }
 
 Value Table::parseValue(const std::string& value_str, const std::string& type) const {
@@ -70,59 +248,118 @@ std::string Table::valueToString(const Value& value) const {
 }
 
 std::vector<size_t> Table::selectRows(const std::string& where_clause) const {
+    return selectRows(Predicate::compile(where_clause, *this));
+}
+
+std::vector<size_t> Table::selectRows(const Predicate& predicate) const {
     std::vector<size_t> result;
-    
-    for (size_t i = 0; i < rows.size(); ++i) {
-        if (where_clause.empty() || evaluateCondition(rows[i], where_clause)) {
-            result.push_back(i);
-        }
-    }
-    
+    filter(predicate).forEach([&](size_t row_idx) {
+        result.push_back(row_idx);
+    });
     return result;
 }
 
-bool Table::evaluateCondition(const Row& row, const std::string& condition) const {
-    // Simple condition parser: column_name operator value
-    // Supports: =, !=, <, >, <=, >=
-    std::istringstream iss(condition);
-    std::string column_name, op, value_str;
-    
-    if (!(iss >> column_name >> op >> value_str)) {
-        return true; // Invalid condition, return all rows
+SelectionBitmap Table::filter(const Predicate& predicate, ThreadPool* pool, bool* used_index) const {
+    SelectionBitmap selection(row_count);
+    bool indexed = !indexes.empty() && !predicate.matchesAll() && filterWithIndexes(predicate, selection);
+    if (used_index) {
+        *used_index = indexed;
     }
-    
-    if (!hasColumn(column_name)) {
-        return false;
+    if (indexed) {
+        return selection;
     }
     
-    size_t col_idx = getColumnIndex(column_name);
-    const Value& row_value = row[col_idx];
-    Value condition_value = parseValue(value_str, columns[col_idx].type);
-    
-    // Compare values based on operator
-    if (op == "=") {
-        return row_value == condition_value;
-    } else if (op == "!=") {
-        return row_value != condition_value;
-    } else if (op == "<") {
-        return row_value < condition_value;
-    } else if (op == ">") {
-        return row_value > condition_value;
-    } else if (op == "<=") {
-        return row_value <= condition_value;
-    } else if (op == ">=") {
-        return row_value >= condition_value;
+    // Morsels are a multiple of 64 rows, so each one writes its own
+    // bitmap words and no merge step is needed
+    size_t num_morsels = (row_count + SCAN_BLOCK_ROWS - 1) / SCAN_BLOCK_ROWS;
+    auto scan_morsel = [&](size_t morsel, size_t) {
+        size_t begin = morsel * SCAN_BLOCK_ROWS;
+        size_t count = std::min(SCAN_BLOCK_ROWS, row_count - begin);
+        predicate.evaluate(*this, begin, count, selection.data() + begin / 64);
+    };
+    
+    if (pool && pool->size() > 1 && num_morsels > 1) {
+        pool->parallelFor(num_morsels, scan_morsel);
+    } else {
+        for (size_t morsel = 0; morsel < num_morsels; ++morsel) {
+            scan_morsel(morsel, 0);
+        }
+    }
+    return selection;
+}
+
+bool Table::filterWithIndexes(const Predicate& predicate, SelectionBitmap& selection) const {
+    // Every OR group needs an indexed comparison, otherwise we scan anyway.
+    // Equality is preferred since it is usually the most selective.
+    const auto& disjuncts = predicate.getDisjuncts();
+    std::vector<std::pair<size_t, const ColumnIndex*>> plan;
+    for (const auto& group : disjuncts) {
+        size_t best_cmp = 0;
+        const ColumnIndex* best_index = nullptr;
+        for (size_t c = 0; c < group.size(); ++c) {
+            const ColumnIndex* index = findIndex(group[c].column_index, group[c].op);
+            if (index && (!best_index || group[c].op == CompareOp::EQ)) {
+                best_cmp = c;
+                best_index = index;
+            }
+        }
+        if (!best_index) {
+            return false;
+        }
+        plan.emplace_back(best_cmp, best_index);
     }
     
-    return false;
+    size_t limit = std::max(row_count / INDEX_SELECTIVITY_LIMIT, size_t(64));
+    std::vector<uint32_t> candidates;
+    for (size_t g = 0; g < disjuncts.size(); ++g) {
+        const auto& group = disjuncts[g];
+        candidates.clear();
+        if (!plan[g].second->lookup(group[plan[g].first], limit, candidates)) {
+            selection = SelectionBitmap(row_count);
+            return false;
+        }
+        
+        // Check the rest of the group only on the rows the index returned
+        for (uint32_t row : candidates) {
+            bool matches = true;
+            for (size_t c = 0; c < group.size() && matches; ++c) {
+                matches = (c == plan[g].first) || group[c].matches(*this, row);
+            }
+            if (matches) {
+                selection.set(row);
+            }
+        }
+    }
+    return true;
 }
 
 void Table::printTable() const {
-    printRows(selectRows());
+    printRows(SelectionBitmap(row_count, true));
 }
 
 void Table::printRows(const std::vector<size_t>& row_indices, 
                       const std::vector<std::string>& selected_columns) const {
+    auto for_each_row = [&](const auto& fn) {
+        for (size_t row_idx : row_indices) {
+            if (row_idx < row_count) {
+                fn(row_idx);
+            }
+        }
+    };
+    printSelected(for_each_row, row_indices.size(), selected_columns);
+}
+
+void Table::printRows(const SelectionBitmap& selection,
+                      const std::vector<std::string>& selected_columns) const {
+    auto for_each_row = [&](const auto& fn) {
+        selection.forEach(fn);
+    };
+    printSelected(for_each_row, selection.count(), selected_columns);
+}
+
+template <typename RowRange>
+void Table::printSelected(const RowRange& for_each_row, size_t selected_count,
+                          const std::vector<std::string>& selected_columns) const {
     std::vector<size_t> col_indices;
     std::vector<std::string> headers;
     
@@ -147,12 +384,10 @@ void Table::printRows(const std::vector<size_t>& row_indices,
     for (size_t i = 0; i < headers.size(); ++i) {
         size_t max_width = headers[i].length();
         
-        for (size_t row_idx : row_indices) {
-            if (row_idx < rows.size()) {
-                std::string value_str = valueToString(rows[row_idx][col_indices[i]]);
-                max_width = std::max(max_width, value_str.length());
-            }
-        }
+        for_each_row([&](size_t row_idx) {
+            std::string value_str = column_data[col_indices[i]].toString(row_idx);
+            max_width = std::max(max_width, value_str.length());
+        });
         widths.push_back(std::max(max_width, size_t(8))); // Minimum width of 8
     }
     
@@ -174,16 +409,14 @@ void Table::printRows(const std::vector<size_t>& row_indices,
     std::cout << "\n";
     
     // Print rows
-    for (size_t row_idx : row_indices) {
-        if (row_idx < rows.size()) {
-            std::cout << "|";
-            for (size_t i = 0; i < col_indices.size(); ++i) {
-                std::string value_str = valueToString(rows[row_idx][col_indices[i]]);
-                std::cout << " " << std::left << std::setw(widths[i]) << value_str << " |";
-            }
-            std::cout << "\n";
+    for_each_row([&](size_t row_idx) {
+        std::cout << "|";
+        for (size_t i = 0; i < col_indices.size(); ++i) {
+            std::string value_str = column_data[col_indices[i]].toString(row_idx);
+            std::cout << " " << std::left << std::setw(widths[i]) << value_str << " |";
         }
-    }
+        std::cout << "\n";
+    });
     
     // Print footer
     std::cout << "+";
@@ -192,5 +425,5 @@ void Table::printRows(const std::vector<size_t>& row_indices,
     }
     std::cout << "\n";
     
-    std::cout << "(" << row_indices.size() << " rows)\n";
+    std::cout << "(" << selected_count << " rows)\n";
 }
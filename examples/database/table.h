@@ -1,13 +1,13 @@
 #pragma once
 
+#include "column_store.h"
+#include "selection_bitmap.h"
 #include <string>
 #include <vector>
 #include <unordered_map>
-#include <variant>
 #include <memory>
-
-// Data types supported by our database
-using Value = std::variant<int, double, std::string, bool>;
+#include <functional>
+#include <string_view>
 
 // Column definition
 struct Column {
@@ -20,16 +20,53 @@ struct Column {
 // Row is a collection of values
 using Row = std::vector<Value>;
 
-// Table class to store data
+class Predicate;
+class ThreadPool;
+class ColumnIndex;
+enum class IndexType;
+enum class CompareOp;
+
+// A named secondary index on one column of a table
+struct IndexEntry {
+    std::string name;
+    size_t column_index;
+    std::unique_ptr<ColumnIndex> index;
+};
+
+// Table class to store data. Values are stored column-wise: one typed
+// ColumnVector per Column, all of the same length.
 class Table {
 private:
     std::string table_name;
     std::vector<Column> columns;
-    std::vector<Row> rows;
+    std::vector<ColumnVector> column_data;
+    size_t row_count;
     std::unordered_map<std::string, size_t> column_index_map;
+    std::vector<IndexEntry> indexes;
+    
+    // Rows filtered per kernel pass (and the morsel size for parallel
+    // scans); keeps every column touched by a predicate group resident in
+    // cache while the group is evaluated
+    static constexpr size_t SCAN_BLOCK_ROWS = 16384;
+    
+    // An index lookup is abandoned for a scan once it returns more than
+    // 1/INDEX_SELECTIVITY_LIMIT of the table
+    static constexpr size_t INDEX_SELECTIVITY_LIMIT = 16;
+    
+    size_t findColumn(const std::string& name) const;  // columns.size() if absent
+    void appendToIndexes(size_t row_idx);
+    const ColumnIndex* findIndex(size_t column_index, CompareOp op) const;
+    bool filterWithIndexes(const Predicate& predicate, SelectionBitmap& selection) const;
+    
+    template <typename RowRange>
+    void printSelected(const RowRange& for_each_row, size_t selected_count,
+                       const std::vector<std::string>& selected_columns) const;
 
 public:
     Table(const std::string& name);
+    ~Table();
+    Table(Table&&) noexcept;
+    Table& operator=(Table&&) noexcept;
     
     // Schema operations
     void addColumn(const std::string& name, const std::string& type);
@@ -38,22 +75,51 @@ public:
     const std::vector<Column>& getColumns() const { return columns; }
     const std::string& getName() const { return table_name; }
     
+    // Index operations
+    void createIndex(const std::string& index_name, const std::string& column_name, IndexType type);
+    bool hasIndex(const std::string& index_name) const;
+    const std::vector<IndexEntry>& getIndexes() const { return indexes; }
+    
     // Data operations
     void insertRow(const Row& row);
     void insertRow(const std::vector<std::string>& values);
-    const std::vector<Row>& getRows() const { return rows; }
+    // Marks a cell of a query result NULL (see ColumnVector)
+    void setNull(size_t row_idx, size_t col_idx) { column_data[col_idx].setNull(row_idx); }
+    // Bulk load: next_row fills one row of field texts and returns false
+    // at the end. Fields are parsed straight into column storage and
+    // indexes are updated once at the end; any bad row rolls back the
+    // whole load. Returns the number of rows added.
+    using RowSource = std::function<bool(std::vector<std::string_view>&)>;
+    size_t loadRows(const RowSource& next_row, size_t expected_rows = 0);
+    void reserve(size_t rows);
+    // Replaces all column storage (e.g. with columns mapped from a segment
+    // file); types must match the schema. Existing indexes are rebuilt.
+    void setColumnData(std::vector<ColumnVector> data);
+    // Appends count rows column by column: column i takes sources[i] at
+    // rows[i][0..count), NO_ROW giving NULL
+    void appendRows(const std::vector<const ColumnVector*>& sources,
+                    const std::vector<const uint32_t*>& rows, size_t count);
+    Row getRow(size_t row_idx) const;
+    Value getValue(size_t row_idx, size_t col_idx) const { return column_data[col_idx].get(row_idx); }
+    const ColumnVector& getColumnData(size_t col_idx) const { return column_data[col_idx]; }
     
     // Query operations
     std::vector<size_t> selectRows(const std::string& where_clause = "") const;
+    std::vector<size_t> selectRows(const Predicate& predicate) const;
+    // used_index, if given, is set to whether an index lookup answered the
+    // predicate instead of a scan
+    SelectionBitmap filter(const Predicate& predicate, ThreadPool* pool = nullptr,
+                           bool* used_index = nullptr) const;
     void printTable() const;
     void printRows(const std::vector<size_t>& row_indices, 
                    const std::vector<std::string>& selected_columns = {}) const;
+    void printRows(const SelectionBitmap& selection,
+                   const std::vector<std::string>& selected_columns = {}) const;
     
     // Utility functions
     Value parseValue(const std::string& value_str, const std::string& type) const;
     std::string valueToString(const Value& value) const;
-    bool evaluateCondition(const Row& row, const std::string& condition) const;
     
-    size_t size() const { return rows.size(); }
-    bool empty() const { return rows.empty(); }
+    size_t size() const { return row_count; }
+    bool empty() const { return row_count == 0; }
 };
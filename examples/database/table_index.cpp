@@ -0,0 +1,258 @@
+#include "table_index.h"
+#include "bplus_tree.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+
+namespace {
+
+inline uint64_t mixHash(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+// Per-type adapters: how to read a key out of a column, how to get the
+// comparison constant as a key, and how to hash it. constant() returns
+// false when no stored key can possibly match.
+struct IntKey {
+    using Key = int;
+    static Key read(const ColumnVector& column, uint32_t row) { return column.intData()[row]; }
+    static bool indexable(Key) { return true; }
+    static bool constant(const Comparison& cmp, Key& key) { key = cmp.int_value; return true; }
+    static uint64_t hash(Key key) { return mixHash(static_cast<uint32_t>(key)); }
+};
+
+struct DoubleKey {
+    using Key = double;
+    static Key read(const ColumnVector& column, uint32_t row) { return column.doubleData()[row]; }
+    static bool indexable(Key key) { return !std::isnan(key); }  // NaN never compares true
+    static bool constant(const Comparison& cmp, Key& key) {
+        key = cmp.double_value;
+        return !std::isnan(key);
+    }
+    static uint64_t hash(Key key) {
+        if (key == 0.0) {
+            key = 0.0;  // -0.0 == 0.0, so they must hash the same
+        }
+        uint64_t bits;
+        std::memcpy(&bits, &key, sizeof(bits));
+        return mixHash(bits);
+    }
+};
+
+struct BoolKey {
+    using Key = uint8_t;
+    static Key read(const ColumnVector& column, uint32_t row) { return column.boolData()[row]; }
+    static bool indexable(Key) { return true; }
+    static bool constant(const Comparison& cmp, Key& key) { key = cmp.bool_value ? 1 : 0; return true; }
+    static uint64_t hash(Key key) { return mixHash(key); }
+};
+
+// Hash indexes on strings only need equality, so they key on dictionary codes
+struct StringCodeKey {
+    using Key = uint32_t;
+    static Key read(const ColumnVector& column, uint32_t row) { return column.stringCodes()[row]; }
+    static bool indexable(Key) { return true; }
+    static bool constant(const Comparison& cmp, Key& key) {
+        key = cmp.string_code;
+        return cmp.code_found;
+    }
+    static uint64_t hash(Key key) { return mixHash(key); }
+};
+
+// Ordered indexes on strings compare the strings themselves. The views
+// point into the column dictionary, which never moves its strings; for a
+// mapped dictionary they point into the file, which the index keeps
+// mapped after the column copies it into owned storage.
+struct StringValueKey {
+    using Key = std::string_view;
+    static Key read(const ColumnVector& column, uint32_t row) {
+        return column.getDictionary().lookup(column.stringCodes()[row]);
+    }
+    static bool indexable(Key) { return true; }
+    static bool constant(const Comparison& cmp, Key& key) { key = cmp.string_value; return true; }
+};
+
+// Open-addressing hash table from key to the most recent row with that
+// key; earlier rows with the same key are chained through next_row.
+template <typename Traits>
+class HashIndex : public ColumnIndex {
+private:
+    using Key = typename Traits::Key;
+    static constexpr uint32_t NO_ROW = UINT32_MAX;
+
+    struct Slot {
+        Key key;
+        uint32_t head;  // NO_ROW marks an empty slot
+    };
+
+    std::vector<Slot> slots;
+    std::vector<uint32_t> next_row;
+    size_t distinct_keys;
+    size_t entry_count;
+
+    size_t findSlot(const std::vector<Slot>& table, const Key& key) const {
+        size_t mask = table.size() - 1;
+        size_t pos = Traits::hash(key) & mask;
+        while (table[pos].head != NO_ROW && !(table[pos].key == key)) {
+            pos = (pos + 1) & mask;
+        }
+        return pos;
+    }
+
+    void grow() {
+        std::vector<Slot> bigger(slots.empty() ? 64 : slots.size() * 2, Slot{Key(), NO_ROW});
+        for (const auto& slot : slots) {
+            if (slot.head != NO_ROW) {
+                bigger[findSlot(bigger, slot.key)] = slot;
+            }
+        }
+        slots.swap(bigger);
+    }
+
+public:
+    HashIndex() : distinct_keys(0), entry_count(0) {}
+
+    IndexType getType() const override { return IndexType::HASH; }
+    bool supports(CompareOp op) const override { return op == CompareOp::EQ; }
+
+    void insert(const ColumnVector& column, uint32_t row) override {
+        Key key = Traits::read(column, row);
+        if (!Traits::indexable(key)) {
+            return;
+        }
+
+        // Keep the load factor at or below 1/2
+        if ((distinct_keys + 1) * 2 > slots.size()) {
+            grow();
+        }
+        if (next_row.size() <= row) {
+            next_row.resize(row + 1, NO_ROW);
+        }
+
+        Slot& slot = slots[findSlot(slots, key)];
+        if (slot.head == NO_ROW) {
+            slot.key = key;
+            distinct_keys++;
+        }
+        next_row[row] = slot.head;
+        slot.head = row;
+        entry_count++;
+    }
+
+    bool lookup(const Comparison& cmp, size_t limit, std::vector<uint32_t>& rows) const override {
+        Key key;
+        if (slots.empty() || !Traits::constant(cmp, key)) {
+            return true;
+        }
+
+        size_t start = rows.size();
+        for (uint32_t row = slots[findSlot(slots, key)].head; row != NO_ROW; row = next_row[row]) {
+            if (rows.size() - start >= limit) {
+                return false;
+            }
+            rows.push_back(row);
+        }
+        return true;
+    }
+
+    size_t size() const override { return entry_count; }
+};
+
+template <typename Traits>
+class OrderedIndex : public ColumnIndex {
+private:
+    using Key = typename Traits::Key;
+    BPlusTree<Key> tree;
+    std::shared_ptr<const void> mapping;  // Backs string keys read from a mapped column
+
+public:
+    IndexType getType() const override { return IndexType::BTREE; }
+    bool supports(CompareOp op) const override { return op != CompareOp::NE; }
+
+    void insert(const ColumnVector& column, uint32_t row) override {
+        if constexpr (std::is_same_v<Key, std::string_view>) {
+            if (!mapping && column.isMapped()) {
+                mapping = column.getMapping();
+            }
+        }
+        Key key = Traits::read(column, row);
+        if (Traits::indexable(key)) {
+            tree.insert(key, row);
+        }
+    }
+
+    bool lookup(const Comparison& cmp, size_t limit, std::vector<uint32_t>& rows) const override {
+        Key key;
+        if (!Traits::constant(cmp, key)) {
+            return true;
+        }
+
+        size_t start = rows.size();
+        bool complete = true;
+        auto collect = [&](uint32_t row) {
+            if (rows.size() - start >= limit) {
+                complete = false;
+                return false;
+            }
+            rows.push_back(row);
+            return true;
+        };
+
+        switch (cmp.op) {
+            case CompareOp::EQ: tree.scan(&key, true, &key, true, collect); break;
+            case CompareOp::LT: tree.scan(nullptr, false, &key, false, collect); break;
+            case CompareOp::LE: tree.scan(nullptr, false, &key, true, collect); break;
+            case CompareOp::GT: tree.scan(&key, false, nullptr, false, collect); break;
+            case CompareOp::GE: tree.scan(&key, true, nullptr, false, collect); break;
+            case CompareOp::NE: throw std::runtime_error("B-tree index cannot answer '!='");
+        }
+        return complete;
+    }
+
+    size_t size() const override { return tree.size(); }
+};
+
+} // namespace
+
+IndexType indexTypeFromString(const std::string& type) {
+    std::string lower = type;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    if (lower == "hash") {
+        return IndexType::HASH;
+    } else if (lower == "btree" || lower == "b+tree") {
+        return IndexType::BTREE;
+    }
+    throw std::runtime_error("Unknown index type '" + type + "' (expected HASH or BTREE)");
+}
+
+std::string indexTypeToString(IndexType type) {
+    return type == IndexType::HASH ? "hash" : "btree";
+}
+
+std::unique_ptr<ColumnIndex> createColumnIndex(IndexType type, ColumnType column_type) {
+    if (type == IndexType::HASH) {
+        switch (column_type) {
+            case ColumnType::INT:    return std::make_unique<HashIndex<IntKey>>();
+            case ColumnType::DOUBLE: return std::make_unique<HashIndex<DoubleKey>>();
+            case ColumnType::BOOL:   return std::make_unique<HashIndex<BoolKey>>();
+            case ColumnType::STRING: return std::make_unique<HashIndex<StringCodeKey>>();
+        }
+    } else {
+        switch (column_type) {
+            case ColumnType::INT:    return std::make_unique<OrderedIndex<IntKey>>();
+            case ColumnType::DOUBLE: return std::make_unique<OrderedIndex<DoubleKey>>();
+            case ColumnType::BOOL:   return std::make_unique<OrderedIndex<BoolKey>>();
+            case ColumnType::STRING: return std::make_unique<OrderedIndex<StringValueKey>>();
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "column_store.h"
+#include "predicate.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+enum class IndexType {
+    HASH,   // Equality lookups only
+    BTREE   // Equality and range lookups
+};
+
+IndexType indexTypeFromString(const std::string& type);
+std::string indexTypeToString(IndexType type);
+
+// Secondary index over one column, maintained as rows are appended
+class ColumnIndex {
+public:
+    virtual ~ColumnIndex() = default;
+
+    virtual IndexType getType() const = 0;
+    virtual bool supports(CompareOp op) const = 0;
+
+    // Indexes the value stored at `row` of `column`
+    virtual void insert(const ColumnVector& column, uint32_t row) = 0;
+
+    // Appends the rows satisfying `cmp` to `rows`. Gives up and returns
+    // false once more than `limit` rows match, leaving `rows` partial.
+    virtual bool lookup(const Comparison& cmp, size_t limit, std::vector<uint32_t>& rows) const = 0;
+
+    virtual size_t size() const = 0;
+};
+
+std::unique_ptr<ColumnIndex> createColumnIndex(IndexType type, ColumnType column_type);
@@ -2,11 +2,38 @@
 
 echo "Testing SimpleDB..."
 
-cd /workspaces/accelerated-data-engineering/examples/database/build
+cd "$(dirname "$0")/build" || exit 1
 
 # Test basic functionality
 echo "CREATE TABLE test (id int, name string)" | ./simple_db
-echo "INSERT INTO test VALUES (1, hello)" | ./simple_db  
+echo "INSERT INTO test VALUES (1, hello)" | ./simple_db
 echo "SELECT * FROM test" | ./simple_db
 
+# Reopen then insert: a B+-tree on a string column of a saved table must
+# survive the column being copied out of its mapped segment
+DATA_DIR=$(mktemp -d)
+printf "CREATE TABLE t (id int, name string)\nINSERT INTO t VALUES (1, bob)\nINSERT INTO t VALUES (2, alice)\nCREATE INDEX idx_name ON t (name) USING BTREE\nCHECKPOINT\nexit\n" \
+    | ./simple_db --data-dir "$DATA_DIR" > /dev/null
+OUTPUT=$(printf "INSERT INTO t VALUES (3, carol)\nSELECT * FROM t WHERE name > b\nexit\n" | ./simple_db --data-dir "$DATA_DIR")
+STATUS=$?
+rm -rf "$DATA_DIR"
+if [ $STATUS -ne 0 ] || ! echo "$OUTPUT" | grep -q "(2 rows)"; then
+    echo "FAILED: insert after reopening a table with a string B+-tree index"
+    exit 1
+fi
+
+# A multi-row INSERT is one batch, and BEGIN ... COMMIT groups statements
+OUTPUT=$(printf "CREATE TABLE b (id int)\nBEGIN\nINSERT INTO b VALUES (1), (2), (3)\nINSERT INTO b VALUES (4)\nCOMMIT\nSELECT COUNT(*) FROM b\nexit\n" | ./simple_db)
+if ! echo "$OUTPUT" | grep -q "3 rows inserted" || ! echo "$OUTPUT" | grep -q "| 4 "; then
+    echo "FAILED: multi-row INSERT inside BEGIN ... COMMIT"
+    exit 1
+fi
+
+# Unmatched LEFT JOIN rows are NULL on the right, which WHERE never matches
+OUTPUT=$(printf "CREATE TABLE l (id int)\nCREATE TABLE r (id int, v int)\nINSERT INTO l VALUES (1), (2)\nINSERT INTO r VALUES (1, 0)\nSELECT * FROM l LEFT JOIN r ON l.id = r.id WHERE r.v = 0\nSELECT COUNT(r.v) FROM l LEFT JOIN r ON l.id = r.id\nexit\n" | ./simple_db)
+if echo "$OUTPUT" | grep -q "(2 rows)" || ! echo "$OUTPUT" | grep -q "| 1  *|$"; then
+    echo "FAILED: NULL right-hand columns of an unmatched LEFT JOIN row"
+    exit 1
+fi
+
 echo "Test completed!"
@@ -0,0 +1,164 @@
+#include "thread_pool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t num_threads) : num_workers(std::max(num_threads, size_t(1))) {
+    for (size_t i = 0; i < num_workers; ++i) {
+        ranges.push_back(std::make_unique<MorselRange>());
+    }
+    // Worker 0 is whichever thread calls parallelFor()
+    for (size_t i = 1; i < num_workers; ++i) {
+        threads.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        stopping = true;
+    }
+    work_available.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::parallelFor(size_t num_morsels, const MorselFunction& fn) {
+    if (num_morsels == 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> job_lock(job_mutex);
+
+    if (num_workers == 1 || num_morsels == 1) {
+        for (size_t morsel = 0; morsel < num_morsels; ++morsel) {
+            fn(morsel, 0);
+        }
+        return;
+    }
+
+    // Give each worker a contiguous slice so neighbouring morsels (and the
+    // memory they touch) tend to stay on the same core
+    size_t per_worker = num_morsels / num_workers;
+    size_t extra = num_morsels % num_workers;
+    size_t begin = 0;
+    for (size_t w = 0; w < num_workers; ++w) {
+        size_t count = per_worker + (w < extra ? 1 : 0);
+        std::lock_guard<std::mutex> lock(ranges[w]->mutex);
+        ranges[w]->next = begin;
+        ranges[w]->end = begin + count;
+        begin += count;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        current_job = &fn;
+        job_error = nullptr;
+        active_workers = num_workers - 1;
+        job_generation++;
+    }
+    work_available.notify_all();
+
+    runMorsels(0, fn);
+
+    std::unique_lock<std::mutex> lock(state_mutex);
+    work_finished.wait(lock, [this] { return active_workers == 0; });
+    current_job = nullptr;
+
+    if (job_error) {
+        std::exception_ptr error = job_error;
+        job_error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::workerLoop(size_t worker_id) {
+    size_t seen_generation = 0;
+
+    while (true) {
+        const MorselFunction* job;
+        {
+            std::unique_lock<std::mutex> lock(state_mutex);
+            work_available.wait(lock, [&] { return stopping || job_generation != seen_generation; });
+            if (stopping) {
+                return;
+            }
+            seen_generation = job_generation;
+            job = current_job;
+        }
+
+        runMorsels(worker_id, *job);
+
+        std::lock_guard<std::mutex> lock(state_mutex);
+        if (--active_workers == 0) {
+            work_finished.notify_one();
+        }
+    }
+}
+
+void ThreadPool::runMorsels(size_t worker_id, const MorselFunction& fn) {
+    size_t morsel;
+    do {
+        while (takeMorsel(worker_id, morsel)) {
+            try {
+                fn(morsel, worker_id);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(state_mutex);
+                if (!job_error) {
+                    job_error = std::current_exception();
+                }
+            }
+        }
+    } while (stealMorsels(worker_id));
+}
+
+bool ThreadPool::takeMorsel(size_t worker_id, size_t& morsel) {
+    MorselRange& range = *ranges[worker_id];
+    std::lock_guard<std::mutex> lock(range.mutex);
+    if (range.next >= range.end) {
+        return false;
+    }
+    morsel = range.next++;
+    return true;
+}
+
+bool ThreadPool::stealMorsels(size_t worker_id) {
+    while (true) {
+        // Pick the victim with the most work left
+        size_t victim = worker_id;
+        size_t most_remaining = 0;
+        for (size_t w = 0; w < num_workers; ++w) {
+            if (w == worker_id) {
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(ranges[w]->mutex);
+            size_t remaining = ranges[w]->end - ranges[w]->next;
+            if (remaining > most_remaining) {
+                most_remaining = remaining;
+                victim = w;
+            }
+        }
+        if (victim == worker_id) {
+            return false;  // Every range is drained
+        }
+
+        size_t stolen_begin;
+        size_t stolen_end;
+        {
+            std::lock_guard<std::mutex> lock(ranges[victim]->mutex);
+            size_t remaining = ranges[victim]->end - ranges[victim]->next;
+            if (remaining == 0) {
+                continue;  // Someone else got there first
+            }
+            // Take the back half, leaving the victim the morsels it is about to reach
+            size_t take = (remaining + 1) / 2;
+            stolen_end = ranges[victim]->end;
+            stolen_begin = stolen_end - take;
+            ranges[victim]->end = stolen_begin;
+        }
+
+        std::lock_guard<std::mutex> lock(ranges[worker_id]->mutex);
+        ranges[worker_id]->next = stolen_begin;
+        ranges[worker_id]->end = stolen_end;
+        return true;
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <memory>
+#include <cstddef>
+
+// Fixed-size pool for morsel-driven execution. parallelFor() hands every
+// worker a contiguous range of morsels; a worker that runs out steals the
+// back half of the largest remaining range, so skewed morsels still keep
+// all threads busy. The calling thread takes part as worker 0.
+class ThreadPool {
+public:
+    // fn(morsel_index, worker_id); worker_id < size() and is stable for
+    // the duration of a call, so it can index per-worker result buffers
+    using MorselFunction = std::function<void(size_t, size_t)>;
+
+    explicit ThreadPool(size_t num_threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return num_workers; }
+
+    // Runs fn for every morsel in [0, num_morsels) and blocks until all
+    // are done. The first exception thrown by fn is rethrown here.
+    void parallelFor(size_t num_morsels, const MorselFunction& fn);
+
+private:
+    struct MorselRange {
+        std::mutex mutex;
+        size_t next = 0;
+        size_t end = 0;
+    };
+
+    size_t num_workers;
+    std::vector<std::thread> threads;
+    std::vector<std::unique_ptr<MorselRange>> ranges;
+
+    std::mutex job_mutex;            // Serializes parallelFor callers
+    std::mutex state_mutex;
+    std::condition_variable work_available;
+    std::condition_variable work_finished;
+    const MorselFunction* current_job = nullptr;
+    size_t job_generation = 0;
+    size_t active_workers = 0;
+    bool stopping = false;
+    std::exception_ptr job_error;
+
+    void workerLoop(size_t worker_id);
+    void runMorsels(size_t worker_id, const MorselFunction& fn);
+    bool takeMorsel(size_t worker_id, size_t& morsel);
+    bool stealMorsels(size_t worker_id);
+};
@@ -0,0 +1,280 @@
+#include "wal.h"
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t FRAME_HEADER_BYTES = 2 * sizeof(uint32_t);  // length + crc
+constexpr size_t MAX_RECORD_BYTES = 1u << 30;
+constexpr size_t BACKPRESSURE_BATCHES = 4;  // Appends block once this many batches are queued
+
+uint32_t crc32(const char* data, size_t length) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
+
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < length; ++i) {
+        crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+template <typename T>
+void putScalar(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool getScalar(const char*& at, const char* end, T& value) {
+    if (static_cast<size_t>(end - at) < sizeof(T)) {
+        return false;
+    }
+    std::memcpy(&value, at, sizeof(T));
+    at += sizeof(T);
+    return true;
+}
+
+std::string systemError(const std::string& what, const std::string& path) {
+    return what + " '" + path + "': " + std::strerror(errno);
+}
+
+} // namespace
+
+WriteAheadLog::WriteAheadLog(const std::string& p, uint64_t last_lsn, const WalConfig& c)
+    : path(p), config(c), next_lsn(last_lsn), durable_lsn(last_lsn) {
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        throw std::runtime_error(systemError("Cannot open write-ahead log", path));
+    }
+    flusher = std::thread(&WriteAheadLog::flushLoop, this);
+}
+
+WriteAheadLog::~WriteAheadLog() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    flush_needed.notify_one();
+    flusher.join();  // Writes out whatever is still pending
+    ::close(fd);
+}
+
+uint64_t WriteAheadLog::append(WalRecordType type, const std::vector<std::string>& fields) {
+    std::string body;
+    size_t body_bytes = sizeof(uint64_t) + 1;
+    for (const auto& field : fields) {
+        body_bytes += sizeof(uint32_t) + field.size();
+    }
+    if (body_bytes > MAX_RECORD_BYTES) {
+        throw std::runtime_error("Write-ahead log record too large");
+    }
+    body.reserve(FRAME_HEADER_BYTES + body_bytes);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!write_error.empty()) {
+        throw std::runtime_error(write_error);
+    }
+    if (pending.size() >= BACKPRESSURE_BATCHES * config.max_batch_bytes) {
+        waitDurable(lock, pending_lsn);
+    }
+
+    uint64_t lsn = ++next_lsn;
+    putScalar(body, static_cast<uint32_t>(body_bytes));
+    putScalar(body, uint32_t(0));  // CRC, filled in below
+    putScalar(body, lsn);
+    putScalar(body, static_cast<uint8_t>(type));
+    for (const auto& field : fields) {
+        putScalar(body, static_cast<uint32_t>(field.size()));
+        body += field;
+    }
+    uint32_t crc = crc32(body.data() + FRAME_HEADER_BYTES, body_bytes);
+    std::memcpy(&body[sizeof(uint32_t)], &crc, sizeof(crc));
+
+    if (pending.empty()) {
+        pending_since = std::chrono::steady_clock::now();
+    }
+    pending += body;
+    pending_lsn = lsn;
+    if (pending.size() >= config.max_batch_bytes) {
+        flush_needed.notify_one();
+    }
+    return lsn;
+}
+
+void WriteAheadLog::commit(uint64_t lsn) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (config.sync_commit) {
+        waitDurable(lock, lsn);
+    }
+}
+
+void WriteAheadLog::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    waitDurable(lock, next_lsn);
+}
+
+void WriteAheadLog::truncate() {
+    flush();
+    std::lock_guard<std::mutex> lock(mutex);
+    if (::ftruncate(fd, 0) != 0 || ::fsync(fd) != 0) {
+        throw std::runtime_error(systemError("Cannot truncate write-ahead log", path));
+    }
+}
+
+void WriteAheadLog::setConfig(const WalConfig& c) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        config = c;
+    }
+    flush_needed.notify_one();  // A shorter latency may already be due
+}
+
+WalConfig WriteAheadLog::getConfig() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return config;
+}
+
+uint64_t WriteAheadLog::lastLsn() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return next_lsn;
+}
+
+void WriteAheadLog::waitDurable(std::unique_lock<std::mutex>& lock, uint64_t lsn) {
+    if (durable_lsn >= lsn) {
+        return;
+    }
+    // A waiting committer makes the flusher write immediately; records
+    // appended meanwhile by other threads join the same batch
+    sync_waiters++;
+    flush_needed.notify_one();
+    flushed.wait(lock, [&] { return durable_lsn >= lsn || !write_error.empty(); });
+    sync_waiters--;
+    if (durable_lsn < lsn) {
+        throw std::runtime_error(write_error);
+    }
+}
+
+void WriteAheadLog::flushLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        while (!stopping) {
+            if (pending.empty()) {
+                flush_needed.wait(lock);
+                continue;
+            }
+            if (sync_waiters > 0 || pending.size() >= config.max_batch_bytes) {
+                break;
+            }
+            auto deadline = pending_since + config.max_latency;
+            if (std::chrono::steady_clock::now() >= deadline) {
+                break;
+            }
+            flush_needed.wait_until(lock, deadline);
+        }
+        if (pending.empty()) {
+            return;  // Stopping with nothing left to write
+        }
+
+        std::string batch;
+        batch.swap(pending);
+        uint64_t batch_lsn = pending_lsn;
+        lock.unlock();
+
+        std::string error;
+        size_t written = 0;
+        while (written < batch.size() && error.empty()) {
+            ssize_t n = ::write(fd, batch.data() + written, batch.size() - written);
+            if (n < 0 && errno != EINTR) {
+                error = systemError("Cannot write write-ahead log", path);
+            } else if (n > 0) {
+                written += static_cast<size_t>(n);
+            }
+        }
+        if (error.empty() && ::fdatasync(fd) != 0) {
+            error = systemError("Cannot sync write-ahead log", path);
+        }
+
+        lock.lock();
+        if (error.empty()) {
+            durable_lsn = batch_lsn;
+        } else {
+            write_error = error;
+        }
+        flushed.notify_all();
+        if (!write_error.empty()) {
+            return;  // The log is no longer trustworthy; every commit now fails
+        }
+    }
+}
+
+uint64_t WriteAheadLog::replay(const std::string& path, const std::function<void(const WalRecord&)>& apply) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return 0;  // No log yet
+    }
+    std::string data;
+    char buffer[1 << 16];
+    size_t n;
+    while ((n = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.append(buffer, n);
+    }
+    std::fclose(file);
+
+    uint64_t last_lsn = 0;
+    size_t offset = 0;
+    WalRecord record;
+    while (data.size() - offset >= FRAME_HEADER_BYTES) {
+        uint32_t length;
+        uint32_t crc;
+        std::memcpy(&length, data.data() + offset, sizeof(length));
+        std::memcpy(&crc, data.data() + offset + sizeof(length), sizeof(crc));
+        const char* body = data.data() + offset + FRAME_HEADER_BYTES;
+        if (length > data.size() - offset - FRAME_HEADER_BYTES || crc32(body, length) != crc) {
+            break;  // Torn write at the tail
+        }
+
+        const char* at = body;
+        const char* end = body + length;
+        uint8_t type;
+        if (!getScalar(at, end, record.lsn) || !getScalar(at, end, type)) {
+            break;
+        }
+        record.type = static_cast<WalRecordType>(type);
+        record.fields.clear();
+        bool ok = true;
+        while (at < end && ok) {
+            uint32_t field_length;
+            ok = getScalar(at, end, field_length) && static_cast<size_t>(end - at) >= field_length;
+            if (ok) {
+                record.fields.emplace_back(at, field_length);
+                at += field_length;
+            }
+        }
+        if (!ok) {
+            break;
+        }
+
+        apply(record);
+        last_lsn = record.lsn;
+        offset += FRAME_HEADER_BYTES + length;
+    }
+
+    if (offset < data.size() && ::truncate(path.c_str(), static_cast<off_t>(offset)) != 0) {
+        throw std::runtime_error(systemError("Cannot truncate write-ahead log", path));
+    }
+    return last_lsn;
+}
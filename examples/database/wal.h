@@ -0,0 +1,84 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <cstdint>
+
+constexpr const char* WAL_FILE_NAME = "wal.log";
+
+enum class WalRecordType : uint8_t {
+    CREATE_TABLE = 1,  // table
+    ADD_COLUMN,        // table, column, type
+    CREATE_INDEX,      // table, index, column, index type
+    INSERT,            // table, values...
+    INSERT_BATCH,      // table, column count, values of every row...
+    DROP_TABLE         // table
+};
+
+struct WalRecord {
+    uint64_t lsn;
+    WalRecordType type;
+    std::vector<std::string> fields;
+};
+
+struct WalConfig {
+    size_t max_batch_bytes = 1 << 20;                 // Flush once this much is buffered...
+    std::chrono::microseconds max_latency{2000};      // ...or the oldest record is this old
+    bool sync_commit = true;                          // commit() waits until the record is durable
+};
+
+// Append-only redo log with group commit. append() frames a record into an
+// in-memory batch; a background thread writes and fdatasyncs whole batches,
+// so every commit waiting on the same fsync shares it. Frames are
+// [length u32][crc32 u32][lsn u64][type u8][fields], each field a u32
+// length plus bytes. Recovery stops at the first torn or corrupt frame.
+class WriteAheadLog {
+public:
+    WriteAheadLog(const std::string& path, uint64_t last_lsn, const WalConfig& config);
+    ~WriteAheadLog();
+
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    // Reads every intact record in order and truncates a torn tail.
+    // Returns the last LSN seen (0 for an empty or missing log).
+    static uint64_t replay(const std::string& path, const std::function<void(const WalRecord&)>& apply);
+
+    uint64_t append(WalRecordType type, const std::vector<std::string>& fields);
+    // Waits for lsn to be durable if sync_commit is set, else returns at once
+    void commit(uint64_t lsn);
+    // Waits until everything appended so far is durable
+    void flush();
+    // Drops all records; callers must have checkpointed everything first
+    void truncate();
+
+    void setConfig(const WalConfig& config);
+    WalConfig getConfig() const;
+    uint64_t lastLsn() const;
+
+private:
+    std::string path;
+    int fd;
+    WalConfig config;
+
+    mutable std::mutex mutex;
+    std::condition_variable flush_needed;
+    std::condition_variable flushed;
+    std::string pending;                    // Framed records not yet written
+    uint64_t pending_lsn = 0;               // Last LSN in pending
+    std::chrono::steady_clock::time_point pending_since;
+    uint64_t next_lsn;
+    uint64_t durable_lsn;
+    size_t sync_waiters = 0;
+    bool stopping = false;
+    std::string write_error;
+    std::thread flusher;
+
+    void flushLoop();
+    void waitDurable(std::unique_lock<std::mutex>& lock, uint64_t lsn);
+};
@@ -0,0 +1,681 @@
+#include "cluster.h"
+#include "processors/stream_operators.h"
+#include <nlohmann/json.hpp>
+#include <unistd.h>
+#include <chrono>
+#include <condition_variable>
+#include <stdexcept>
+#include <thread>
+
+using etl::Accumulator;
+using etl::AggregateFunction;
+using etl::AggregateSpec;
+using etl::Column;
+using etl::Fingerprint;
+using etl::FingerprintTable;
+using etl::KeyEncoder;
+using etl::RecordBatch;
+
+namespace {
+
+// A job fails if it waits this long without a frame from any worker, e.g.
+// because a peer died before it connected
+constexpr auto PEER_TIMEOUT = std::chrono::seconds(60);
+
+// Finished job ids remembered to turn away late shuffle connections
+constexpr size_t FINISHED_JOBS_KEPT = 1024;
+
+double millisSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Parts of an Accumulator each function's partial state carries
+enum PartialPart : unsigned {
+    PART_SUM = 1,
+    PART_MIN = 2,
+    PART_MAX = 4,
+    PART_NUMBERS = 8,
+    PART_VALUES = 16
+};
+
+unsigned partialParts(AggregateFunction function) {
+    switch (function) {
+        case AggregateFunction::SUM: return PART_SUM | PART_NUMBERS;
+        case AggregateFunction::AVG: return PART_SUM | PART_NUMBERS;
+        case AggregateFunction::MIN: return PART_MIN | PART_NUMBERS;
+        case AggregateFunction::MAX: return PART_MAX | PART_NUMBERS;
+        case AggregateFunction::COUNT: return PART_VALUES;
+    }
+    return 0;
+}
+
+std::string partialName(size_t spec, const char* part) {
+    return "__partial" + std::to_string(spec) + "_" + part;
+}
+
+// Groups and their accumulators, fed either input records (the map side)
+// or other tables' partial states (the reduce side). Groups keep the order
+// they were first seen in.
+class GroupTable {
+public:
+    GroupTable(const std::vector<std::string>& groupBy, const std::vector<AggregateSpec>& specs)
+        : group_by_(groupBy), specs_(specs) {
+        for (const auto& field : group_by_) {
+            keys_.emplace_back(field);
+        }
+    }
+
+    size_t size() const { return hashes_.size(); }
+
+    void addRecords(const RecordBatch& batch) {
+        std::vector<const Column*> groupColumns = columnsOf(batch, group_by_);
+        std::vector<const Column*> valueColumns;
+        for (const auto& spec : specs_) {
+            valueColumns.push_back(batch.findColumn(spec.field));
+        }
+        KeyEncoder encoder(batch, group_by_);
+
+        for (size_t row = 0; row < batch.numRows(); ++row) {
+            Accumulator* acc = groupOf(encoder, groupColumns, row);
+            for (size_t i = 0; i < specs_.size(); ++i) {
+                const Column* column = valueColumns[i];
+                if (!column || !column->isPresent(row)) continue;
+
+                acc[i].values++;
+                double value;
+                if (etl::numericCellValue(*column, row, value)) {
+                    acc[i].add(value);
+                }
+            }
+        }
+    }
+
+    void addPartials(const RecordBatch& batch) {
+        std::vector<const Column*> groupColumns = columnsOf(batch, group_by_);
+        static const char* const PART_NAMES[] = {"sum", "min", "max", "numbers", "values"};
+        std::vector<const Column*> parts;
+        for (size_t i = 0; i < specs_.size(); ++i) {
+            for (const char* part : PART_NAMES) {
+                parts.push_back(batch.findColumn(partialName(i, part)));
+            }
+        }
+        KeyEncoder encoder(batch, group_by_);
+
+        auto number = [&](size_t i, size_t part, size_t row) {
+            double value = 0;
+            const Column* column = parts[i * 5 + part];
+            if (column) column->numberAt(row, value);
+            return value;
+        };
+        for (size_t row = 0; row < batch.numRows(); ++row) {
+            Accumulator* acc = groupOf(encoder, groupColumns, row);
+            for (size_t i = 0; i < specs_.size(); ++i) {
+                Accumulator partial;
+                partial.sum = number(i, 0, row);
+                partial.min = number(i, 1, row);
+                partial.max = number(i, 2, row);
+                partial.numbers = static_cast<size_t>(number(i, 3, row));
+                partial.values = static_cast<size_t>(number(i, 4, row));
+                acc[i].merge(partial);
+            }
+        }
+    }
+
+    // Each group's partial state, in one batch per hash partition
+    std::vector<RecordBatch> partials(size_t partitions) const {
+        std::vector<std::vector<size_t>> groups(partitions);
+        for (size_t group = 0; group < size(); ++group) {
+            groups[hashes_[group] % partitions].push_back(group);
+        }
+
+        std::vector<RecordBatch> batches;
+        for (const auto& rows : groups) {
+            std::vector<Column> columns = keyColumns(rows);
+            for (size_t i = 0; i < specs_.size(); ++i) {
+                unsigned parts = partialParts(specs_[i].function);
+                auto addPart = [&](unsigned part, const char* name, auto value) {
+                    if (!(parts & part)) return;
+                    Column column(partialName(i, name));
+                    for (size_t group : rows) {
+                        column.append(value(accumulators_[group * specs_.size() + i]));
+                    }
+                    columns.push_back(std::move(column));
+                };
+                addPart(PART_SUM, "sum", [](const Accumulator& acc) { return acc.sum; });
+                addPart(PART_MIN, "min", [](const Accumulator& acc) { return acc.min; });
+                addPart(PART_MAX, "max", [](const Accumulator& acc) { return acc.max; });
+                addPart(PART_NUMBERS, "numbers", [](const Accumulator& acc) { return acc.numbers; });
+                addPart(PART_VALUES, "values", [](const Accumulator& acc) { return acc.values; });
+            }
+            batches.push_back(RecordBatch::fromColumns(std::move(columns)));
+        }
+        return batches;
+    }
+
+    // One row per group: the group-by fields, then "<field>_<function>"
+    RecordBatch results() const {
+        std::vector<size_t> rows(size());
+        for (size_t group = 0; group < rows.size(); ++group) {
+            rows[group] = group;
+        }
+        std::vector<Column> columns = keyColumns(rows);
+        for (size_t i = 0; i < specs_.size(); ++i) {
+            Column column(specs_[i].output_name);
+            for (size_t group : rows) {
+                column.append(accumulators_[group * specs_.size() + i].result(specs_[i].function));
+            }
+            columns.push_back(std::move(column));
+        }
+        return RecordBatch::fromColumns(std::move(columns));
+    }
+
+private:
+    static std::vector<const Column*> columnsOf(const RecordBatch& batch, const std::vector<std::string>& fields) {
+        std::vector<const Column*> columns;
+        for (const auto& field : fields) {
+            columns.push_back(batch.findColumn(field));
+        }
+        return columns;
+    }
+
+    // The row's group's accumulators, creating the group if it is new
+    Accumulator* groupOf(const KeyEncoder& encoder, const std::vector<const Column*>& groupColumns, size_t row) {
+        // No group-by fields is one group of everything, not KeyEncoder's whole-record key
+        if (group_by_.empty()) {
+            key_.clear();
+        } else {
+            encoder.encode(row, key_);
+        }
+        Fingerprint fingerprint = etl::fingerprintOf(key_);
+        if (const uint32_t* group = table_.find(fingerprint)) {
+            return accumulators_.data() + *group * specs_.size();
+        }
+
+        size_t group = size();
+        table_.insert(fingerprint, static_cast<uint32_t>(group));
+        hashes_.push_back(fingerprint.lo);
+        for (size_t g = 0; g < keys_.size(); ++g) {
+            if (groupColumns[g]) {
+                keys_[g].appendFrom(*groupColumns[g], row);
+            } else {
+                keys_[g].appendAbsent();
+            }
+        }
+        accumulators_.resize(accumulators_.size() + specs_.size());
+        return accumulators_.data() + group * specs_.size();
+    }
+
+    std::vector<Column> keyColumns(const std::vector<size_t>& rows) const {
+        std::vector<Column> columns;
+        for (const auto& column : keys_) {
+            columns.push_back(column.take(rows));
+        }
+        return columns;
+    }
+
+    std::vector<std::string> group_by_;
+    std::vector<AggregateSpec> specs_;
+    FingerprintTable table_;
+    std::vector<uint64_t> hashes_;          // Per group, picks its partition
+    std::vector<Column> keys_;              // Group-by values, a row per group
+    std::vector<Accumulator> accumulators_; // specs_.size() per group
+    std::string key_;
+};
+
+// First-occurrence filter over a stream of batches
+class Deduplicator {
+public:
+    explicit Deduplicator(const std::vector<std::string>& keyFields) : key_fields_(keyFields) {}
+
+    // Rows of batch whose key is new, with each one's hash in hashes
+    std::vector<size_t> firstOccurrences(const RecordBatch& batch, std::vector<uint64_t>* hashes = nullptr) {
+        KeyEncoder encoder(batch, key_fields_);
+        std::vector<size_t> keep;
+        if (hashes) hashes->clear();
+        for (size_t row = 0; row < batch.numRows(); ++row) {
+            encoder.encode(row, key_);
+            Fingerprint fingerprint = etl::fingerprintOf(key_);
+            if (table_.find(fingerprint)) continue;
+
+            table_.insert(fingerprint, 0);
+            keep.push_back(row);
+            if (hashes) hashes->push_back(fingerprint.lo);
+        }
+        return keep;
+    }
+
+private:
+    std::vector<std::string> key_fields_;
+    FingerprintTable table_;
+    std::string key_;
+};
+
+nlohmann::json statsToJson(const WorkerStats& stats) {
+    return {
+        {"files", stats.files}, {"rows_scanned", stats.rows_scanned},
+        {"rows_shuffled", stats.rows_shuffled}, {"rows_received", stats.rows_received},
+        {"rows_out", stats.rows_out}, {"shuffle_bytes_raw", stats.shuffle_bytes_raw},
+        {"shuffle_bytes", stats.shuffle_bytes}, {"scan_ms", stats.scan_ms},
+        {"wait_ms", stats.wait_ms}, {"merge_ms", stats.merge_ms}
+    };
+}
+
+WorkerStats statsFromJson(const nlohmann::json& json) {
+    WorkerStats stats;
+    stats.files = json.value("files", size_t(0));
+    stats.rows_scanned = json.value("rows_scanned", size_t(0));
+    stats.rows_shuffled = json.value("rows_shuffled", size_t(0));
+    stats.rows_received = json.value("rows_received", size_t(0));
+    stats.rows_out = json.value("rows_out", size_t(0));
+    stats.shuffle_bytes_raw = json.value("shuffle_bytes_raw", size_t(0));
+    stats.shuffle_bytes = json.value("shuffle_bytes", size_t(0));
+    stats.scan_ms = json.value("scan_ms", 0.0);
+    stats.wait_ms = json.value("wait_ms", 0.0);
+    stats.merge_ms = json.value("merge_ms", 0.0);
+    return stats;
+}
+
+} // anonymous namespace
+
+// Shuffle data one worker has received for a job, by source worker. Made
+// by the job's JOB or by a peer's HELLO, whichever arrives first.
+struct Worker::Exchange {
+    explicit Exchange(size_t workers)
+        : batches(workers), ended(workers, false), remaining(workers),
+          last_activity(std::chrono::steady_clock::now()) {}
+
+    void deliver(size_t source, RecordBatch batch) {
+        std::lock_guard<std::mutex> lock(mutex);
+        checkSource(source);
+        batches[source].push_back(std::move(batch));
+        last_activity = std::chrono::steady_clock::now();
+    }
+
+    void end(size_t source) {
+        std::lock_guard<std::mutex> lock(mutex);
+        checkSource(source);
+        if (!ended[source]) {
+            ended[source] = true;
+            remaining--;
+        }
+        last_activity = std::chrono::steady_clock::now();
+        changed.notify_all();
+    }
+
+    void fail(const std::string& message) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (error.empty()) error = message;
+        changed.notify_all();
+    }
+
+    // Blocks until every source has ended and hands over their batches
+    std::vector<std::vector<RecordBatch>> wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (remaining > 0 && error.empty()) {
+            changed.wait_for(lock, std::chrono::seconds(1));
+            if (remaining > 0 && std::chrono::steady_clock::now() - last_activity > PEER_TIMEOUT) {
+                for (size_t source = 0; source < ended.size(); ++source) {
+                    if (!ended[source]) {
+                        error = "Timed out waiting for shuffle data from worker " + std::to_string(source);
+                        break;
+                    }
+                }
+            }
+        }
+        if (!error.empty()) {
+            throw std::runtime_error(error);
+        }
+        return std::move(batches);
+    }
+
+    void checkSource(size_t source) const {
+        if (source >= batches.size()) {
+            throw std::runtime_error("Shuffle frame from unknown worker " + std::to_string(source));
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<std::vector<RecordBatch>> batches;
+    std::vector<bool> ended;
+    size_t remaining;
+    std::string error;
+    std::chrono::steady_clock::time_point last_activity;
+};
+
+Worker::Worker(uint16_t port) : Worker(std::make_unique<Listener>(port)) {
+}
+
+Worker::Worker(std::unique_ptr<Listener> listener) : listener_(std::move(listener)) {
+}
+
+Worker::~Worker() {
+    stop();
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this] { return active_ == 0; });
+}
+
+void Worker::serve() {
+    while (!stopping_) {
+        std::unique_ptr<Connection> connection = listener_->accept();
+        if (!connection) break;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        active_++;
+        std::thread([this, connection = std::move(connection)]() mutable {
+            handleConnection(std::move(connection));
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--active_ == 0) idle_.notify_all();
+        }).detach();
+    }
+}
+
+void Worker::stop() {
+    stopping_ = true;
+    listener_->close();
+}
+
+void Worker::handleConnection(std::unique_ptr<Connection> connection) {
+    FrameHeader header;
+    std::string payload;
+    try {
+        if (!connection->receive(header, payload)) return;
+    } catch (const std::exception&) {
+        return;
+    }
+
+    if (header.type == FrameType::JOB) {
+        runJob(*connection, payload);
+    } else if (header.type == FrameType::HELLO) {
+        receiveShuffle(*connection, header, payload);
+    }
+}
+
+std::shared_ptr<Worker::Exchange> Worker::exchange(const std::string& jobId, size_t workers) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (finished_jobs_.count(jobId)) {
+        throw std::runtime_error("Job " + jobId + " has already finished");
+    }
+    auto& exchange = exchanges_[jobId];
+    if (!exchange) {
+        exchange = std::make_shared<Exchange>(workers);
+    } else if (exchange->batches.size() != workers) {
+        throw std::runtime_error("Workers disagree on the size of job " + jobId);
+    }
+    return exchange;
+}
+
+void Worker::releaseExchange(const std::string& jobId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    exchanges_.erase(jobId);
+    if (finished_jobs_.insert(jobId).second) {
+        finished_order_.push_back(jobId);
+        if (finished_order_.size() > FINISHED_JOBS_KEPT) {
+            finished_jobs_.erase(finished_order_.front());
+            finished_order_.pop_front();
+        }
+    }
+}
+
+void Worker::receiveShuffle(Connection& peer, const FrameHeader& hello, const std::string& payload) {
+    std::shared_ptr<Exchange> exchange;
+    size_t source = hello.source;
+    try {
+        nlohmann::json description = nlohmann::json::parse(payload);
+        exchange = this->exchange(description.at("job").get<std::string>(), description.at("workers").get<size_t>());
+
+        FrameHeader header;
+        std::string frame;
+        std::string scratch;
+        while (peer.receive(header, frame)) {
+            switch (header.type) {
+                case FrameType::DATA:
+                    exchange->deliver(source, decodeFrame(header, frame, scratch));
+                    break;
+                case FrameType::END:
+                    exchange->end(source);
+                    return;
+                case FrameType::ERROR:
+                    exchange->fail("Worker " + std::to_string(source) + " failed: " + frame);
+                    return;
+                default:
+                    throw std::runtime_error("Unexpected frame on a shuffle connection");
+            }
+        }
+        exchange->fail("Worker " + std::to_string(source) + " closed its shuffle connection early");
+    } catch (const std::exception& e) {
+        if (exchange) exchange->fail("Shuffle from worker " + std::to_string(source) + ": " + e.what());
+    }
+}
+
+void Worker::runJob(Connection& coordinator, const std::string& description) {
+    std::string jobId;
+    try {
+        nlohmann::json job = nlohmann::json::parse(description);
+        jobId = job.at("id").get<std::string>();
+        size_t index = job.at("index").get<size_t>();
+        const auto& addresses = job.at("workers");
+        size_t workers = addresses.size();
+        std::vector<std::string> keyFields = job.at("key_fields").get<std::vector<std::string>>();
+        bool aggregate = job.at("kind").get<std::string>() == "aggregate";
+        std::vector<AggregateSpec> specs =
+            etl::parseAggregateSpecs(job.value("aggregations", std::map<std::string, std::string>()));
+        size_t batchRows = job.value("batch_rows", size_t(65536));
+        size_t frameBytes = job.value("frame_bytes", size_t(1 << 20));
+        const Codec& codec = getCodec(job.value("codec", std::string("lz4")));
+        std::shared_ptr<Exchange> exchange = this->exchange(jobId, workers);
+
+        WorkerStats stats;
+        auto phase = std::chrono::steady_clock::now();
+
+        // One connection to every other worker; this worker's own partition
+        // goes straight into its exchange
+        std::vector<std::unique_ptr<Connection>> peers(workers);
+        std::vector<std::unique_ptr<FrameEncoder>> encoders(workers);
+        std::string hello = nlohmann::json{{"job", jobId}, {"workers", workers}}.dump();
+        for (size_t p = 0; p < workers; ++p) {
+            if (p == index) continue;
+            peers[p] = Connection::connect(addresses[p].at("host").get<std::string>(),
+                                           addresses[p].at("port").get<uint16_t>());
+            peers[p]->send(FrameType::HELLO, static_cast<uint32_t>(index), hello);
+            encoders[p] = std::make_unique<FrameEncoder>(codec);
+        }
+
+        auto route = [&](size_t partition, RecordBatch batch) {
+            if (batch.numRows() == 0) return;
+            if (partition == index) {
+                exchange->deliver(index, std::move(batch));
+                return;
+            }
+            stats.rows_shuffled += batch.numRows();
+            encoders[partition]->add(batch);
+            if (encoders[partition]->bufferedBytes() >= frameBytes) {
+                encoders[partition]->sendTo(*peers[partition], FrameType::DATA, static_cast<uint32_t>(index));
+            }
+        };
+
+        // Map side: pre-aggregate or deduplicate locally, then partition
+        GroupTable groups(keyFields, specs);
+        Deduplicator local(keyFields);
+        std::vector<uint64_t> hashes;
+        for (const auto& input : job.at("inputs")) {
+            std::unique_ptr<etl::RecordReader> reader = etl::RecordReader::open(input.get<std::string>());
+            stats.files++;
+            RecordBatch batch;
+            while (reader->next(batch, batchRows)) {
+                stats.rows_scanned += batch.numRows();
+                if (aggregate) {
+                    groups.addRecords(batch);
+                    continue;
+                }
+
+                std::vector<size_t> keep = local.firstOccurrences(batch, &hashes);
+                std::vector<std::vector<size_t>> rows(workers);
+                for (size_t i = 0; i < keep.size(); ++i) {
+                    rows[hashes[i] % workers].push_back(keep[i]);
+                }
+                for (size_t p = 0; p < workers; ++p) {
+                    if (!rows[p].empty()) route(p, batch.take(rows[p]));
+                }
+            }
+        }
+        if (aggregate) {
+            std::vector<RecordBatch> partials = groups.partials(workers);
+            for (size_t p = 0; p < workers; ++p) {
+                for (size_t offset = 0; offset < partials[p].numRows(); offset += batchRows) {
+                    route(p, partials[p].slice(offset, batchRows));
+                }
+            }
+        }
+        for (size_t p = 0; p < workers; ++p) {
+            if (!peers[p]) continue;
+            encoders[p]->sendTo(*peers[p], FrameType::DATA, static_cast<uint32_t>(index));
+            peers[p]->send(FrameType::END, static_cast<uint32_t>(index), {});
+            stats.shuffle_bytes_raw += encoders[p]->rawBytesSent();
+            stats.shuffle_bytes += encoders[p]->bytesSent();
+        }
+        exchange->end(index);
+        stats.scan_ms = millisSince(phase);
+
+        phase = std::chrono::steady_clock::now();
+        std::vector<std::vector<RecordBatch>> received = exchange->wait();
+        releaseExchange(jobId);
+        stats.wait_ms = millisSince(phase);
+
+        // Reduce side, in source order so results do not depend on arrival order
+        phase = std::chrono::steady_clock::now();
+        FrameEncoder results(codec);
+        auto emit = [&](const RecordBatch& batch) {
+            stats.rows_out += batch.numRows();
+            results.add(batch);
+            if (results.bufferedBytes() >= frameBytes) {
+                results.sendTo(coordinator, FrameType::RESULT, static_cast<uint32_t>(index));
+            }
+        };
+        if (aggregate) {
+            GroupTable merged(keyFields, specs);
+            for (size_t source = 0; source < workers; ++source) {
+                for (const auto& batch : received[source]) {
+                    if (source != index) stats.rows_received += batch.numRows();
+                    merged.addPartials(batch);
+                }
+                received[source].clear();
+            }
+            RecordBatch output = merged.results();
+            for (size_t offset = 0; offset < output.numRows(); offset += batchRows) {
+                emit(output.slice(offset, batchRows));
+            }
+        } else {
+            Deduplicator merged(keyFields);
+            for (size_t source = 0; source < workers; ++source) {
+                for (const auto& batch : received[source]) {
+                    if (source != index) stats.rows_received += batch.numRows();
+                    std::vector<size_t> keep = merged.firstOccurrences(batch);
+                    emit(keep.size() == batch.numRows() ? batch : batch.take(keep));
+                }
+                received[source].clear();
+            }
+        }
+        results.sendTo(coordinator, FrameType::RESULT, static_cast<uint32_t>(index));
+        stats.merge_ms = millisSince(phase);
+
+        coordinator.send(FrameType::DONE, static_cast<uint32_t>(index), statsToJson(stats).dump());
+    } catch (const std::exception& e) {
+        if (!jobId.empty()) releaseExchange(jobId);
+        try {
+            coordinator.send(FrameType::ERROR, 0, e.what());
+        } catch (const std::exception&) {
+            // The coordinator is gone as well
+        }
+    }
+}
+
+Coordinator::Coordinator(std::vector<WorkerAddress> workers) : workers_(std::move(workers)), jobs_run_(0) {
+}
+
+std::vector<WorkerStats> Coordinator::run(const ClusterJob& job,
+                                          const std::function<void(const RecordBatch&)>& onResult) {
+    if (workers_.empty()) {
+        throw std::runtime_error("A cluster job needs at least one worker");
+    }
+    if (job.kind == JobKind::AGGREGATE) {
+        etl::parseAggregateSpecs(job.aggregations);    // Throws for an unknown function
+    }
+    std::string codec = isCodecAvailable(job.codec) ? job.codec : "zlib";
+
+    // Job ids only need to be unique among jobs running at the same time
+    std::string jobId = std::to_string(getpid()) + "-" +
+        std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + "-" +
+        std::to_string(jobs_run_++);
+    nlohmann::json addresses = nlohmann::json::array();
+    for (const auto& worker : workers_) {
+        addresses.push_back({{"host", worker.host}, {"port", worker.port}});
+    }
+
+    // Whole files go to workers round-robin
+    size_t workers = workers_.size();
+    std::vector<nlohmann::json> inputs(workers, nlohmann::json::array());
+    for (size_t i = 0; i < job.inputs.size(); ++i) {
+        inputs[i % workers].push_back(job.inputs[i]);
+    }
+
+    std::vector<std::unique_ptr<Connection>> connections;
+    for (size_t w = 0; w < workers; ++w) {
+        nlohmann::json description = {
+            {"id", jobId}, {"index", w}, {"workers", addresses},
+            {"kind", job.kind == JobKind::AGGREGATE ? "aggregate" : "deduplicate"},
+            {"key_fields", job.key_fields}, {"aggregations", job.aggregations},
+            {"inputs", inputs[w]}, {"codec", codec},
+            {"batch_rows", job.batch_rows}, {"frame_bytes", job.frame_bytes}
+        };
+        connections.push_back(Connection::connect(workers_[w].host, workers_[w].port));
+        connections.back()->send(FrameType::JOB, 0, description.dump());
+    }
+
+    std::vector<WorkerStats> stats(workers);
+    std::vector<std::string> errors(workers);
+    std::mutex resultMutex;
+    std::vector<std::thread> readers;
+    for (size_t w = 0; w < workers; ++w) {
+        readers.emplace_back([&, w] {
+            try {
+                FrameHeader header;
+                std::string payload;
+                std::string scratch;
+                while (connections[w]->receive(header, payload)) {
+                    if (header.type == FrameType::RESULT) {
+                        RecordBatch batch = decodeFrame(header, payload, scratch);
+                        std::lock_guard<std::mutex> lock(resultMutex);
+                        onResult(batch);
+                    } else if (header.type == FrameType::DONE) {
+                        stats[w] = statsFromJson(nlohmann::json::parse(payload));
+                        return;
+                    } else if (header.type == FrameType::ERROR) {
+                        errors[w] = payload;
+                        return;
+                    }
+                }
+                errors[w] = "connection closed before the job finished";
+            } catch (const std::exception& e) {
+                errors[w] = e.what();
+            }
+        });
+    }
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    // One failure usually fails the workers shuffling with it too, so
+    // report every worker's error rather than the first
+    std::string failures;
+    for (size_t w = 0; w < workers; ++w) {
+        if (!errors[w].empty()) {
+            failures += (failures.empty() ? "" : "; ") + std::string("worker ") + std::to_string(w) + " (" +
+                        workers_[w].host + ":" + std::to_string(workers_[w].port) + "): " + errors[w];
+        }
+    }
+    if (!failures.empty()) {
+        throw std::runtime_error("Cluster job failed: " + failures);
+    }
+    return stats;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+#include "shuffle.h"
+
+// What a job computes. Both kinds hash-partition records by key, so every
+// occurrence of a key meets on one worker.
+enum class JobKind {
+    AGGREGATE,      // GROUP BY key_fields, as DataTransformer::aggregateData
+    DEDUPLICATE     // First record per key_fields (the whole record if empty)
+};
+
+struct ClusterJob {
+    JobKind kind = JobKind::AGGREGATE;
+    std::vector<std::string> key_fields;
+    std::map<std::string, std::string> aggregations;    // field -> function, for AGGREGATE
+    std::vector<std::string> inputs;    // Files any RecordReader can open, read where the workers run
+    std::string codec = "lz4";          // Shuffle compression; zlib if lz4 was not compiled in
+    size_t batch_rows = 65536;          // Records read per batch
+    size_t frame_bytes = 1 << 20;       // Encoded bytes per DATA frame before it is sent
+};
+
+struct WorkerAddress {
+    std::string host;
+    uint16_t port;
+};
+
+// What one worker did for a job
+struct WorkerStats {
+    size_t files = 0;
+    size_t rows_scanned = 0;
+    size_t rows_shuffled = 0;       // Sent to other workers, after local pre-aggregation or dedup
+    size_t rows_received = 0;       // From other workers
+    size_t rows_out = 0;
+    size_t shuffle_bytes_raw = 0;   // Encoded records sent, before compression
+    size_t shuffle_bytes = 0;       // On the wire
+    double scan_ms = 0;             // Reading and the map side, including sends
+    double wait_ms = 0;             // Until every peer's data had arrived
+    double merge_ms = 0;            // Reduce side and sending results
+};
+
+// A worker process's server. Jobs arrive from a coordinator; shuffle data
+// arrives from the other workers of the same job. Each connection gets a
+// thread of its own. A connection's first frame says which it is: JOB from
+// a coordinator, HELLO from a peer.
+class Worker {
+public:
+    explicit Worker(uint16_t port);
+    // Serves on a listener made earlier, e.g. before fork()
+    explicit Worker(std::unique_ptr<Listener> listener);
+    ~Worker();
+
+    uint16_t port() const { return listener_->port(); }
+
+    // Accepts connections until stop()
+    void serve();
+    void stop();
+
+private:
+    struct Exchange;
+
+    void handleConnection(std::unique_ptr<Connection> connection);
+    void runJob(Connection& coordinator, const std::string& description);
+    void receiveShuffle(Connection& peer, const FrameHeader& hello, const std::string& payload);
+    std::shared_ptr<Exchange> exchange(const std::string& jobId, size_t workers);
+    void releaseExchange(const std::string& jobId);
+
+    std::unique_ptr<Listener> listener_;
+    std::atomic<bool> stopping_{false};
+    std::mutex mutex_;
+    std::map<std::string, std::shared_ptr<Exchange>> exchanges_;
+    // Jobs whose exchange was released, most recent last, so a peer's late
+    // HELLO cannot recreate an exchange that nothing would release
+    std::set<std::string> finished_jobs_;
+    std::deque<std::string> finished_order_;
+    size_t active_ = 0;                     // Connection threads still running
+    std::condition_variable idle_;
+};
+
+// Sends a job to every worker and gathers their results. Records are
+// handed to onResult one batch at a time, from one thread at a time,
+// in no particular order across workers.
+class Coordinator {
+public:
+    explicit Coordinator(std::vector<WorkerAddress> workers);
+
+    // Throws std::runtime_error if any worker fails
+    std::vector<WorkerStats> run(const ClusterJob& job, const std::function<void(const etl::RecordBatch&)>& onResult);
+
+private:
+    std::vector<WorkerAddress> workers_;
+    uint64_t jobs_run_;
+};
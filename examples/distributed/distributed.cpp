@@ -0,0 +1,284 @@
+#include "cluster.h"
+#include "processors/binary_records.h"
+#include "processors/record_stream.h"
+#include <sys/wait.h>
+#include <signal.h>
+#include <unistd.h>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace etl;
+
+std::vector<std::string> splitList(const std::string& text) {
+    std::vector<std::string> items;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+std::vector<WorkerAddress> parseWorkers(const std::string& text) {
+    std::vector<WorkerAddress> workers;
+    for (const auto& item : splitList(text)) {
+        size_t colon = item.rfind(':');
+        if (colon == std::string::npos) {
+            throw std::runtime_error("Expected host:port, got " + item);
+        }
+        workers.push_back({item.substr(0, colon), static_cast<uint16_t>(std::stoi(item.substr(colon + 1)))});
+    }
+    return workers;
+}
+
+// Worker processes on this machine, forked with their listeners already
+// bound so the coordinator can connect at once
+class LocalCluster {
+public:
+    explicit LocalCluster(size_t workers) {
+        for (size_t i = 0; i < workers; ++i) {
+            auto listener = std::make_unique<Listener>(0, "127.0.0.1");
+            addresses_.push_back({"127.0.0.1", listener->port()});
+            std::cout.flush();
+            pid_t pid = fork();
+            if (pid < 0) {
+                throw std::runtime_error("fork failed");
+            }
+            if (pid == 0) {
+                Worker(std::move(listener)).serve();
+                _exit(0);
+            }
+            pids_.push_back(pid);
+        }
+    }
+
+    ~LocalCluster() {
+        for (pid_t pid : pids_) kill(pid, SIGTERM);
+        for (pid_t pid : pids_) waitpid(pid, nullptr, 0);
+    }
+
+    const std::vector<WorkerAddress>& addresses() const { return addresses_; }
+
+private:
+    std::vector<WorkerAddress> addresses_;
+    std::vector<pid_t> pids_;
+};
+
+// Order records in binary record files. One in five orders is sent twice,
+// possibly in another file, as an at-least-once source would.
+size_t generateOrders(const std::string& directory, size_t files, size_t ordersPerFile, std::vector<std::string>& paths) {
+    static const char* const REGIONS[] = {"north", "south", "east", "west", "central", "coastal", "mountain", "island"};
+    std::filesystem::create_directories(directory);
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<int> customer(0, 99999);
+    std::uniform_int_distribution<int> region(0, 7);
+    std::uniform_real_distribution<double> amount(1.0, 500.0);
+    std::uniform_int_distribution<int> quantity(1, 10);
+    std::uniform_int_distribution<int> resend(0, 4);
+
+    std::vector<nlohmann::json> recent;
+    size_t orders = 0;
+    for (size_t f = 0; f < files; ++f) {
+        std::string path = directory + "/orders-" + std::to_string(f) + ".bin";
+        std::ofstream file(path, std::ios::binary);
+        std::string buffer;
+        BinaryRecordWriter writer(buffer, &file);
+
+        RecordBatch batch;
+        for (size_t i = 0; i < ordersPerFile; ++i) {
+            nlohmann::json order;
+            if (!recent.empty() && resend(rng) == 0) {
+                order = recent[rng() % recent.size()];
+            } else {
+                int id = customer(rng);
+                order = {
+                    {"order_id", static_cast<int64_t>(orders++)},
+                    {"customer", "customer-" + std::to_string(id)},
+                    {"region", REGIONS[region(rng)]},
+                    {"amount", std::round(amount(rng) * 100) / 100},
+                    {"quantity", quantity(rng)}
+                };
+                if (recent.size() < 4096) {
+                    recent.push_back(order);
+                } else {
+                    recent[rng() % recent.size()] = order;
+                }
+            }
+            batch.appendRecord(order);
+            if (batch.numRows() == 65536) {
+                writer.write(batch);
+                batch = RecordBatch();
+            }
+        }
+        writer.write(batch);
+        writer.flush();
+        paths.push_back(path);
+    }
+    return orders;
+}
+
+struct RunSummary {
+    size_t rows = 0;
+    double checksum = 0;
+    double seconds = 0;
+    WorkerStats totals;
+};
+
+RunSummary runJob(Coordinator& coordinator, const ClusterJob& job, const std::string& sumField) {
+    RunSummary summary;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<WorkerStats> stats = coordinator.run(job, [&](const RecordBatch& batch) {
+        summary.rows += batch.numRows();
+        if (const Column* column = batch.findColumn(sumField)) {
+            for (size_t row = 0; row < batch.numRows(); ++row) {
+                double value;
+                if (column->numberAt(row, value)) summary.checksum += value;
+            }
+        }
+    });
+    summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (const auto& worker : stats) {
+        summary.totals.rows_scanned += worker.rows_scanned;
+        summary.totals.rows_shuffled += worker.rows_shuffled;
+        summary.totals.shuffle_bytes_raw += worker.shuffle_bytes_raw;
+        summary.totals.shuffle_bytes += worker.shuffle_bytes;
+        summary.totals.scan_ms = std::max(summary.totals.scan_ms, worker.scan_ms);
+        summary.totals.wait_ms = std::max(summary.totals.wait_ms, worker.wait_ms);
+        summary.totals.merge_ms = std::max(summary.totals.merge_ms, worker.merge_ms);
+    }
+    return summary;
+}
+
+void printRun(const char* name, size_t workers, const RunSummary& run) {
+    const WorkerStats& totals = run.totals;
+    std::cout << std::fixed << std::setprecision(2)
+              << "  " << std::setw(8) << name << "  " << workers << " worker" << (workers == 1 ? " " : "s")
+              << std::setw(8) << run.seconds << " s  " << std::setw(8) << run.rows << " rows out  "
+              << std::setw(9) << totals.rows_shuffled << " shuffled  "
+              << std::setw(6) << totals.shuffle_bytes_raw / 1e6 << " MB -> "
+              << std::setw(6) << totals.shuffle_bytes / 1e6 << " MB on the wire"
+              << "  (scan " << std::setprecision(0) << totals.scan_ms << " ms, wait " << totals.wait_ms
+              << " ms, merge " << totals.merge_ms << " ms)" << std::endl;
+}
+
+// GROUP BY and dedup over the same files on clusters of 1, 2 and 4 local
+// workers; every cluster size must give the same answers
+void localDemo() {
+    std::cout << "=== Distributed GROUP BY and Dedup (local workers) ===" << std::endl;
+    std::vector<std::string> inputs;
+    size_t orders = generateOrders("distributed_data", 8, 250000, inputs);
+    std::cout << "8 files, 2000000 records, " << orders << " distinct orders" << std::endl;
+
+    ClusterJob groupBy;
+    groupBy.kind = JobKind::AGGREGATE;
+    groupBy.key_fields = {"region", "customer"};
+    groupBy.aggregations = {{"amount", "sum"}, {"quantity", "avg"}};
+    groupBy.inputs = inputs;
+
+    ClusterJob dedup;
+    dedup.kind = JobKind::DEDUPLICATE;
+    dedup.key_fields = {"order_id"};
+    dedup.inputs = inputs;
+
+    RunSummary firstGroups;
+    RunSummary firstDedup;
+    for (size_t workers : {1, 2, 4}) {
+        LocalCluster cluster(workers);
+        Coordinator coordinator(cluster.addresses());
+
+        RunSummary groups = runJob(coordinator, groupBy, "amount_sum");
+        RunSummary unique = runJob(coordinator, dedup, "amount");
+        printRun("GROUP BY", workers, groups);
+        printRun("dedup", workers, unique);
+
+        if (workers == 1) {
+            firstGroups = groups;
+            firstDedup = unique;
+        }
+        bool same = groups.rows == firstGroups.rows && std::abs(groups.checksum - firstGroups.checksum) < 1e-3 * firstGroups.checksum &&
+                    unique.rows == orders && std::abs(unique.checksum - firstDedup.checksum) < 1e-3 * firstDedup.checksum;
+        if (!same) {
+            std::cout << "  results differ from the single-worker run!" << std::endl;
+        }
+    }
+    std::filesystem::remove_all("distributed_data");
+}
+
+int usage() {
+    std::cerr << "Usage:\n"
+              << "  distributed                      run the local demo\n"
+              << "  distributed worker <port>\n"
+              << "  distributed aggregate <host:port,...> <group,by,fields> <field=function,...> <output.json> <input>...\n"
+              << "  distributed dedup <host:port,...> <key,fields|-> <output.json> <input>...\n";
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    // A worker whose coordinator or peer disappears gets an error, not a signal
+    signal(SIGPIPE, SIG_IGN);
+
+    try {
+        if (argc == 1) {
+            localDemo();
+            return 0;
+        }
+
+        std::string mode = argv[1];
+        if (mode == "worker" && argc == 3) {
+            Worker worker(static_cast<uint16_t>(std::stoi(argv[2])));
+            std::cout << "Worker listening on port " << worker.port() << std::endl;
+            worker.serve();
+            return 0;
+        }
+
+        ClusterJob job;
+        int firstInput;
+        std::string output;
+        if (mode == "aggregate" && argc >= 7) {
+            job.kind = JobKind::AGGREGATE;
+            job.key_fields = splitList(argv[3]);
+            for (const auto& item : splitList(argv[4])) {
+                size_t equals = item.find('=');
+                if (equals == std::string::npos) return usage();
+                job.aggregations[item.substr(0, equals)] = item.substr(equals + 1);
+            }
+            output = argv[5];
+            firstInput = 6;
+        } else if (mode == "dedup" && argc >= 6) {
+            job.kind = JobKind::DEDUPLICATE;
+            if (std::string(argv[3]) != "-") job.key_fields = splitList(argv[3]);
+            output = argv[4];
+            firstInput = 5;
+        } else {
+            return usage();
+        }
+        for (int i = firstInput; i < argc; ++i) {
+            job.inputs.push_back(argv[i]);
+        }
+
+        Coordinator coordinator(parseWorkers(argv[2]));
+        JsonLinesWriter writer(output);
+        std::vector<WorkerStats> stats = coordinator.run(job, [&](const RecordBatch& batch) { writer.write(batch); });
+        writer.close();
+
+        for (size_t w = 0; w < stats.size(); ++w) {
+            std::cout << "worker " << w << ": " << stats[w].files << " files, " << stats[w].rows_scanned
+                      << " rows scanned, " << stats[w].rows_shuffled << " shuffled, " << stats[w].rows_out
+                      << " out" << std::endl;
+        }
+        std::cout << writer.recordsWritten() << " records written to " << output << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
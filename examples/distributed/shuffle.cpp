@@ -0,0 +1,253 @@
+#include "shuffle.h"
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+constexpr uint32_t FRAME_MAGIC = 0x534c5445;     // "ETLS"
+constexpr uint64_t MAX_FRAME_SIZE = 1ULL << 31;
+
+[[noreturn]] void fail(const std::string& what) {
+    throw std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+void configureSocket(int fd) {
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    int buffer = 4 << 20;
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &buffer, sizeof(buffer));
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof(buffer));
+}
+
+// Reads exactly size bytes; false on a clean close before the first byte
+bool readFully(int fd, char* data, size_t size) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = ::recv(fd, data + done, size - done, 0);
+        if (n == 0) {
+            if (done == 0) return false;
+            throw std::runtime_error("Shuffle connection closed mid-frame");
+        }
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            fail("Shuffle receive failed");
+        }
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+Connection::Connection(int fd) : fd_(fd) {
+    configureSocket(fd_);
+}
+
+Connection::~Connection() {
+    ::close(fd_);
+}
+
+std::unique_ptr<Connection> Connection::connect(const std::string& host, uint16_t port,
+                                                std::chrono::milliseconds timeout) {
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    int status = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses);
+    if (status != 0) {
+        throw std::runtime_error("Cannot resolve " + host + ": " + gai_strerror(status));
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    auto delay = std::chrono::milliseconds(10);
+    while (true) {
+        int fd = ::socket(addresses->ai_family, addresses->ai_socktype, addresses->ai_protocol);
+        if (fd < 0) {
+            freeaddrinfo(addresses);
+            fail("Cannot create socket");
+        }
+        if (::connect(fd, addresses->ai_addr, addresses->ai_addrlen) == 0) {
+            freeaddrinfo(addresses);
+            return std::make_unique<Connection>(fd);
+        }
+        int error = errno;
+        ::close(fd);
+        if (std::chrono::steady_clock::now() >= deadline || (error != ECONNREFUSED && error != EINTR)) {
+            freeaddrinfo(addresses);
+            errno = error;
+            fail("Cannot connect to " + host + ":" + std::to_string(port));
+        }
+        std::this_thread::sleep_for(delay);
+        delay = std::min(delay * 2, std::chrono::milliseconds(500));
+    }
+}
+
+void Connection::send(FrameType type, uint32_t source, std::string_view payload,
+                      CodecType codec, uint64_t rawSize, uint32_t records) {
+    FrameHeader header{};
+    header.magic = FRAME_MAGIC;
+    header.type = type;
+    header.codec = codec;
+    header.source = source;
+    header.records = records;
+    header.raw_size = rawSize ? rawSize : payload.size();
+    header.size = payload.size();
+
+    iovec parts[2];
+    parts[0] = {&header, sizeof(header)};
+    parts[1] = {const_cast<char*>(payload.data()), payload.size()};
+    int count = payload.empty() ? 1 : 2;
+    size_t remaining = sizeof(header) + payload.size();
+
+    iovec* part = parts;
+    while (remaining > 0) {
+        msghdr message{};
+        message.msg_iov = part;
+        message.msg_iovlen = count;
+        ssize_t n = ::sendmsg(fd_, &message, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            fail("Shuffle send failed");
+        }
+        remaining -= static_cast<size_t>(n);
+        // Skip what went out, possibly part of a buffer
+        while (count > 0 && static_cast<size_t>(n) >= part->iov_len) {
+            n -= static_cast<ssize_t>(part->iov_len);
+            ++part;
+            --count;
+        }
+        if (count > 0) {
+            part->iov_base = static_cast<char*>(part->iov_base) + n;
+            part->iov_len -= static_cast<size_t>(n);
+        }
+    }
+}
+
+bool Connection::receive(FrameHeader& header, std::string& payload) {
+    if (!readFully(fd_, reinterpret_cast<char*>(&header), sizeof(header))) {
+        return false;
+    }
+    if (header.magic != FRAME_MAGIC) {
+        throw std::runtime_error("Not a shuffle frame");
+    }
+    if (header.size > MAX_FRAME_SIZE || header.raw_size > MAX_FRAME_SIZE) {
+        throw std::runtime_error("Shuffle frame too large: " + std::to_string(header.size) + " bytes");
+    }
+    payload.resize(header.size);
+    if (header.size > 0 && !readFully(fd_, &payload[0], payload.size())) {
+        throw std::runtime_error("Shuffle connection closed mid-frame");
+    }
+    return true;
+}
+
+Listener::Listener(uint16_t port, const std::string& address) : fd_(-1), port_(port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        fail("Cannot create socket");
+    }
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in bound{};
+    bound.sin_family = AF_INET;
+    bound.sin_port = htons(port);
+    if (inet_pton(AF_INET, address.c_str(), &bound.sin_addr) != 1) {
+        ::close(fd);
+        throw std::runtime_error("Invalid listen address: " + address);
+    }
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&bound), sizeof(bound)) != 0 || ::listen(fd, 128) != 0) {
+        int error = errno;
+        ::close(fd);
+        errno = error;
+        fail("Cannot listen on port " + std::to_string(port));
+    }
+
+    socklen_t length = sizeof(bound);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&bound), &length);
+    port_ = ntohs(bound.sin_port);
+    fd_ = fd;
+}
+
+Listener::~Listener() {
+    // Only closes this process's descriptor: shutdown() would also stop a
+    // forked copy of the listener
+    int fd = fd_.exchange(-1);
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+std::unique_ptr<Connection> Listener::accept() {
+    int listening;
+    while ((listening = fd_.load()) >= 0) {
+        int fd = ::accept(listening, nullptr, nullptr);
+        if (fd >= 0) {
+            return std::make_unique<Connection>(fd);
+        }
+        if (errno != EINTR && errno != ECONNABORTED) {
+            break;
+        }
+    }
+    return nullptr;
+}
+
+void Listener::close() {
+    int fd = fd_.exchange(-1);
+    if (fd >= 0) {
+        // Wakes a thread blocked in accept()
+        ::shutdown(fd, SHUT_RDWR);
+        ::close(fd);
+    }
+}
+
+FrameEncoder::FrameEncoder(const Codec& codec, int level)
+    : codec_(codec), level_(level < 0 ? codec.defaultLevel() : level) {
+}
+
+void FrameEncoder::add(const etl::RecordBatch& batch) {
+    if (batch.numRows() == 0) return;
+    if (!writer_) {
+        encoded_.clear();
+        writer_ = std::make_unique<etl::BinaryRecordWriter>(encoded_);
+    }
+    writer_->write(batch);
+    records_ += batch.numRows();
+}
+
+void FrameEncoder::sendTo(Connection& connection, FrameType type, uint32_t source) {
+    if (!writer_) return;
+
+    std::string_view payload = encoded_;
+    if (codec_.type() != CodecType::NONE) {
+        compressed_.resize(codec_.maxCompressedSize(encoded_.size()));
+        size_t size = codec_.compress(encoded_.data(), encoded_.size(), &compressed_[0], compressed_.size(), level_);
+        payload = std::string_view(compressed_.data(), size);
+    }
+    connection.send(type, source, payload, codec_.type(), encoded_.size(), static_cast<uint32_t>(records_));
+
+    raw_bytes_sent_ += encoded_.size();
+    bytes_sent_ += payload.size();
+    writer_.reset();
+    records_ = 0;
+}
+
+etl::RecordBatch decodeFrame(const FrameHeader& header, const std::string& payload, std::string& scratch) {
+    std::string_view encoded = payload;
+    if (header.codec != CodecType::NONE) {
+        scratch.resize(header.raw_size);
+        getCodec(header.codec).decompress(payload.data(), payload.size(), &scratch[0], scratch.size());
+        encoded = scratch;
+    }
+    etl::BinaryRecordReader reader(encoded);
+    return reader.readBatch(header.records);
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <atomic>
+#include <cstdint>
+#include "codec.h"
+#include "processors/record_batch.h"
+#include "processors/binary_records.h"
+
+// Kinds of frame exchanged between coordinator and workers
+enum class FrameType : uint8_t {
+    JOB = 1,        // Coordinator -> worker: job description (JSON)
+    HELLO = 2,      // Worker -> worker: first frame of a shuffle connection (JSON)
+    DATA = 3,       // Worker -> worker: shuffled records
+    END = 4,        // Worker -> worker: no more DATA from this source
+    RESULT = 5,     // Worker -> coordinator: final records
+    DONE = 6,       // Worker -> coordinator: job finished, with statistics (JSON)
+    ERROR = 7       // Either way: the job failed (message text)
+};
+
+// Fixed 32-byte header in front of every payload, in host byte order (all
+// supported hosts are little-endian). DATA and RESULT payloads are binary
+// records (processors/binary_records.h) compressed with codec.
+struct FrameHeader {
+    uint32_t magic;
+    FrameType type;
+    CodecType codec;
+    uint16_t reserved;
+    uint32_t source;            // Sending worker's index
+    uint32_t records;           // In DATA and RESULT frames
+    uint64_t raw_size;          // Payload size before compression
+    uint64_t size;              // Payload bytes that follow
+};
+
+static_assert(sizeof(FrameHeader) == 32, "FrameHeader is a wire format");
+
+// A TCP connection carrying frames. Every call blocks; failures throw
+// std::runtime_error.
+class Connection {
+public:
+    explicit Connection(int fd);
+    ~Connection();
+
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    // Retries refused connections until timeout, so workers may start in any order
+    static std::unique_ptr<Connection> connect(const std::string& host, uint16_t port,
+                                               std::chrono::milliseconds timeout = std::chrono::seconds(10));
+
+    // Header and payload go out in one writev, straight from the caller's buffer
+    void send(FrameType type, uint32_t source, std::string_view payload,
+              CodecType codec = CodecType::NONE, uint64_t rawSize = 0, uint32_t records = 0);
+    // Reads the next frame's payload into payload, reusing its capacity;
+    // false if the peer closed the connection between frames
+    bool receive(FrameHeader& header, std::string& payload);
+
+private:
+    int fd_;
+};
+
+class Listener {
+public:
+    // Port 0 picks a free port
+    explicit Listener(uint16_t port, const std::string& address = "0.0.0.0");
+    ~Listener();
+
+    Listener(const Listener&) = delete;
+    Listener& operator=(const Listener&) = delete;
+
+    uint16_t port() const { return port_; }
+    // Null once close() has been called, from any thread
+    std::unique_ptr<Connection> accept();
+    // Stops the listening socket, in forked copies as well
+    void close();
+
+private:
+    std::atomic<int> fd_;
+    uint16_t port_;
+};
+
+// Encodes records as binary records and compresses them, one DATA or
+// RESULT frame at a time. Frames are independent: each starts with its own
+// format header and schema.
+class FrameEncoder {
+public:
+    // A level of -1 is the codec's default
+    explicit FrameEncoder(const Codec& codec, int level = -1);
+
+    void add(const etl::RecordBatch& batch);
+    size_t records() const { return records_; }
+    size_t bufferedBytes() const { return encoded_.size(); }
+
+    // Sends what has been added, if anything, and starts a new frame
+    void sendTo(Connection& connection, FrameType type, uint32_t source);
+
+    size_t rawBytesSent() const { return raw_bytes_sent_; }
+    size_t bytesSent() const { return bytes_sent_; }
+
+private:
+    const Codec& codec_;
+    int level_;
+    std::string encoded_;
+    std::string compressed_;
+    std::unique_ptr<etl::BinaryRecordWriter> writer_;   // Appends to encoded_
+    size_t records_ = 0;
+    size_t raw_bytes_sent_ = 0;
+    size_t bytes_sent_ = 0;
+};
+
+// Decodes a DATA or RESULT frame's payload; scratch holds the decompressed
+// bytes and keeps its capacity from frame to frame
+etl::RecordBatch decodeFrame(const FrameHeader& header, const std::string& payload, std::string& scratch);
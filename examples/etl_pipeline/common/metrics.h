@@ -0,0 +1,300 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace etl {
+
+// Label names and values of one series, e.g. {{"stage", "filter"}}
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+// Updates go to one of this many cache-line-sized stripes, chosen per
+// thread, so threads updating the same metric do not share a cache line
+constexpr size_t METRIC_STRIPES = 16;
+
+inline size_t metricStripe() {
+    static std::atomic<size_t> next{0};
+    thread_local size_t stripe = next.fetch_add(1, std::memory_order_relaxed) % METRIC_STRIPES;
+    return stripe;
+}
+
+inline void atomicAdd(std::atomic<double>& target, double value) {
+    double current = target.load(std::memory_order_relaxed);
+    while (!target.compare_exchange_weak(current, current + value, std::memory_order_relaxed)) {
+    }
+}
+
+// Monotonic count, e.g. records processed
+class Counter {
+public:
+    void add(uint64_t amount = 1) {
+        stripes_[metricStripe()].value.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    uint64_t value() const {
+        uint64_t total = 0;
+        for (const auto& stripe : stripes_) {
+            total += stripe.value.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+private:
+    struct alignas(64) Stripe {
+        std::atomic<uint64_t> value{0};
+    };
+    std::array<Stripe, METRIC_STRIPES> stripes_;
+};
+
+// Value that goes up and down, e.g. records buffered
+class Gauge {
+public:
+    void set(double value) { value_.store(value, std::memory_order_relaxed); }
+    void add(double amount) { atomicAdd(value_, amount); }
+    double value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<double> value_{0};
+};
+
+// Distribution of observed values over fixed buckets, e.g. latencies.
+// With sampleEvery n, each stripe keeps every n-th observation only, and
+// counts it n times; a caller can ask sampleNext() first and skip the
+// measurement itself for the observations that would be dropped.
+class Histogram {
+public:
+    explicit Histogram(std::vector<double> bounds = latencyBounds(), unsigned sampleEvery = 1)
+        : bounds_(std::move(bounds)), sample_every_(sampleEvery ? sampleEvery : 1) {
+        for (auto& stripe : stripes_) {
+            stripe.counts = std::make_unique<std::atomic<uint64_t>[]>(bounds_.size() + 1);
+        }
+    }
+
+    // 10 us to about 84 s, doubling
+    static std::vector<double> latencyBounds() { return exponentialBounds(1e-5, 2, 24); }
+
+    static std::vector<double> exponentialBounds(double start, double factor, size_t count) {
+        std::vector<double> bounds;
+        for (double bound = start; bounds.size() < count; bound *= factor) {
+            bounds.push_back(bound);
+        }
+        return bounds;
+    }
+
+    const std::vector<double>& bounds() const { return bounds_; }
+    unsigned sampleEvery() const { return sample_every_; }
+
+    // True if the next observation on this thread's stripe is kept
+    bool sampleNext() {
+        if (sample_every_ == 1) return true;
+        return stripes_[metricStripe()].ticks.fetch_add(1, std::memory_order_relaxed) % sample_every_ == 0;
+    }
+
+    void observe(double value) {
+        if (sampleNext()) record(value);
+    }
+
+    // Counts value as sampleEvery observations; for a caller that has
+    // already had sampleNext() say yes
+    void record(double value) {
+        size_t bucket = 0;
+        while (bucket < bounds_.size() && value > bounds_[bucket]) {
+            bucket++;
+        }
+        Stripe& stripe = stripes_[metricStripe()];
+        stripe.counts[bucket].fetch_add(sample_every_, std::memory_order_relaxed);
+        stripe.count.fetch_add(sample_every_, std::memory_order_relaxed);
+        atomicAdd(stripe.sum, value * sample_every_);
+    }
+
+    struct Snapshot {
+        std::vector<uint64_t> counts;   // Per bucket, the last one above every bound
+        uint64_t count = 0;
+        double sum = 0;
+    };
+
+    Snapshot snapshot() const {
+        Snapshot snapshot;
+        snapshot.counts.assign(bounds_.size() + 1, 0);
+        for (const auto& stripe : stripes_) {
+            for (size_t b = 0; b <= bounds_.size(); ++b) {
+                snapshot.counts[b] += stripe.counts[b].load(std::memory_order_relaxed);
+            }
+            snapshot.count += stripe.count.load(std::memory_order_relaxed);
+            snapshot.sum += stripe.sum.load(std::memory_order_relaxed);
+        }
+        return snapshot;
+    }
+
+private:
+    struct alignas(64) Stripe {
+        std::unique_ptr<std::atomic<uint64_t>[]> counts;
+        std::atomic<uint64_t> count{0};
+        std::atomic<double> sum{0};
+        std::atomic<uint64_t> ticks{0};
+    };
+
+    std::vector<double> bounds_;
+    unsigned sample_every_;
+    std::array<Stripe, METRIC_STRIPES> stripes_;
+};
+
+// Records the seconds from construction to destruction into a histogram,
+// reading the clock only for observations the histogram keeps
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Histogram* histogram)
+        : histogram_(histogram && histogram->sampleNext() ? histogram : nullptr) {
+        if (histogram_) start_ = std::chrono::steady_clock::now();
+    }
+
+    ~ScopedTimer() {
+        if (histogram_) {
+            histogram_->record(std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count());
+        }
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Histogram* histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+// Named metrics, exported in the Prometheus text format. Looking a metric
+// up takes a lock, so hot paths look theirs up once and keep the
+// reference; metrics live as long as the registry. Updating one is a
+// relaxed atomic add on the calling thread's stripe.
+class MetricsRegistry {
+public:
+    // The registry every ETL component records into
+    static MetricsRegistry& global() {
+        static MetricsRegistry registry;
+        return registry;
+    }
+
+    // Each returns the series for name and labels, creating it on first use;
+    // throws std::runtime_error if name is already a metric of another type
+    Counter& counter(const std::string& name, const std::string& help, const MetricLabels& labels = {}) {
+        return series<Counter>(name, help, Family::COUNTER, labels, [] { return std::make_unique<Counter>(); });
+    }
+
+    Gauge& gauge(const std::string& name, const std::string& help, const MetricLabels& labels = {}) {
+        return series<Gauge>(name, help, Family::GAUGE, labels, [] { return std::make_unique<Gauge>(); });
+    }
+
+    // Bounds and sampling apply when the series is created
+    Histogram& histogram(const std::string& name, const std::string& help, const MetricLabels& labels = {},
+                         const std::vector<double>& bounds = Histogram::latencyBounds(), unsigned sampleEvery = 1) {
+        return series<Histogram>(name, help, Family::HISTOGRAM, labels,
+                                 [&] { return std::make_unique<Histogram>(bounds, sampleEvery); });
+    }
+
+    std::string exportPrometheus() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::ostringstream out;
+        out << std::setprecision(10);
+        for (const auto& entry : families_) {
+            const std::string& name = entry.first;
+            const Family& family = entry.second;
+            static const char* const TYPES[] = {"counter", "gauge", "histogram"};
+            out << "# HELP " << name << " " << family.help << "\n";
+            out << "# TYPE " << name << " " << TYPES[family.type] << "\n";
+
+            for (const auto& series : family.series) {
+                const std::string& labels = series.first;
+                if (family.type == Family::COUNTER) {
+                    out << name << braces(labels) << " " << static_cast<Counter*>(series.second.get())->value() << "\n";
+                } else if (family.type == Family::GAUGE) {
+                    out << name << braces(labels) << " " << static_cast<Gauge*>(series.second.get())->value() << "\n";
+                } else {
+                    const auto* histogram = static_cast<Histogram*>(series.second.get());
+                    Histogram::Snapshot snapshot = histogram->snapshot();
+                    std::string prefix = labels.empty() ? "" : labels + ",";
+                    uint64_t cumulative = 0;
+                    for (size_t b = 0; b < snapshot.counts.size(); ++b) {
+                        cumulative += snapshot.counts[b];
+                        out << name << "_bucket{" << prefix << "le=\"";
+                        if (b < histogram->bounds().size()) {
+                            out << histogram->bounds()[b];
+                        } else {
+                            out << "+Inf";
+                        }
+                        out << "\"} " << cumulative << "\n";
+                    }
+                    out << name << "_sum" << braces(labels) << " " << snapshot.sum << "\n";
+                    out << name << "_count" << braces(labels) << " " << snapshot.count << "\n";
+                }
+            }
+        }
+        return out.str();
+    }
+
+private:
+    struct Family {
+        enum Type { COUNTER, GAUGE, HISTOGRAM };
+        Type type;
+        std::string help;
+        // Rendered label set -> metric; shared_ptr<void> keeps the right deleter
+        std::map<std::string, std::shared_ptr<void>> series;
+    };
+
+    template <typename T, typename Make>
+    T& series(const std::string& name, const std::string& help, typename Family::Type type,
+              const MetricLabels& labels, Make make) {
+        std::string rendered = renderLabels(labels);
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = families_.find(name);
+        if (found == families_.end()) {
+            found = families_.emplace(name, Family{type, help, {}}).first;
+        } else if (found->second.type != type) {
+            throw std::runtime_error("Metric " + name + " already exists with another type");
+        }
+        auto& metric = found->second.series[rendered];
+        if (!metric) {
+            metric = std::shared_ptr<T>(make());
+        }
+        return *static_cast<T*>(metric.get());
+    }
+
+    static std::string renderLabels(const MetricLabels& labels) {
+        std::string rendered;
+        for (const auto& label : labels) {
+            if (!rendered.empty()) rendered += ',';
+            rendered += label.first + "=\"";
+            for (char c : label.second) {
+                if (c == '\\' || c == '"') {
+                    rendered += '\\';
+                    rendered += c;
+                } else if (c == '\n') {
+                    rendered += "\\n";
+                } else {
+                    rendered += c;
+                }
+            }
+            rendered += '"';
+        }
+        return rendered;
+    }
+
+    static std::string braces(const std::string& labels) {
+        return labels.empty() ? "" : "{" + labels + "}";
+    }
+
+    mutable std::mutex mutex_;
+    std::map<std::string, Family> families_;
+};
+
+} // namespace etl
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cstddef>
+#include <utility>
+
+namespace etl {
+
+// Waiting strategy for the rings' blocking calls: spin briefly, then yield,
+// then sleep in short naps so an idle stage costs next to no CPU.
+class Backoff {
+public:
+    void pause() {
+        if (spins_ < 64) {
+            spins_++;
+        } else if (spins_ < 128) {
+            spins_++;
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+
+    void reset() { spins_ = 0; }
+
+private:
+    unsigned spins_ = 0;
+};
+
+inline size_t ringCapacity(size_t capacity) {
+    size_t power = 2;
+    while (power < capacity) power <<= 1;
+    return power;
+}
+
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread. Each side caches the other's index, so it touches the shared
+// cache line only when its cached view says the ring is full or empty.
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity) : slots_(ringCapacity(capacity)), mask_(slots_.size() - 1) {}
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    size_t capacity() const { return slots_.size(); }
+
+    // Producer only
+    bool tryPush(T& value) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ == slots_.size()) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ == slots_.size()) return false;
+        }
+        slots_[tail & mask_] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    void push(T value) {
+        Backoff backoff;
+        while (!tryPush(value)) backoff.pause();
+    }
+
+    // Consumer only
+    bool tryPop(T& value) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cached_tail_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_) return false;
+        }
+        value = std::move(slots_[head & mask_]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    T pop() {
+        T value;
+        Backoff backoff;
+        while (!tryPop(value)) backoff.pause();
+        return value;
+    }
+
+private:
+    std::vector<T> slots_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> head_{0};
+    size_t cached_tail_ = 0;                    // Consumer's view of tail_
+    alignas(64) std::atomic<size_t> tail_{0};
+    size_t cached_head_ = 0;                    // Producer's view of head_
+};
+
+// Bounded lock-free queue for any number of producers and consumers
+// (Vyukov's design). Every slot carries a sequence number saying whose
+// turn it is, so a push or pop is one compare-and-swap on the shared index
+// plus a handoff through the slot, and neither side ever waits on a lock.
+template <typename T>
+class MpmcRing {
+public:
+    explicit MpmcRing(size_t capacity) : slots_(ringCapacity(capacity)), mask_(slots_.size() - 1) {
+        for (size_t i = 0; i < slots_.size(); ++i) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpmcRing(const MpmcRing&) = delete;
+    MpmcRing& operator=(const MpmcRing&) = delete;
+
+    size_t capacity() const { return slots_.size(); }
+
+    bool tryPush(T& value) {
+        size_t position = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots_[position & mask_];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(sequence - position);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    slot.value = std::move(value);
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;                   // Full
+            } else {
+                position = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void push(T value) {
+        Backoff backoff;
+        while (!tryPush(value)) backoff.pause();
+    }
+
+    bool tryPop(T& value) {
+        size_t position = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots_[position & mask_];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(sequence - (position + 1));
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    value = std::move(slot.value);
+                    slot.sequence.store(position + slots_.size(), std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;                   // Empty
+            } else {
+                position = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    T pop() {
+        T value;
+        Backoff backoff;
+        while (!tryPop(value)) backoff.pause();
+        return value;
+    }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::vector<Slot> slots_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+};
+
+} // namespace etl
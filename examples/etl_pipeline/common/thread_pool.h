@@ -0,0 +1,113 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <exception>
+
+namespace etl {
+
+// Fixed set of worker threads fed from one FIFO queue. Tasks must not wait on
+// other tasks of the same pool, or the pool can run out of workers.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t numThreads) {
+        if (numThreads == 0) numThreads = 1;
+        for (size_t i = 0; i < numThreads; ++i) {
+            workers_.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        available_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers_.size(); }
+
+    template <typename F>
+    auto submit(F fn) -> std::future<decltype(fn())> {
+        auto task = std::make_shared<std::packaged_task<decltype(fn())()>>(std::move(fn));
+        auto result = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.emplace([task] { (*task)(); });
+        }
+        available_.notify_one();
+        return result;
+    }
+
+    // Runs fn(0) .. fn(count - 1) on the pool and waits for all of them; the
+    // first exception thrown is rethrown once every call has finished
+    template <typename F>
+    void forEach(size_t count, F fn) {
+        std::vector<std::future<void>> pending;
+        pending.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            pending.push_back(submit([&fn, i] { fn(i); }));
+        }
+
+        std::exception_ptr error;
+        for (auto& future : pending) {
+            try {
+                future.get();
+            } catch (...) {
+                if (!error) error = std::current_exception();
+            }
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+private:
+    void workerLoop() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                available_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+                if (tasks_.empty()) {
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable available_;
+    bool stopping_ = false;
+};
+
+// Runs fn(0) .. fn(count - 1) on pool, or inline when pool is null
+template <typename F>
+void forEachIndex(ThreadPool* pool, size_t count, F fn) {
+    if (pool && count > 1) {
+        pool->forEach(count, fn);
+    } else {
+        for (size_t i = 0; i < count; ++i) {
+            fn(i);
+        }
+    }
+}
+
+} // namespace etl
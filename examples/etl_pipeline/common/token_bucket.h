@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <algorithm>
+
+namespace etl {
+
+// Rate limiter that never blocks: tokens accrue at rate per second, up to
+// burst of them banked. Callers that find no token ask how long until the
+// next one and wait for it in their own event loop. A rate of 0 or less
+// means unlimited. Not thread-safe.
+class TokenBucket {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit TokenBucket(double ratePerSecond = 0, double burst = 1) {
+        setRate(ratePerSecond, burst);
+    }
+
+    void setRate(double ratePerSecond, double burst = 1) {
+        rate_ = ratePerSecond;
+        burst_ = std::max(burst, 1.0);
+        tokens_ = burst_;
+        last_ = Clock::now();
+    }
+
+    bool unlimited() const { return rate_ <= 0; }
+
+    // Takes a token if one is available
+    bool tryAcquire(Clock::time_point now = Clock::now()) {
+        if (unlimited()) return true;
+        refill(now);
+        if (tokens_ < 1) return false;
+        tokens_ -= 1;
+        return true;
+    }
+
+    // Zero when tryAcquire would succeed now
+    Clock::duration timeUntilAvailable(Clock::time_point now = Clock::now()) {
+        if (unlimited()) return Clock::duration::zero();
+        refill(now);
+        if (tokens_ >= 1) return Clock::duration::zero();
+        return std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>((1 - tokens_) / rate_));
+    }
+
+private:
+    void refill(Clock::time_point now) {
+        if (now <= last_) return;
+        tokens_ = std::min(burst_, tokens_ + std::chrono::duration<double>(now - last_).count() * rate_);
+        last_ = now;
+    }
+
+    double rate_ = 0;
+    double burst_ = 1;
+    double tokens_ = 1;
+    Clock::time_point last_;
+};
+
+} // namespace etl
@@ -0,0 +1,197 @@
+#include "async_file_sink.h"
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+
+namespace etl {
+
+AsyncFileSink::AsyncFileSink(const std::string& path, const AsyncFileSinkOptions& options)
+    : path_(path), options_(options), writing_(false), stopping_(false),
+      bytes_accepted_(0), bytes_written_(0) {
+    options_.buffer_bytes = std::max<size_t>(options_.buffer_bytes, 1);
+    if (options_.codec && options_.compression_level < 0) {
+        options_.compression_level = options_.codec->defaultLevel();
+    }
+
+    output_ = options_.append ? FileOutput::openAppend(path)
+                              : FileOutput::open(path, options_.backend, options_.buffer_bytes);
+    backend_ = output_->backend();
+    current_.data = allocateAligned(options_.buffer_bytes);
+    if (options_.max_pending_buffers > 0) {
+        thread_ = std::thread(&AsyncFileSink::run, this);
+    }
+}
+
+AsyncFileSink::~AsyncFileSink() {
+    try {
+        close();
+    } catch (...) {
+        // Errors surface only through an explicit close()
+    }
+}
+
+void AsyncFileSink::write(std::string_view data) {
+    if (!output_) {
+        throw std::runtime_error("Write to closed file " + path_);
+    }
+    bytes_accepted_ += data.size();
+    if (!thread_.joinable() && !options_.codec && current_.size == 0 && data.size() >= options_.buffer_bytes) {
+        // Written inline anyway, so whole buffers need not be copied first
+        size_t n = data.size() / options_.buffer_bytes * options_.buffer_bytes;
+        throwIfFailed();
+        try {
+            output_->append(data.data(), n);
+        } catch (const std::exception& e) {
+            error_ = e.what();
+            throw;
+        }
+        bytes_written_ = output_->bytesWritten();
+        data.remove_prefix(n);
+    }
+    while (!data.empty()) {
+        size_t n = std::min(data.size(), options_.buffer_bytes - current_.size);
+        std::memcpy(current_.data.get() + current_.size, data.data(), n);
+        current_.size += n;
+        data.remove_prefix(n);
+        if (current_.size == options_.buffer_bytes) {
+            submit();
+        }
+    }
+}
+
+void AsyncFileSink::flush() {
+    if (!output_) {
+        return;
+    }
+    if (current_.size > 0) {
+        submit();
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    buffer_done_.wait(lock, [this] { return queue_.empty() && !writing_; });
+    throwIfFailed();
+}
+
+void AsyncFileSink::close() {
+    if (!output_) {
+        return;
+    }
+
+    std::string error;
+    try {
+        if (options_.codec && bytes_accepted_ == 0) {
+            submit();                   // An empty frame keeps an empty file decodable
+        }
+        flush();
+    } catch (const std::exception& e) {
+        error = e.what();
+    }
+    if (thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        work_ready_.notify_one();
+        thread_.join();
+    }
+
+    std::unique_ptr<FileOutput> output = std::move(output_);
+    try {
+        output->close();
+    } catch (const std::exception& e) {
+        if (error.empty()) error = e.what();
+    }
+    bytes_written_ = output->bytesWritten();
+    if (!error.empty()) {
+        throw std::runtime_error(error);
+    }
+}
+
+AsyncFileSink::Buffer AsyncFileSink::takeBuffer(std::unique_lock<std::mutex>& lock) {
+    // Back-pressure: the caller waits while the I/O thread is behind
+    buffer_done_.wait(lock, [this] { return queue_.size() < options_.max_pending_buffers || !error_.empty(); });
+    throwIfFailed();
+
+    Buffer buffer;
+    if (!free_.empty()) {
+        buffer = std::move(free_.back());
+        free_.pop_back();
+    } else {
+        buffer.data = allocateAligned(options_.buffer_bytes);
+    }
+    buffer.size = 0;
+    return buffer;
+}
+
+void AsyncFileSink::submit() {
+    if (!thread_.joinable()) {
+        throwIfFailed();
+        try {
+            writeBuffer(current_);
+        } catch (const std::exception& e) {
+            error_ = e.what();
+            throw;
+        }
+        current_.size = 0;
+        return;
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        Buffer next = takeBuffer(lock);
+        queue_.push_back(std::move(current_));
+        current_ = std::move(next);
+    }
+    work_ready_.notify_one();
+}
+
+void AsyncFileSink::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        work_ready_.wait(lock, [this] { return !queue_.empty() || stopping_; });
+        if (queue_.empty()) {
+            return;
+        }
+        Buffer buffer = std::move(queue_.front());
+        queue_.pop_front();
+        writing_ = true;
+        bool failed = !error_.empty();
+        lock.unlock();
+
+        std::string error;
+        if (!failed) {
+            try {
+                writeBuffer(buffer);
+            } catch (const std::exception& e) {
+                error = e.what();
+            }
+        }
+
+        lock.lock();
+        if (!error.empty() && error_.empty()) {
+            error_ = error;
+        }
+        buffer.size = 0;
+        free_.push_back(std::move(buffer));
+        writing_ = false;
+        buffer_done_.notify_all();
+    }
+}
+
+void AsyncFileSink::writeBuffer(const Buffer& buffer) {
+    if (options_.codec) {
+        compressed_.resize(options_.codec->maxCompressedSize(buffer.size));
+        size_t n = options_.codec->compress(buffer.data.get(), buffer.size, &compressed_[0],
+                                            compressed_.size(), options_.compression_level);
+        output_->append(compressed_.data(), n);
+    } else {
+        output_->append(buffer.data.get(), buffer.size);
+    }
+    bytes_written_ = output_->bytesWritten();
+}
+
+void AsyncFileSink::throwIfFailed() {
+    if (!error_.empty()) {
+        throw std::runtime_error(error_);
+    }
+}
+
+} // namespace etl
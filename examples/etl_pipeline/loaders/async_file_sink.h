@@ -0,0 +1,94 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include "codec.h"
+#include "file_output.h"
+
+namespace etl {
+
+struct AsyncFileSinkOptions {
+    size_t buffer_bytes = 4 << 20;              // Data is handed to the I/O thread in buffers of this size
+    size_t max_pending_buffers = 2;             // Full buffers queued before write() blocks;
+                                                // 0 writes them on the caller's thread
+    const Codec* codec = nullptr;               // Compresses each buffer as one frame; null writes it as-is
+    int compression_level = -1;                 // Negative: the codec's default
+    FileWriteBackend backend = FileWriteBackend::BUFFERED;
+    bool append = false;                        // Continue an existing file, BUFFERED, instead
+                                                // of creating or truncating it
+};
+
+// Appends data to a file from a background thread. write() copies into the
+// current buffer; a full buffer is queued for the I/O thread, which
+// compresses it if a codec is set and writes it, while the caller fills the
+// next one. When max_pending_buffers are queued, write() waits for the I/O
+// thread to catch up. Compressed output is a series of complete frames,
+// which gunzip, `zstd -d`, `lz4 -d` and Codec::decompress read as one stream.
+//
+// The file is written with options.backend; O_DIRECT and io_uring keep the
+// output out of the page cache.
+//
+// A failed write or compression is reported by the next write(), flush() or
+// close() as std::runtime_error; later data is then discarded.
+class AsyncFileSink {
+public:
+    // Creates or truncates path, or appends to it with options.append;
+    // throws std::runtime_error if it cannot
+    explicit AsyncFileSink(const std::string& path, const AsyncFileSinkOptions& options = {});
+    ~AsyncFileSink();
+
+    AsyncFileSink(const AsyncFileSink&) = delete;
+    AsyncFileSink& operator=(const AsyncFileSink&) = delete;
+
+    void write(std::string_view data);
+    // Returns once everything written so far is in the file
+    void flush();
+    // Flushes, stops the I/O thread and closes the file. Called by the
+    // destructor if needed, ignoring errors.
+    void close();
+
+    size_t bytesAccepted() const { return bytes_accepted_; }
+    size_t bytesWritten() const { return bytes_written_; }    // In the file, after compression
+    FileWriteBackend backend() const { return backend_; }     // In effect, after any fallback
+
+private:
+    struct Buffer {
+        AlignedBuffer data;
+        size_t size = 0;
+    };
+
+    Buffer takeBuffer(std::unique_lock<std::mutex>& lock);
+    void submit();
+    void run();
+    void writeBuffer(const Buffer& buffer);
+    void throwIfFailed();
+
+    std::unique_ptr<FileOutput> output_;        // Null once closed
+    FileWriteBackend backend_;
+    std::string path_;
+    AsyncFileSinkOptions options_;
+
+    std::mutex mutex_;
+    std::condition_variable work_ready_;        // Queue gained a buffer, or closing
+    std::condition_variable buffer_done_;       // I/O thread finished a buffer
+    std::deque<Buffer> queue_;
+    std::vector<Buffer> free_;
+    bool writing_;                              // I/O thread holds a buffer
+    bool stopping_;
+    std::string error_;
+
+    Buffer current_;                            // Owned by the caller's thread
+    std::string compressed_;                    // Owned by the I/O thread, if any
+    size_t bytes_accepted_;
+    std::atomic<size_t> bytes_written_;
+    std::thread thread_;
+};
+
+} // namespace etl
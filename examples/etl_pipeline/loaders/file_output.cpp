@@ -0,0 +1,495 @@
+#include "file_output.h"
+#include <stdexcept>
+#include <algorithm>
+#include <vector>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>) && defined(__NR_io_uring_setup)
+#include <linux/io_uring.h>
+#define ETL_IO_URING 1
+#endif
+
+namespace etl {
+
+namespace {
+
+size_t roundUp(size_t size) {
+    return (size + FILE_BLOCK_ALIGNMENT - 1) / FILE_BLOCK_ALIGNMENT * FILE_BLOCK_ALIGNMENT;
+}
+
+std::runtime_error ioError(const std::string& what, const std::string& path, int err) {
+    return std::runtime_error(what + " " + path + ": " + std::strerror(err));
+}
+
+class BufferedOutput : public FileOutput {
+public:
+    BufferedOutput(int fd, const std::string& path) : fd_(fd), path_(path) {}
+
+    ~BufferedOutput() override {
+        try {
+            close();
+        } catch (...) {
+            // Errors surface only through an explicit close()
+        }
+    }
+
+    void append(const char* data, size_t size) override {
+        while (size > 0) {
+            ssize_t n = ::write(fd_, data, size);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw ioError("Error writing", path_, errno);
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+            bytes_written_ += static_cast<size_t>(n);
+        }
+    }
+
+    void close() override {
+        if (fd_ < 0) {
+            return;
+        }
+        int result = ::close(fd_);
+        fd_ = -1;
+        if (result != 0) {
+            throw ioError("Error closing", path_, errno);
+        }
+    }
+
+    FileWriteBackend backend() const override { return FileWriteBackend::BUFFERED; }
+
+private:
+    int fd_;
+    std::string path_;
+};
+
+// Block-at-a-time O_DIRECT writes with pwrite(2)
+class DirectOutput : public FileOutput {
+public:
+    DirectOutput(int fd, const std::string& path, size_t blockBytes)
+        : fd_(fd), path_(path), block_bytes_(blockBytes), block_(allocateAligned(blockBytes)),
+          staged_(0), offset_(0) {}
+
+    ~DirectOutput() override {
+        try {
+            close();
+        } catch (...) {
+            // Errors surface only through an explicit close()
+        }
+    }
+
+    void append(const char* data, size_t size) override {
+        while (size > 0) {
+            // Aligned whole blocks go straight from the caller's memory
+            if (staged_ == 0 && size >= FILE_BLOCK_ALIGNMENT &&
+                reinterpret_cast<uintptr_t>(data) % FILE_BLOCK_ALIGNMENT == 0) {
+                size_t n = size / FILE_BLOCK_ALIGNMENT * FILE_BLOCK_ALIGNMENT;
+                writeAt(data, n);
+                data += n;
+                size -= n;
+                continue;
+            }
+            size_t n = std::min(size, block_bytes_ - staged_);
+            std::memcpy(block_.get() + staged_, data, n);
+            staged_ += n;
+            data += n;
+            size -= n;
+            if (staged_ == block_bytes_) {
+                writeAt(block_.get(), block_bytes_);
+                staged_ = 0;
+            }
+        }
+    }
+
+    void close() override {
+        if (fd_ < 0) {
+            return;
+        }
+        std::string error;
+        try {
+            if (staged_ > 0) {
+                // Padded to a whole block, then cut back to the real length
+                size_t length = offset_ + staged_;
+                size_t padded = roundUp(staged_);
+                std::memset(block_.get() + staged_, 0, padded - staged_);
+                writeAt(block_.get(), padded);
+                bytes_written_ -= padded - staged_;
+                staged_ = 0;
+                if (ftruncate(fd_, static_cast<off_t>(length)) != 0) {
+                    throw ioError("Error truncating", path_, errno);
+                }
+            }
+        } catch (const std::exception& e) {
+            error = e.what();
+        }
+        int result = ::close(fd_);
+        fd_ = -1;
+        if (!error.empty()) {
+            throw std::runtime_error(error);
+        }
+        if (result != 0) {
+            throw ioError("Error closing", path_, errno);
+        }
+    }
+
+    FileWriteBackend backend() const override { return FileWriteBackend::DIRECT; }
+
+private:
+    void writeAt(const char* data, size_t size) {
+        while (size > 0) {
+            ssize_t n = ::pwrite(fd_, data, size, static_cast<off_t>(offset_));
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw ioError("Error writing", path_, errno);
+            }
+            if (n == 0 || n % FILE_BLOCK_ALIGNMENT != 0) {
+                throw std::runtime_error("Short direct write to " + path_);
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+            offset_ += static_cast<size_t>(n);
+            bytes_written_ += static_cast<size_t>(n);
+        }
+    }
+
+    int fd_;
+    std::string path_;
+    size_t block_bytes_;
+    AlignedBuffer block_;
+    size_t staged_;                             // Bytes gathered in block_
+    size_t offset_;                             // File offset of the next write
+};
+
+#ifdef ETL_IO_URING
+
+// Minimal io_uring access through the raw system calls
+class Ring {
+public:
+    Ring() = default;
+    ~Ring() {
+        if (sqes_) munmap(sqes_, sqes_length_);
+        if (cq_ring_ && cq_ring_ != sq_ring_) munmap(cq_ring_, cq_length_);
+        if (sq_ring_) munmap(sq_ring_, sq_length_);
+        if (fd_ >= 0) ::close(fd_);
+    }
+
+    Ring(const Ring&) = delete;
+    Ring& operator=(const Ring&) = delete;
+
+    // False if the kernel does not offer io_uring to this process
+    bool init(unsigned entries) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        fd_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (fd_ < 0) {
+            return false;
+        }
+
+        sq_length_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_length_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single) {
+            sq_length_ = cq_length_ = std::max(sq_length_, cq_length_);
+        }
+        sq_ring_ = map(sq_length_, IORING_OFF_SQ_RING);
+        cq_ring_ = single ? sq_ring_ : map(cq_length_, IORING_OFF_CQ_RING);
+        sqes_length_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe*>(map(sqes_length_, IORING_OFF_SQES));
+        if (!sq_ring_ || !cq_ring_ || !sqes_) {
+            return false;
+        }
+
+        char* sq = static_cast<char*>(sq_ring_);
+        char* cq = static_cast<char*>(cq_ring_);
+        sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    bool registerBuffers(const std::vector<iovec>& buffers) {
+        return syscall(__NR_io_uring_register, fd_, IORING_REGISTER_BUFFERS, buffers.data(),
+                       static_cast<unsigned>(buffers.size())) == 0;
+    }
+
+    // Queues a write from registered buffer index and submits it
+    void submitWriteFixed(int fd, const char* data, size_t size, size_t offset, unsigned index) {
+        unsigned tail = *sq_tail_;
+        unsigned slot = tail & sq_mask_;
+        io_uring_sqe& sqe = sqes_[slot];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_WRITE_FIXED;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<uintptr_t>(data);
+        sqe.len = static_cast<unsigned>(size);
+        sqe.off = offset;
+        sqe.buf_index = static_cast<uint16_t>(index);
+        sqe.user_data = index;
+        sq_array_[slot] = slot;
+        __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+        enter(1, 0);
+    }
+
+    // Calls done(user_data, result) for each completion, first waiting for
+    // one if wait is set
+    template <typename F>
+    void reap(bool wait, F done) {
+        if (wait) {
+            enter(0, 1);
+        }
+        unsigned head = *cq_head_;
+        unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head) {
+            const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+            done(cqe.user_data, cqe.res);
+        }
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    }
+
+private:
+    void* map(size_t length, off_t offset) {
+        void* p = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, offset);
+        return p == MAP_FAILED ? nullptr : p;
+    }
+
+    void enter(unsigned submit, unsigned minComplete) {
+        unsigned flags = minComplete > 0 ? IORING_ENTER_GETEVENTS : 0;
+        while (syscall(__NR_io_uring_enter, fd_, submit, minComplete, flags, nullptr, 0) < 0) {
+            if (errno != EINTR) {
+                throw std::runtime_error(std::string("io_uring_enter failed: ") + std::strerror(errno));
+            }
+        }
+    }
+
+    int fd_ = -1;
+    void* sq_ring_ = nullptr;
+    void* cq_ring_ = nullptr;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sq_length_ = 0;
+    size_t cq_length_ = 0;
+    size_t sqes_length_ = 0;
+    unsigned* sq_tail_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned* sq_array_ = nullptr;
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+};
+
+// O_DIRECT writes of whole blocks from registered buffers; append() only
+// waits when every buffer is in flight
+class UringOutput : public FileOutput {
+public:
+    // Null if the ring or its buffers cannot be set up
+    static std::unique_ptr<UringOutput> create(int fd, const std::string& path, size_t blockBytes,
+                                               size_t queueDepth) {
+        std::unique_ptr<UringOutput> output(new UringOutput(fd, path, blockBytes));
+        std::vector<iovec> buffers;
+        for (size_t i = 0; i < std::max<size_t>(queueDepth, 2); ++i) {
+            output->blocks_.push_back(allocateAligned(blockBytes));
+            buffers.push_back({output->blocks_.back().get(), blockBytes});
+            output->lengths_.push_back(0);
+            if (i > 0) output->free_.push_back(static_cast<unsigned>(i));
+        }
+        if (!output->ring_.init(static_cast<unsigned>(buffers.size())) || !output->ring_.registerBuffers(buffers)) {
+            output->fd_ = -1;           // The caller still owns fd
+            return nullptr;
+        }
+        return output;
+    }
+
+    ~UringOutput() override {
+        try {
+            close();
+        } catch (...) {
+            // Errors surface only through an explicit close()
+        }
+    }
+
+    void append(const char* data, size_t size) override {
+        throwIfFailed();
+        while (size > 0) {
+            size_t n = std::min(size, block_bytes_ - staged_);
+            std::memcpy(blocks_[current_].get() + staged_, data, n);
+            staged_ += n;
+            data += n;
+            size -= n;
+            if (staged_ == block_bytes_) {
+                submit(block_bytes_);
+                current_ = takeFree();
+                staged_ = 0;
+            }
+        }
+    }
+
+    void close() override {
+        if (fd_ < 0) {
+            return;
+        }
+        size_t length = offset_ + staged_;
+        try {
+            if (staged_ > 0 && error_.empty()) {
+                // Padded to a whole block, then cut back to the real length
+                std::memset(blocks_[current_].get() + staged_, 0, roundUp(staged_) - staged_);
+                padding_ = roundUp(staged_) - staged_;
+                submit(roundUp(staged_));
+                staged_ = 0;
+            }
+            while (in_flight_ > 0) {
+                reap(true);
+            }
+            throwIfFailed();
+            bytes_written_ -= padding_;
+            if (length % FILE_BLOCK_ALIGNMENT != 0 && ftruncate(fd_, static_cast<off_t>(length)) != 0) {
+                throw ioError("Error truncating", path_, errno);
+            }
+        } catch (...) {
+            ::close(fd_);
+            fd_ = -1;
+            throw;
+        }
+        int result = ::close(fd_);
+        fd_ = -1;
+        if (result != 0) {
+            throw ioError("Error closing", path_, errno);
+        }
+    }
+
+    FileWriteBackend backend() const override { return FileWriteBackend::IO_URING; }
+
+private:
+    UringOutput(int fd, const std::string& path, size_t blockBytes)
+        : fd_(fd), path_(path), block_bytes_(blockBytes), current_(0), staged_(0), offset_(0),
+          in_flight_(0), padding_(0) {}
+
+    void submit(size_t size) {
+        lengths_[current_] = size;
+        ring_.submitWriteFixed(fd_, blocks_[current_].get(), size, offset_, current_);
+        offset_ += size;
+        in_flight_++;
+    }
+
+    unsigned takeFree() {
+        while (free_.empty()) {
+            reap(true);
+        }
+        throwIfFailed();
+        unsigned index = free_.back();
+        free_.pop_back();
+        return index;
+    }
+
+    void reap(bool wait) {
+        ring_.reap(wait, [this](uint64_t index, int result) {
+            if (result < 0) {
+                if (error_.empty()) error_ = ioError("Error writing", path_, -result).what();
+            } else if (static_cast<size_t>(result) != lengths_[index]) {
+                if (error_.empty()) error_ = "Short direct write to " + path_;
+            } else {
+                bytes_written_ += static_cast<size_t>(result);
+            }
+            free_.push_back(static_cast<unsigned>(index));
+            in_flight_--;
+        });
+    }
+
+    void throwIfFailed() {
+        if (!error_.empty()) {
+            throw std::runtime_error(error_);
+        }
+    }
+
+    int fd_;
+    std::string path_;
+    size_t block_bytes_;
+    std::vector<AlignedBuffer> blocks_;         // Registered with the ring, by index
+    Ring ring_;
+    std::vector<size_t> lengths_;               // Length of each block's write in flight
+    std::vector<unsigned> free_;
+    unsigned current_;                          // Block being filled
+    size_t staged_;
+    size_t offset_;
+    size_t in_flight_;
+    size_t padding_;
+    std::string error_;
+};
+
+#endif // ETL_IO_URING
+
+} // namespace
+
+AlignedBuffer allocateAligned(size_t size) {
+    void* p = nullptr;
+    if (posix_memalign(&p, FILE_BLOCK_ALIGNMENT, roundUp(std::max<size_t>(size, 1))) != 0) {
+        throw std::bad_alloc();
+    }
+    return AlignedBuffer(static_cast<char*>(p));
+}
+
+const char* fileWriteBackendName(FileWriteBackend backend) {
+    switch (backend) {
+        case FileWriteBackend::DIRECT: return "direct";
+        case FileWriteBackend::IO_URING: return "io_uring";
+        default: return "buffered";
+    }
+}
+
+std::unique_ptr<FileOutput> FileOutput::open(const std::string& path, FileWriteBackend backend,
+                                             size_t blockBytes, size_t queueDepth) {
+    const int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    int fd = -1;
+    if (backend != FileWriteBackend::BUFFERED) {
+        fd = ::open(path.c_str(), flags | O_DIRECT, 0644);
+        if (fd < 0 && errno == EINVAL) {
+            backend = FileWriteBackend::BUFFERED;      // The filesystem has no direct I/O
+        }
+    }
+    if (fd < 0) {
+        fd = ::open(path.c_str(), flags, 0644);
+    }
+    if (fd < 0) {
+        throw ioError("Cannot open", path, errno);
+    }
+
+    blockBytes = roundUp(std::max(blockBytes, FILE_BLOCK_ALIGNMENT));
+#ifdef ETL_IO_URING
+    if (backend == FileWriteBackend::IO_URING) {
+        if (auto output = UringOutput::create(fd, path, blockBytes, queueDepth)) {
+            return output;
+        }
+        backend = FileWriteBackend::DIRECT;
+    }
+#else
+    (void)queueDepth;
+    if (backend == FileWriteBackend::IO_URING) {
+        backend = FileWriteBackend::DIRECT;
+    }
+#endif
+    if (backend == FileWriteBackend::DIRECT) {
+        return std::make_unique<DirectOutput>(fd, path, blockBytes);
+    }
+    return std::make_unique<BufferedOutput>(fd, path);
+}
+
+std::unique_ptr<FileOutput> FileOutput::openAppend(const std::string& path) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+    if (fd < 0) {
+        throw ioError("Cannot open", path, errno);
+    }
+    return std::make_unique<BufferedOutput>(fd, path);
+}
+
+} // namespace etl
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <cstddef>
+#include <cstdlib>
+
+namespace etl {
+
+// Alignment of O_DIRECT buffers, offsets and lengths
+constexpr size_t FILE_BLOCK_ALIGNMENT = 4096;
+
+struct AlignedFree {
+    void operator()(char* p) const { std::free(p); }
+};
+using AlignedBuffer = std::unique_ptr<char, AlignedFree>;
+
+// size bytes, rounded up to a multiple of FILE_BLOCK_ALIGNMENT, starting on
+// that boundary; throws std::bad_alloc
+AlignedBuffer allocateAligned(size_t size);
+
+enum class FileWriteBackend {
+    BUFFERED,   // write(2) through the page cache
+    DIRECT,     // O_DIRECT pwrite(2) of aligned blocks, bypassing the page cache
+    IO_URING    // O_DIRECT writes from registered buffers, several in flight on an io_uring
+};
+
+const char* fileWriteBackendName(FileWriteBackend backend);
+
+// Sequential output to a new file. DIRECT and IO_URING gather appended data
+// into aligned blocks; the last block is padded for the write and the file
+// truncated to its real length on close. Where the filesystem refuses
+// O_DIRECT, or the kernel io_uring, the next backend down is used instead;
+// backend() tells which one is in effect. Not thread-safe.
+class FileOutput {
+public:
+    // Creates or truncates path, gathering blockBytes (rounded up to the
+    // alignment) per write with up to queueDepth writes in flight for
+    // IO_URING; throws std::runtime_error if the file cannot be opened
+    static std::unique_ptr<FileOutput> open(const std::string& path, FileWriteBackend backend,
+                                            size_t blockBytes = 1 << 20, size_t queueDepth = 4);
+    // Continues an existing file, always BUFFERED: its end need not be
+    // aligned for O_DIRECT. Throws std::runtime_error if it cannot be opened.
+    static std::unique_ptr<FileOutput> openAppend(const std::string& path);
+    virtual ~FileOutput() = default;
+
+    // Throws std::runtime_error on a write error
+    virtual void append(const char* data, size_t size) = 0;
+    // Writes what is pending and closes the file; throws std::runtime_error
+    // on error. Called by the destructor if needed, ignoring errors.
+    virtual void close() = 0;
+
+    virtual FileWriteBackend backend() const = 0;
+    size_t bytesWritten() const { return bytes_written_; }
+
+protected:
+    size_t bytes_written_ = 0;
+};
+
+} // namespace etl
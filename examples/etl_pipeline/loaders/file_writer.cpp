@@ -5,11 +5,154 @@
 #include <iomanip>
 #include <sstream>
 #include <algorithm>
+#include <numeric>
 #include <regex>
+#include <cstring>
+#include <cctype>
+#include <list>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 #include <nlohmann/json.hpp>
+#include "processors/record_batch.h"
+#include "common/thread_pool.h"
+#include "common/metrics.h"
 
 namespace etl {
 
+namespace {
+
+const char XML_PROLOG[] = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<root>\n";
+
+// Records routed to a partition thread at a time, and batches it may have queued
+constexpr size_t PARTITION_BATCH_RECORDS = 1024;
+constexpr size_t MAX_QUEUED_PARTITION_BATCHES = 8;
+// Output buffer of each open partition file
+constexpr size_t PARTITION_BUFFER_BYTES = 256 * 1024;
+
+// Hive's name for the partition of records without a partition value
+const char DEFAULT_PARTITION[] = "__HIVE_DEFAULT_PARTITION__";
+
+// A stream writer times one record in this many; reading the clock for
+// every record would cost about as much as buffering it
+constexpr unsigned RECORD_TIMING_SAMPLE = 64;
+
+// Records and bytes written, per output format, for the metrics export
+void countWritten(const std::string& format, size_t records, size_t bytes) {
+    MetricsRegistry& metrics = MetricsRegistry::global();
+    metrics.counter("etl_file_writer_records_total", "Records written to output files", {{"format", format}}).add(records);
+    metrics.counter("etl_file_writer_bytes_total", "Bytes written to output files, before compression",
+                    {{"format", format}}).add(bytes);
+}
+
+std::string sanitizePathComponent(std::string value) {
+    for (char& c : value) {
+        if (c == '/' || c == '\\' || static_cast<unsigned char>(c) < 0x20) {
+            c = '_';
+        }
+    }
+    if (value.empty() || value == "." || value == "..") {
+        value = "_" + value;
+    }
+    return value;
+}
+
+// Fills YYYY, MM, DD and HH in format from an ISO 8601 date or timestamp;
+// false if value is not one
+bool formatDatePartition(const std::string& value, const std::string& format, std::string& path) {
+    static const std::regex isoDate(R"((\d{4})-(\d{2})-(\d{2})(?:[T ](\d{2}))?.*)");
+    std::smatch match;
+    if (!std::regex_match(value, match, isoDate)) {
+        return false;
+    }
+
+    static const std::pair<const char*, int> tokens[] = {{"YYYY", 1}, {"MM", 2}, {"DD", 3}, {"HH", 4}};
+    path = format;
+    for (const auto& token : tokens) {
+        std::string replacement = match[token.second].matched ? match[token.second].str() : "00";
+        for (size_t at = path.find(token.first); at != std::string::npos;
+             at = path.find(token.first, at + replacement.size())) {
+            path.replace(at, std::strlen(token.first), replacement);
+        }
+    }
+    return true;
+}
+
+std::string partitionPath(const nlohmann::json& record, const FileWriter::PartitionConfig& config) {
+    const std::string& field = config.partition_field;
+    if (field.empty()) {
+        return "";
+    }
+    auto value = record.is_object() ? record.find(field) : record.end();
+    if (!record.is_object() || value == record.end() || value->is_null()) {
+        return field + "=" + DEFAULT_PARTITION;
+    }
+
+    std::string text = value->is_string() ? value->get<std::string>() : value->dump();
+    std::string path;
+    if (!config.partition_format.empty() && formatDatePartition(text, config.partition_format, path)) {
+        return path;
+    }
+    return field + "=" + sanitizePathComponent(text);
+}
+
+// A CSV field for value, quoted if it holds a comma or quote
+std::string csvField(const nlohmann::json& value) {
+    std::string text = value.is_string() ? value.get<std::string>() : value.dump();
+    if (text.find(',') == std::string::npos && text.find('"') == std::string::npos) {
+        return text;
+    }
+    std::string escaped = "\"";
+    for (char c : text) {
+        if (c == '"') escaped += "\"\"";
+        else escaped += c;
+    }
+    escaped += "\"";
+    return escaped;
+}
+
+void appendXml(std::ostream& xml, const nlohmann::json& value, int indent);
+
+// One array element as an <item> element
+void appendXmlItem(std::ostream& xml, const nlohmann::json& item, int indent) {
+    std::string indentStr(indent * 2, ' ');
+    xml << indentStr << "<item>";
+    if (item.is_object() || item.is_array()) {
+        xml << "\n";
+        appendXml(xml, item, indent + 1);
+        xml << indentStr;
+    } else {
+        xml << (item.is_string() ? item.get<std::string>() : item.dump());
+    }
+    xml << "</item>\n";
+}
+
+void appendXml(std::ostream& xml, const nlohmann::json& value, int indent) {
+    std::string indentStr(indent * 2, ' ');
+    
+    if (value.is_object()) {
+        for (auto it = value.begin(); it != value.end(); ++it) {
+            xml << indentStr << "<" << it.key() << ">";
+            if (it->is_object() || it->is_array()) {
+                xml << "\n";
+                appendXml(xml, *it, indent + 1);
+                xml << indentStr;
+            } else {
+                xml << (it->is_string() ? it->get<std::string>() : it->dump());
+            }
+            xml << "</" << it.key() << ">\n";
+        }
+    } else if (value.is_array()) {
+        for (const auto& item : value) {
+            appendXmlItem(xml, item, indent);
+        }
+    }
+}
+
+} // namespace
+
 FileWriter::FileWriter() {
     // Set default configuration
     config_.format = OutputFormat::JSON;
@@ -18,7 +161,14 @@ FileWriter::FileWriter() {
     config_.filename_suffix = "";
     config_.append_timestamp = true;
     config_.compress_output = false;
+    config_.compression_codec = "gzip";
+    config_.compression_level = -1;
     config_.max_file_size_mb = 100;
+    config_.parquet_row_group_rows = ParquetWriterOptions().row_group_rows;
+    config_.stream_buffer_bytes = AsyncFileSinkOptions().buffer_bytes;
+    config_.write_backend = FileWriteBackend::BUFFERED;
+    config_.partition_writer_threads = std::max(1u, std::thread::hardware_concurrency());
+    config_.max_open_partition_files = 64;
     config_.create_directories = true;
     
     resetStatistics();
@@ -42,6 +192,20 @@ void FileWriter::setCompressionEnabled(bool enabled) {
     config_.compress_output = enabled;
 }
 
+void FileWriter::setCompression(const std::string& codec, int level) {
+    getCodec(codec);  // Throws for unknown codecs and ones not compiled in
+    config_.compress_output = true;
+    config_.compression_codec = codec;
+    config_.compression_level = level;
+}
+
+void FileWriter::setCompressionProfile(CompressionProfile profile) {
+    CodecChoice choice = recommendedCodec(profile);
+    config_.compress_output = true;
+    config_.compression_codec = choice.codec->name();
+    config_.compression_level = choice.level;
+}
+
 void FileWriter::setMaxFileSize(size_t maxSizeMB) {
     config_.max_file_size_mb = maxSizeMB;
 }
@@ -71,29 +235,21 @@ LoadResult FileWriter::writeData(const std::string& data, const std::string& fil
         // Format data according to specified format
         std::string formattedData = formatDataForOutput(data, config_.format);
         
-        // Compress if enabled
-        if (config_.compress_output) {
-            formattedData = compressData(formattedData);
-            if (fullPath.find(".gz") == std::string::npos) {
-                fullPath += ".gz";
+        // Compress if enabled; Parquet compresses its pages instead
+        if (config_.compress_output && config_.format != OutputFormat::PARQUET) {
+            formattedData = compressData(formattedData, config_.compression_codec, config_.compression_level);
+            std::string extension = getCodec(config_.compression_codec).fileExtension();
+            if (fullPath.size() < extension.size() ||
+                fullPath.compare(fullPath.size() - extension.size(), extension.size(), extension) != 0) {
+                fullPath += extension;
             }
         }
         
         // Write to file
-        std::ofstream outFile(fullPath, std::ios::binary);
-        if (!outFile.is_open()) {
-            result.error_message = "Cannot open file for writing: " + fullPath;
-            return result;
-        }
-        
-        outFile.write(formattedData.c_str(), formattedData.length());
+        AsyncFileSink outFile(fullPath, fileSinkOptions(0));
+        outFile.write(formattedData);
         outFile.close();
         
-        if (outFile.fail()) {
-            result.error_message = "Error writing to file: " + fullPath;
-            return result;
-        }
-        
         result.success = true;
         result.bytes_written = formattedData.length();
         result.records_processed = 1;
@@ -135,34 +291,33 @@ LoadResult FileWriter::writeDataBatch(const std::vector<std::string>& dataItems,
             std::filesystem::create_directories(config_.output_directory);
         }
         
-        std::ofstream outFile(fullPath);
-        if (!outFile.is_open()) {
-            result.error_message = "Cannot open file for writing: " + fullPath;
-            return result;
-        }
+        // Items are formatted while earlier ones are written
+        AsyncFileSink outFile(fullPath, fileSinkOptions(AsyncFileSinkOptions().max_pending_buffers));
         
         size_t totalBytes = 0;
         size_t recordsProcessed = 0;
         
         // Handle different formats
         if (config_.format == OutputFormat::JSON) {
-            outFile << "[\n";
+            outFile.write("[\n");
             for (size_t i = 0; i < dataItems.size(); ++i) {
-                if (i > 0) outFile << ",\n";
+                if (i > 0) outFile.write(",\n");
                 
                 std::string formattedItem = formatDataForOutput(dataItems[i], config_.format);
-                outFile << "  " << formattedItem;
+                outFile.write("  ");
+                outFile.write(formattedItem);
                 totalBytes += formattedItem.length();
                 recordsProcessed++;
             }
-            outFile << "\n]";
+            outFile.write("\n]");
             totalBytes += 4; // For brackets and newlines
             
         } else if (config_.format == OutputFormat::CSV) {
             // For CSV, assume first item contains headers or write all items as rows
             for (const auto& item : dataItems) {
                 std::string formattedItem = formatDataForOutput(item, config_.format);
-                outFile << formattedItem << "\n";
+                outFile.write(formattedItem);
+                outFile.write("\n");
                 totalBytes += formattedItem.length() + 1;
                 recordsProcessed++;
             }
@@ -171,7 +326,8 @@ LoadResult FileWriter::writeDataBatch(const std::vector<std::string>& dataItems,
             // For other formats, write items sequentially
             for (const auto& item : dataItems) {
                 std::string formattedItem = formatDataForOutput(item, config_.format);
-                outFile << formattedItem << "\n";
+                outFile.write(formattedItem);
+                outFile.write("\n");
                 totalBytes += formattedItem.length() + 1;
                 recordsProcessed++;
             }
@@ -189,6 +345,7 @@ LoadResult FileWriter::writeDataBatch(const std::vector<std::string>& dataItems,
         stats_.total_bytes_written += result.bytes_written;
         stats_.total_records_written += result.records_processed;
         stats_.format_distribution[config_.format]++;
+        countWritten(getFileExtension(config_.format).substr(1), result.records_processed, result.bytes_written);
         
     } catch (const std::exception& e) {
         result.error_message = e.what();
@@ -197,6 +354,10 @@ LoadResult FileWriter::writeDataBatch(const std::vector<std::string>& dataItems,
     auto end = std::chrono::high_resolution_clock::now();
     result.processing_time = std::chrono::duration<double>(end - start).count();
     stats_.total_processing_time += result.processing_time;
+    MetricsRegistry::global().histogram("etl_file_writer_batch_seconds", "Time to write one batch file",
+                                        {{"format", getFileExtension(config_.format).substr(1)},
+                                         {"result", result.success ? "ok" : "error"}})
+        .observe(result.processing_time);
     
     return result;
 }
@@ -242,41 +403,86 @@ LoadResult FileWriter::writeCsvFromJson(const std::string& jsonData, const std::
 }
 
 // StreamWriter implementation
-FileWriter::StreamWriter::StreamWriter(const std::string& filepath, OutputFormat format) 
-    : format_(format), record_count_(0), bytes_written_(0), header_written_(false), is_first_record_(true) {
+FileWriter::StreamWriter::StreamWriter(const std::string& filepath, OutputFormat format,
+                                       const ParquetWriterOptions& parquetOptions,
+                                       const AsyncFileSinkOptions& sinkOptions) 
+    : path_(filepath), sink_options_(sinkOptions), format_(format), record_count_(0), bytes_written_(0),
+      closed_sink_bytes_(0), header_written_(false), is_first_record_(true), metrics_reported_(false),
+      suspended_(false) {
     
-    file_stream_ = std::make_unique<std::ofstream>(filepath);
+    record_seconds_ = &MetricsRegistry::global().histogram(
+        "etl_stream_writer_record_seconds", "Time to encode and buffer one streamed record",
+        {{"format", getFileExtension(format_).substr(1)}}, Histogram::exponentialBounds(1e-7, 2, 24),
+        RECORD_TIMING_SAMPLE);
     
-    if (format_ == OutputFormat::JSON) {
-        *file_stream_ << "[\n";
+    if (format_ == OutputFormat::PARQUET) {
+        parquet_writer_ = std::make_unique<ParquetWriter>(filepath, parquetOptions);
+        bytes_written_ = parquet_writer_->bytesWritten();
+        return;
+    }
+    
+    sink_ = std::make_unique<AsyncFileSink>(filepath, sinkOptions);
+    
+    if (format_ == OutputFormat::BINARY) {
+        binary_writer_ = std::make_unique<BinaryRecordWriter>(binary_buffer_);
+        drainBinary();
+    } else if (format_ == OutputFormat::JSON) {
+        sink_->write("[\n");
         bytes_written_ += 2;
+    } else if (format_ == OutputFormat::XML) {
+        sink_->write(XML_PROLOG);
+        bytes_written_ += std::strlen(XML_PROLOG);
     }
 }
 
 FileWriter::StreamWriter::~StreamWriter() {
-    close();
+    try {
+        close();
+    } catch (const std::exception&) {
+        // Errors surface only through an explicit close()
+    }
 }
 
 bool FileWriter::StreamWriter::writeRecord(const std::string& record) {
-    if (!file_stream_ || !file_stream_->is_open()) {
+    ScopedTimer timer(record_seconds_);
+    return appendRecord(record);
+}
+
+bool FileWriter::StreamWriter::appendRecord(const std::string& record) {
+    if (parquet_writer_) {
+        try {
+            parquet_writer_->writeRecord(nlohmann::json::parse(record));
+        } catch (const std::exception&) {
+            return false;
+        }
+        bytes_written_ = parquet_writer_->bytesWritten();
+        record_count_++;
+        return true;
+    }
+    
+    if (!resume()) {
         return false;
     }
     
-    if (format_ == OutputFormat::JSON) {
-        if (!is_first_record_) {
-            *file_stream_ << ",\n";
-            bytes_written_ += 2;
+    try {
+        if (binary_writer_) {
+            binary_writer_->writeRecord(nlohmann::json::parse(record));
+            drainBinary();
+        } else {
+            // One copy into the sink's buffer per record
+            line_.clear();
+            if (format_ == OutputFormat::JSON) {
+                line_ += is_first_record_ ? "  " : ",\n  ";
+                line_ += record;
+            } else {
+                line_ += record;
+                line_ += '\n';
+            }
+            sink_->write(line_);
+            bytes_written_ += line_.size();
         }
-        *file_stream_ << "  " << record;
-        bytes_written_ += record.length() + 2;
-        
-    } else if (format_ == OutputFormat::CSV) {
-        *file_stream_ << record << "\n";
-        bytes_written_ += record.length() + 1;
-        
-    } else {
-        *file_stream_ << record << "\n";
-        bytes_written_ += record.length() + 1;
+    } catch (const std::exception&) {
+        return false;
     }
     
     is_first_record_ = false;
@@ -285,14 +491,173 @@ bool FileWriter::StreamWriter::writeRecord(const std::string& record) {
     return true;
 }
 
+bool FileWriter::StreamWriter::writeJsonRecord(const nlohmann::json& record) {
+    ScopedTimer timer(record_seconds_);
+    
+    if (parquet_writer_) {
+        try {
+            parquet_writer_->writeRecord(record);
+        } catch (const std::exception&) {
+            return false;
+        }
+        bytes_written_ = parquet_writer_->bytesWritten();
+        record_count_++;
+        return true;
+    }
+    
+    if (!resume()) {
+        return false;
+    }
+    
+    switch (format_) {
+        case OutputFormat::BINARY:
+            try {
+                binary_writer_->writeRecord(record);
+                drainBinary();
+            } catch (const std::exception&) {
+                return false;
+            }
+            is_first_record_ = false;
+            record_count_++;
+            return true;
+            
+        case OutputFormat::CSV: {
+            if (is_first_record_ && csv_columns_.empty() && record.is_object()) {
+                for (auto it = record.begin(); it != record.end(); ++it) {
+                    csv_columns_.push_back(it.key());
+                }
+                if (!header_written_ && !writeHeader(csv_columns_)) {
+                    return false;
+                }
+            }
+            std::string line;
+            for (size_t i = 0; i < csv_columns_.size(); ++i) {
+                if (i > 0) line += ",";
+                auto value = record.find(csv_columns_[i]);
+                if (value != record.end()) {
+                    line += csvField(*value);
+                }
+            }
+            return appendRecord(line);
+        }
+            
+        case OutputFormat::XML: {
+            std::ostringstream xml;
+            appendXmlItem(xml, record, 1);
+            std::string text = xml.str();
+            text.pop_back();                // appendRecord ends the line
+            return appendRecord(text);
+        }
+            
+        default:
+            return appendRecord(record.dump());
+    }
+}
+
+bool FileWriter::StreamWriter::writeHeader(const std::vector<std::string>& headers) {
+    // Only CSV has a header line, and only before the first record
+    if (format_ != OutputFormat::CSV || header_written_ || !is_first_record_ || !resume()) {
+        return false;
+    }
+    
+    std::string line;
+    for (size_t i = 0; i < headers.size(); ++i) {
+        if (i > 0) line += ",";
+        line += headers[i];
+    }
+    line += "\n";
+    try {
+        sink_->write(line);
+    } catch (const std::exception&) {
+        return false;
+    }
+    bytes_written_ += line.length();
+    header_written_ = true;
+    return true;
+}
+
+void FileWriter::StreamWriter::flush() {
+    // Parquet row groups are written once they fill
+    if (sink_) {
+        sink_->flush();
+    }
+}
+
 void FileWriter::StreamWriter::close() {
-    if (file_stream_ && file_stream_->is_open()) {
+    if (suspended_ && !parquet_writer_) {
+        // The JSON and XML trailers still have to go in
+        sink_ = std::make_unique<AsyncFileSink>(path_, sink_options_);
+        suspended_ = false;
+    }
+    if (parquet_writer_) {
+        parquet_writer_->close();
+        bytes_written_ = parquet_writer_->bytesWritten();
+    } else if (sink_) {
+        std::unique_ptr<AsyncFileSink> sink = std::move(sink_);
         if (format_ == OutputFormat::JSON) {
-            *file_stream_ << "\n]";
+            sink->write("\n]");
             bytes_written_ += 2;
+        } else if (format_ == OutputFormat::XML) {
+            sink->write("</root>");
+            bytes_written_ += 7;
         }
-        file_stream_->close();
+        sink->close();
+        closed_sink_bytes_ += sink->bytesWritten();
     }
+    // Counted once the file is complete, so a failed close counts nothing
+    if (!metrics_reported_) {
+        metrics_reported_ = true;
+        countWritten(getFileExtension(format_).substr(1), record_count_, bytes_written_);
+    }
+}
+
+void FileWriter::StreamWriter::suspend() {
+    if (parquet_writer_) {
+        parquet_writer_->suspend();
+    } else if (sink_) {
+        std::unique_ptr<AsyncFileSink> sink = std::move(sink_);
+        sink->close();
+        closed_sink_bytes_ += sink->bytesWritten();
+        sink_options_.append = true;
+        suspended_ = true;
+    }
+}
+
+bool FileWriter::StreamWriter::resume() {
+    if (sink_) {
+        return true;
+    }
+    if (!suspended_) {
+        return false;
+    }
+    try {
+        sink_ = std::make_unique<AsyncFileSink>(path_, sink_options_);
+    } catch (const std::exception&) {
+        return false;
+    }
+    suspended_ = false;
+    return true;
+}
+
+void FileWriter::StreamWriter::drainBinary() {
+    sink_->write(binary_buffer_);
+    binary_buffer_.clear();
+    bytes_written_ = binary_writer_->bytesWritten();
+}
+
+size_t FileWriter::StreamWriter::getRecordCount() const {
+    return record_count_;
+}
+
+size_t FileWriter::StreamWriter::getBytesWritten() const {
+    return bytes_written_;
+}
+
+size_t FileWriter::StreamWriter::getFileBytes() const {
+    if (parquet_writer_) {
+        return parquet_writer_->bytesWritten();
+    }
+    return closed_sink_bytes_ + (sink_ ? sink_->bytesWritten() : 0);
 }
 
 std::unique_ptr<FileWriter::StreamWriter> FileWriter::createStreamWriter(const std::string& filename) {
@@ -303,7 +668,326 @@ std::unique_ptr<FileWriter::StreamWriter> FileWriter::createStreamWriter(const s
         std::filesystem::create_directories(config_.output_directory);
     }
     
-    return std::make_unique<StreamWriter>(fullPath, config_.format);
+    return openStreamWriter(fullPath, fileSinkOptions(AsyncFileSinkOptions().max_pending_buffers));
+}
+
+std::unique_ptr<FileWriter::StreamWriter> FileWriter::openStreamWriter(std::string path,
+                                                                       AsyncFileSinkOptions sinkOptions) const {
+    // Parquet compresses its pages; other formats compress each buffer as a frame
+    if (config_.compress_output && config_.format != OutputFormat::PARQUET) {
+        sinkOptions.codec = &getCodec(config_.compression_codec);
+        sinkOptions.compression_level = config_.compression_level;
+        path += sinkOptions.codec->fileExtension();
+    }
+    
+    sinkOptions.backend = config_.write_backend;
+    return std::make_unique<StreamWriter>(path, config_.format, parquetOptions(), sinkOptions);
+}
+
+LoadResult FileWriter::writePartitionedData(const std::string& jsonArrayData, 
+                                            const PartitionConfig& partitionConfig) {
+    LoadResult result;
+    result.success = false;
+    result.records_processed = 0;
+    result.bytes_written = 0;
+    
+    auto start = std::chrono::high_resolution_clock::now();
+    
+    try {
+        nlohmann::json data = nlohmann::json::parse(jsonArrayData);
+        if (!data.is_array()) {
+            throw std::runtime_error("Partitioned output needs a JSON array of records");
+        }
+        
+        // Partition by partition, so each opens one file at a time however
+        // the input interleaves them; records keep their order within one
+        std::vector<std::string> paths;
+        paths.reserve(data.size());
+        for (const auto& record : data) {
+            paths.push_back(partitionPath(record, partitionConfig));
+        }
+        std::vector<size_t> order(data.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return paths[a] < paths[b]; });
+        
+        PartitionWriter writer(*this, partitionConfig);
+        for (size_t i : order) {
+            writer.writeRecord(paths[i], std::move(data[i]));
+        }
+        writer.close();
+        
+        result.records_processed = writer.getRecordCount();
+        result.bytes_written = writer.getBytesWritten();
+        stats_.total_files_written += writer.getFileCount();
+        stats_.total_bytes_written += writer.getBytesWritten();
+        stats_.total_records_written += writer.getRecordCount();
+        stats_.format_distribution[config_.format] += writer.getFileCount();
+        
+        result.success = true;
+        result.output_location = config_.output_directory;
+        
+    } catch (const std::exception& e) {
+        result.error_message = e.what();
+    }
+    
+    auto end = std::chrono::high_resolution_clock::now();
+    result.processing_time = std::chrono::duration<double>(end - start).count();
+    stats_.total_processing_time += result.processing_time;
+    
+    return result;
+}
+
+std::unique_ptr<FileWriter::PartitionWriter> FileWriter::createPartitionWriter(const PartitionConfig& partitionConfig) {
+    return std::make_unique<PartitionWriter>(*this, partitionConfig);
+}
+
+// PartitionWriter implementation
+
+// The unfinished part file, if any, of one partition
+struct FileWriter::PartitionWriter::Partition {
+    std::string directory;
+    std::string filename;                       // Current or last part file, before any codec extension
+    std::string path;                           // Current file, with the codec extension
+    std::unique_ptr<StreamWriter> writer;
+    bool suspended = false;                     // writer's file is closed until its next record
+    size_t records = 0;                         // In the current file
+    std::list<Partition*>::iterator lru;        // Unless suspended
+};
+
+// Partitions owned by one strand of the pool. The caller fills pending and
+// queues it; drain() runs on the pool, one at a time per shard.
+struct FileWriter::PartitionWriter::Shard {
+    using Batch = std::vector<std::pair<std::string, nlohmann::json>>;
+    
+    Batch pending;                              // Caller's thread only
+    
+    std::mutex mutex;
+    std::condition_variable progress;           // A batch was taken or draining stopped
+    std::deque<Batch> queue;
+    bool scheduled = false;                     // A drain() task is queued or running
+    std::string error;
+    
+    // Touched by drain() only, or after the queue is idle
+    std::unordered_map<std::string, Partition> partitions;
+    std::list<Partition*> lru;                  // Open files, most recently written first
+    size_t records = 0;
+    size_t files = 0;
+    size_t bytes = 0;
+};
+
+FileWriter::PartitionWriter::PartitionWriter(const FileWriter& owner, const PartitionConfig& config)
+    : owner_(owner), config_(config), records_(0), files_(0), bytes_(0), closed_(false) {
+    size_t threads = std::max<size_t>(owner_.config_.partition_writer_threads, 1);
+    max_open_per_shard_ = std::max<size_t>(owner_.config_.max_open_partition_files / threads, 1);
+    for (size_t i = 0; i < threads; ++i) {
+        shards_.push_back(std::make_unique<Shard>());
+    }
+    pool_ = std::make_unique<ThreadPool>(threads);
+}
+
+FileWriter::PartitionWriter::~PartitionWriter() {
+    try {
+        close();
+    } catch (const std::exception&) {
+        // Errors surface only through an explicit close()
+    }
+}
+
+void FileWriter::PartitionWriter::writeRecord(nlohmann::json record) {
+    std::string partition = partitionPath(record, config_);
+    writeRecord(partition, std::move(record));
+}
+
+void FileWriter::PartitionWriter::writeRecord(const std::string& partition, nlohmann::json record) {
+    if (closed_) {
+        throw std::runtime_error("Partition writer is closed");
+    }
+    Shard& shard = *shards_[std::hash<std::string>()(partition) % shards_.size()];
+    shard.pending.emplace_back(partition, std::move(record));
+    if (shard.pending.size() >= PARTITION_BATCH_RECORDS) {
+        submit(shard);
+    }
+}
+
+void FileWriter::PartitionWriter::close() {
+    if (closed_) {
+        return;
+    }
+    closed_ = true;
+    
+    for (auto& shard : shards_) {
+        if (!shard->pending.empty()) {
+            try {
+                submit(*shard);
+            } catch (const std::exception&) {
+                // Reported below with the shard's error
+            }
+        }
+    }
+    for (auto& shard : shards_) {
+        std::unique_lock<std::mutex> lock(shard->mutex);
+        shard->progress.wait(lock, [&] { return !shard->scheduled; });
+    }
+    
+    // Shards close their remaining files side by side
+    pool_->forEach(shards_.size(), [this](size_t i) {
+        Shard& shard = *shards_[i];
+        for (auto& entry : shard.partitions) {
+            if (!entry.second.writer) {
+                continue;
+            }
+            try {
+                closeFile(shard, entry.second);
+            } catch (const std::exception& e) {
+                if (shard.error.empty()) shard.error = e.what();
+            }
+        }
+    });
+    
+    std::string error;
+    for (auto& shard : shards_) {
+        records_ += shard->records;
+        files_ += shard->files;
+        bytes_ += shard->bytes;
+        if (error.empty()) error = shard->error;
+    }
+    if (!error.empty()) {
+        throw std::runtime_error(error);
+    }
+}
+
+void FileWriter::PartitionWriter::submit(Shard& shard) {
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    // Back-pressure: the caller waits while this shard's thread is behind
+    shard.progress.wait(lock, [&] {
+        return shard.queue.size() < MAX_QUEUED_PARTITION_BATCHES || !shard.error.empty();
+    });
+    if (!shard.error.empty()) {
+        throw std::runtime_error(shard.error);
+    }
+    
+    shard.queue.push_back(std::move(shard.pending));
+    shard.pending.clear();
+    if (!shard.scheduled) {
+        shard.scheduled = true;
+        pool_->submit([this, &shard] { drain(shard); });
+    }
+}
+
+void FileWriter::PartitionWriter::drain(Shard& shard) {
+    while (true) {
+        Shard::Batch batch;
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            if (shard.queue.empty() || !shard.error.empty()) {
+                shard.queue.clear();
+                shard.scheduled = false;
+                shard.progress.notify_all();
+                return;
+            }
+            batch = std::move(shard.queue.front());
+            shard.queue.pop_front();
+            shard.progress.notify_all();
+        }
+        
+        // Grouped by partition, so a batch opens each partition's file once
+        std::stable_sort(batch.begin(), batch.end(),
+                         [](const auto& a, const auto& b) { return a.first < b.first; });
+        try {
+            for (const auto& routed : batch) {
+                write(shard, routed.first, routed.second);
+            }
+        } catch (const std::exception& e) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.error = e.what();
+        }
+    }
+}
+
+void FileWriter::PartitionWriter::write(Shard& shard, const std::string& path, const nlohmann::json& record) {
+    Partition& partition = shard.partitions[path];
+    if (partition.writer && !partition.suspended) {
+        shard.lru.splice(shard.lru.begin(), shard.lru, partition.lru);
+    } else {
+        if (shard.lru.size() >= max_open_per_shard_) {
+            // The least recent file is released, not finished: its
+            // partition picks it up again on its next record
+            Partition& evicted = *shard.lru.back();
+            shard.lru.pop_back();
+            evicted.suspended = true;
+            evicted.writer->suspend();
+        }
+        if (partition.writer) {
+            partition.suspended = false;
+        } else {
+            if (partition.filename.empty()) {
+                partition.directory = (std::filesystem::path(owner_.config_.output_directory) / path).string();
+                std::filesystem::create_directories(partition.directory);
+                partition.filename = "part-00000" + getFileExtension(owner_.config_.format);
+            } else {
+                // Earlier parts are complete files; never reopen them
+                partition.filename = owner_.getNextRotatedFilename(partition.filename);
+            }
+            // The shard's thread does the file's I/O itself, through a small buffer
+            AsyncFileSinkOptions sinkOptions;
+            sinkOptions.buffer_bytes = PARTITION_BUFFER_BYTES;
+            sinkOptions.max_pending_buffers = 0;
+            partition.writer = owner_.openStreamWriter(
+                (std::filesystem::path(partition.directory) / partition.filename).string(), sinkOptions);
+            partition.path = (std::filesystem::path(partition.directory) / partition.filename).string();
+            if (owner_.config_.compress_output && owner_.config_.format != OutputFormat::PARQUET) {
+                partition.path += getCodec(owner_.config_.compression_codec).fileExtension();
+            }
+            partition.records = 0;
+            shard.files++;
+        }
+        partition.lru = shard.lru.insert(shard.lru.begin(), &partition);
+    }
+    
+    if (!partition.writer->writeJsonRecord(record)) {
+        throw std::runtime_error("Error writing record to " + partition.path);
+    }
+    partition.records++;
+    shard.records++;
+    
+    if (owner_.shouldRotateFile(partition.writer->getFileBytes(), partition.records, config_)) {
+        closeFile(shard, partition);
+    }
+}
+
+void FileWriter::PartitionWriter::closeFile(Shard& shard, Partition& partition) {
+    if (!partition.suspended) {
+        shard.lru.erase(partition.lru);
+    }
+    partition.suspended = false;
+    std::unique_ptr<StreamWriter> writer = std::move(partition.writer);
+    writer->close();
+    shard.bytes += std::filesystem::file_size(partition.path);
+}
+
+bool FileWriter::shouldRotateFile(size_t bytes, size_t records, const PartitionConfig& config) const {
+    size_t maxMb = config.max_size_per_partition_mb > 0 ? config.max_size_per_partition_mb : config_.max_file_size_mb;
+    return (config.max_records_per_partition > 0 && records >= config.max_records_per_partition) ||
+           (maxMb > 0 && bytes >= maxMb * 1024 * 1024);
+}
+
+std::string FileWriter::getNextRotatedFilename(const std::string& baseFilename) const {
+    // The sequence number sits before the first extension: "name-NNNNN.ext..."
+    size_t dot = baseFilename.find('.', baseFilename.rfind('/') == std::string::npos ? 0 : baseFilename.rfind('/') + 1);
+    std::string stem = baseFilename.substr(0, dot);
+    std::string extension = dot == std::string::npos ? "" : baseFilename.substr(dot);
+    
+    size_t number = 0;
+    size_t dash = stem.rfind('-');
+    if (dash != std::string::npos && dash + 1 < stem.size() &&
+        std::all_of(stem.begin() + dash + 1, stem.end(), [](unsigned char c) { return std::isdigit(c); })) {
+        number = std::stoul(stem.substr(dash + 1));
+        stem.erase(dash);
+    }
+    
+    std::ostringstream next;
+    next << stem << "-" << std::setw(5) << std::setfill('0') << number + 1 << extension;
+    return next.str();
 }
 
 std::string FileWriter::generateFilename(const std::string& prefix, const std::string& suffix) {
@@ -359,11 +1043,41 @@ std::string FileWriter::formatDataForOutput(const std::string& data, OutputForma
             }
             return data;
             
+        case OutputFormat::PARQUET: {
+            nlohmann::json records = nlohmann::json::parse(data);
+            return ParquetWriter::encode(RecordBatch::fromJson(records), parquetOptions());
+        }
+            
+        case OutputFormat::BINARY:
+            // Already encoded data is written as-is
+            if (isBinaryRecords(data)) {
+                return data;
+            }
+            return BinaryRecordWriter::encode(RecordBatch::fromJson(nlohmann::json::parse(data)));
+            
         default:
             return data;
     }
 }
 
+AsyncFileSinkOptions FileWriter::fileSinkOptions(size_t maxPendingBuffers) const {
+    AsyncFileSinkOptions options;
+    options.buffer_bytes = config_.stream_buffer_bytes;
+    options.max_pending_buffers = maxPendingBuffers;
+    options.backend = config_.write_backend;
+    return options;
+}
+
+ParquetWriterOptions FileWriter::parquetOptions() const {
+    ParquetWriterOptions options;
+    options.row_group_rows = config_.parquet_row_group_rows;
+    if (config_.compress_output) {
+        options.compression = config_.compression_codec;
+        options.compression_level = config_.compression_level;
+    }
+    return options;
+}
+
 std::string FileWriter::getFileExtension(OutputFormat format) {
     switch (format) {
         case OutputFormat::JSON: return ".json";
@@ -434,23 +1148,7 @@ std::string FileWriter::jsonToCsv(const std::string& jsonData) {
                     if (i > 0) csv << ",";
                     
                     if (record.contains(headers[i])) {
-                        std::string value = record[headers[i]].is_string() 
-                            ? record[headers[i]].get<std::string>()
-                            : record[headers[i]].dump();
-                        
-                        // Escape CSV field if needed
-                        if (value.find(',') != std::string::npos || 
-                            value.find('"') != std::string::npos) {
-                            std::string escaped = "\"";
-                            for (char c : value) {
-                                if (c == '"') escaped += "\"\"";
-                                else escaped += c;
-                            }
-                            escaped += "\"";
-                            csv << escaped;
-                        } else {
-                            csv << value;
-                        }
+                        csv << csvField(record[headers[i]]);
                     }
                 }
                 csv << "\n";
@@ -466,46 +1164,23 @@ std::string FileWriter::jsonToXml(const std::string& jsonData) {
     nlohmann::json data = nlohmann::json::parse(jsonData);
     std::stringstream xml;
     
-    xml << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
-    xml << "<root>\n";
-    
-    std::function<void(const nlohmann::json&, int)> jsonToXmlRecursive = 
-        [&](const nlohmann::json& obj, int indent) {
-            std::string indentStr(indent * 2, ' ');
-            
-            if (obj.is_object()) {
-                for (auto it = obj.begin(); it != obj.end(); ++it) {
-                    xml << indentStr << "<" << it.key() << ">";
-                    if (it->is_object() || it->is_array()) {
-                        xml << "\n";
-                        jsonToXmlRecursive(*it, indent + 1);
-                        xml << indentStr;
-                    } else {
-                        xml << (it->is_string() ? it->get<std::string>() : it->dump());
-                    }
-                    xml << "</" << it.key() << ">\n";
-                }
-            } else if (obj.is_array()) {
-                for (const auto& item : obj) {
-                    xml << indentStr << "<item>";
-                    if (item.is_object() || item.is_array()) {
-                        xml << "\n";
-                        jsonToXmlRecursive(item, indent + 1);
-                        xml << indentStr;
-                    } else {
-                        xml << (item.is_string() ? item.get<std::string>() : item.dump());
-                    }
-                    xml << "</item>\n";
-                }
-            }
-        };
+    xml << XML_PROLOG;
     
-    jsonToXmlRecursive(data, 1);
+    appendXml(xml, data, 1);
     xml << "</root>";
     
     return xml.str();
 }
 
+std::string FileWriter::compressData(const std::string& data, const std::string& algorithm, int level) {
+    const Codec& codec = getCodec(algorithm);
+    return codec.compress(data, level < 0 ? codec.defaultLevel() : level);
+}
+
+std::string FileWriter::decompressData(const std::string& compressedData, const std::string& algorithm) {
+    return getCodec(algorithm).decompress(compressedData);
+}
+
 FileWriter::WriterStats FileWriter::getStatistics() const {
     return stats_;
 }
@@ -6,9 +6,16 @@
 #include <memory>
 #include <fstream>
 #include <functional>
+#include "codec.h"
+#include "parquet_writer.h"
+#include "async_file_sink.h"
+#include "processors/binary_records.h"
 
 namespace etl {
 
+class ThreadPool;
+class Histogram;
+
 struct LoadResult {
     bool success;
     std::string error_message;
@@ -33,7 +40,14 @@ struct FileWriterConfig {
     std::string filename_suffix;
     bool append_timestamp;
     bool compress_output;
+    std::string compression_codec;   // "gzip", "zstd", "lz4", ... (see codec.h)
+    int compression_level;           // Negative: the codec's default
     size_t max_file_size_mb;
+    size_t parquet_row_group_rows;   // Rows per Parquet row group
+    size_t stream_buffer_bytes;      // StreamWriter's unit of background writes
+    FileWriteBackend write_backend;  // How output files reach the disk (see file_output.h)
+    size_t partition_writer_threads; // Threads writing partition files
+    size_t max_open_partition_files; // Open partition files before the least recently used is suspended
     bool create_directories;
     std::map<std::string, std::string> custom_headers;
 };
@@ -48,6 +62,8 @@ public:
     void setOutputDirectory(const std::string& directory);
     void setOutputFormat(OutputFormat format);
     void setCompressionEnabled(bool enabled);
+    void setCompression(const std::string& codec, int level = -1);  // Also enables compression
+    void setCompressionProfile(CompressionProfile profile);
     void setMaxFileSize(size_t maxSizeMB);
     
     // Basic file operations
@@ -64,29 +80,69 @@ public:
     // Streaming operations for large datasets
     class StreamWriter {
     public:
-        StreamWriter(const std::string& filepath, OutputFormat format);
+        // PARQUET buffers records into row groups with parquetOptions. Other
+        // formats go through an AsyncFileSink configured by sinkOptions, so
+        // encoding overlaps the writes (and compression) on its I/O thread.
+        StreamWriter(const std::string& filepath, OutputFormat format,
+                     const ParquetWriterOptions& parquetOptions = {},
+                     const AsyncFileSinkOptions& sinkOptions = {});
         ~StreamWriter();
         
+        // A JSON object for PARQUET and BINARY; text written as-is otherwise
         bool writeRecord(const std::string& record);
+        // Formats record for any output format. CSV columns, and the
+        // header line, come from the first record's fields.
+        bool writeJsonRecord(const nlohmann::json& record);
         bool writeHeader(const std::vector<std::string>& headers);
+        // Waits until written records are in the file; throws
+        // std::runtime_error on a write error
         void flush();
         void close();
+        // Writes out what is buffered and closes the file, keeping the
+        // stream's state; the next record reopens it and carries on, in
+        // the same file. Parquet keeps its unwritten row group in memory.
+        // Throws std::runtime_error on a write error.
+        void suspend();
         
         size_t getRecordCount() const;
-        size_t getBytesWritten() const;
+        size_t getBytesWritten() const;     // Before any compression
+        // In the file so far, after compression; what is still buffered
+        // (up to one sink buffer, or Parquet's open row group) is not counted
+        size_t getFileBytes() const;
         
     private:
-        std::unique_ptr<std::ofstream> file_stream_;
+        // writeRecord without the timing, for writeJsonRecord's formats
+        // that end up as a line of text
+        bool appendRecord(const std::string& record);
+        void drainBinary();
+        // False if the stream is closed; reopens a suspended file
+        bool resume();
+        
+        std::string path_;
+        AsyncFileSinkOptions sink_options_;     // Append set once suspended
+        std::unique_ptr<AsyncFileSink> sink_;
+        std::unique_ptr<ParquetWriter> parquet_writer_;
+        std::string line_;
+        std::vector<std::string> csv_columns_;
+        std::string binary_buffer_;
+        std::unique_ptr<BinaryRecordWriter> binary_writer_;
         OutputFormat format_;
         size_t record_count_;
         size_t bytes_written_;
+        size_t closed_sink_bytes_;          // Written by sinks already closed
         bool header_written_;
         bool is_first_record_;
+        bool metrics_reported_;
+        bool suspended_;
+        Histogram* record_seconds_;     // Sampled per-record latency
     };
     
     std::unique_ptr<StreamWriter> createStreamWriter(const std::string& filename = "");
     
-    // Partitioned output for large datasets
+    // Partitioned output for large datasets. Each partition is a directory
+    // under the output directory, "<field>=<value>" or, for date values,
+    // partition_format filled in ("YYYY/MM/DD" -> 2024/03/15); records with
+    // no value go to "<field>=__HIVE_DEFAULT_PARTITION__".
     struct PartitionConfig {
         std::string partition_field;
         size_t max_records_per_partition;
@@ -94,9 +150,66 @@ public:
         std::string partition_format; // "YYYY/MM/DD", "YYYY-MM", etc.
     };
     
+    // Writes each partition through its own StreamWriters: part-00000,
+    // part-00001, ... A file is closed, and the next one started, once it
+    // holds max_records_per_partition records or max_size_per_partition_mb
+    // (else max_file_size_mb) on disk, after any compression; zero limits
+    // are ignored.
     LoadResult writePartitionedData(const std::string& jsonArrayData, 
                                    const PartitionConfig& partitionConfig);
     
+    // Streaming form of writePartitionedData. Partitions are spread over
+    // partition_writer_threads, each writing its own partitions' files in
+    // record order while the caller keeps routing batches of records. Each
+    // thread keeps at most its share of max_open_partition_files open,
+    // suspending the least recently written one when it needs another. A
+    // suspended part file is reopened for append when its partition is
+    // written again, so the cap costs reopens, not extra files; Parquet
+    // keeps the unwritten row group of each suspended file in memory.
+    // Not thread-safe.
+    class PartitionWriter {
+    public:
+        PartitionWriter(const FileWriter& owner, const PartitionConfig& config);
+        ~PartitionWriter();
+        
+        PartitionWriter(const PartitionWriter&) = delete;
+        PartitionWriter& operator=(const PartitionWriter&) = delete;
+        
+        // Blocks while the partition's thread is behind; throws
+        // std::runtime_error once any file has failed
+        void writeRecord(nlohmann::json record);
+        // Writes record to a partition directory computed by the caller
+        void writeRecord(const std::string& partition, nlohmann::json record);
+        // Writes everything and closes all files; throws std::runtime_error
+        // on the first error. Called by the destructor if needed, ignoring errors.
+        void close();
+        
+        size_t getRecordCount() const { return records_; }
+        size_t getFileCount() const { return files_; }
+        size_t getBytesWritten() const { return bytes_; }   // On disk, after compression
+        
+    private:
+        struct Partition;
+        struct Shard;
+        
+        void submit(Shard& shard);
+        void drain(Shard& shard);
+        void write(Shard& shard, const std::string& path, const nlohmann::json& record);
+        void closeFile(Shard& shard, Partition& partition);
+        
+        const FileWriter& owner_;
+        PartitionConfig config_;
+        size_t max_open_per_shard_;
+        std::vector<std::unique_ptr<Shard>> shards_;
+        std::unique_ptr<ThreadPool> pool_;
+        size_t records_;
+        size_t files_;
+        size_t bytes_;
+        bool closed_;
+    };
+    
+    std::unique_ptr<PartitionWriter> createPartitionWriter(const PartitionConfig& partitionConfig);
+    
     // Batch operations
     struct BatchWriteResult {
         int successful_writes;
@@ -116,7 +229,7 @@ public:
     bool deleteFile(const std::string& filepath);
     
     // Compression utilities
-    std::string compressData(const std::string& data, const std::string& algorithm = "gzip");
+    std::string compressData(const std::string& data, const std::string& algorithm = "gzip", int level = -1);
     std::string decompressData(const std::string& compressedData, const std::string& algorithm = "gzip");
     
     // Validation
@@ -141,11 +254,20 @@ private:
     
     // Helper methods
     std::string formatDataForOutput(const std::string& data, OutputFormat format);
-    std::string getFileExtension(OutputFormat format);
+    ParquetWriterOptions parquetOptions() const;            // Page compression from the config
+    // Buffering and backend from the config; 0 pending buffers writes inline
+    AsyncFileSinkOptions fileSinkOptions(size_t maxPendingBuffers) const;
+    static std::string getFileExtension(OutputFormat format);
     bool createDirectoryIfNotExists(const std::string& path);
     std::string addTimestampToFilename(const std::string& filename);
-    bool shouldRotateFile(const std::string& filepath);
-    std::string getNextRotatedFilename(const std::string& baseFilename);
+    // True once a file of bytes and records has reached config's limits
+    bool shouldRotateFile(size_t bytes, size_t records, const PartitionConfig& config) const;
+    // "part-00000.json" -> "part-00001.json", "out.csv.gz" -> "out-00001.csv.gz"
+    std::string getNextRotatedFilename(const std::string& baseFilename) const;
+    // A StreamWriter for path with the configured format and compression;
+    // the codec's extension is added to path. sinkOptions supplies the
+    // buffering; its codec and backend fields are overwritten.
+    std::unique_ptr<StreamWriter> openStreamWriter(std::string path, AsyncFileSinkOptions sinkOptions) const;
     
     // Format converters
     std::string jsonToCsv(const std::string& jsonData);
@@ -0,0 +1,810 @@
+#include "parquet_writer.h"
+#include "codec.h"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+#include <unordered_map>
+#include <deque>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+
+#ifdef HAVE_LZ4
+#include <lz4.h>
+#endif
+
+namespace etl {
+
+namespace {
+
+const char PARQUET_MAGIC[] = "PAR1";
+
+// parquet.thrift enums
+enum PhysicalType : int32_t { BOOLEAN = 0, INT64 = 2, DOUBLE = 5, BYTE_ARRAY = 6 };
+enum ConvertedType : int32_t { UTF8 = 0, JSON = 19 };
+enum Encoding : int32_t { PLAIN = 0, RLE = 3, RLE_DICTIONARY = 8 };
+enum PageType : int32_t { DATA_PAGE = 0, DICTIONARY_PAGE = 2 };
+enum CompressionCodec : int32_t { UNCOMPRESSED = 0, GZIP = 2, ZSTD = 6, LZ4_RAW = 7 };
+constexpr int32_t OPTIONAL = 1;
+
+// Min/max statistics are left out for values longer than this, as other
+// writers do; the null count is always written
+constexpr size_t MAX_STATISTICS_BYTES = 4096;
+
+// Thrift compact protocol, just the parts parquet.thrift metadata needs
+class ThriftWriter {
+public:
+    explicit ThriftWriter(std::string& out) : out_(out), last_field_(0) {}
+
+    // A struct without a field header: the top-level one, or a list element
+    void beginStruct() {
+        stack_.push_back(last_field_);
+        last_field_ = 0;
+    }
+    void beginStructField(int16_t id) {
+        fieldHeader(id, 12);
+        beginStruct();
+    }
+    void endStruct() {
+        out_ += '\0';
+        last_field_ = stack_.back();
+        stack_.pop_back();
+    }
+
+    void fieldI32(int16_t id, int32_t value) {
+        fieldHeader(id, 5);
+        varint(zigzag(value));
+    }
+    void fieldI64(int16_t id, int64_t value) {
+        fieldHeader(id, 6);
+        varint(zigzag(value));
+    }
+    void fieldBinary(int16_t id, const std::string& value) {
+        fieldHeader(id, 8);
+        binary(value);
+    }
+
+    // List header; the elements follow as listI32 / listBinary / structs
+    void beginListField(int16_t id, uint8_t elementType, size_t size) {
+        fieldHeader(id, 9);
+        if (size < 15) {
+            out_ += static_cast<char>((size << 4) | elementType);
+        } else {
+            out_ += static_cast<char>(0xf0 | elementType);
+            varint(size);
+        }
+    }
+    void listI32(int32_t value) { varint(zigzag(value)); }
+    void listBinary(const std::string& value) { binary(value); }
+    // A struct element serialized beforehand (the compact protocol encodes
+    // field ids relative to the enclosing struct only)
+    void listRaw(const std::string& bytes) { out_ += bytes; }
+
+    static constexpr uint8_t I32 = 5;
+    static constexpr uint8_t BINARY = 8;
+    static constexpr uint8_t STRUCT = 12;
+
+private:
+    void fieldHeader(int16_t id, uint8_t type) {
+        int delta = id - last_field_;
+        if (delta > 0 && delta <= 15) {
+            out_ += static_cast<char>((delta << 4) | type);
+        } else {
+            out_ += static_cast<char>(type);
+            varint(zigzag(id));
+        }
+        last_field_ = id;
+    }
+
+    void binary(const std::string& value) {
+        varint(value.size());
+        out_ += value;
+    }
+
+    static uint64_t zigzag(int64_t value) {
+        return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    }
+
+    void varint(uint64_t value) {
+        while (value >= 0x80) {
+            out_ += static_cast<char>((value & 0x7f) | 0x80);
+            value >>= 7;
+        }
+        out_ += static_cast<char>(value);
+    }
+
+    std::string& out_;
+    int16_t last_field_;
+    std::vector<int16_t> stack_;
+};
+
+void appendVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+void appendUint32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out += static_cast<char>(value >> (8 * i));
+    }
+}
+
+// RLE / bit-packing hybrid: runs of 8 or more equal values become RLE runs,
+// everything else is bit-packed in groups of 8 (the last one zero-padded)
+void appendRleHybrid(std::string& out, const uint32_t* values, size_t count, int bitWidth) {
+    const size_t byteWidth = (bitWidth + 7) / 8;
+    std::string packed;
+    size_t groups = 0;
+    auto flushPacked = [&]() {
+        if (groups > 0) {
+            appendVarint(out, (groups << 1) | 1);
+            out += packed;
+            packed.clear();
+            groups = 0;
+        }
+    };
+
+    size_t i = 0;
+    while (i < count) {
+        size_t run = 1;
+        while (i + run < count && values[i + run] == values[i]) {
+            run++;
+        }
+        if (run >= 8) {
+            flushPacked();
+            appendVarint(out, run << 1);
+            for (size_t b = 0; b < byteWidth; ++b) {
+                out += static_cast<char>(values[i] >> (8 * b));
+            }
+            i += run;
+            continue;
+        }
+
+        uint64_t bits = 0;
+        int used = 0;
+        for (size_t k = 0; k < 8; ++k) {
+            uint64_t value = i + k < count ? values[i + k] : 0;
+            bits |= value << used;
+            used += bitWidth;
+            while (used >= 8) {
+                packed += static_cast<char>(bits & 0xff);
+                bits >>= 8;
+                used -= 8;
+            }
+        }
+        groups++;
+        i += 8;
+    }
+    flushPacked();
+}
+
+void appendPlain(std::string& out, int64_t value) {
+    char bytes[8];
+    std::memcpy(bytes, &value, 8);
+    out.append(bytes, 8);
+}
+
+void appendPlain(std::string& out, double value) {
+    char bytes[8];
+    std::memcpy(bytes, &value, 8);
+    out.append(bytes, 8);
+}
+
+void appendPlain(std::string& out, std::string_view value) {
+    appendUint32(out, static_cast<uint32_t>(value.size()));
+    out.append(value.data(), value.size());
+}
+
+size_t plainSize(int64_t) { return 8; }
+size_t plainSize(double) { return 8; }
+size_t plainSize(std::string_view value) { return 4 + value.size(); }
+
+// Statistics hold min/max PLAIN encoded, without a length for byte arrays
+std::string statisticValue(int64_t value) {
+    std::string out;
+    appendPlain(out, value);
+    return out;
+}
+
+std::string statisticValue(double value) {
+    std::string out;
+    appendPlain(out, value);
+    return out;
+}
+
+std::string statisticValue(std::string_view value) {
+    return std::string(value);
+}
+
+bool orderable(int64_t) { return true; }
+bool orderable(double value) { return !std::isnan(value); }
+bool orderable(std::string_view) { return true; }
+
+// Dictionary lookup keys; doubles by bit pattern so that -0.0 and 0.0 stay apart
+int64_t dictionaryKey(int64_t value) { return value; }
+std::string_view dictionaryKey(std::string_view value) { return value; }
+uint64_t dictionaryKey(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, 8);
+    return bits;
+}
+
+struct ChunkStatistics {
+    bool has_min_max = false;
+    std::string min;
+    std::string max;
+    size_t null_count = 0;
+};
+
+// One page before compression
+struct EncodedPage {
+    bool dictionary;
+    size_t num_values;          // Rows for a data page, entries for a dictionary page
+    std::string body;
+};
+
+struct EncodedChunk {
+    std::vector<EncodedPage> pages;
+    bool dictionary_encoded = false;
+    ChunkStatistics statistics;
+};
+
+size_t rowsPerPage(size_t rows, size_t estimatedBytes, size_t pageBytes) {
+    size_t pages = std::max<size_t>(1, (estimatedBytes + pageBytes - 1) / std::max<size_t>(pageBytes, 1));
+    return std::max<size_t>(1, (rows + pages - 1) / pages);
+}
+
+void appendDefinitionLevels(std::string& body, const std::vector<uint32_t>& defs, size_t begin, size_t end) {
+    std::string levels;
+    appendRleHybrid(levels, defs.data() + begin, end - begin, 1);
+    appendUint32(body, static_cast<uint32_t>(levels.size()));
+    body += levels;
+}
+
+template <typename T>
+EncodedChunk encodeChunk(const std::vector<T>& values, const std::vector<uint32_t>& defs,
+                         const ParquetWriterOptions& options) {
+    EncodedChunk chunk;
+    chunk.statistics.null_count = defs.size() - values.size();
+
+    bool first = true;
+    T min{};
+    T max{};
+    for (const T& value : values) {
+        if (!orderable(value)) continue;
+        if (first || value < min) min = value;
+        if (first || max < value) max = value;
+        first = false;
+    }
+    if (!first) {
+        if constexpr (std::is_same<T, double>::value) {
+            // The spec's rule for zeros, since -0.0 == 0.0
+            if (min == 0) min = -0.0;
+            if (max == 0) max = 0.0;
+        }
+        chunk.statistics.min = statisticValue(min);
+        chunk.statistics.max = statisticValue(max);
+        chunk.statistics.has_min_max = chunk.statistics.min.size() <= MAX_STATISTICS_BYTES &&
+                                       chunk.statistics.max.size() <= MAX_STATISTICS_BYTES;
+    }
+
+    // Dictionary, abandoned as soon as it outgrows its page
+    std::unordered_map<decltype(dictionaryKey(T{})), uint32_t> index;
+    std::vector<T> dictionary;
+    std::vector<uint32_t> indices;
+    size_t dictionaryBytes = 0;
+    bool useDictionary = !values.empty();
+    indices.reserve(values.size());
+    for (const T& value : values) {
+        auto inserted = index.emplace(dictionaryKey(value), static_cast<uint32_t>(dictionary.size()));
+        if (inserted.second) {
+            dictionary.push_back(value);
+            dictionaryBytes += plainSize(value);
+            if (dictionaryBytes > options.dictionary_page_bytes) {
+                useDictionary = false;
+                break;
+            }
+        }
+        indices.push_back(inserted.first->second);
+    }
+
+    const size_t rows = defs.size();
+    int bitWidth = 1;
+    size_t estimatedBytes = rows / 8;
+    if (useDictionary) {
+        while ((size_t(1) << bitWidth) < dictionary.size()) {
+            bitWidth++;
+        }
+        estimatedBytes += values.size() * bitWidth / 8;
+
+        EncodedPage page{true, dictionary.size(), std::string()};
+        page.body.reserve(dictionaryBytes);
+        for (const T& value : dictionary) {
+            appendPlain(page.body, value);
+        }
+        chunk.pages.push_back(std::move(page));
+        chunk.dictionary_encoded = true;
+    } else {
+        for (const T& value : values) {
+            estimatedBytes += plainSize(value);
+        }
+    }
+
+    size_t pageRows = rowsPerPage(rows, estimatedBytes, options.data_page_bytes);
+    size_t valueIndex = 0;
+    for (size_t begin = 0; begin < rows; begin += pageRows) {
+        size_t end = std::min(rows, begin + pageRows);
+        size_t present = 0;
+        for (size_t row = begin; row < end; ++row) {
+            present += defs[row];
+        }
+
+        EncodedPage page{false, end - begin, std::string()};
+        appendDefinitionLevels(page.body, defs, begin, end);
+        if (useDictionary) {
+            page.body += static_cast<char>(bitWidth);
+            appendRleHybrid(page.body, indices.data() + valueIndex, present, bitWidth);
+        } else {
+            for (size_t i = valueIndex; i < valueIndex + present; ++i) {
+                appendPlain(page.body, values[i]);
+            }
+        }
+        valueIndex += present;
+        chunk.pages.push_back(std::move(page));
+    }
+    return chunk;
+}
+
+EncodedChunk encodeBooleanChunk(const std::vector<uint32_t>& values, const std::vector<uint32_t>& defs,
+                                const ParquetWriterOptions& options) {
+    EncodedChunk chunk;
+    chunk.statistics.null_count = defs.size() - values.size();
+    if (!values.empty()) {
+        bool anyFalse = std::find(values.begin(), values.end(), 0u) != values.end();
+        bool anyTrue = std::find(values.begin(), values.end(), 1u) != values.end();
+        chunk.statistics.has_min_max = true;
+        chunk.statistics.min = std::string(1, anyFalse ? '\0' : '\1');
+        chunk.statistics.max = std::string(1, anyTrue ? '\1' : '\0');
+    }
+
+    const size_t rows = defs.size();
+    size_t pageRows = rowsPerPage(rows, rows / 4, options.data_page_bytes);
+    size_t valueIndex = 0;
+    for (size_t begin = 0; begin < rows; begin += pageRows) {
+        size_t end = std::min(rows, begin + pageRows);
+        size_t present = 0;
+        for (size_t row = begin; row < end; ++row) {
+            present += defs[row];
+        }
+
+        // PLAIN booleans are bit-packed, least significant bit first
+        EncodedPage page{false, end - begin, std::string()};
+        appendDefinitionLevels(page.body, defs, begin, end);
+        for (size_t i = 0; i < present; i += 8) {
+            uint8_t byte = 0;
+            for (size_t k = 0; k < 8 && i + k < present; ++k) {
+                byte |= static_cast<uint8_t>(values[valueIndex + i + k] << k);
+            }
+            page.body += static_cast<char>(byte);
+        }
+        valueIndex += present;
+        chunk.pages.push_back(std::move(page));
+    }
+    return chunk;
+}
+
+std::runtime_error conversionError(const std::string& column, size_t row, const char* type) {
+    return std::runtime_error("Parquet column '" + column + "': value in row " + std::to_string(row) +
+                              " does not convert to " + type);
+}
+
+} // namespace
+
+struct ParquetWriter::ChunkMetadata {
+    std::string column_chunk;                   // Serialized ColumnChunk struct
+    size_t uncompressed_bytes;
+    size_t compressed_bytes;
+};
+
+ParquetWriter::ParquetWriter(const std::string& path, const ParquetWriterOptions& options)
+    : file_(std::make_unique<std::ofstream>(path, std::ios::binary | std::ios::trunc)),
+      path_(path), output_(file_.get()), options_(options) {
+    if (!*file_) {
+        throw std::runtime_error("Cannot open file for writing: " + path);
+    }
+    init();
+}
+
+ParquetWriter::ParquetWriter(std::ostream& output, const ParquetWriterOptions& options)
+    : output_(&output), options_(options) {
+    init();
+}
+
+ParquetWriter::~ParquetWriter() {
+    if (!closed_) {
+        try {
+            close();
+        } catch (...) {
+            // Errors surface only through an explicit close()
+        }
+    }
+}
+
+void ParquetWriter::init() {
+    rows_written_ = 0;
+    offset_ = 0;
+    closed_ = false;
+    options_.row_group_rows = std::max<size_t>(options_.row_group_rows, 1);
+
+    const std::string& compression = options_.compression;
+    if (compression.empty() || compression == "none") {
+        codec_ = UNCOMPRESSED;
+    } else if (compression == "gzip") {
+        codec_ = GZIP;
+    } else if (compression == "zstd") {
+        codec_ = ZSTD;
+    } else if (compression == "lz4") {
+#ifdef HAVE_LZ4
+        codec_ = LZ4_RAW;
+#else
+        throw std::runtime_error("Codec 'lz4' was not compiled in");
+#endif
+    } else {
+        throw std::runtime_error("Compression '" + compression + "' is not supported for Parquet "
+                                 "(use none, gzip, zstd or lz4)");
+    }
+    if (codec_ == GZIP || codec_ == ZSTD) {
+        getCodec(compression);      // Throws if not compiled in
+    }
+
+    emit(std::string(PARQUET_MAGIC, 4));
+}
+
+void ParquetWriter::write(const RecordBatch& batch) {
+    size_t offset = 0;
+    while (offset < batch.numRows()) {
+        size_t count = std::min(batch.numRows() - offset, options_.row_group_rows - pending_.numRows());
+        if (offset == 0 && count == batch.numRows() && pending_.numRows() == 0) {
+            pending_ = batch;
+        } else {
+            pending_.append(batch.slice(offset, count));
+        }
+        offset += count;
+        if (pending_.numRows() >= options_.row_group_rows) {
+            flushRowGroup();
+        }
+    }
+}
+
+void ParquetWriter::writeRecord(const nlohmann::json& record) {
+    pending_.appendRecord(record);
+    if (pending_.numRows() >= options_.row_group_rows) {
+        flushRowGroup();
+    }
+}
+
+void ParquetWriter::close() {
+    if (closed_) {
+        return;
+    }
+    closed_ = true;
+
+    if (pending_.numRows() > 0) {
+        flushRowGroup();
+    }
+
+    std::string footer;
+    ThriftWriter thrift(footer);
+    thrift.beginStruct();
+    thrift.fieldI32(1, 2);                                      // version
+
+    thrift.beginListField(2, ThriftWriter::STRUCT, schema_.size() + 1);
+    thrift.beginStruct();
+    thrift.fieldBinary(4, "schema");
+    thrift.fieldI32(5, static_cast<int32_t>(schema_.size()));    // num_children
+    thrift.endStruct();
+    for (const auto& column : schema_) {
+        thrift.beginStruct();
+        thrift.fieldI32(1, column.physical_type);
+        thrift.fieldI32(3, OPTIONAL);
+        thrift.fieldBinary(4, column.name);
+        if (column.physical_type == BYTE_ARRAY) {
+            thrift.fieldI32(6, column.json ? JSON : UTF8);
+            thrift.beginStructField(10);                        // logicalType union
+            thrift.beginStructField(column.json ? 12 : 1);      // JsonType / StringType
+            thrift.endStruct();
+            thrift.endStruct();
+        }
+        thrift.endStruct();
+    }
+
+    thrift.fieldI64(3, static_cast<int64_t>(rows_written_));
+    thrift.beginListField(4, ThriftWriter::STRUCT, row_groups_.size());
+    for (const auto& rowGroup : row_groups_) {
+        thrift.listRaw(rowGroup);
+    }
+    thrift.fieldBinary(6, "etl_pipeline parquet writer");
+    // column_orders: TYPE_ORDER for every column, so readers trust min/max
+    thrift.beginListField(7, ThriftWriter::STRUCT, schema_.size());
+    for (size_t i = 0; i < schema_.size(); ++i) {
+        thrift.beginStruct();
+        thrift.beginStructField(1);
+        thrift.endStruct();
+        thrift.endStruct();
+    }
+    thrift.endStruct();
+
+    appendUint32(footer, static_cast<uint32_t>(footer.size()));
+    footer.append(PARQUET_MAGIC, 4);
+    emit(footer);
+
+    output_->flush();
+    if (file_) {
+        file_->close();
+    }
+    if (output_->fail()) {
+        throw std::runtime_error("Error writing Parquet output");
+    }
+}
+
+void ParquetWriter::suspend() {
+    if (closed_ || !file_ || !file_->is_open()) {
+        return;
+    }
+    file_->close();
+    if (file_->fail()) {
+        throw std::runtime_error("Error writing Parquet output");
+    }
+}
+
+std::string ParquetWriter::encode(const RecordBatch& batch, const ParquetWriterOptions& options) {
+    std::ostringstream output;
+    {
+        ParquetWriter writer(output, options);
+        writer.write(batch);
+        writer.close();
+    }
+    return output.str();
+}
+
+void ParquetWriter::flushRowGroup() {
+    if (schema_.empty() && row_groups_.empty()) {
+        // The first row group fixes the schema
+        for (const auto& column : pending_.columns()) {
+            ColumnSchema schema{column.name(), BYTE_ARRAY, false};
+            switch (column.type()) {
+                case ColumnType::BOOL: schema.physical_type = BOOLEAN; break;
+                case ColumnType::INT: schema.physical_type = INT64; break;
+                case ColumnType::DOUBLE: schema.physical_type = DOUBLE; break;
+                case ColumnType::JSON: schema.json = true; break;
+                default: break;
+            }
+            schema_.push_back(std::move(schema));
+        }
+    } else {
+        for (const auto& column : pending_.columns()) {
+            bool known = std::any_of(schema_.begin(), schema_.end(),
+                                     [&](const ColumnSchema& schema) { return schema.name == column.name(); });
+            if (!known) {
+                throw std::runtime_error("Parquet column '" + column.name() +
+                                         "' is not in the schema of the first row group");
+            }
+        }
+    }
+
+    size_t rows = pending_.numRows();
+    size_t fileOffset = offset_;
+    size_t uncompressed = 0;
+    size_t compressed = 0;
+    std::vector<ChunkMetadata> chunks;
+    for (const auto& schema : schema_) {
+        chunks.push_back(writeColumnChunk(schema, pending_.findColumn(schema.name), rows));
+        uncompressed += chunks.back().uncompressed_bytes;
+        compressed += chunks.back().compressed_bytes;
+    }
+
+    std::string rowGroup;
+    ThriftWriter thrift(rowGroup);
+    thrift.beginStruct();
+    thrift.beginListField(1, ThriftWriter::STRUCT, chunks.size());
+    for (const auto& chunk : chunks) {
+        thrift.listRaw(chunk.column_chunk);
+    }
+    thrift.fieldI64(2, static_cast<int64_t>(uncompressed));     // total_byte_size
+    thrift.fieldI64(3, static_cast<int64_t>(rows));
+    thrift.fieldI64(5, static_cast<int64_t>(fileOffset));
+    thrift.fieldI64(6, static_cast<int64_t>(compressed));
+    thrift.endStruct();
+    row_groups_.push_back(std::move(rowGroup));
+
+    rows_written_ += rows;
+    pending_ = RecordBatch();
+}
+
+ParquetWriter::ChunkMetadata ParquetWriter::writeColumnChunk(const ColumnSchema& schema, const Column* column,
+                                                             size_t rows) {
+    // Definition level 1 marks a value; absent and null cells are 0
+    std::vector<uint32_t> defs(rows, 0);
+    EncodedChunk chunk;
+
+    if (schema.physical_type == BOOLEAN) {
+        std::vector<uint32_t> values;
+        for (size_t row = 0; column && row < rows; ++row) {
+            if (!column->isPresent(row)) continue;
+            if (column->type() == ColumnType::BOOL) {
+                values.push_back(column->boolAt(row));
+            } else if (column->type() == ColumnType::JSON && column->jsonAt(row).is_boolean()) {
+                values.push_back(column->jsonAt(row).get<bool>());
+            } else {
+                throw conversionError(schema.name, row, "BOOLEAN");
+            }
+            defs[row] = 1;
+        }
+        chunk = encodeBooleanChunk(values, defs, options_);
+    } else if (schema.physical_type == INT64) {
+        std::vector<int64_t> values;
+        for (size_t row = 0; column && row < rows; ++row) {
+            if (!column->isPresent(row)) continue;
+            double number;
+            if (column->type() == ColumnType::INT) {
+                values.push_back(column->intAt(row));
+            } else if (column->type() == ColumnType::JSON && column->jsonAt(row).is_number_integer()) {
+                values.push_back(column->jsonAt(row).get<int64_t>());
+            } else if (column->numberAt(row, number) && std::floor(number) == number &&
+                       std::fabs(number) < 9.2e18) {
+                values.push_back(static_cast<int64_t>(number));
+            } else {
+                throw conversionError(schema.name, row, "INT64");
+            }
+            defs[row] = 1;
+        }
+        chunk = encodeChunk(values, defs, options_);
+    } else if (schema.physical_type == DOUBLE) {
+        std::vector<double> values;
+        for (size_t row = 0; column && row < rows; ++row) {
+            if (!column->isPresent(row)) continue;
+            double number;
+            if (!column->numberAt(row, number)) {
+                throw conversionError(schema.name, row, "DOUBLE");
+            }
+            values.push_back(number);
+            defs[row] = 1;
+        }
+        chunk = encodeChunk(values, defs, options_);
+    } else {
+        // Views into the column where it already holds the text
+        std::vector<std::string_view> values;
+        std::deque<std::string> owned;
+        for (size_t row = 0; column && row < rows; ++row) {
+            if (!column->isPresent(row)) continue;
+            if (!schema.json && column->type() == ColumnType::STRING) {
+                values.push_back(column->stringAt(row));
+            } else {
+                owned.push_back(schema.json ? column->valueAt(row).dump() : column->textAt(row));
+                values.push_back(owned.back());
+            }
+            defs[row] = 1;
+        }
+        chunk = encodeChunk(values, defs, options_);
+    }
+
+    const Codec* codec = nullptr;
+    if (codec_ == GZIP || codec_ == ZSTD) {
+        codec = &getCodec(options_.compression);
+    }
+    int level = codec && options_.compression_level >= 0 ? options_.compression_level
+                                                          : (codec ? codec->defaultLevel() : 0);
+
+    size_t chunkOffset = offset_;
+    size_t dataPageOffset = 0;
+    size_t uncompressed = 0;
+    size_t compressed = 0;
+    for (const auto& page : chunk.pages) {
+        std::string body;
+        if (codec) {
+            body = codec->compress(page.body, level);
+        } else if (codec_ == LZ4_RAW) {
+#ifdef HAVE_LZ4
+            body.resize(LZ4_compressBound(static_cast<int>(page.body.size())));
+            int size = LZ4_compress_default(page.body.data(), &body[0], static_cast<int>(page.body.size()),
+                                            static_cast<int>(body.size()));
+            if (size <= 0) {
+                // An empty body would still be described as the full page
+                throw std::runtime_error("LZ4 compression failed for Parquet column '" + schema.name + "'");
+            }
+            body.resize(size);
+#endif
+        } else {
+            body = page.body;
+        }
+
+        std::string header;
+        ThriftWriter thrift(header);
+        thrift.beginStruct();
+        thrift.fieldI32(1, page.dictionary ? DICTIONARY_PAGE : DATA_PAGE);
+        thrift.fieldI32(2, static_cast<int32_t>(page.body.size()));
+        thrift.fieldI32(3, static_cast<int32_t>(body.size()));
+        if (page.dictionary) {
+            thrift.beginStructField(7);
+            thrift.fieldI32(1, static_cast<int32_t>(page.num_values));
+            thrift.fieldI32(2, PLAIN);
+            thrift.endStruct();
+        } else {
+            if (dataPageOffset == 0) {
+                dataPageOffset = offset_;
+            }
+            thrift.beginStructField(5);
+            thrift.fieldI32(1, static_cast<int32_t>(page.num_values));
+            thrift.fieldI32(2, chunk.dictionary_encoded ? RLE_DICTIONARY : PLAIN);
+            thrift.fieldI32(3, RLE);                            // definition levels
+            thrift.fieldI32(4, RLE);                            // repetition levels (none here)
+            thrift.endStruct();
+        }
+        thrift.endStruct();
+
+        uncompressed += header.size() + page.body.size();
+        compressed += header.size() + body.size();
+        emit(header);
+        emit(body);
+    }
+
+    ChunkMetadata metadata;
+    metadata.uncompressed_bytes = uncompressed;
+    metadata.compressed_bytes = compressed;
+
+    ThriftWriter thrift(metadata.column_chunk);
+    thrift.beginStruct();
+    thrift.fieldI64(2, static_cast<int64_t>(chunkOffset));      // file_offset
+    thrift.beginStructField(3);                                 // meta_data
+    thrift.fieldI32(1, schema.physical_type);
+    if (chunk.dictionary_encoded) {
+        thrift.beginListField(2, ThriftWriter::I32, 3);
+        thrift.listI32(PLAIN);
+        thrift.listI32(RLE);
+        thrift.listI32(RLE_DICTIONARY);
+    } else {
+        thrift.beginListField(2, ThriftWriter::I32, 2);
+        thrift.listI32(PLAIN);
+        thrift.listI32(RLE);
+    }
+    thrift.beginListField(3, ThriftWriter::BINARY, 1);
+    thrift.listBinary(schema.name);
+    thrift.fieldI32(4, codec_);
+    thrift.fieldI64(5, static_cast<int64_t>(rows));
+    thrift.fieldI64(6, static_cast<int64_t>(uncompressed));
+    thrift.fieldI64(7, static_cast<int64_t>(compressed));
+    thrift.fieldI64(9, static_cast<int64_t>(dataPageOffset));
+    if (chunk.dictionary_encoded) {
+        thrift.fieldI64(11, static_cast<int64_t>(chunkOffset));
+    }
+    thrift.beginStructField(12);                                // statistics
+    thrift.fieldI64(3, static_cast<int64_t>(chunk.statistics.null_count));
+    if (chunk.statistics.has_min_max) {
+        thrift.fieldBinary(5, chunk.statistics.max);
+        thrift.fieldBinary(6, chunk.statistics.min);
+    }
+    thrift.endStruct();
+    thrift.endStruct();
+    thrift.endStruct();
+    return metadata;
+}
+
+void ParquetWriter::emit(const std::string& bytes) {
+    if (file_ && !file_->is_open()) {
+        file_->open(path_, std::ios::binary | std::ios::app);   // After suspend()
+        if (!*file_) {
+            throw std::runtime_error("Cannot reopen file for writing: " + path_);
+        }
+    }
+    output_->write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    if (!*output_) {
+        throw std::runtime_error("Error writing Parquet output");
+    }
+    offset_ += bytes.size();
+}
+
+} // namespace etl
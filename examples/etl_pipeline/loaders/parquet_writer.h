@@ -0,0 +1,88 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <iosfwd>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include "processors/record_batch.h"
+
+namespace etl {
+
+struct ParquetWriterOptions {
+    size_t row_group_rows = 128 * 1024;         // Rows buffered before a row group is written
+    size_t data_page_bytes = 1 << 20;           // Target encoded size of one data page
+    size_t dictionary_page_bytes = 1 << 20;     // Larger dictionaries fall back to PLAIN
+    // Page compression: "none", "gzip", "zstd", or "lz4" (written as LZ4_RAW)
+    std::string compression = "none";
+    int compression_level = -1;                 // Negative: the codec's default
+};
+
+// Writes records as a Parquet file (format version 1, flat schema). Every
+// column is OPTIONAL, with absent and null cells both stored as null:
+//   BOOL -> BOOLEAN, INT -> INT64, DOUBLE -> DOUBLE,
+//   STRING -> BYTE_ARRAY (UTF8), JSON -> BYTE_ARRAY (JSON text).
+// Each column chunk is dictionary encoded (RLE_DICTIONARY data pages after
+// a PLAIN dictionary page) unless its dictionary outgrows
+// dictionary_page_bytes, in which case it is PLAIN. Definition levels are
+// RLE encoded, pages are compressed one by one, and every chunk carries
+// min/max/null-count statistics.
+//
+// The schema is taken from the first row group. Later records may leave
+// columns out, and values convert to the column's type where that loses
+// nothing; a new column or an unconvertible value throws std::runtime_error.
+class ParquetWriter {
+public:
+    // Throws std::runtime_error if the file cannot be opened or the
+    // compression is not available for Parquet
+    ParquetWriter(const std::string& path, const ParquetWriterOptions& options = {});
+    ParquetWriter(std::ostream& output, const ParquetWriterOptions& options = {});
+    ~ParquetWriter();
+
+    ParquetWriter(const ParquetWriter&) = delete;
+    ParquetWriter& operator=(const ParquetWriter&) = delete;
+
+    void write(const RecordBatch& batch);
+    void writeRecord(const nlohmann::json& record);
+    // Writes the last row group and the footer; throws std::runtime_error
+    // on a write error. Called by the destructor if needed, ignoring errors.
+    void close();
+    // Closes a file opened by path until the next row group is written,
+    // which reopens it for append; buffered rows stay in memory. Throws
+    // std::runtime_error on a write error.
+    void suspend();
+
+    size_t rowsWritten() const { return rows_written_; }
+    size_t bytesWritten() const { return offset_; }
+
+    // Encodes batch as a complete Parquet file
+    static std::string encode(const RecordBatch& batch, const ParquetWriterOptions& options = {});
+
+private:
+    struct ColumnSchema {
+        std::string name;
+        int physical_type;
+        bool json;                              // BYTE_ARRAY holding JSON rather than UTF8 text
+    };
+    struct ChunkMetadata;
+
+    void init();
+    void flushRowGroup();
+    ChunkMetadata writeColumnChunk(const ColumnSchema& schema, const Column* column, size_t rows);
+    void emit(const std::string& bytes);
+
+    std::unique_ptr<std::ofstream> file_;
+    std::string path_;                          // Of file_, for reopening after suspend()
+    std::ostream* output_;
+    ParquetWriterOptions options_;
+    int codec_;                                 // Parquet CompressionCodec id
+    std::vector<ColumnSchema> schema_;
+    RecordBatch pending_;
+    std::vector<std::string> row_groups_;       // Serialized RowGroup structs for the footer
+    size_t rows_written_;
+    size_t offset_;
+    bool closed_;
+};
+
+} // namespace etl
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <stdexcept>
+#include <nlohmann/json.hpp>
+
+namespace etl {
+
+// Aggregations understood by DataTransformer::aggregateData and the
+// streaming aggregator; each output column is named "<field>_<function>".
+// sum, avg, min and max are null for a group with no numeric values, as
+// in SQL; count is the number of non-null values.
+enum class AggregateFunction { SUM, AVG, MIN, MAX, COUNT };
+
+struct AggregateSpec {
+    std::string field;
+    AggregateFunction function;
+    std::string output_name;
+};
+
+// Parses field -> function name ("sum", "avg"/"mean", "min", "max",
+// "count"); throws std::runtime_error for an unknown function
+inline std::vector<AggregateSpec> parseAggregateSpecs(const std::map<std::string, std::string>& aggregations) {
+    static const std::map<std::string, AggregateFunction> functions = {
+        {"sum", AggregateFunction::SUM}, {"avg", AggregateFunction::AVG},
+        {"mean", AggregateFunction::AVG}, {"min", AggregateFunction::MIN},
+        {"max", AggregateFunction::MAX}, {"count", AggregateFunction::COUNT}
+    };
+
+    std::vector<AggregateSpec> specs;
+    for (const auto& aggregation : aggregations) {
+        auto function = functions.find(aggregation.second);
+        if (function == functions.end()) {
+            throw std::runtime_error("Unknown aggregation: " + aggregation.second);
+        }
+        specs.push_back({aggregation.first, function->second, aggregation.first + "_" + aggregation.second});
+    }
+    return specs;
+}
+
+// Running state of one aggregation in one group. Plain data, so partial
+// states can be written to spill files as they are.
+struct Accumulator {
+    double sum = 0;
+    double min = 0;
+    double max = 0;
+    size_t numbers = 0;     // Values that sum/avg/min/max used
+    size_t values = 0;      // Non-null values, for count
+
+    void add(double value) {
+        sum += value;
+        min = numbers == 0 ? value : std::min(min, value);
+        max = numbers == 0 ? value : std::max(max, value);
+        numbers++;
+    }
+
+    void merge(const Accumulator& other) {
+        if (other.numbers > 0) {
+            min = numbers == 0 ? other.min : std::min(min, other.min);
+            max = numbers == 0 ? other.max : std::max(max, other.max);
+        }
+        sum += other.sum;
+        numbers += other.numbers;
+        values += other.values;
+    }
+
+    // Final value; null where the function has no input numbers
+    nlohmann::json result(AggregateFunction function) const {
+        switch (function) {
+            case AggregateFunction::COUNT: return values;
+            case AggregateFunction::SUM: return numbers ? nlohmann::json(sum) : nlohmann::json();
+            case AggregateFunction::AVG: return numbers ? nlohmann::json(sum / numbers) : nlohmann::json();
+            case AggregateFunction::MIN: return numbers ? nlohmann::json(min) : nlohmann::json();
+            case AggregateFunction::MAX: return numbers ? nlohmann::json(max) : nlohmann::json();
+        }
+        return nlohmann::json();
+    }
+};
+
+} // namespace etl
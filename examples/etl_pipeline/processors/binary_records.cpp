@@ -0,0 +1,527 @@
+#include "binary_records.h"
+#include <ostream>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <limits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace etl {
+
+namespace {
+
+const char MAGIC[] = "ETLB";
+constexpr uint8_t FORMAT_VERSION = 1;
+constexpr size_t HEADER_SIZE = 5;
+
+// The writer hands its buffer to the sink in pieces of about this size
+constexpr size_t FLUSH_BYTES = 1 << 20;
+
+void appendVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+BinaryFieldType fieldTypeOf(ColumnType type) {
+    switch (type) {
+        case ColumnType::NULL_TYPE: return BinaryFieldType::NULL_TYPE;
+        case ColumnType::BOOL: return BinaryFieldType::BOOL;
+        case ColumnType::INT: return BinaryFieldType::INT;
+        case ColumnType::DOUBLE: return BinaryFieldType::DOUBLE;
+        case ColumnType::STRING: return BinaryFieldType::STRING;
+        default: return BinaryFieldType::JSON;
+    }
+}
+
+// The field type of value, as a one-row RecordBatch column of it would have
+BinaryFieldType fieldTypeOf(const nlohmann::json& value) {
+    switch (value.type()) {
+        case nlohmann::json::value_t::null: return BinaryFieldType::NULL_TYPE;
+        case nlohmann::json::value_t::boolean: return BinaryFieldType::BOOL;
+        case nlohmann::json::value_t::number_integer: return BinaryFieldType::INT;
+        case nlohmann::json::value_t::number_unsigned:
+            return value.get<uint64_t>() <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max())
+                ? BinaryFieldType::INT : BinaryFieldType::JSON;
+        case nlohmann::json::value_t::number_float: return BinaryFieldType::DOUBLE;
+        case nlohmann::json::value_t::string: return BinaryFieldType::STRING;
+        default: return BinaryFieldType::JSON;
+    }
+}
+
+// Type that can hold the values of both; differing scalars become JSON text
+BinaryFieldType mergeTypes(BinaryFieldType a, BinaryFieldType b) {
+    if (a == b || b == BinaryFieldType::NULL_TYPE) return a;
+    if (a == BinaryFieldType::NULL_TYPE) return b;
+    return BinaryFieldType::JSON;
+}
+
+bool isText(BinaryFieldType type) {
+    return type == BinaryFieldType::STRING || type == BinaryFieldType::JSON;
+}
+
+// One row of a batch, by schema position; null columns are absent
+struct BatchCells {
+    const std::vector<const Column*>& columns;
+    size_t row;
+
+    Column::CellState state(size_t i) const { return columns[i] ? columns[i]->state(row) : Column::ABSENT; }
+    bool boolAt(size_t i) const { return columns[i]->boolAt(row); }
+    int64_t intAt(size_t i) const { return columns[i]->intAt(row); }
+    double doubleAt(size_t i) const { return columns[i]->doubleAt(row); }
+    std::string_view stringAt(size_t i) const { return columns[i]->stringAt(row); }
+    // The column may be of any type the schema merged into JSON
+    std::string jsonText(size_t i) const {
+        const Column& column = *columns[i];
+        return column.type() == ColumnType::JSON ? column.jsonAt(row).dump() : column.valueAt(row).dump();
+    }
+};
+
+// The fields of a JSON object, by schema position; null pointers are absent
+struct RecordCells {
+    const std::vector<const nlohmann::json*>& values;
+
+    Column::CellState state(size_t i) const {
+        return !values[i] ? Column::ABSENT : values[i]->is_null() ? Column::NULL_VALUE : Column::PRESENT;
+    }
+    bool boolAt(size_t i) const { return values[i]->get<bool>(); }
+    int64_t intAt(size_t i) const { return values[i]->get<int64_t>(); }
+    double doubleAt(size_t i) const { return values[i]->get<double>(); }
+    std::string_view stringAt(size_t i) const { return values[i]->get_ref<const std::string&>(); }
+    std::string jsonText(size_t i) const { return values[i]->dump(); }
+};
+
+} // namespace
+
+bool isBinaryRecords(std::string_view data) {
+    return data.size() >= HEADER_SIZE && data.compare(0, 4, MAGIC) == 0;
+}
+
+BinaryRecordWriter::BinaryRecordWriter(std::string& out, std::ostream* sink)
+    : out_(out), sink_(sink), records_(0), bytes_(0) {
+    std::string header(MAGIC, 4);
+    header += static_cast<char>(FORMAT_VERSION);
+    emit(header);
+}
+
+void BinaryRecordWriter::write(const RecordBatch& batch) {
+    bool changed = false;
+    column_of_.clear();
+    for (const auto& column : batch.columns()) {
+        column_of_.push_back(adoptField(column.name(), fieldTypeOf(column.type()), changed));
+    }
+    if (changed) {
+        writeSchema();
+    }
+    
+    sources_.assign(schema_.size(), nullptr);
+    for (size_t c = 0; c < column_of_.size(); ++c) {
+        sources_[column_of_[c]] = &batch.columns()[c];
+    }
+    for (size_t row = 0; row < batch.numRows(); ++row) {
+        writeBody(BatchCells{sources_, row});
+    }
+}
+
+void BinaryRecordWriter::writeRecord(const nlohmann::json& record) {
+    if (!record.is_object()) {
+        throw std::runtime_error("Record is not a JSON object");
+    }
+    
+    bool changed = false;
+    column_of_.clear();
+    for (auto it = record.begin(); it != record.end(); ++it) {
+        column_of_.push_back(adoptField(it.key(), fieldTypeOf(it.value()), changed));
+    }
+    if (changed) {
+        writeSchema();
+    }
+    
+    values_.assign(schema_.size(), nullptr);
+    size_t c = 0;
+    for (auto it = record.begin(); it != record.end(); ++it) {
+        values_[column_of_[c++]] = &it.value();
+    }
+    writeBody(RecordCells{values_});
+}
+
+void BinaryRecordWriter::flush() {
+    if (sink_ && !out_.empty()) {
+        sink_->write(out_.data(), static_cast<std::streamsize>(out_.size()));
+        out_.clear();
+    }
+}
+
+std::string BinaryRecordWriter::encode(const RecordBatch& batch) {
+    std::string out;
+    BinaryRecordWriter writer(out);
+    writer.write(batch);
+    return out;
+}
+
+size_t BinaryRecordWriter::adoptField(const std::string& name, BinaryFieldType type, bool& changed) {
+    auto found = index_.find(name);
+    if (found == index_.end()) {
+        index_.emplace(name, schema_.size());
+        schema_.push_back({name, type});
+        changed = true;
+        return schema_.size() - 1;
+    }
+    BinaryField& field = schema_[found->second];
+    BinaryFieldType merged = mergeTypes(field.type, type);
+    changed = changed || merged != field.type;
+    field.type = merged;
+    return found->second;
+}
+
+void BinaryRecordWriter::writeSchema() {
+    record_.clear();
+    appendVarint(record_, schema_.size());
+    for (const auto& field : schema_) {
+        record_ += static_cast<char>(field.type);
+        appendVarint(record_, field.name.size());
+        record_ += field.name;
+    }
+    emitLength((record_.size() << 1) | 1);
+    emit(record_);
+}
+
+template <typename Cells>
+void BinaryRecordWriter::writeBody(const Cells& cells) {
+    const size_t stateBytes = (schema_.size() + 3) / 4;
+    record_.assign(stateBytes, '\0');
+    heap_.clear();
+    for (size_t i = 0; i < schema_.size(); ++i) {
+        Column::CellState state = cells.state(i);
+        record_[i / 4] = static_cast<char>(record_[i / 4] | (state << (2 * (i % 4))));
+        if (state != Column::PRESENT) continue;
+
+        switch (schema_[i].type) {
+            case BinaryFieldType::BOOL:
+                record_ += static_cast<char>(cells.boolAt(i) ? 1 : 0);
+                break;
+            case BinaryFieldType::INT: {
+                int64_t value = cells.intAt(i);
+                appendVarint(record_, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+                break;
+            }
+            case BinaryFieldType::DOUBLE: {
+                double value = cells.doubleAt(i);
+                char bytes[8];
+                std::memcpy(bytes, &value, 8);
+                record_.append(bytes, 8);
+                break;
+            }
+            case BinaryFieldType::STRING: {
+                std::string_view value = cells.stringAt(i);
+                appendVarint(record_, value.size());
+                heap_.append(value.data(), value.size());
+                break;
+            }
+            default: {
+                std::string value = cells.jsonText(i);
+                appendVarint(record_, value.size());
+                heap_ += value;
+                break;
+            }
+        }
+    }
+    record_ += heap_;
+
+    emitLength(record_.size() << 1);
+    emit(record_);
+    records_++;
+}
+
+void BinaryRecordWriter::emitLength(size_t value) {
+    char bytes[10];
+    size_t n = 0;
+    while (value >= 0x80) {
+        bytes[n++] = static_cast<char>((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    bytes[n++] = static_cast<char>(value);
+    emit(std::string_view(bytes, n));
+}
+
+void BinaryRecordWriter::emit(std::string_view bytes) {
+    out_.append(bytes.data(), bytes.size());
+    bytes_ += bytes.size();
+    if (sink_ && out_.size() >= FLUSH_BYTES) {
+        flush();
+    }
+}
+
+nlohmann::json BinaryRecordView::valueAt(size_t i) const {
+    if (cells_[i].state != Column::PRESENT) {
+        return nlohmann::json();
+    }
+    switch ((*schema_)[i].type) {
+        case BinaryFieldType::BOOL: return boolAt(i);
+        case BinaryFieldType::INT: return intAt(i);
+        case BinaryFieldType::DOUBLE: return doubleAt(i);
+        case BinaryFieldType::STRING: return std::string(stringAt(i));
+        case BinaryFieldType::JSON: return nlohmann::json::parse(stringAt(i));
+        default: return nlohmann::json();
+    }
+}
+
+nlohmann::json BinaryRecordView::toJson() const {
+    nlohmann::json record = nlohmann::json::object();
+    for (size_t i = 0; i < cells_.size(); ++i) {
+        if (cells_[i].state != Column::ABSENT) {
+            record[(*schema_)[i].name] = valueAt(i);
+        }
+    }
+    return record;
+}
+
+BinaryRecordReader::BinaryRecordReader(std::string_view data)
+    : data_(data), pos_(0), schema_version_(0), record_count_(0), mapping_(nullptr), mapping_length_(0) {
+    if (!isBinaryRecords(data_)) {
+        fail("not a binary record file");
+    }
+    if (static_cast<uint8_t>(data_[4]) != FORMAT_VERSION) {
+        fail("unsupported format version " + std::to_string(static_cast<uint8_t>(data_[4])));
+    }
+    pos_ = HEADER_SIZE;
+}
+
+BinaryRecordReader::BinaryRecordReader(void* mapping, size_t length)
+    : BinaryRecordReader(std::string_view(static_cast<const char*>(mapping), length)) {
+    mapping_ = mapping;
+    mapping_length_ = length;
+}
+
+BinaryRecordReader::~BinaryRecordReader() {
+    if (mapping_) {
+        munmap(mapping_, mapping_length_);
+    }
+}
+
+std::unique_ptr<BinaryRecordReader> BinaryRecordReader::openFile(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open binary record file: " + path + ": " + std::strerror(errno));
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        int err = errno;
+        ::close(fd);
+        throw std::runtime_error("Cannot read binary record file: " + path +
+                                 (st.st_size == 0 ? ": empty file" : ": " + std::string(std::strerror(err))));
+    }
+
+    size_t length = static_cast<size_t>(st.st_size);
+    void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    int err = errno;
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Cannot map binary record file: " + path + ": " + std::strerror(err));
+    }
+
+    madvise(mapping, length, MADV_SEQUENTIAL);
+    try {
+        return std::unique_ptr<BinaryRecordReader>(new BinaryRecordReader(mapping, length));
+    } catch (...) {
+        munmap(mapping, length);
+        throw;
+    }
+}
+
+bool BinaryRecordReader::next(BinaryRecordView& record) {
+    while (pos_ < data_.size()) {
+        uint64_t header = readVarint();
+        size_t length = static_cast<size_t>(header >> 1);
+        if (length > data_.size() - pos_) {
+            fail("truncated entry");
+        }
+        size_t end = pos_ + length;
+        if (header & 1) {
+            readSchema(end);
+            continue;
+        }
+
+        const size_t fields = schema_.size();
+        const size_t stateBytes = (fields + 3) / 4;
+        if (length < stateBytes) {
+            fail("truncated record");
+        }
+        const uint8_t* states = reinterpret_cast<const uint8_t*>(data_.data() + pos_);
+        size_t p = pos_ + stateBytes;
+        auto varint = [&]() {
+            uint64_t value = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                if (p >= end) fail("truncated record");
+                uint8_t byte = static_cast<uint8_t>(data_[p++]);
+                value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+                if (byte < 0x80) return value;
+            }
+            fail("varint too long");
+        };
+
+        record.schema_ = &schema_;
+        record.cells_.resize(fields);
+        for (size_t i = 0; i < fields; ++i) {
+            auto& cell = record.cells_[i];
+            cell.state = static_cast<Column::CellState>((states[i / 4] >> (2 * (i % 4))) & 3);
+            cell.text = std::string_view();
+            if (cell.state > Column::PRESENT) {
+                fail("bad cell state");
+            }
+            if (cell.state != Column::PRESENT) continue;
+
+            switch (schema_[i].type) {
+                case BinaryFieldType::BOOL:
+                    if (p >= end) fail("truncated record");
+                    cell.int_value = data_[p++] != 0;
+                    break;
+                case BinaryFieldType::INT: {
+                    uint64_t value = varint();
+                    cell.int_value = static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1));
+                    break;
+                }
+                case BinaryFieldType::DOUBLE:
+                    if (end - p < 8) fail("truncated record");
+                    std::memcpy(&cell.double_value, data_.data() + p, 8);
+                    p += 8;
+                    break;
+                case BinaryFieldType::STRING:
+                case BinaryFieldType::JSON:
+                    // Length for now; placed in the heap once its start is known
+                    cell.text = std::string_view(nullptr, static_cast<size_t>(varint()));
+                    break;
+                default:
+                    fail("value in a NULL_TYPE field");
+            }
+        }
+
+        size_t heap = p;
+        for (size_t i = 0; i < fields; ++i) {
+            auto& cell = record.cells_[i];
+            if (cell.state != Column::PRESENT || !isText(schema_[i].type)) continue;
+            if (cell.text.size() > end - heap) {
+                fail("string runs past its record");
+            }
+            cell.text = std::string_view(data_.data() + heap, cell.text.size());
+            heap += cell.text.size();
+        }
+
+        pos_ = end;
+        record_count_++;
+        return true;
+    }
+    return false;
+}
+
+RecordBatch BinaryRecordReader::readBatch(size_t maxRows) {
+    std::vector<Column> columns;
+    std::unordered_map<std::string, size_t> indexOf;
+    std::vector<size_t> columnOf;
+    size_t version = 0;
+    size_t rows = 0;
+
+    BinaryRecordView record;
+    while (rows < maxRows && next(record)) {
+        if (columnOf.empty() || version != schema_version_) {
+            version = schema_version_;
+            columnOf.clear();
+            for (const auto& field : schema_) {
+                auto inserted = indexOf.emplace(field.name, columns.size());
+                if (inserted.second) {
+                    columns.emplace_back(field.name);
+                    for (size_t row = 0; row < rows; ++row) {
+                        columns.back().appendAbsent();
+                    }
+                }
+                columnOf.push_back(inserted.first->second);
+            }
+        }
+
+        for (size_t i = 0; i < record.size(); ++i) {
+            Column& column = columns[columnOf[i]];
+            switch (record.state(i)) {
+                case Column::ABSENT:
+                    column.appendAbsent();
+                    break;
+                case Column::NULL_VALUE:
+                    column.append(nlohmann::json());
+                    break;
+                default:
+                    if (schema_[i].type == BinaryFieldType::STRING) {
+                        column.appendString(record.stringAt(i));
+                    } else {
+                        column.append(record.valueAt(i));
+                    }
+                    break;
+            }
+        }
+        rows++;
+        // Columns of an earlier schema that this record's schema lacks
+        for (auto& column : columns) {
+            if (column.size() < rows) {
+                column.appendAbsent();
+            }
+        }
+    }
+    if (columns.empty()) {
+        // Records with no fields are still rows
+        RecordBatch batch;
+        for (size_t row = 0; row < rows; ++row) {
+            batch.appendRecord(nlohmann::json::object());
+        }
+        return batch;
+    }
+    return RecordBatch::fromColumns(std::move(columns));
+}
+
+uint64_t BinaryRecordReader::readVarint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (pos_ >= data_.size()) fail("truncated entry");
+        uint8_t byte = static_cast<uint8_t>(data_[pos_++]);
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (byte < 0x80) return value;
+    }
+    fail("varint too long");
+}
+
+void BinaryRecordReader::readSchema(size_t end) {
+    std::string_view full = data_;
+    data_ = data_.substr(0, end);       // Bounds the varint reads below
+
+    // A field takes at least two bytes (type and name length), which bounds
+    // the count before anything is allocated for it
+    uint64_t count = readVarint();
+    if (count > (end - pos_) / 2) fail("field count exceeds schema entry");
+    std::vector<BinaryField> schema(static_cast<size_t>(count));
+    for (auto& field : schema) {
+        if (pos_ >= end) fail("truncated schema");
+        uint8_t type = static_cast<uint8_t>(data_[pos_++]);
+        if (type > static_cast<uint8_t>(BinaryFieldType::JSON)) fail("unknown field type");
+        field.type = static_cast<BinaryFieldType>(type);
+        size_t length = static_cast<size_t>(readVarint());
+        if (length > end - pos_) fail("truncated schema");
+        field.name.assign(data_.data() + pos_, length);
+        pos_ += length;
+    }
+
+    data_ = full;
+    if (pos_ != end) {
+        fail("schema entry has trailing bytes");
+    }
+    schema_ = std::move(schema);
+    schema_version_++;
+}
+
+void BinaryRecordReader::fail(const std::string& message) const {
+    throw std::runtime_error("Binary record error at byte " + std::to_string(pos_) + ": " + message);
+}
+
+} // namespace etl
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <iosfwd>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include "record_batch.h"
+
+namespace etl {
+
+// Compact binary rows for handing records between pipeline stages.
+//
+//   file    := "ETLB" version:u8 entry*
+//   entry   := varint((length << 1) | is_schema) body[length]
+//   schema  := varint(count) (type:u8 varint(name_length) name)*
+//   record  := states values heap
+//
+// A schema entry applies to the records after it; the writer emits a new
+// one whenever records bring a new column or a conflicting type. states
+// has 2 bits per schema column (0 absent, 1 null, 2 present), low bits
+// first. values holds the present cells in schema order: BOOL as one byte,
+// INT as a zigzag varint, DOUBLE as 8 little-endian bytes, STRING and JSON
+// (JSON text) as a varint length whose bytes sit at the running offset in
+// heap. Records can be skipped without decoding them.
+enum class BinaryFieldType : uint8_t {
+    NULL_TYPE = 0,      // Never present
+    BOOL = 1,
+    INT = 2,
+    DOUBLE = 3,
+    STRING = 4,
+    JSON = 5
+};
+
+struct BinaryField {
+    std::string name;
+    BinaryFieldType type;
+};
+
+// True if data starts with the format's magic
+bool isBinaryRecords(std::string_view data);
+
+// Encodes records, appending to out; with a sink, out is flushed to it as
+// it fills
+class BinaryRecordWriter {
+public:
+    explicit BinaryRecordWriter(std::string& out, std::ostream* sink = nullptr);
+
+    void write(const RecordBatch& batch);
+    // Encodes the object directly, as write() would a one-row batch of it;
+    // throws std::runtime_error if it is not an object
+    void writeRecord(const nlohmann::json& record);
+    // Hands what is buffered to the sink
+    void flush();
+
+    size_t recordsWritten() const { return records_; }
+    size_t bytesWritten() const { return bytes_; }
+
+    static std::string encode(const RecordBatch& batch);
+
+private:
+    // Makes the schema cover a field of type, marking changed if it had to
+    // grow; returns the field's schema position
+    size_t adoptField(const std::string& name, BinaryFieldType type, bool& changed);
+    void writeSchema();
+    // Encodes one record from cells, which reads the schema's fields by
+    // position (see the two callers), and emits it
+    template <typename Cells>
+    void writeBody(const Cells& cells);
+    void emitLength(size_t value);
+    void emit(std::string_view bytes);
+
+    std::string& out_;
+    std::ostream* sink_;
+    std::vector<BinaryField> schema_;
+    std::unordered_map<std::string, size_t> index_;
+    // Scratch kept across records, so encoding one allocates nothing once
+    // they have grown
+    std::vector<size_t> column_of_;             // Batch column or record field -> schema position
+    std::vector<const Column*> sources_;        // Schema position -> batch column, if any
+    std::vector<const nlohmann::json*> values_; // Schema position -> record value, if any
+    std::string record_;                        // One encoded body
+    std::string heap_;
+    size_t records_;
+    size_t bytes_;
+};
+
+// One decoded record; strings are views into the reader's input and stay
+// valid as long as it does
+class BinaryRecordView {
+public:
+    size_t size() const { return cells_.size(); }
+    const std::vector<BinaryField>& schema() const { return *schema_; }
+
+    Column::CellState state(size_t i) const { return cells_[i].state; }
+    bool isPresent(size_t i) const { return cells_[i].state == Column::PRESENT; }
+
+    // Typed access; valid only for present cells of a field of that type
+    bool boolAt(size_t i) const { return cells_[i].int_value != 0; }
+    int64_t intAt(size_t i) const { return cells_[i].int_value; }
+    double doubleAt(size_t i) const { return cells_[i].double_value; }
+    // STRING text or JSON text
+    std::string_view stringAt(size_t i) const { return cells_[i].text; }
+
+    nlohmann::json valueAt(size_t i) const;     // null for absent and null cells
+    nlohmann::json toJson() const;              // The record, absent fields left out
+
+private:
+    friend class BinaryRecordReader;
+
+    struct Cell {
+        Column::CellState state;
+        int64_t int_value;
+        double double_value;
+        std::string_view text;
+    };
+
+    const std::vector<BinaryField>* schema_ = nullptr;
+    std::vector<Cell> cells_;
+};
+
+// Reads records from a buffer the caller keeps alive, or from a
+// memory-mapped file. Malformed input throws std::runtime_error.
+class BinaryRecordReader {
+public:
+    explicit BinaryRecordReader(std::string_view data);
+    ~BinaryRecordReader();
+
+    BinaryRecordReader(const BinaryRecordReader&) = delete;
+    BinaryRecordReader& operator=(const BinaryRecordReader&) = delete;
+
+    static std::unique_ptr<BinaryRecordReader> openFile(const std::string& path);
+
+    // Decodes the next record into record; returns false at end of input
+    bool next(BinaryRecordView& record);
+    // Up to maxRows further records as a batch; empty at end of input
+    RecordBatch readBatch(size_t maxRows);
+
+    const std::vector<BinaryField>& schema() const { return schema_; }
+    size_t recordCount() const { return record_count_; }
+
+private:
+    BinaryRecordReader(void* mapping, size_t length);
+
+    uint64_t readVarint();
+    void readSchema(size_t end);
+    [[noreturn]] void fail(const std::string& message) const;
+
+    std::string_view data_;
+    size_t pos_;
+    std::vector<BinaryField> schema_;
+    size_t schema_version_;                     // Bumped by every schema entry
+    size_t record_count_;
+    void* mapping_;
+    size_t mapping_length_;
+};
+
+} // namespace etl
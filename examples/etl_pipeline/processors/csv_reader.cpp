@@ -0,0 +1,295 @@
+#include "csv_reader.h"
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace etl {
+
+namespace {
+
+// A mapped file's pages are dropped from RSS once this much has been parsed
+constexpr size_t RELEASE_INTERVAL = 64 << 20;
+
+} // namespace
+
+CsvReader::CsvReader(std::string_view data, const CsvReaderOptions& options)
+    : options_(options), data_(data), pos_(0), record_number_(0), consumed_total_(0),
+      input_(nullptr), eof_(true), mapping_(nullptr), mapping_length_(0), released_(0) {}
+
+CsvReader::CsvReader(std::istream& input, const CsvReaderOptions& options)
+    : options_(options), pos_(0), record_number_(0), consumed_total_(0),
+      input_(&input), eof_(false), mapping_(nullptr), mapping_length_(0), released_(0) {
+    if (options_.chunk_size == 0) {
+        options_.chunk_size = CsvReaderOptions().chunk_size;
+    }
+}
+
+CsvReader::CsvReader(void* mapping, size_t length, const CsvReaderOptions& options)
+    : CsvReader(std::string_view(static_cast<const char*>(mapping), length), options) {
+    mapping_ = mapping;
+    mapping_length_ = length;
+}
+
+CsvReader::~CsvReader() {
+    if (mapping_) {
+        munmap(mapping_, mapping_length_);
+    }
+}
+
+std::unique_ptr<CsvReader> CsvReader::openFile(const std::string& path, const CsvReaderOptions& options) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open CSV file: " + path + ": " + std::strerror(errno));
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int err = errno;
+        ::close(fd);
+        throw std::runtime_error("Cannot stat CSV file: " + path + ": " + std::strerror(err));
+    }
+
+    size_t length = static_cast<size_t>(st.st_size);
+    if (length == 0) {
+        ::close(fd);
+        return std::unique_ptr<CsvReader>(new CsvReader(std::string_view(), options));
+    }
+
+    void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    int err = errno;
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Cannot map CSV file: " + path + ": " + std::strerror(err));
+    }
+
+    // Pages are read once, front to back
+    madvise(mapping, length, MADV_SEQUENTIAL);
+    return std::unique_ptr<CsvReader>(new CsvReader(mapping, length, options));
+}
+
+bool CsvReader::next(CsvRow& row) {
+    if (mapping_ && pos_ - released_ >= RELEASE_INTERVAL) {
+        releaseConsumedPages();
+    }
+
+    while (true) {
+        ParseStatus status = parseRecord(row);
+
+        if (status == ParseStatus::END) {
+            row.fields.clear();
+            return false;
+        }
+        if (status == ParseStatus::INCOMPLETE) {
+            refill();
+            continue;
+        }
+
+        if (options_.skip_empty_lines && row.spans_.size() == 1 &&
+            row.spans_[0].begin == row.spans_[0].end && !row.spans_[0].unescaped) {
+            // A bare line break; a quoted "" is a real (empty) field and is kept
+            size_t begin = row.spans_[0].begin;
+            if (begin == 0 || data_[begin - 1] != '"') {
+                continue;
+            }
+        }
+
+        record_number_++;
+        row.fields.clear();
+        row.fields.reserve(row.spans_.size());
+        for (const auto& span : row.spans_) {
+            const char* base = span.unescaped ? row.unescaped_.data() : data_.data();
+            row.fields.emplace_back(base + span.begin, span.end - span.begin);
+        }
+        return true;
+    }
+}
+
+CsvReader::ParseStatus CsvReader::parseRecord(CsvRow& row) {
+    row.spans_.clear();
+    row.unescaped_.clear();
+
+    const char* data = data_.data();
+    const size_t n = data_.size();
+    const char delimiter = options_.delimiter;
+    size_t p = pos_;
+
+    if (p >= n) {
+        return eof_ ? ParseStatus::END : ParseStatus::INCOMPLETE;
+    }
+
+    while (true) {
+        if (p < n && data[p] == '"') {
+            // Quoted field: runs to the next quote that is not part of a "" pair
+            size_t start = ++p;
+            bool escaped = false;
+            size_t scratchStart = 0;
+
+            while (true) {
+                const void* found = p < n ? std::memchr(data + p, '"', n - p) : nullptr;
+                if (!found) {
+                    if (eof_) {
+                        throw std::runtime_error("CSV parse error in record " +
+                                                 std::to_string(record_number_ + 1) +
+                                                 ": unterminated quoted field");
+                    }
+                    return ParseStatus::INCOMPLETE;
+                }
+
+                size_t q = static_cast<const char*>(found) - data;
+                if (q + 1 >= n && !eof_) {
+                    return ParseStatus::INCOMPLETE;   // Can't tell "" from a closing quote yet
+                }
+
+                if (q + 1 < n && data[q + 1] == '"') {
+                    if (!escaped) {
+                        escaped = true;
+                        scratchStart = row.unescaped_.size();
+                    }
+                    row.unescaped_.append(data + start, q + 1 - start);
+                    p = q + 2;
+                    start = p;
+                    continue;
+                }
+
+                if (escaped) {
+                    row.unescaped_.append(data + start, q - start);
+                    row.spans_.push_back({scratchStart, row.unescaped_.size(), true});
+                } else {
+                    row.spans_.push_back({start, q, false});
+                }
+                p = q + 1;
+                break;
+            }
+
+            if (p >= n) {
+                break;                                  // Last record, no trailing newline
+            }
+
+            char c = data[p];
+            if (c == delimiter) {
+                p++;
+                continue;
+            }
+            if (c == '\n') {
+                p++;
+                break;
+            }
+            if (c == '\r') {
+                if (p + 1 >= n && !eof_) {
+                    return ParseStatus::INCOMPLETE;
+                }
+                p += (p + 1 < n && data[p + 1] == '\n') ? 2 : 1;
+                break;
+            }
+
+            throw std::runtime_error("CSV parse error in record " + std::to_string(record_number_ + 1) +
+                                     ": unexpected character after closing quote");
+        }
+
+        // Unquoted field: a stray quote inside it is kept as a literal
+        size_t q = findSpecial(p);
+        if (q >= n) {
+            if (!eof_) {
+                return ParseStatus::INCOMPLETE;
+            }
+            row.spans_.push_back({p, n, false});
+            p = n;
+            break;
+        }
+
+        row.spans_.push_back({p, q, false});
+        char c = data[q];
+        if (c == delimiter) {
+            p = q + 1;
+            continue;
+        }
+        if (c == '\r') {
+            if (q + 1 >= n && !eof_) {
+                return ParseStatus::INCOMPLETE;
+            }
+            p = (q + 1 < n && data[q + 1] == '\n') ? q + 2 : q + 1;
+            break;
+        }
+        p = q + 1;                                      // '\n'
+        break;
+    }
+
+    pos_ = p;
+    return ParseStatus::RECORD;
+}
+
+size_t CsvReader::findSpecial(size_t from) const {
+    const char* data = data_.data();
+    const size_t n = data_.size();
+    const char delimiter = options_.delimiter;
+    size_t p = from;
+
+#ifdef __SSE2__
+    // Compare 16 bytes at a time against the three characters that end an
+    // unquoted field
+    const __m128i delim = _mm_set1_epi8(delimiter);
+    const __m128i lf = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+    while (p + 16 <= n) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + p));
+        __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, delim),
+                                                 _mm_cmpeq_epi8(chunk, lf)),
+                                    _mm_cmpeq_epi8(chunk, cr));
+        int mask = _mm_movemask_epi8(hits);
+        if (mask != 0) {
+            return p + __builtin_ctz(static_cast<unsigned>(mask));
+        }
+        p += 16;
+    }
+#endif
+
+    for (; p < n; ++p) {
+        char c = data[p];
+        if (c == delimiter || c == '\n' || c == '\r') {
+            return p;
+        }
+    }
+    return n;
+}
+
+void CsvReader::releaseConsumedPages() {
+    // Everything before pos_ has been returned, and the previous row's views
+    // are invalidated by this call anyway
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t end = pos_ / page * page;
+    if (end > released_) {
+        madvise(static_cast<char*>(mapping_) + released_, end - released_, MADV_DONTNEED);
+        released_ = end;
+    }
+}
+
+bool CsvReader::refill() {
+    // Keep the partial record, drop everything already returned
+    if (pos_ > 0) {
+        buffer_.erase(0, pos_);
+        consumed_total_ += pos_;
+        pos_ = 0;
+    }
+
+    size_t kept = buffer_.size();
+    buffer_.resize(kept + options_.chunk_size);
+    input_->read(&buffer_[kept], static_cast<std::streamsize>(options_.chunk_size));
+    size_t got = static_cast<size_t>(input_->gcount());
+    buffer_.resize(kept + got);
+
+    if (got == 0 || !*input_) {
+        eof_ = true;
+    }
+    data_ = buffer_;
+    return got > 0;
+}
+
+} // namespace etl
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <istream>
+#include <memory>
+#include <cstddef>
+
+namespace etl {
+
+// One parsed CSV record. Fields are views into the reader's buffer (or into
+// the row's own scratch space for quoted fields containing "" escapes) and
+// stay valid only until the next call to CsvReader::next().
+struct CsvRow {
+    std::vector<std::string_view> fields;
+
+    size_t size() const { return fields.size(); }
+    bool empty() const { return fields.empty(); }
+    std::string_view operator[](size_t i) const { return fields[i]; }
+
+private:
+    friend class CsvReader;
+    struct Span {
+        size_t begin;
+        size_t end;
+        bool unescaped;                        // Offsets are into unescaped_
+    };
+    std::vector<Span> spans_;
+    std::string unescaped_;                    // Quoted fields that contained ""
+};
+
+struct CsvReaderOptions {
+    char delimiter = ',';
+    bool skip_empty_lines = true;
+    size_t chunk_size = 1 << 20;               // Read size when streaming from an istream
+};
+
+// Incremental RFC 4180 reader: quoted fields may contain delimiters, line
+// breaks and "" escapes; records end in LF or CRLF. Input is either a
+// caller-owned buffer, a memory-mapped file, or an istream read in chunks,
+// so memory use is bounded by the longest record rather than the input.
+// Malformed input (an unterminated quote, or text after a closing quote)
+// throws std::runtime_error.
+class CsvReader {
+public:
+    explicit CsvReader(std::string_view data, const CsvReaderOptions& options = {});
+    explicit CsvReader(std::istream& input, const CsvReaderOptions& options = {});
+    ~CsvReader();
+
+    CsvReader(const CsvReader&) = delete;
+    CsvReader& operator=(const CsvReader&) = delete;
+
+    // Memory-maps the file; throws std::runtime_error if it cannot be opened
+    static std::unique_ptr<CsvReader> openFile(const std::string& path,
+                                               const CsvReaderOptions& options = {});
+
+    // Reads the next record into row; returns false at end of input
+    bool next(CsvRow& row);
+
+    size_t recordNumber() const { return record_number_; }   // 1-based, of the last record read
+    size_t bytesConsumed() const { return consumed_total_ + pos_; }
+
+private:
+    CsvReader(void* mapping, size_t length, const CsvReaderOptions& options);
+
+    enum class ParseStatus { RECORD, INCOMPLETE, END };
+
+    ParseStatus parseRecord(CsvRow& row);
+    bool refill();
+    void releaseConsumedPages();
+    size_t findSpecial(size_t from) const;
+
+    CsvReaderOptions options_;
+    std::string_view data_;
+    size_t pos_;
+    size_t record_number_;
+    size_t consumed_total_;
+
+    // Streaming mode
+    std::istream* input_;
+    std::string buffer_;
+    bool eof_;
+
+    // Memory-mapped mode
+    void* mapping_;
+    size_t mapping_length_;
+    size_t released_;                          // Pages below this were dropped from RSS
+};
+
+} // namespace etl
@@ -5,10 +5,17 @@
 #include <map>
 #include <functional>
 #include <memory>
+#include <iosfwd>
 #include <nlohmann/json.hpp>
+#include "record_batch.h"
+#include "json_projection.h"
+#include "stream_operators.h"
 
 namespace etl {
 
+class CsvReader;
+class ThreadPool;
+
 struct TransformationResult {
     bool success;
     std::string error_message;
@@ -39,9 +46,15 @@ public:
     TransformationResult filterJsonFields(const std::string& jsonData, 
                                          const std::vector<std::string>& fieldsToKeep);
     
-    // CSV Processing
+    // CSV Processing (RFC 4180; see csv_reader.h). The *File variants stream
+    // from a memory-mapped input to the output file, so memory use does not
+    // grow with the size of the CSV.
     TransformationResult processCsv(const std::string& csvData, const DataSchema& schema);
+    TransformationResult processCsvFile(const std::string& inputPath, const std::string& outputPath,
+                                        const DataSchema& schema);
     TransformationResult csvToJson(const std::string& csvData, bool hasHeader = true);
+    TransformationResult csvFileToJson(const std::string& inputPath, const std::string& outputPath,
+                                       bool hasHeader = true);
     TransformationResult jsonToCsv(const std::string& jsonData, 
                                   const std::vector<std::string>& columnOrder = {});
     TransformationResult transformCsvColumns(const std::string& csvData, 
@@ -54,6 +67,12 @@ public:
                                          const std::map<std::string, std::map<std::string, std::string>>& mappings);
     TransformationResult deduplicateRecords(const std::string& jsonArrayData, 
                                            const std::vector<std::string>& keyFields);
+    // Streams inputPath (CSV for ".csv", else one JSON object per line) to
+    // outputPath as JSON lines, keeping the first record of each key in
+    // bounded memory; see StreamingDeduplicator for the spill behaviour
+    TransformationResult deduplicateFile(const std::string& inputPath, const std::string& outputPath,
+                                         const std::vector<std::string>& keyFields,
+                                         const StreamingOptions& options = {});
     
     // Data Validation
     struct ValidationResult {
@@ -67,6 +86,7 @@ public:
     ValidationResult validateData(const std::string& data, const DataSchema& schema);
     ValidationResult validateJson(const std::string& jsonData, const DataSchema& schema);
     ValidationResult validateCsv(const std::string& csvData, const DataSchema& schema);
+    ValidationResult validateCsvFile(const std::string& path, const DataSchema& schema);
     
     // Data Type Conversions
     TransformationResult convertDataTypes(const std::string& jsonData, 
@@ -78,6 +98,11 @@ public:
     TransformationResult aggregateData(const std::string& jsonArrayData, 
                                       const std::vector<std::string>& groupByFields,
                                       const std::map<std::string, std::string>& aggregations);
+    // aggregateData over a file, in bounded memory, like deduplicateFile
+    TransformationResult aggregateFile(const std::string& inputPath, const std::string& outputPath,
+                                       const std::vector<std::string>& groupByFields,
+                                       const std::map<std::string, std::string>& aggregations,
+                                       const StreamingOptions& options = {});
     
     // Date/Time Processing
     TransformationResult standardizeDates(const std::string& jsonData, 
@@ -110,19 +135,76 @@ public:
     void addCustomTransformer(const std::string& name, 
                              const std::function<std::string(const std::string&)>& transformer);
     void setErrorTolerance(bool continueOnError);
+    // ON_DEMAND makes filterJsonFields, and pipelines whose first step is a
+    // filter, parse only the kept fields; returns false (keeping the current
+    // backend) if the backend was not compiled in
+    bool setJsonBackend(JsonBackend backend);
     
     // ETL Pipeline Integration
+    //
+    // The input (a JSON object or array of objects, or CSV with a header) is
+    // parsed once into a RecordBatch that every step then transforms in place;
+    // it is serialized back to JSON only after the last step. A step is
+    // "name" or "name:arguments":
+    //   remove_nulls                      clean
+    //   filter:field,...                  rename:old=new,...
+    //   convert:field=type,...            normalize_text:field,...
+    //   deduplicate[:key,...]             aggregate:group,...;field=sum|avg|min|max|count,...
+    //   normalize:field,...[;min-max]     <name given to addCustomTransformer>
+    // A field may appear once per rename, convert or aggregate step; a
+    // repeated field fails the step. A custom transformer sees the records
+    // as a JSON string and must return one, so it costs a serialization
+    // round trip.
+    //
+    // With more than one thread the records are split into chunks of
+    // chunkRows that pass through the steps on a thread pool; deduplicate,
+    // aggregate and normalize combine per-chunk partial results, so the
+    // output is the same as with one thread up to floating-point rounding
+    // of sums.
     TransformationResult processDataPipeline(const std::string& inputData, 
                                             const std::vector<std::string>& transformationSteps);
+    void setPipelineParallelism(size_t threads, size_t chunkRows = 50000);
+    
+    // Record batch transformations behind the pipeline steps; the string
+    // methods above of the same name parse, call these and serialize
+    void removeNullValues(RecordBatch& batch);
+    void cleanRecords(RecordBatch& batch);
+    void filterFields(RecordBatch& batch, const std::vector<std::string>& fieldsToKeep);
+    void renameFields(RecordBatch& batch, const std::map<std::string, std::string>& fieldMappings);
+    size_t convertDataTypes(RecordBatch& batch,                     // Returns failed conversions
+                            const std::map<std::string, std::string>& typeConversions);
+    void deduplicateRecords(RecordBatch& batch, const std::vector<std::string>& keyFields);
+    RecordBatch aggregateData(const RecordBatch& batch, 
+                              const std::vector<std::string>& groupByFields,
+                              const std::map<std::string, std::string>& aggregations);
+    void normalizeNumericFields(RecordBatch& batch, 
+                                const std::vector<std::string>& numericFields,
+                                const std::string& method = "z-score");
+    void normalizeText(RecordBatch& batch, const std::vector<std::string>& textFields);
     
 private:
     std::string default_date_format_;
     std::map<std::string, std::function<std::string(const std::string&)>> custom_transformers_;
     bool continue_on_error_;
+    size_t pipeline_threads_;
+    size_t pipeline_chunk_rows_;
+    JsonBackend json_backend_;
     
     // Helper methods
     nlohmann::json parseJsonSafely(const std::string& jsonStr);
+    TransformationResult transformRecords(const std::string& jsonData, 
+                                          const std::function<void(RecordBatch&)>& transform);
+    std::string serializeRecords(const RecordBatch& batch, bool singleRecord);
+    TransformationResult streamFile(const std::string& inputPath, const std::string& outputPath,
+                                    const std::function<StreamingStats(RecordReader&, JsonLinesWriter&)>& op);
+    std::string serializeChunks(const std::vector<RecordBatch>& chunks, bool singleRecord, ThreadPool* pool);
+    void applyPipelineStep(std::vector<RecordBatch>& chunks, const std::string& step, 
+                           ThreadPool* pool, TransformationResult& result);
     std::vector<std::vector<std::string>> parseCsv(const std::string& csvData);
+    // Stream one CSV reader into out; with a sink, out is flushed to it as it fills
+    size_t writeCsvAsJson(CsvReader& reader, bool hasHeader, std::string& out, std::ostream* sink);
+    size_t writeProcessedCsv(CsvReader& reader, const DataSchema& schema, std::string& out, std::ostream* sink);
+    void validateCsvRecords(CsvReader& reader, const DataSchema& schema, ValidationResult& result);
     std::string escapeCSVField(const std::string& field);
     std::vector<std::string> splitString(const std::string& str, char delimiter);
     std::string trimString(const std::string& str);
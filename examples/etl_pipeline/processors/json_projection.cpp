@@ -0,0 +1,147 @@
+#include "json_projection.h"
+#include <stdexcept>
+#include <string_view>
+
+#ifdef HAVE_SIMDJSON
+#include <simdjson.h>
+#endif
+
+namespace etl {
+
+bool isJsonBackendAvailable(JsonBackend backend) {
+#ifdef HAVE_SIMDJSON
+    (void)backend;
+    return true;
+#else
+    return backend == JsonBackend::DOM;
+#endif
+}
+
+#ifdef HAVE_SIMDJSON
+
+namespace {
+
+// Stores one on-demand value into row of column
+void storeValue(simdjson::ondemand::value value, Column& column, size_t row) {
+    switch (value.type()) {
+        case simdjson::ondemand::json_type::string:
+            column.setString(row, value.get_string());
+            break;
+        case simdjson::ondemand::json_type::number:
+            switch (value.get_number_type()) {
+                case simdjson::ondemand::number_type::signed_integer:
+                    column.set(row, static_cast<int64_t>(value.get_int64()));
+                    break;
+                case simdjson::ondemand::number_type::unsigned_integer:
+                    column.set(row, static_cast<uint64_t>(value.get_uint64()));
+                    break;
+                default:
+                    // Big integers are parsed as double, as nlohmann::json does
+                    column.set(row, static_cast<double>(value.get_double()));
+                    break;
+            }
+            break;
+        case simdjson::ondemand::json_type::boolean:
+            column.set(row, static_cast<bool>(value.get_bool()));
+            break;
+        case simdjson::ondemand::json_type::null:
+            if (value.is_null()) {
+                column.setNull(row);
+            }
+            break;
+        default: {
+            // Nested objects and arrays are rare in projections; hand their
+            // text to nlohmann
+            std::string_view raw = value.raw_json();
+            column.set(row, nlohmann::json::parse(raw.begin(), raw.end()));
+            break;
+        }
+    }
+}
+
+void projectObject(simdjson::ondemand::object object, const std::vector<std::string>& fields,
+                   std::vector<Column>& columns) {
+    size_t row = columns.front().size();
+    for (auto& column : columns) {
+        column.appendAbsent();
+    }
+
+    for (auto field : object) {
+        std::string_view key = field.unescaped_key();
+        for (size_t i = 0; i < fields.size(); ++i) {
+            if (key == fields[i]) {
+                // A repeated key overwrites, as in nlohmann::json
+                storeValue(field.value(), columns[i], row);
+                break;
+            }
+        }
+        // Unmatched values are skipped when the loop advances
+    }
+}
+
+} // namespace
+
+RecordBatch projectJsonRecords(const std::string& json, const std::vector<std::string>& fields,
+                               bool& singleRecord) {
+    std::vector<Column> columns;
+    for (const auto& field : fields) {
+        columns.emplace_back(field);
+    }
+    if (columns.empty()) {
+        columns.emplace_back("");   // Counts rows when no field is requested
+    }
+
+    try {
+        // simdjson reads up to SIMDJSON_PADDING bytes past the end; copy only
+        // when the string has no spare capacity for that
+        simdjson::padded_string copy;
+        simdjson::padded_string_view input;
+        if (json.capacity() - json.size() >= simdjson::SIMDJSON_PADDING) {
+            input = simdjson::padded_string_view(json.data(), json.size(), json.capacity());
+        } else {
+            copy = simdjson::padded_string(json);
+            input = copy;
+        }
+
+        simdjson::ondemand::parser parser;
+        simdjson::ondemand::document document = parser.iterate(input);
+
+        singleRecord = document.type() == simdjson::ondemand::json_type::object;
+        if (singleRecord) {
+            projectObject(document.get_object(), fields, columns);
+        } else if (document.type() == simdjson::ondemand::json_type::array) {
+            size_t index = 0;
+            for (auto element : document.get_array()) {
+                simdjson::ondemand::value value = element.value();
+                if (value.type() != simdjson::ondemand::json_type::object) {
+                    throw std::runtime_error("Record " + std::to_string(index) + " is not a JSON object");
+                }
+                projectObject(value.get_object(), fields, columns);
+                index++;
+            }
+        } else {
+            throw std::runtime_error("Expected a JSON object or an array of objects");
+        }
+
+        if (!document.at_end()) {
+            throw std::runtime_error("Unexpected content after the JSON document");
+        }
+    } catch (const simdjson::simdjson_error& e) {
+        throw std::runtime_error(std::string("JSON parse error: ") + e.what());
+    }
+
+    // Columns never present are dropped; the row count stays
+    RecordBatch batch = RecordBatch::fromColumns(std::move(columns));
+    batch.dropEmptyColumns();
+    return batch;
+}
+
+#else
+
+RecordBatch projectJsonRecords(const std::string&, const std::vector<std::string>&, bool&) {
+    throw std::runtime_error("JSON backend 'on-demand' was not compiled in (needs simdjson)");
+}
+
+#endif
+
+} // namespace etl
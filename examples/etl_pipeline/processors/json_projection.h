@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "record_batch.h"
+
+namespace etl {
+
+// Which parser DataTransformer uses for JSON it only projects
+enum class JsonBackend {
+    DOM,        // nlohmann::json: builds the whole document
+    ON_DEMAND   // simdjson on-demand: materializes only the requested fields; needs HAVE_SIMDJSON
+};
+
+bool isJsonBackendAvailable(JsonBackend backend);
+
+// Reads the given top-level fields of every object in a JSON array (or of a
+// single object, setting singleRecord) into a RecordBatch, skipping all other
+// values without building them. Skipped values are only checked for
+// structure, not fully validated. Throws std::runtime_error on malformed
+// input, or if the ON_DEMAND backend was not compiled in.
+RecordBatch projectJsonRecords(const std::string& json, const std::vector<std::string>& fields,
+                               bool& singleRecord);
+
+} // namespace etl
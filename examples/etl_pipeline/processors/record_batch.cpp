@@ -0,0 +1,516 @@
+#include "record_batch.h"
+#include "csv_reader.h"
+#include <stdexcept>
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <cstdlib>
+
+namespace etl {
+
+namespace {
+
+ColumnType columnTypeOf(const nlohmann::json& value) {
+    switch (value.type()) {
+        case nlohmann::json::value_t::null:
+            return ColumnType::NULL_TYPE;
+        case nlohmann::json::value_t::boolean:
+            return ColumnType::BOOL;
+        case nlohmann::json::value_t::number_integer:
+            return ColumnType::INT;
+        case nlohmann::json::value_t::number_unsigned:
+            return value.get<uint64_t>() <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max())
+                ? ColumnType::INT : ColumnType::JSON;
+        case nlohmann::json::value_t::number_float:
+            return ColumnType::DOUBLE;
+        case nlohmann::json::value_t::string:
+            return ColumnType::STRING;
+        default:
+            return ColumnType::JSON;
+    }
+}
+
+void appendJsonKey(std::string& key, const nlohmann::json& value) {
+    std::string text = value.dump();
+    key += 'j';
+    key += std::to_string(text.size());
+    key += ':';
+    key += text;
+}
+
+} // namespace
+
+// Column
+
+Column::Column(std::string name) : name_(std::move(name)), type_(ColumnType::NULL_TYPE) {}
+
+bool Column::numberAt(size_t row, double& value) const {
+    if (states_[row] != PRESENT) return false;
+    switch (type_) {
+        case ColumnType::INT:
+            value = static_cast<double>(ints_[row]);
+            return true;
+        case ColumnType::DOUBLE:
+            value = doubles_[row];
+            return true;
+        case ColumnType::JSON:
+            if (json_[row].is_number()) {
+                value = json_[row].get<double>();
+                return true;
+            }
+            return false;
+        default:
+            return false;
+    }
+}
+
+nlohmann::json Column::valueAt(size_t row) const {
+    if (states_[row] != PRESENT) return nullptr;
+    switch (type_) {
+        case ColumnType::BOOL: return bools_[row] != 0;
+        case ColumnType::INT: return ints_[row];
+        case ColumnType::DOUBLE: return doubles_[row];
+        case ColumnType::STRING: return strings_[row];
+        case ColumnType::JSON: return json_[row];
+        default: return nullptr;
+    }
+}
+
+std::string Column::textAt(size_t row) const {
+    if (states_[row] == PRESENT && type_ == ColumnType::STRING) {
+        return strings_[row];
+    }
+    if (states_[row] == PRESENT && type_ == ColumnType::JSON && json_[row].is_string()) {
+        return json_[row].get<std::string>();
+    }
+    return valueAt(row).dump();
+}
+
+void Column::append(const nlohmann::json& value) {
+    appendAbsent();
+    if (value.is_null()) {
+        states_.back() = NULL_VALUE;
+    } else {
+        set(states_.size() - 1, value);
+    }
+}
+
+void Column::appendString(std::string_view value) {
+    appendAbsent();
+    setString(states_.size() - 1, value);
+}
+
+void Column::appendAbsent() {
+    states_.push_back(ABSENT);
+    pushDefault();
+}
+
+void Column::appendFrom(const Column& other, size_t row) {
+    CellState cell = other.state(row);
+    if (cell != PRESENT) {
+        appendAbsent();
+        states_.back() = cell;
+        return;
+    }
+
+    if (type_ == ColumnType::NULL_TYPE) {
+        adopt(other.type_);
+    }
+    if (other.type_ != type_) {
+        append(other.valueAt(row));
+        return;
+    }
+
+    states_.push_back(PRESENT);
+    switch (type_) {
+        case ColumnType::BOOL: bools_.push_back(other.bools_[row]); break;
+        case ColumnType::INT: ints_.push_back(other.ints_[row]); break;
+        case ColumnType::DOUBLE: doubles_.push_back(other.doubles_[row]); break;
+        case ColumnType::STRING: strings_.push_back(other.strings_[row]); break;
+        case ColumnType::JSON: json_.push_back(other.json_[row]); break;
+        default: break;
+    }
+}
+
+void Column::set(size_t row, const nlohmann::json& value) {
+    ColumnType valueType = columnTypeOf(value);
+    if (valueType == ColumnType::NULL_TYPE) {
+        setNull(row);
+        return;
+    }
+
+    if (type_ == ColumnType::NULL_TYPE) {
+        adopt(valueType);
+    } else if (type_ != valueType && type_ != ColumnType::JSON) {
+        promoteToJson();
+    }
+
+    states_[row] = PRESENT;
+    switch (type_) {
+        case ColumnType::BOOL: bools_[row] = value.get<bool>(); break;
+        case ColumnType::INT: ints_[row] = value.get<int64_t>(); break;
+        case ColumnType::DOUBLE: doubles_[row] = value.get<double>(); break;
+        case ColumnType::STRING: strings_[row] = value.get<std::string>(); break;
+        default: json_[row] = value; break;
+    }
+}
+
+void Column::setString(size_t row, std::string_view value) {
+    if (type_ == ColumnType::NULL_TYPE) {
+        adopt(ColumnType::STRING);
+    }
+    if (type_ != ColumnType::STRING) {
+        set(row, std::string(value));
+        return;
+    }
+    states_[row] = PRESENT;
+    strings_[row].assign(value.data(), value.size());
+}
+
+void Column::setNull(size_t row) {
+    states_[row] = NULL_VALUE;
+}
+
+void Column::setAbsent(size_t row) {
+    states_[row] = ABSENT;
+}
+
+Column Column::take(const std::vector<size_t>& rows) const {
+    Column result(name_);
+    result.adopt(type_);
+    result.states_.reserve(rows.size());
+    for (size_t row : rows) {
+        result.states_.push_back(states_[row]);
+        switch (type_) {
+            case ColumnType::BOOL: result.bools_.push_back(bools_[row]); break;
+            case ColumnType::INT: result.ints_.push_back(ints_[row]); break;
+            case ColumnType::DOUBLE: result.doubles_.push_back(doubles_[row]); break;
+            case ColumnType::STRING: result.strings_.push_back(strings_[row]); break;
+            case ColumnType::JSON: result.json_.push_back(json_[row]); break;
+            default: break;
+        }
+    }
+    return result;
+}
+
+void Column::adopt(ColumnType type) {
+    type_ = type;
+    size_t rows = states_.size();
+    switch (type_) {
+        case ColumnType::BOOL: bools_.resize(rows); break;
+        case ColumnType::INT: ints_.resize(rows); break;
+        case ColumnType::DOUBLE: doubles_.resize(rows); break;
+        case ColumnType::STRING: strings_.resize(rows); break;
+        case ColumnType::JSON: json_.resize(rows); break;
+        default: break;
+    }
+}
+
+void Column::promoteToJson() {
+    std::vector<nlohmann::json> values(states_.size());
+    for (size_t row = 0; row < states_.size(); ++row) {
+        if (states_[row] == PRESENT) {
+            values[row] = valueAt(row);
+        }
+    }
+
+    bools_.clear();
+    ints_.clear();
+    doubles_.clear();
+    strings_.clear();
+    json_ = std::move(values);
+    type_ = ColumnType::JSON;
+}
+
+void Column::pushDefault() {
+    switch (type_) {
+        case ColumnType::BOOL: bools_.push_back(0); break;
+        case ColumnType::INT: ints_.push_back(0); break;
+        case ColumnType::DOUBLE: doubles_.push_back(0.0); break;
+        case ColumnType::STRING: strings_.emplace_back(); break;
+        case ColumnType::JSON: json_.emplace_back(); break;
+        default: break;
+    }
+}
+
+// RecordBatch
+
+RecordBatch::RecordBatch() : rows_(0) {}
+
+Column* RecordBatch::findColumn(const std::string& name) {
+    auto it = index_.find(name);
+    return it == index_.end() ? nullptr : &columns_[it->second];
+}
+
+const Column* RecordBatch::findColumn(const std::string& name) const {
+    auto it = index_.find(name);
+    return it == index_.end() ? nullptr : &columns_[it->second];
+}
+
+Column& RecordBatch::addColumn(const std::string& name) {
+    auto it = index_.find(name);
+    if (it != index_.end()) {
+        return columns_[it->second];
+    }
+
+    index_[name] = columns_.size();
+    columns_.emplace_back(name);
+    Column& column = columns_.back();
+    column.states_.assign(rows_, Column::ABSENT);
+    return column;
+}
+
+void RecordBatch::removeColumn(const std::string& name) {
+    auto it = index_.find(name);
+    if (it == index_.end()) return;
+
+    columns_.erase(columns_.begin() + it->second);
+    reindex();
+}
+
+void RecordBatch::renameColumn(const std::string& from, const std::string& to) {
+    if (from == to || !findColumn(from)) return;
+
+    if (!findColumn(to)) {
+        Column& column = *findColumn(from);
+        column.name_ = to;
+        reindex();
+        return;
+    }
+
+    Column& source = *findColumn(from);
+    Column& target = *findColumn(to);
+    for (size_t row = 0; row < rows_; ++row) {
+        switch (source.state(row)) {
+            case Column::PRESENT: target.set(row, source.valueAt(row)); break;
+            case Column::NULL_VALUE: target.setNull(row); break;
+            default: break;
+        }
+    }
+    removeColumn(from);
+}
+
+void RecordBatch::dropEmptyColumns() {
+    auto empty = [](const Column& column) {
+        for (uint8_t state : column.states_) {
+            if (state != Column::ABSENT) return false;
+        }
+        return true;
+    };
+    columns_.erase(std::remove_if(columns_.begin(), columns_.end(), empty), columns_.end());
+    reindex();
+}
+
+void RecordBatch::appendRecord(const nlohmann::json& record) {
+    if (!record.is_object()) {
+        throw std::runtime_error("Record " + std::to_string(rows_) + " is not a JSON object");
+    }
+
+    for (auto it = record.begin(); it != record.end(); ++it) {
+        addColumn(it.key()).append(it.value());
+    }
+    rows_++;
+
+    for (auto& column : columns_) {
+        if (column.size() < rows_) {
+            column.appendAbsent();
+        }
+    }
+}
+
+void RecordBatch::append(const RecordBatch& other) {
+    for (const auto& source : other.columns_) {
+        Column& target = addColumn(source.name_);
+        for (size_t row = 0; row < other.rows_; ++row) {
+            target.appendFrom(source, row);
+        }
+    }
+    rows_ += other.rows_;
+
+    for (auto& column : columns_) {
+        while (column.size() < rows_) {
+            column.appendAbsent();
+        }
+    }
+}
+
+RecordBatch RecordBatch::take(const std::vector<size_t>& rows) const {
+    RecordBatch result;
+    for (const auto& column : columns_) {
+        result.columns_.push_back(column.take(rows));
+    }
+    result.rows_ = rows.size();
+    result.reindex();
+    return result;
+}
+
+RecordBatch RecordBatch::slice(size_t offset, size_t count) const {
+    offset = std::min(offset, rows_);
+    count = std::min(count, rows_ - offset);
+    std::vector<size_t> rows(count);
+    std::iota(rows.begin(), rows.end(), offset);
+    return take(rows);
+}
+
+nlohmann::json RecordBatch::recordAt(size_t row) const {
+    nlohmann::json record = nlohmann::json::object();
+    for (const auto& column : columns_) {
+        if (column.state(row) != Column::ABSENT) {
+            record[column.name_] = column.valueAt(row);
+        }
+    }
+    return record;
+}
+
+nlohmann::json RecordBatch::toJson() const {
+    nlohmann::json data = nlohmann::json::array();
+    for (size_t row = 0; row < rows_; ++row) {
+        data.push_back(recordAt(row));
+    }
+    return data;
+}
+
+RecordBatch RecordBatch::fromJson(const nlohmann::json& data) {
+    RecordBatch batch;
+    if (data.is_object()) {
+        batch.appendRecord(data);
+    } else if (data.is_array()) {
+        for (const auto& record : data) {
+            batch.appendRecord(record);
+        }
+    } else {
+        throw std::runtime_error("Expected a JSON object or an array of objects");
+    }
+    return batch;
+}
+
+RecordBatch RecordBatch::fromColumns(std::vector<Column> columns) {
+    RecordBatch batch;
+    batch.rows_ = columns.empty() ? 0 : columns.front().size();
+    for (const auto& column : columns) {
+        if (column.size() != batch.rows_) {
+            throw std::runtime_error("Column '" + column.name() + "' has " + std::to_string(column.size()) +
+                                     " rows, expected " + std::to_string(batch.rows_));
+        }
+    }
+
+    batch.columns_ = std::move(columns);
+    batch.reindex();
+    if (batch.index_.size() != batch.columns_.size()) {
+        throw std::runtime_error("Duplicate column name in record batch");
+    }
+    return batch;
+}
+
+RecordBatch RecordBatch::fromCsv(CsvReader& reader, bool hasHeader) {
+    RecordBatch batch;
+    CsvRow row;
+    if (!reader.next(row)) {
+        return batch;
+    }
+
+    // Repeated header names share a column; the last one wins
+    std::vector<size_t> columnOf;
+    for (size_t i = 0; i < row.size(); ++i) {
+        std::string name = hasHeader ? std::string(row[i]) : "column_" + std::to_string(i);
+        batch.addColumn(name);
+        columnOf.push_back(batch.index_[name]);
+    }
+
+    bool haveRow = !hasHeader;
+    while (haveRow || reader.next(row)) {
+        haveRow = false;
+        for (auto& column : batch.columns_) {
+            column.appendAbsent();
+        }
+        for (size_t i = 0; i < row.size() && i < columnOf.size(); ++i) {
+            batch.columns_[columnOf[i]].setString(batch.rows_, row[i]);
+        }
+        batch.rows_++;
+    }
+    return batch;
+}
+
+void RecordBatch::reindex() {
+    index_.clear();
+    for (size_t i = 0; i < columns_.size(); ++i) {
+        index_[columns_[i].name_] = i;
+    }
+}
+
+void appendCellKey(std::string& key, const Column* column, size_t row) {
+    if (!column || column->state(row) == Column::ABSENT) {
+        key += 'a';
+        return;
+    }
+    if (column->state(row) == Column::NULL_VALUE) {
+        key += 'n';
+        return;
+    }
+
+    switch (column->type()) {
+        case ColumnType::BOOL:
+            key += column->boolAt(row) ? "b1" : "b0";
+            break;
+        case ColumnType::INT:
+            key += 'i';
+            key += std::to_string(column->intAt(row));
+            key += ';';
+            break;
+        case ColumnType::STRING: {
+            const std::string& value = column->stringAt(row);
+            key += 's';
+            key += std::to_string(value.size());
+            key += ':';
+            key += value;
+            break;
+        }
+        case ColumnType::JSON: {
+            // Scalars key as they would in a column of their own type, so
+            // keys do not depend on what else a batch happened to hold
+            const nlohmann::json& value = column->jsonAt(row);
+            if (value.is_string()) {
+                const std::string& text = value.get_ref<const std::string&>();
+                key += 's';
+                key += std::to_string(text.size());
+                key += ':';
+                key += text;
+                break;
+            }
+            if (value.is_boolean()) {
+                key += value.get<bool>() ? "b1" : "b0";
+                break;
+            }
+            if (value.is_number_integer()) {
+                key += 'i';
+                key += value.dump();
+                key += ';';
+                break;
+            }
+            appendJsonKey(key, value);
+            break;
+        }
+        default:
+            appendJsonKey(key, column->valueAt(row));
+            break;
+    }
+}
+
+bool numericCellValue(const Column& column, size_t row, double& value) {
+    if (column.numberAt(row, value)) return true;
+    if (!column.isPresent(row)) return false;
+
+    const std::string* text = nullptr;
+    if (column.type() == ColumnType::STRING) {
+        text = &column.stringAt(row);
+    } else if (column.type() == ColumnType::JSON && column.jsonAt(row).is_string()) {
+        text = &column.jsonAt(row).get_ref<const std::string&>();
+    }
+    if (!text || text->empty()) return false;
+
+    char* end = nullptr;
+    value = std::strtod(text->c_str(), &end);
+    return end == text->c_str() + text->size();
+}
+
+} // namespace etl
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+
+namespace etl {
+
+class CsvReader;
+
+// Storage type of a column. A column holds one scalar type, or JSON once its
+// values stop agreeing (mixed types, nested objects or arrays)
+enum class ColumnType {
+    NULL_TYPE,      // No present values yet
+    BOOL,
+    INT,
+    DOUBLE,
+    STRING,
+    JSON
+};
+
+// One named column of a RecordBatch. Every row is absent (the record has no
+// such key), null, or present with a value in the vector for type().
+class Column {
+public:
+    enum CellState : uint8_t {
+        ABSENT = 0,
+        NULL_VALUE = 1,
+        PRESENT = 2
+    };
+
+    explicit Column(std::string name);
+
+    const std::string& name() const { return name_; }
+    ColumnType type() const { return type_; }
+    size_t size() const { return states_.size(); }
+
+    CellState state(size_t row) const { return static_cast<CellState>(states_[row]); }
+    bool isPresent(size_t row) const { return states_[row] == PRESENT; }
+
+    // Typed access; valid only for present rows of a column of that type
+    bool boolAt(size_t row) const { return bools_[row] != 0; }
+    int64_t intAt(size_t row) const { return ints_[row]; }
+    double doubleAt(size_t row) const { return doubles_[row]; }
+    const std::string& stringAt(size_t row) const { return strings_[row]; }
+    const nlohmann::json& jsonAt(size_t row) const { return json_[row]; }
+
+    // Numeric value of a present INT, DOUBLE or numeric JSON cell
+    bool numberAt(size_t row, double& value) const;
+    // The value as nlohmann::json; null for absent and null rows
+    nlohmann::json valueAt(size_t row) const;
+    // Strings as-is, everything else as its JSON text
+    std::string textAt(size_t row) const;
+
+    void append(const nlohmann::json& value);
+    void appendString(std::string_view value);
+    void appendAbsent();
+    void appendFrom(const Column& other, size_t row);
+
+    void set(size_t row, const nlohmann::json& value);
+    void setString(size_t row, std::string_view value);
+    void setNull(size_t row);
+    void setAbsent(size_t row);
+
+    Column take(const std::vector<size_t>& rows) const;
+
+private:
+    friend class RecordBatch;
+
+    void adopt(ColumnType type);
+    void promoteToJson();
+    void pushDefault();
+
+    std::string name_;
+    ColumnType type_;
+    std::vector<uint8_t> states_;
+    std::vector<uint8_t> bools_;
+    std::vector<int64_t> ints_;
+    std::vector<double> doubles_;
+    std::vector<std::string> strings_;
+    std::vector<nlohmann::json> json_;
+};
+
+// Columnar set of records passed between DataTransformer pipeline steps, so
+// that data is parsed once at the source and serialized once at the sink.
+// Records are JSON objects; a column exists for every top-level key seen.
+class RecordBatch {
+public:
+    RecordBatch();
+
+    size_t numRows() const { return rows_; }
+    size_t numColumns() const { return columns_.size(); }
+
+    std::vector<Column>& columns() { return columns_; }
+    const std::vector<Column>& columns() const { return columns_; }
+    Column* findColumn(const std::string& name);
+    const Column* findColumn(const std::string& name) const;
+
+    // Returns the existing column, or a new one absent in every row
+    Column& addColumn(const std::string& name);
+    void removeColumn(const std::string& name);
+    // Renames from to to; where to already exists, rows present in from
+    // overwrite it
+    void renameColumn(const std::string& from, const std::string& to);
+    // Removes columns with no present or null cell
+    void dropEmptyColumns();
+
+    void appendRecord(const nlohmann::json& record);
+    void append(const RecordBatch& other);
+    RecordBatch take(const std::vector<size_t>& rows) const;
+    RecordBatch slice(size_t offset, size_t count) const;
+
+    nlohmann::json recordAt(size_t row) const;
+    nlohmann::json toJson() const;
+
+    // An array of objects, or a single object as a one-row batch; throws
+    // std::runtime_error for anything else
+    static RecordBatch fromJson(const nlohmann::json& data);
+    // Columns must all have the same size and distinct names
+    static RecordBatch fromColumns(std::vector<Column> columns);
+    // Every field becomes a string column, as in DataTransformer::csvToJson
+    static RecordBatch fromCsv(CsvReader& reader, bool hasHeader = true);
+
+private:
+    void reindex();
+
+    std::vector<Column> columns_;
+    std::unordered_map<std::string, size_t> index_;
+    size_t rows_;
+};
+
+// Appends an unambiguous encoding of one cell to a dedup or group key; a
+// missing column encodes like an absent cell
+void appendCellKey(std::string& key, const Column* column, size_t row);
+
+// Numbers, and strings that hold nothing but a number (as CSV input does)
+bool numericCellValue(const Column& column, size_t row, double& value);
+
+} // namespace etl
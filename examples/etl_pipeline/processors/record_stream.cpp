@@ -0,0 +1,164 @@
+#include "record_stream.h"
+#include <stdexcept>
+#include <algorithm>
+
+namespace etl {
+
+namespace {
+
+bool endsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() &&
+           text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+} // namespace
+
+std::unique_ptr<RecordReader> RecordReader::open(const std::string& path) {
+    if (endsWith(path, ".csv") || endsWith(path, ".CSV")) {
+        return std::make_unique<CsvRecordReader>(path);
+    }
+    if (endsWith(path, ".bin")) {
+        return std::make_unique<BinaryFileRecordReader>(path);
+    }
+    return std::make_unique<JsonLinesRecordReader>(path);
+}
+
+CsvRecordReader::CsvRecordReader(const std::string& path, bool hasHeader)
+    : reader_(CsvReader::openFile(path)), pending_row_(false) {
+    if (!reader_->next(row_)) {
+        return;
+    }
+
+    // Repeated header names share a column; the last one wins
+    for (size_t i = 0; i < row_.size(); ++i) {
+        std::string name = hasHeader ? std::string(row_[i]) : "column_" + std::to_string(i);
+        auto existing = std::find(names_.begin(), names_.end(), name);
+        column_of_.push_back(static_cast<size_t>(existing - names_.begin()));
+        if (existing == names_.end()) {
+            names_.push_back(std::move(name));
+        }
+    }
+    pending_row_ = !hasHeader;
+}
+
+bool CsvRecordReader::next(RecordBatch& batch, size_t maxRows) {
+    std::vector<Column> columns;
+    for (const auto& name : names_) {
+        columns.emplace_back(name);
+    }
+
+    size_t rows = 0;
+    while (!names_.empty() && rows < maxRows && (pending_row_ || reader_->next(row_))) {
+        pending_row_ = false;
+        for (auto& column : columns) {
+            column.appendAbsent();
+        }
+        for (size_t i = 0; i < row_.size() && i < column_of_.size(); ++i) {
+            columns[column_of_[i]].setString(rows, row_[i]);
+        }
+        rows++;
+    }
+
+    batch = rows > 0 ? RecordBatch::fromColumns(std::move(columns)) : RecordBatch();
+    return rows > 0;
+}
+
+JsonLinesRecordReader::JsonLinesRecordReader(const std::string& path)
+    : input_(path, std::ios::binary), path_(path), line_number_(0) {
+    if (!input_) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+}
+
+bool JsonLinesRecordReader::next(RecordBatch& batch, size_t maxRows) {
+    batch = RecordBatch();
+    size_t rows = 0;
+    while (rows < maxRows && std::getline(input_, line_)) {
+        line_number_++;
+        if (line_.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+
+        nlohmann::json record;
+        try {
+            record = nlohmann::json::parse(line_);
+        } catch (const nlohmann::json::parse_error& e) {
+            throw std::runtime_error(path_ + ":" + std::to_string(line_number_) + ": " + e.what());
+        }
+        if (!record.is_object()) {
+            throw std::runtime_error(path_ + ":" + std::to_string(line_number_) + ": not a JSON object");
+        }
+        batch.appendRecord(record);
+        rows++;
+    }
+    if (input_.bad()) {
+        throw std::runtime_error("Error reading " + path_);
+    }
+    return rows > 0;
+}
+
+BinaryFileRecordReader::BinaryFileRecordReader(const std::string& path)
+    : reader_(BinaryRecordReader::openFile(path)) {
+}
+
+bool BinaryFileRecordReader::next(RecordBatch& batch, size_t maxRows) {
+    batch = reader_->readBatch(maxRows);
+    return batch.numRows() > 0;
+}
+
+JsonLinesWriter::JsonLinesWriter(const std::string& path, size_t bufferBytes)
+    : output_(path, std::ios::binary | std::ios::trunc), path_(path), buffer_bytes_(bufferBytes),
+      records_(0), bytes_(0) {
+    if (!output_) {
+        throw std::runtime_error("Cannot open " + path + " for writing");
+    }
+    buffer_.reserve(buffer_bytes_);
+}
+
+JsonLinesWriter::~JsonLinesWriter() {
+    if (output_.is_open()) {
+        try {
+            close();
+        } catch (...) {
+            // Errors surface only through an explicit close()
+        }
+    }
+}
+
+void JsonLinesWriter::write(const nlohmann::json& record) {
+    size_t before = buffer_.size();
+    buffer_ += record.dump();
+    buffer_ += '\n';
+    bytes_ += buffer_.size() - before;
+    records_++;
+    if (buffer_.size() >= buffer_bytes_) {
+        flush();
+    }
+}
+
+void JsonLinesWriter::write(const RecordBatch& batch) {
+    for (size_t row = 0; row < batch.numRows(); ++row) {
+        write(batch.recordAt(row));
+    }
+}
+
+void JsonLinesWriter::close() {
+    if (!output_.is_open()) {
+        return;
+    }
+    flush();
+    output_.close();
+    if (output_.fail()) {
+        throw std::runtime_error("Error writing " + path_);
+    }
+}
+
+void JsonLinesWriter::flush() {
+    output_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    buffer_.clear();
+    if (!output_) {
+        throw std::runtime_error("Error writing " + path_);
+    }
+}
+
+} // namespace etl
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include "record_batch.h"
+#include "csv_reader.h"
+#include "binary_records.h"
+
+namespace etl {
+
+// Source of records read one batch at a time, for operators that must not
+// hold their whole input in memory
+class RecordReader {
+public:
+    virtual ~RecordReader() = default;
+
+    // Replaces batch with up to maxRows further records; returns false, with
+    // batch empty, once the input is exhausted
+    virtual bool next(RecordBatch& batch, size_t maxRows) = 0;
+
+    // CSV with a header for paths ending in ".csv", binary records for ".bin",
+    // newline-delimited JSON objects otherwise; throws std::runtime_error if
+    // the file cannot be opened
+    static std::unique_ptr<RecordReader> open(const std::string& path);
+};
+
+// Every field becomes a string column, as in RecordBatch::fromCsv
+class CsvRecordReader : public RecordReader {
+public:
+    explicit CsvRecordReader(const std::string& path, bool hasHeader = true);
+
+    bool next(RecordBatch& batch, size_t maxRows) override;
+
+private:
+    std::unique_ptr<CsvReader> reader_;
+    std::vector<std::string> names_;        // Distinct column names
+    std::vector<size_t> column_of_;         // Field index -> index into names_
+    CsvRow row_;
+    bool pending_row_;                      // row_ holds the first record of a headerless file
+};
+
+// One JSON object per line; blank lines are skipped
+class JsonLinesRecordReader : public RecordReader {
+public:
+    explicit JsonLinesRecordReader(const std::string& path);
+
+    bool next(RecordBatch& batch, size_t maxRows) override;
+
+private:
+    std::ifstream input_;
+    std::string path_;
+    std::string line_;
+    size_t line_number_;
+};
+
+// Binary records (binary_records.h) read from a memory-mapped file
+class BinaryFileRecordReader : public RecordReader {
+public:
+    explicit BinaryFileRecordReader(const std::string& path);
+
+    bool next(RecordBatch& batch, size_t maxRows) override;
+
+private:
+    std::unique_ptr<BinaryRecordReader> reader_;
+};
+
+// Writes records as newline-delimited JSON through a buffer flushed as it fills
+class JsonLinesWriter {
+public:
+    explicit JsonLinesWriter(const std::string& path, size_t bufferBytes = 1 << 20);
+    ~JsonLinesWriter();
+
+    JsonLinesWriter(const JsonLinesWriter&) = delete;
+    JsonLinesWriter& operator=(const JsonLinesWriter&) = delete;
+
+    void write(const nlohmann::json& record);
+    void write(const RecordBatch& batch);
+    // Flushes and closes; throws std::runtime_error on a write error
+    void close();
+
+    size_t recordsWritten() const { return records_; }
+    size_t bytesWritten() const { return bytes_; }
+
+private:
+    void flush();
+
+    std::ofstream output_;
+    std::string path_;
+    std::string buffer_;
+    size_t buffer_bytes_;
+    size_t records_;
+    size_t bytes_;
+};
+
+} // namespace etl
@@ -0,0 +1,566 @@
+#include "stream_engine.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace etl {
+
+namespace {
+
+using SteadyClock = std::chrono::steady_clock;
+
+int64_t systemMillis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+int64_t floorDiv(int64_t a, int64_t b) {
+    int64_t q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+// Days since 1970-01-01 of a proleptic Gregorian date
+int64_t daysFromCivil(int64_t year, unsigned month, unsigned day) {
+    year -= month <= 2;
+    int64_t era = floorDiv(year, 400);
+    unsigned yearOfEra = static_cast<unsigned>(year - era * 400);
+    unsigned dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + static_cast<int64_t>(dayOfEra) - 719468;
+}
+
+// "YYYY-MM-DD[T ]HH:MM:SS[.fff][Z|+hh:mm|+hhmm|+hh]" (or -) to epoch milliseconds
+bool parseIsoTime(const std::string& text, int64_t& millis) {
+    int year, month, day, hour, minute, second, consumed = 0;
+    if (std::sscanf(text.c_str(), "%4d-%2d-%2d%*1[T ]%2d:%2d:%2d%n",
+                    &year, &month, &day, &hour, &minute, &second, &consumed) != 6) {
+        return false;
+    }
+    if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) {
+        return false;
+    }
+
+    size_t pos = static_cast<size_t>(consumed);
+    int64_t fraction = 0;
+    if (pos < text.size() && text[pos] == '.') {
+        int64_t scale = 100;
+        for (++pos; pos < text.size() && std::isdigit(static_cast<unsigned char>(text[pos])); ++pos) {
+            fraction += (text[pos] - '0') * scale;
+            scale /= 10;
+        }
+    }
+    int64_t offsetMinutes = 0;
+    if (pos < text.size() && (text[pos] == '+' || text[pos] == '-')) {
+        // Only the three ISO forms; anything else is rejected, not guessed at
+        std::string offset = text.substr(pos + 1);
+        auto digitsAt = [&offset](size_t from) {
+            return std::isdigit(static_cast<unsigned char>(offset[from])) &&
+                   std::isdigit(static_cast<unsigned char>(offset[from + 1]));
+        };
+        if (offset.size() < 2 || !digitsAt(0)) return false;
+        int offsetHours = std::stoi(offset.substr(0, 2));
+        int offsetMins = 0;
+        if (offset.size() == 4 && digitsAt(2)) {
+            offsetMins = std::stoi(offset.substr(2));
+        } else if (offset.size() == 5 && offset[2] == ':' && digitsAt(3)) {
+            offsetMins = std::stoi(offset.substr(3));
+        } else if (offset.size() != 2) {
+            return false;
+        }
+        if (offsetHours > 23 || offsetMins > 59) return false;
+        offsetMinutes = (text[pos] == '-' ? -1 : 1) * (offsetHours * 60 + offsetMins);
+    }
+
+    int64_t seconds = daysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+    millis = (seconds - offsetMinutes * 60) * 1000 + fraction;
+    return true;
+}
+
+class MapOperator : public StreamOperator {
+public:
+    explicit MapOperator(std::function<void(RecordBatch&)> fn) : fn_(std::move(fn)) {}
+
+    void process(StreamBatch& batch) override {
+        size_t rows = batch.records.numRows();
+        if (rows == 0) return;
+        fn_(batch.records);
+        if (batch.records.numRows() != rows) {
+            throw std::runtime_error("map must keep the batch's rows; use filter to drop records");
+        }
+    }
+
+private:
+    std::function<void(RecordBatch&)> fn_;
+};
+
+class FilterOperator : public StreamOperator {
+public:
+    explicit FilterOperator(std::function<bool(const RecordBatch&, size_t)> keep) : keep_(std::move(keep)) {}
+
+    void process(StreamBatch& batch) override {
+        if (batch.records.numRows() == 0) return;
+        std::vector<size_t> rows;
+        for (size_t row = 0; row < batch.records.numRows(); ++row) {
+            if (keep_(batch.records, row)) rows.push_back(row);
+        }
+        if (rows.size() == batch.records.numRows()) return;
+
+        std::vector<int64_t> times;
+        times.reserve(rows.size());
+        for (size_t row : rows) times.push_back(batch.event_times[row]);
+        batch.records = batch.records.take(rows);
+        batch.event_times = std::move(times);
+    }
+
+private:
+    std::function<bool(const RecordBatch&, size_t)> keep_;
+};
+
+class CallbackSink : public StreamOperator {
+public:
+    explicit CallbackSink(std::function<void(const StreamBatch&)> fn) : fn_(std::move(fn)) {}
+
+    void process(StreamBatch& batch) override {
+        fn_(batch);
+    }
+
+private:
+    std::function<void(const StreamBatch&)> fn_;
+};
+
+} // namespace
+
+// Groups of one pane, laid out like DataTransformer's grouped partials
+struct WindowAggregateOperator::Pane {
+    std::unordered_map<std::string, size_t> index;
+    std::vector<std::string> keys;
+    std::vector<Column> group_values;           // Group-by values of each group's first record
+    std::vector<Accumulator> accumulators;      // Group-major, one per aggregation
+};
+
+WindowAggregateOperator::WindowAggregateOperator(WindowSpec window, std::vector<std::string> groupByFields,
+                                                 const std::map<std::string, std::string>& aggregations)
+    : window_(window), group_by_fields_(std::move(groupByFields)), specs_(parseAggregateSpecs(aggregations)) {
+    if (window_.size_ms <= 0 || window_.slide_ms <= 0 || window_.slide_ms > window_.size_ms) {
+        throw std::runtime_error("Window size and slide must be positive, with slide at most size");
+    }
+    pane_ms_ = std::gcd(window_.size_ms, window_.slide_ms);
+}
+
+WindowAggregateOperator::~WindowAggregateOperator() = default;
+
+void WindowAggregateOperator::process(StreamBatch& batch) {
+    add(batch);
+    batch.records = RecordBatch();
+    batch.event_times.clear();
+    advance(batch.watermark, batch);
+}
+
+int64_t WindowAggregateOperator::firstWindowStart(int64_t time) const {
+    return (floorDiv(time - window_.size_ms, window_.slide_ms) + 1) * window_.slide_ms;
+}
+
+void WindowAggregateOperator::add(const StreamBatch& batch) {
+    const RecordBatch& records = batch.records;
+    std::vector<const Column*> groupColumns;
+    for (const auto& field : group_by_fields_) {
+        groupColumns.push_back(records.findColumn(field));
+    }
+    std::vector<const Column*> valueColumns;
+    for (const auto& spec : specs_) {
+        valueColumns.push_back(records.findColumn(spec.field));
+    }
+
+    std::string key;
+    for (size_t row = 0; row < records.numRows(); ++row) {
+        int64_t time = batch.event_times[row];
+        int64_t lastWindow = floorDiv(time, window_.slide_ms) * window_.slide_ms;
+        if (lastWindow + (window_.size_ms - 1) <= watermark_ ||
+            (next_window_start_ != NO_WATERMARK && lastWindow < next_window_start_)) {
+            late_records_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        auto& pane = panes_[floorDiv(time, pane_ms_) * pane_ms_];
+        if (!pane) {
+            pane = std::make_unique<Pane>();
+            for (const auto& field : group_by_fields_) {
+                pane->group_values.emplace_back(field);
+            }
+        }
+
+        key.clear();
+        for (const Column* column : groupColumns) {
+            appendCellKey(key, column, row);
+        }
+        auto it = pane->index.find(key);
+        size_t group;
+        if (it != pane->index.end()) {
+            group = it->second;
+        } else {
+            group = pane->keys.size();
+            pane->index.emplace(key, group);
+            pane->keys.push_back(key);
+            for (size_t i = 0; i < groupColumns.size(); ++i) {
+                if (groupColumns[i]) {
+                    pane->group_values[i].appendFrom(*groupColumns[i], row);
+                } else {
+                    pane->group_values[i].appendAbsent();
+                }
+            }
+            pane->accumulators.resize(pane->accumulators.size() + specs_.size());
+        }
+
+        Accumulator* acc = &pane->accumulators[group * specs_.size()];
+        for (size_t i = 0; i < specs_.size(); ++i) {
+            const Column* column = valueColumns[i];
+            if (!column || !column->isPresent(row)) continue;
+
+            acc[i].values++;
+            double value;
+            if (numericCellValue(*column, row, value)) {
+                acc[i].add(value);
+            }
+        }
+    }
+}
+
+void WindowAggregateOperator::advance(int64_t watermark, StreamBatch& out) {
+    if (watermark <= watermark_) return;
+
+    while (!panes_.empty()) {
+        // The earliest unemitted window holding data; every pane before
+        // next_window_start_ is gone, so it always contains the first pane
+        int64_t start = firstWindowStart(panes_.begin()->first);
+        if (next_window_start_ != NO_WATERMARK) {
+            start = std::max(start, next_window_start_);
+        }
+        if (start > watermark - (window_.size_ms - 1)) break;
+
+        emitWindow(start, out);
+        next_window_start_ = start + window_.slide_ms;
+        while (!panes_.empty() && panes_.begin()->first < next_window_start_) {
+            panes_.erase(panes_.begin());
+        }
+    }
+    watermark_ = watermark;
+}
+
+void WindowAggregateOperator::emitWindow(int64_t start, StreamBatch& out) {
+    int64_t end = start + window_.size_ms;
+    auto first = panes_.lower_bound(start);
+    auto last = panes_.lower_bound(end);
+    if (first == last) return;
+
+    // One pane per window when tumbling; otherwise merge the panes in time
+    // order so groups keep their first-appearance order
+    Pane merged;
+    const Pane* window = nullptr;
+    if (std::next(first) == last) {
+        window = first->second.get();
+    } else {
+        for (const auto& field : group_by_fields_) {
+            merged.group_values.emplace_back(field);
+        }
+        for (auto it = first; it != last; ++it) {
+            const Pane& pane = *it->second;
+            for (size_t group = 0; group < pane.keys.size(); ++group) {
+                auto found = merged.index.find(pane.keys[group]);
+                size_t target;
+                if (found != merged.index.end()) {
+                    target = found->second;
+                } else {
+                    target = merged.keys.size();
+                    merged.index.emplace(pane.keys[group], target);
+                    merged.keys.push_back(pane.keys[group]);
+                    for (size_t i = 0; i < pane.group_values.size(); ++i) {
+                        merged.group_values[i].appendFrom(pane.group_values[i], group);
+                    }
+                    merged.accumulators.resize(merged.accumulators.size() + specs_.size());
+                }
+                for (size_t i = 0; i < specs_.size(); ++i) {
+                    merged.accumulators[target * specs_.size() + i].merge(
+                        pane.accumulators[group * specs_.size() + i]);
+                }
+            }
+        }
+        window = &merged;
+    }
+
+    size_t groups = window->keys.size();
+    std::vector<Column> columns;
+    columns.emplace_back("window_start");
+    columns.emplace_back("window_end");
+    for (size_t group = 0; group < groups; ++group) {
+        columns[0].append(start);
+        columns[1].append(end);
+    }
+    for (const Column& column : window->group_values) {
+        columns.push_back(column);
+    }
+    for (size_t i = 0; i < specs_.size(); ++i) {
+        Column output(specs_[i].output_name);
+        for (size_t group = 0; group < groups; ++group) {
+            output.append(window->accumulators[group * specs_.size() + i].result(specs_[i].function));
+        }
+        columns.push_back(std::move(output));
+    }
+
+    out.records.append(RecordBatch::fromColumns(std::move(columns)));
+    out.event_times.insert(out.event_times.end(), groups, end - 1);
+    windows_emitted_.fetch_add(1, std::memory_order_relaxed);
+}
+
+StreamWriterSink::StreamWriterSink(FileWriter::StreamWriter& writer, std::chrono::milliseconds flushInterval)
+    : writer_(writer), flush_interval_(flushInterval), last_flush_(SteadyClock::now()) {}
+
+void StreamWriterSink::process(StreamBatch& batch) {
+    for (size_t row = 0; row < batch.records.numRows(); ++row) {
+        if (!writer_.writeJsonRecord(batch.records.recordAt(row))) {
+            throw std::runtime_error("Stream sink: failed to write a record");
+        }
+    }
+
+    auto now = SteadyClock::now();
+    if (batch.watermark == END_OF_STREAM || now - last_flush_ >= flush_interval_) {
+        writer_.flush();
+        last_flush_ = now;
+    }
+}
+
+// One operator and the ring feeding it
+struct StreamPipeline::Stage {
+    std::unique_ptr<StreamOperator> op;
+    std::unique_ptr<SpscRing<StreamBatch>> input;
+};
+
+StreamPipeline::StreamPipeline(StreamPipelineOptions options)
+    : options_(std::move(options)), input_(options_.input_capacity) {}
+
+StreamPipeline::~StreamPipeline() {
+    if (started_ && !threads_.empty()) {
+        try {
+            finish();
+        } catch (...) {
+            // Destructors must not throw; call finish() to see the error
+        }
+    }
+}
+
+StreamPipeline& StreamPipeline::then(std::unique_ptr<StreamOperator> op) {
+    if (started_) {
+        throw std::runtime_error("Stream pipeline already started");
+    }
+    auto stage = std::make_unique<Stage>();
+    stage->op = std::move(op);
+    stage->input = std::make_unique<SpscRing<StreamBatch>>(options_.stage_capacity);
+    stages_.push_back(std::move(stage));
+    return *this;
+}
+
+StreamPipeline& StreamPipeline::map(std::function<void(RecordBatch&)> fn) {
+    return then(std::make_unique<MapOperator>(std::move(fn)));
+}
+
+StreamPipeline& StreamPipeline::filter(std::function<bool(const RecordBatch&, size_t row)> keep) {
+    return then(std::make_unique<FilterOperator>(std::move(keep)));
+}
+
+StreamPipeline& StreamPipeline::window(WindowSpec window, std::vector<std::string> groupByFields,
+                                       const std::map<std::string, std::string>& aggregations) {
+    auto op = std::make_unique<WindowAggregateOperator>(window, std::move(groupByFields), aggregations);
+    windows_.push_back(op.get());
+    return then(std::move(op));
+}
+
+StreamPipeline& StreamPipeline::sink(FileWriter::StreamWriter& writer) {
+    return then(std::make_unique<StreamWriterSink>(writer));
+}
+
+StreamPipeline& StreamPipeline::sink(std::function<void(const StreamBatch&)> fn) {
+    return then(std::make_unique<CallbackSink>(std::move(fn)));
+}
+
+void StreamPipeline::start() {
+    if (stages_.empty()) {
+        throw std::runtime_error("Stream pipeline has no operators");
+    }
+    if (started_.exchange(true)) {
+        throw std::runtime_error("Stream pipeline already started");
+    }
+    for (size_t i = 0; i < stages_.size(); ++i) {
+        threads_.emplace_back([this, i] { runStage(i); });
+    }
+    threads_.emplace_back([this] { runSource(); });
+}
+
+bool StreamPipeline::tryPush(nlohmann::json& record) {
+    if (input_closed_.load(std::memory_order_relaxed) || failed_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    return input_.tryPush(record);
+}
+
+bool StreamPipeline::push(nlohmann::json record) {
+    Backoff backoff;
+    for (;;) {
+        if (input_closed_.load(std::memory_order_relaxed) || failed_.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        if (input_.tryPush(record)) return true;
+        backoff.pause();
+    }
+}
+
+void StreamPipeline::finish() {
+    if (!started_) {
+        throw std::runtime_error("Stream pipeline not started");
+    }
+    input_closed_.store(true, std::memory_order_release);
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+    threads_.clear();
+
+    std::lock_guard<std::mutex> lock(error_mutex_);
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+}
+
+StreamPipelineStats StreamPipeline::stats() const {
+    StreamPipelineStats stats;
+    stats.records_in = records_in_.load(std::memory_order_relaxed);
+    stats.records_out = records_out_.load(std::memory_order_relaxed);
+    stats.batches = batches_.load(std::memory_order_relaxed);
+    stats.watermark = last_watermark_.load(std::memory_order_relaxed);
+    for (const auto* window : windows_) {
+        stats.late_records += window->lateRecords();
+        stats.windows_emitted += window->windowsEmitted();
+    }
+    return stats;
+}
+
+void StreamPipeline::fail(std::exception_ptr error) {
+    std::lock_guard<std::mutex> lock(error_mutex_);
+    if (!error_) {
+        error_ = error;
+    }
+    failed_.store(true, std::memory_order_relaxed);
+}
+
+int64_t StreamPipeline::eventTime(const nlohmann::json& record, int64_t now) const {
+    if (options_.time_field.empty() || !record.is_object()) return now;
+
+    auto it = record.find(options_.time_field);
+    if (it == record.end()) return now;
+    if (it->is_number()) return it->get<int64_t>();
+    int64_t millis;
+    if (it->is_string() && parseIsoTime(it->get_ref<const std::string&>(), millis)) return millis;
+    return now;
+}
+
+void StreamPipeline::runSource() {
+    SpscRing<StreamBatch>& out = *stages_.front()->input;
+    bool arrivalTime = options_.time_field.empty();
+
+    StreamBatch batch;
+    int64_t maxEventTime = NO_WATERMARK;
+    int64_t watermark = NO_WATERMARK;
+    int64_t sentWatermark = NO_WATERMARK;
+    auto batchStarted = SteadyClock::now();
+    auto lastInput = SteadyClock::now();
+    auto lastSend = SteadyClock::now();
+
+    auto send = [&]() {
+        if (batch.records.numRows() > 0) {
+            batches_.fetch_add(1, std::memory_order_relaxed);
+        }
+        batch.watermark = watermark;
+        sentWatermark = watermark;
+        lastSend = SteadyClock::now();
+        out.push(std::move(batch));
+        batch = StreamBatch();
+    };
+
+    nlohmann::json record;
+    Backoff backoff;
+    for (;;) {
+        // Read the flag first: a record pushed before finish() is then
+        // always popped before the loop ends
+        bool closed = input_closed_.load(std::memory_order_acquire);
+        if (input_.tryPop(record)) {
+            backoff.reset();
+            lastInput = SteadyClock::now();
+            if (failed_.load(std::memory_order_relaxed)) continue;
+
+            if (batch.records.numRows() == 0) batchStarted = lastInput;
+            int64_t time = eventTime(record, systemMillis());
+            batch.records.appendRecord(record);
+            batch.event_times.push_back(time);
+            records_in_.fetch_add(1, std::memory_order_relaxed);
+
+            // Arrival times only grow, so only later milliseconds can follow
+            maxEventTime = std::max(maxEventTime, time);
+            watermark = std::max(watermark, arrivalTime ? maxEventTime - 1
+                                                        : maxEventTime - options_.max_out_of_order_ms);
+            if (batch.records.numRows() >= options_.batch_records) send();
+            continue;
+        }
+        if (closed) break;
+
+        auto now = SteadyClock::now();
+        if (arrivalTime) {
+            watermark = std::max(watermark, systemMillis() - 1);
+        } else if (options_.idle_timeout_ms > 0 &&
+                   now - lastInput >= std::chrono::milliseconds(options_.idle_timeout_ms)) {
+            watermark = std::max(watermark, systemMillis() - options_.max_out_of_order_ms);
+        }
+
+        if (batch.records.numRows() > 0) {
+            if (now - batchStarted >= options_.max_batch_delay) send();
+        } else if (watermark > sentWatermark && now - lastSend >= options_.max_batch_delay) {
+            send();
+        }
+        backoff.pause();
+    }
+
+    if (batch.records.numRows() > 0) send();
+    watermark = END_OF_STREAM;
+    send();
+}
+
+void StreamPipeline::runStage(size_t index) {
+    Stage& stage = *stages_[index];
+    SpscRing<StreamBatch>* out = index + 1 < stages_.size() ? stages_[index + 1]->input.get() : nullptr;
+    int64_t forwarded = NO_WATERMARK;
+
+    for (;;) {
+        StreamBatch batch = stage.input->pop();
+        bool end = batch.watermark == END_OF_STREAM;
+        if (!failed_.load(std::memory_order_relaxed)) {
+            try {
+                stage.op->process(batch);
+            } catch (...) {
+                fail(std::current_exception());
+            }
+        }
+
+        if (out) {
+            // Watermark-only batches go on only when they move it
+            if (batch.records.numRows() > 0 || batch.watermark > forwarded || end) {
+                forwarded = std::max(forwarded, batch.watermark);
+                out->push(std::move(batch));
+            }
+        } else {
+            records_out_.fetch_add(batch.records.numRows(), std::memory_order_relaxed);
+            last_watermark_.store(batch.watermark, std::memory_order_relaxed);
+        }
+        if (end) return;
+    }
+}
+
+} // namespace etl
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <thread>
+#include <exception>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <nlohmann/json.hpp>
+#include "record_batch.h"
+#include "aggregation.h"
+#include "common/ring_buffer.h"
+#include "loaders/file_writer.h"
+
+namespace etl {
+
+constexpr int64_t NO_WATERMARK = std::numeric_limits<int64_t>::min();
+constexpr int64_t END_OF_STREAM = std::numeric_limits<int64_t>::max();
+
+// Unit of work between pipeline stages: a group of records with their
+// event times (epoch milliseconds), and the watermark as of the last of
+// them. The watermark promises that no later record has an event time at
+// or before it; END_OF_STREAM closes everything. A batch may carry no
+// records and only move the watermark.
+struct StreamBatch {
+    RecordBatch records;
+    std::vector<int64_t> event_times;
+    int64_t watermark = NO_WATERMARK;
+};
+
+// One step of a StreamPipeline. Each operator runs on a thread of its own
+// and sees every batch in order; whatever it leaves in the batch, watermark
+// included, goes to the next stage.
+class StreamOperator {
+public:
+    virtual ~StreamOperator() = default;
+
+    virtual void process(StreamBatch& batch) = 0;
+};
+
+// Event-time windows [start, start + size), starting every slide
+// milliseconds: tumbling when slide equals size, sliding when it is
+// shorter. A window closes once the watermark reaches its end.
+struct WindowSpec {
+    int64_t size_ms;
+    int64_t slide_ms;
+
+    static WindowSpec tumbling(int64_t sizeMs) { return {sizeMs, sizeMs}; }
+    static WindowSpec sliding(int64_t sizeMs, int64_t slideMs) { return {sizeMs, slideMs}; }
+};
+
+// Groups and aggregates each window like DataTransformer::aggregateData.
+// The same functions and output names are used, and nulls and numeric
+// strings are treated the same way. Records are folded into accumulators for
+// panes of gcd(size, slide) milliseconds as they arrive, and a closing
+// window merges its panes, so a sliding window costs one accumulator update
+// per record however many windows overlap. A closed window emits one row
+// per group, in order of first appearance: window_start, window_end
+// (epoch milliseconds), the group-by fields, then the aggregates. Records
+// arriving after all their windows have closed are dropped and counted as
+// late.
+class WindowAggregateOperator : public StreamOperator {
+public:
+    WindowAggregateOperator(WindowSpec window, std::vector<std::string> groupByFields,
+                            const std::map<std::string, std::string>& aggregations);
+    ~WindowAggregateOperator() override;
+
+    void process(StreamBatch& batch) override;
+
+    size_t lateRecords() const { return late_records_.load(std::memory_order_relaxed); }
+    size_t windowsEmitted() const { return windows_emitted_.load(std::memory_order_relaxed); }
+
+private:
+    struct Pane;
+
+    void add(const StreamBatch& batch);
+    void advance(int64_t watermark, StreamBatch& out);
+    void emitWindow(int64_t start, StreamBatch& out);
+    int64_t firstWindowStart(int64_t time) const;
+
+    WindowSpec window_;
+    int64_t pane_ms_;
+    std::vector<std::string> group_by_fields_;
+    std::vector<AggregateSpec> specs_;
+    std::map<int64_t, std::unique_ptr<Pane>> panes_;    // By pane start
+    int64_t watermark_ = NO_WATERMARK;
+    int64_t next_window_start_ = NO_WATERMARK;          // Lowest window not yet emitted
+    std::atomic<size_t> late_records_{0};
+    std::atomic<size_t> windows_emitted_{0};
+};
+
+// Writes every record reaching it to a FileWriter::StreamWriter, flushing
+// at most every flush_interval and at the end of the stream.
+class StreamWriterSink : public StreamOperator {
+public:
+    explicit StreamWriterSink(FileWriter::StreamWriter& writer,
+                              std::chrono::milliseconds flushInterval = std::chrono::milliseconds(1000));
+
+    void process(StreamBatch& batch) override;
+
+private:
+    FileWriter::StreamWriter& writer_;
+    std::chrono::milliseconds flush_interval_;
+    std::chrono::steady_clock::time_point last_flush_;
+};
+
+struct StreamPipelineOptions {
+    // Field holding each record's event time: epoch milliseconds, or an
+    // ISO 8601 UTC timestamp ("2024-03-15T10:00:00.250Z"). Empty: arrival time.
+    std::string time_field;
+    int64_t max_out_of_order_ms = 500;          // Watermark lag behind the latest event time
+    // After this long without input the watermark follows the wall clock
+    // (minus the lag), so windows still close when event times track real
+    // time and a source falls silent. 0: only event times move it.
+    int64_t idle_timeout_ms = 0;
+    size_t batch_records = 1024;                // Records per batch at most
+    std::chrono::milliseconds max_batch_delay{10};   // Before a partial batch is sent on
+    size_t input_capacity = 65536;              // Records the input ring holds
+    size_t stage_capacity = 64;                 // Batches each ring between stages holds
+};
+
+struct StreamPipelineStats {
+    size_t records_in = 0;
+    size_t records_out = 0;                     // Reaching the last stage
+    size_t late_records = 0;                    // Dropped by window operators
+    size_t windows_emitted = 0;
+    size_t batches = 0;                         // Built by the source stage
+    int64_t watermark = NO_WATERMARK;           // As of the last stage
+};
+
+// Event-time stream processing over a chain of operators. Any number of
+// threads push records into a lock-free MPMC ring. A source thread drains
+// it into batches of at most batch_records, or whatever arrived within
+// max_batch_delay. It stamps event times and watermarks, then hands each
+// batch down a chain of single-producer/single-consumer rings, one operator
+// thread per stage. Full rings push back all the way to push().
+//
+//     StreamPipeline pipeline(options);
+//     pipeline.filter(...).window(WindowSpec::tumbling(1000), {"sensor"}, {{"temp", "avg"}})
+//             .sink(writer);
+//     pipeline.start();
+//     pipeline.push(record);      // From any thread
+//     pipeline.finish();          // Closes the open windows and waits for the last stage
+class StreamPipeline {
+public:
+    explicit StreamPipeline(StreamPipelineOptions options = {});
+    ~StreamPipeline();
+
+    StreamPipeline(const StreamPipeline&) = delete;
+    StreamPipeline& operator=(const StreamPipeline&) = delete;
+
+    // Building; only before start()
+    StreamPipeline& then(std::unique_ptr<StreamOperator> op);
+    StreamPipeline& map(std::function<void(RecordBatch&)> fn);
+    StreamPipeline& filter(std::function<bool(const RecordBatch&, size_t row)> keep);
+    StreamPipeline& window(WindowSpec window, std::vector<std::string> groupByFields,
+                           const std::map<std::string, std::string>& aggregations);
+    StreamPipeline& sink(FileWriter::StreamWriter& writer);
+    StreamPipeline& sink(std::function<void(const StreamBatch&)> fn);
+
+    void start();
+
+    // Blocks while the input ring is full; false once the pipeline has
+    // finished or an operator has failed
+    bool push(nlohmann::json record);
+    bool tryPush(nlohmann::json& record);
+
+    // Ends the input and waits until every stage has drained. Rethrows the
+    // first exception an operator threw.
+    void finish();
+
+    StreamPipelineStats stats() const;
+
+private:
+    struct Stage;
+
+    void runSource();
+    void runStage(size_t index);
+    void fail(std::exception_ptr error);
+    int64_t eventTime(const nlohmann::json& record, int64_t now) const;
+
+    StreamPipelineOptions options_;
+    MpmcRing<nlohmann::json> input_;
+    std::vector<std::unique_ptr<Stage>> stages_;
+    std::vector<WindowAggregateOperator*> windows_;     // For stats
+    std::vector<std::thread> threads_;
+    std::atomic<bool> started_{false};
+    std::atomic<bool> input_closed_{false};
+    std::atomic<bool> failed_{false};
+    std::mutex error_mutex_;
+    std::exception_ptr error_;
+
+    std::atomic<size_t> records_in_{0};
+    std::atomic<size_t> records_out_{0};
+    std::atomic<size_t> batches_{0};
+    std::atomic<int64_t> last_watermark_{NO_WATERMARK};
+};
+
+} // namespace etl
@@ -0,0 +1,522 @@
+#include "stream_operators.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace etl {
+
+namespace {
+
+// Past this many nested spill passes the budget is ignored, so input that
+// keeps spilling (a budget far below the table's minimum size) still ends.
+// Every pass admits at least one key, so each one makes progress.
+constexpr size_t MAX_SPILL_DEPTH = 8;
+
+// Write buffer of each spill file; a pass may have spill_partitions open
+constexpr size_t SPILL_BUFFER_BYTES = 64 << 10;
+
+constexpr size_t BLOOM_BITS_PER_KEY = 10;
+constexpr size_t BLOOM_BLOCK_BITS = 512;
+constexpr size_t BLOOM_WORDS_PER_BLOCK = BLOOM_BLOCK_BITS / 64;
+constexpr size_t BLOOM_PROBES = 7;
+
+inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t fmix64(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+// Rough heap footprint of a stored group-by value
+size_t jsonBytes(const nlohmann::json& value) {
+    size_t bytes = sizeof(nlohmann::json);
+    if (value.is_string()) {
+        bytes += value.get_ref<const std::string&>().capacity();
+    } else if (value.is_structured()) {
+        bytes += 2 * value.dump().size();
+    }
+    return bytes;
+}
+
+// Files one spill pass writes, NDJSON records split by fingerprint. The
+// split depends on the pass depth, so a partition spilled again divides
+// further instead of repeating itself. Files are removed on destruction.
+class SpillPartitions {
+public:
+    SpillPartitions(const StreamingOptions& options, size_t depth, StreamingStats& stats)
+        : depth_(depth), stats_(stats), writers_(std::max<size_t>(options.spill_partitions, 1)),
+          paths_(writers_.size()) {
+        directory_ = options.spill_directory.empty() ? std::filesystem::temp_directory_path()
+                                                     : std::filesystem::path(options.spill_directory);
+    }
+
+    ~SpillPartitions() {
+        for (size_t i = 0; i < paths_.size(); ++i) {
+            remove(i);
+        }
+    }
+
+    SpillPartitions(const SpillPartitions&) = delete;
+    SpillPartitions& operator=(const SpillPartitions&) = delete;
+
+    void write(const Fingerprint& fingerprint, const nlohmann::json& record) {
+        uint64_t mixed = fmix64(fingerprint.lo ^ (0x9e3779b97f4a7c15ULL * (depth_ + 1)));
+        size_t partition = static_cast<size_t>(mixed % writers_.size());
+        if (!writers_[partition]) {
+            static std::atomic<uint64_t> counter{0};
+            std::string name = "etl-spill-" + std::to_string(getpid()) + "-" + std::to_string(counter++) +
+                               "-" + std::to_string(partition) + ".ndjson";
+            paths_[partition] = (directory_ / name).string();
+            writers_[partition] = std::make_unique<JsonLinesWriter>(paths_[partition], SPILL_BUFFER_BYTES);
+            stats_.spill_files++;
+        }
+        writers_[partition]->write(record);
+        stats_.spilled_records++;
+    }
+
+    // Closes every file; throws std::runtime_error on a write error
+    void finish() {
+        for (auto& writer : writers_) {
+            if (writer) writer->close();
+        }
+    }
+
+    size_t count() const { return paths_.size(); }
+    const std::string& path(size_t i) const { return paths_[i]; }
+
+    void remove(size_t i) {
+        writers_[i].reset();
+        if (!paths_[i].empty()) {
+            std::error_code ignored;
+            std::filesystem::remove(paths_[i], ignored);
+            paths_[i].clear();
+        }
+    }
+
+private:
+    size_t depth_;
+    StreamingStats& stats_;
+    std::filesystem::path directory_;
+    std::vector<std::unique_ptr<JsonLinesWriter>> writers_;
+    std::vector<std::string> paths_;            // Empty for partitions never written
+};
+
+std::unique_ptr<BloomFilter> bloomOf(const FingerprintTable& table) {
+    auto bloom = std::make_unique<BloomFilter>(table.size());
+    table.forEach([&](const Fingerprint& fingerprint, uint32_t) { bloom->add(fingerprint); });
+    return bloom;
+}
+
+} // namespace
+
+KeyEncoder::KeyEncoder(const RecordBatch& batch, const std::vector<std::string>& fields)
+    : whole_record_(fields.empty()) {
+    if (whole_record_) {
+        for (const auto& column : batch.columns()) {
+            columns_.push_back(&column);
+        }
+        std::sort(columns_.begin(), columns_.end(), [](const Column* a, const Column* b) {
+            return a->name() < b->name();
+        });
+    } else {
+        for (const auto& field : fields) {
+            columns_.push_back(batch.findColumn(field));
+        }
+    }
+}
+
+void KeyEncoder::encode(size_t row, std::string& key) const {
+    key.clear();
+    for (const Column* column : columns_) {
+        if (whole_record_) {
+            if (column->state(row) == Column::ABSENT) continue;
+            key += std::to_string(column->name().size());
+            key += ':';
+            key += column->name();
+        }
+        appendCellKey(key, column, row);
+    }
+}
+
+Fingerprint fingerprintOf(const std::string& key) {
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(key.data());
+    const size_t len = key.size();
+    const size_t nblocks = len / 16;
+    const uint64_t c1 = 0x87c37b91114253d5ULL;
+    const uint64_t c2 = 0x4cf5ad432745937fULL;
+    uint64_t h1 = 0;
+    uint64_t h2 = 0;
+
+    for (size_t i = 0; i < nblocks; ++i) {
+        uint64_t k1;
+        uint64_t k2;
+        std::memcpy(&k1, data + i * 16, 8);
+        std::memcpy(&k2, data + i * 16 + 8, 8);
+
+        k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+        h1 = rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+        k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+        h2 = rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+    }
+
+    const uint8_t* tail = data + nblocks * 16;
+    uint64_t k1 = 0;
+    uint64_t k2 = 0;
+    switch (len & 15) {
+        case 15: k2 ^= static_cast<uint64_t>(tail[14]) << 48; [[fallthrough]];
+        case 14: k2 ^= static_cast<uint64_t>(tail[13]) << 40; [[fallthrough]];
+        case 13: k2 ^= static_cast<uint64_t>(tail[12]) << 32; [[fallthrough]];
+        case 12: k2 ^= static_cast<uint64_t>(tail[11]) << 24; [[fallthrough]];
+        case 11: k2 ^= static_cast<uint64_t>(tail[10]) << 16; [[fallthrough]];
+        case 10: k2 ^= static_cast<uint64_t>(tail[9]) << 8; [[fallthrough]];
+        case 9:  k2 ^= static_cast<uint64_t>(tail[8]);
+                 k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+                 [[fallthrough]];
+        case 8:  k1 ^= static_cast<uint64_t>(tail[7]) << 56; [[fallthrough]];
+        case 7:  k1 ^= static_cast<uint64_t>(tail[6]) << 48; [[fallthrough]];
+        case 6:  k1 ^= static_cast<uint64_t>(tail[5]) << 40; [[fallthrough]];
+        case 5:  k1 ^= static_cast<uint64_t>(tail[4]) << 32; [[fallthrough]];
+        case 4:  k1 ^= static_cast<uint64_t>(tail[3]) << 24; [[fallthrough]];
+        case 3:  k1 ^= static_cast<uint64_t>(tail[2]) << 16; [[fallthrough]];
+        case 2:  k1 ^= static_cast<uint64_t>(tail[1]) << 8; [[fallthrough]];
+        case 1:  k1 ^= static_cast<uint64_t>(tail[0]);
+                 k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+                 break;
+        default: break;
+    }
+
+    h1 ^= len;
+    h2 ^= len;
+    h1 += h2;
+    h2 += h1;
+    h1 = fmix64(h1);
+    h2 = fmix64(h2);
+    h1 += h2;
+    h2 += h1;
+
+    if (h1 == 0 && h2 == 0) {
+        h1 = 1;
+    }
+    return Fingerprint{h1, h2};
+}
+
+FingerprintTable::FingerprintTable(size_t initialCapacity) : size_(0) {
+    size_t capacity = 16;
+    while (capacity < initialCapacity) {
+        capacity <<= 1;
+    }
+    slots_.assign(capacity, Slot{0, 0, 0});
+}
+
+size_t FingerprintTable::memoryBytesForInsert() const {
+    bool grows = (size_ + 1) * 10 > slots_.size() * 7;
+    return grows ? 2 * memoryBytes() : memoryBytes();
+}
+
+const uint32_t* FingerprintTable::find(const Fingerprint& fingerprint) const {
+    size_t mask = slots_.size() - 1;
+    for (size_t i = fingerprint.lo & mask;; i = (i + 1) & mask) {
+        const Slot& slot = slots_[i];
+        if (slot.lo == fingerprint.lo && slot.hi == fingerprint.hi) {
+            return &slot.value;
+        }
+        if (slot.lo == 0 && slot.hi == 0) {
+            return nullptr;
+        }
+    }
+}
+
+bool FingerprintTable::insert(const Fingerprint& fingerprint, uint32_t value) {
+    if ((size_ + 1) * 10 > slots_.size() * 7) {
+        grow();
+    }
+
+    size_t mask = slots_.size() - 1;
+    for (size_t i = fingerprint.lo & mask;; i = (i + 1) & mask) {
+        Slot& slot = slots_[i];
+        if (slot.lo == fingerprint.lo && slot.hi == fingerprint.hi) {
+            return false;
+        }
+        if (slot.lo == 0 && slot.hi == 0) {
+            slot = Slot{fingerprint.lo, fingerprint.hi, value};
+            size_++;
+            return true;
+        }
+    }
+}
+
+void FingerprintTable::grow() {
+    std::vector<Slot> old(slots_.size() * 2, Slot{0, 0, 0});
+    old.swap(slots_);
+
+    size_t mask = slots_.size() - 1;
+    for (const Slot& slot : old) {
+        if (slot.lo == 0 && slot.hi == 0) continue;
+        size_t i = slot.lo & mask;
+        while (slots_[i].lo != 0 || slots_[i].hi != 0) {
+            i = (i + 1) & mask;
+        }
+        slots_[i] = slot;
+    }
+}
+
+BloomFilter::BloomFilter(size_t expectedKeys) {
+    num_blocks_ = std::max<size_t>(1, (expectedKeys * BLOOM_BITS_PER_KEY + BLOOM_BLOCK_BITS - 1) / BLOOM_BLOCK_BITS);
+    blocks_.assign(num_blocks_ * BLOOM_WORDS_PER_BLOCK, 0);
+}
+
+void BloomFilter::add(const Fingerprint& fingerprint) {
+    uint64_t* block = &blocks_[(fingerprint.hi % num_blocks_) * BLOOM_WORDS_PER_BLOCK];
+    for (size_t i = 0; i < BLOOM_PROBES; ++i) {
+        size_t bit = (fingerprint.lo >> (1 + 9 * i)) & (BLOOM_BLOCK_BITS - 1);
+        block[bit / 64] |= uint64_t(1) << (bit % 64);
+    }
+}
+
+bool BloomFilter::mayContain(const Fingerprint& fingerprint) const {
+    const uint64_t* block = &blocks_[(fingerprint.hi % num_blocks_) * BLOOM_WORDS_PER_BLOCK];
+    for (size_t i = 0; i < BLOOM_PROBES; ++i) {
+        size_t bit = (fingerprint.lo >> (1 + 9 * i)) & (BLOOM_BLOCK_BITS - 1);
+        if (!(block[bit / 64] & (uint64_t(1) << (bit % 64)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+StreamingDeduplicator::StreamingDeduplicator(std::vector<std::string> keyFields, StreamingOptions options)
+    : key_fields_(std::move(keyFields)), options_(std::move(options)) {
+}
+
+StreamingStats StreamingDeduplicator::run(RecordReader& input, JsonLinesWriter& output) {
+    StreamingStats stats;
+    runPass(input, output, 0, stats);
+    return stats;
+}
+
+void StreamingDeduplicator::runPass(RecordReader& input, JsonLinesWriter& output, size_t depth,
+                                    StreamingStats& stats) {
+    const bool limited = depth < MAX_SPILL_DEPTH;
+    SpillPartitions spill(options_, depth, stats);
+    {
+        FingerprintTable table;
+        std::unique_ptr<BloomFilter> bloom;
+        bool frozen = false;
+
+        RecordBatch batch;
+        std::string key;
+        std::vector<size_t> keep;
+        while (input.next(batch, options_.batch_rows)) {
+            if (depth == 0) {
+                stats.records_in += batch.numRows();
+            }
+
+            KeyEncoder encoder(batch, key_fields_);
+            keep.clear();
+            for (size_t row = 0; row < batch.numRows(); ++row) {
+                encoder.encode(row, key);
+                Fingerprint fingerprint = fingerprintOf(key);
+
+                if (frozen) {
+                    // Keys first seen after the freeze are settled per partition
+                    bool known = (!bloom || bloom->mayContain(fingerprint)) && table.find(fingerprint);
+                    if (!known) {
+                        spill.write(fingerprint, batch.recordAt(row));
+                    }
+                    continue;
+                }
+                if (table.find(fingerprint)) {
+                    continue;
+                }
+                if (limited && table.size() > 0 && table.memoryBytesForInsert() > options_.memory_budget_bytes) {
+                    frozen = true;
+                    if (options_.use_bloom_filter) {
+                        bloom = bloomOf(table);
+                    }
+                    spill.write(fingerprint, batch.recordAt(row));
+                    continue;
+                }
+                table.insert(fingerprint, 0);
+                keep.push_back(row);
+            }
+
+            if (keep.size() == batch.numRows()) {
+                output.write(batch);
+            } else if (!keep.empty()) {
+                output.write(batch.take(keep));
+            }
+            stats.records_out += keep.size();
+        }
+    }
+
+    spill.finish();
+    for (size_t i = 0; i < spill.count(); ++i) {
+        if (spill.path(i).empty()) continue;
+        JsonLinesRecordReader partition(spill.path(i));
+        runPass(partition, output, depth + 1, stats);
+        spill.remove(i);
+    }
+}
+
+StreamingAggregator::StreamingAggregator(std::vector<std::string> groupByFields,
+                                         const std::map<std::string, std::string>& aggregations,
+                                         StreamingOptions options)
+    : group_by_fields_(std::move(groupByFields)), specs_(parseAggregateSpecs(aggregations)),
+      options_(std::move(options)) {
+}
+
+StreamingStats StreamingAggregator::run(RecordReader& input, JsonLinesWriter& output) {
+    StreamingStats stats;
+    runPass(input, output, 0, stats);
+    return stats;
+}
+
+void StreamingAggregator::runPass(RecordReader& input, JsonLinesWriter& output, size_t depth,
+                                  StreamingStats& stats) {
+    const bool limited = depth < MAX_SPILL_DEPTH;
+    const size_t numFields = group_by_fields_.size();
+    const size_t numSpecs = specs_.size();
+    SpillPartitions spill(options_, depth, stats);
+    {
+        FingerprintTable table;
+        std::unique_ptr<BloomFilter> bloom;
+        bool frozen = false;
+
+        // Group state, one entry per group in order of first appearance
+        std::vector<nlohmann::json> groupValues;    // group * numFields + field; discarded if absent
+        std::vector<Accumulator> accumulators;      // group * numSpecs + spec
+        size_t groupBytes = 0;
+
+        RecordBatch batch;
+        std::string key;
+        while (input.next(batch, options_.batch_rows)) {
+            if (depth == 0) {
+                stats.records_in += batch.numRows();
+            }
+
+            std::vector<const Column*> groupColumns;
+            for (const auto& field : group_by_fields_) {
+                groupColumns.push_back(batch.findColumn(field));
+            }
+            std::vector<const Column*> valueColumns;
+            for (const auto& spec : specs_) {
+                valueColumns.push_back(batch.findColumn(spec.field));
+            }
+
+            auto groupValue = [&](size_t g, size_t row) {
+                const Column* column = groupColumns[g];
+                if (!column || column->state(row) == Column::ABSENT) {
+                    return nlohmann::json(nlohmann::json::value_t::discarded);
+                }
+                return column->valueAt(row);
+            };
+
+            for (size_t row = 0; row < batch.numRows(); ++row) {
+                key.clear();
+                for (const Column* column : groupColumns) {
+                    appendCellKey(key, column, row);
+                }
+                Fingerprint fingerprint = fingerprintOf(key);
+
+                const uint32_t* found = nullptr;
+                if (!frozen || !bloom || bloom->mayContain(fingerprint)) {
+                    found = table.find(fingerprint);
+                }
+
+                size_t group;
+                if (found) {
+                    group = *found;
+                } else {
+                    size_t added = numSpecs * sizeof(Accumulator);
+                    std::vector<nlohmann::json> values;
+                    if (!frozen) {
+                        for (size_t g = 0; g < numFields; ++g) {
+                            values.push_back(groupValue(g, row));
+                            added += jsonBytes(values.back());
+                        }
+                        if (limited && table.size() > 0 &&
+                            table.memoryBytesForInsert() + groupBytes + added > options_.memory_budget_bytes) {
+                            frozen = true;
+                            if (options_.use_bloom_filter) {
+                                bloom = bloomOf(table);
+                            }
+                        }
+                    }
+
+                    if (frozen) {
+                        // Only what the aggregation reads goes to disk
+                        nlohmann::json record = nlohmann::json::object();
+                        for (size_t g = 0; g < numFields; ++g) {
+                            if (groupColumns[g] && groupColumns[g]->state(row) != Column::ABSENT) {
+                                record[group_by_fields_[g]] = groupColumns[g]->valueAt(row);
+                            }
+                        }
+                        for (size_t i = 0; i < numSpecs; ++i) {
+                            if (valueColumns[i] && valueColumns[i]->isPresent(row)) {
+                                record[specs_[i].field] = valueColumns[i]->valueAt(row);
+                            }
+                        }
+                        spill.write(fingerprint, record);
+                        continue;
+                    }
+
+                    group = table.size();
+                    table.insert(fingerprint, static_cast<uint32_t>(group));
+                    for (auto& value : values) {
+                        groupValues.push_back(std::move(value));
+                    }
+                    accumulators.resize(accumulators.size() + numSpecs);
+                    groupBytes += added;
+                }
+
+                Accumulator* acc = numSpecs ? &accumulators[group * numSpecs] : nullptr;
+                for (size_t i = 0; i < numSpecs; ++i) {
+                    const Column* column = valueColumns[i];
+                    if (!column || !column->isPresent(row)) continue;
+
+                    acc[i].values++;
+                    double value;
+                    if (numericCellValue(*column, row, value)) {
+                        acc[i].add(value);
+                    }
+                }
+            }
+        }
+
+        size_t groups = table.size();
+        for (size_t group = 0; group < groups; ++group) {
+            nlohmann::json record = nlohmann::json::object();
+            for (size_t g = 0; g < numFields; ++g) {
+                const nlohmann::json& value = groupValues[group * numFields + g];
+                if (!value.is_discarded()) {
+                    record[group_by_fields_[g]] = value;
+                }
+            }
+            for (size_t i = 0; i < numSpecs; ++i) {
+                record[specs_[i].output_name] = accumulators[group * numSpecs + i].result(specs_[i].function);
+            }
+            output.write(record);
+        }
+        stats.records_out += groups;
+    }
+
+    spill.finish();
+    for (size_t i = 0; i < spill.count(); ++i) {
+        if (spill.path(i).empty()) continue;
+        JsonLinesRecordReader partition(spill.path(i));
+        runPass(partition, output, depth + 1, stats);
+        spill.remove(i);
+    }
+}
+
+} // namespace etl
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+#include "record_batch.h"
+#include "record_stream.h"
+#include "aggregation.h"
+
+namespace etl {
+
+struct StreamingOptions {
+    size_t memory_budget_bytes = 256 << 20;     // Hash table and group state
+    size_t batch_rows = 65536;                  // Records read per batch
+    size_t spill_partitions = 64;               // Files each spill pass splits into
+    bool use_bloom_filter = true;               // Prefilter lookups once the table is full
+    std::string spill_directory;                // Empty: the system temp directory
+};
+
+struct StreamingStats {
+    size_t records_in = 0;
+    size_t records_out = 0;
+    size_t spilled_records = 0;                 // Over all passes
+    size_t spill_files = 0;
+};
+
+// 128-bit hash of a record key. Operators compare fingerprints instead of
+// keys, so two distinct keys are merged only on a full 128-bit collision.
+struct Fingerprint {
+    uint64_t lo;
+    uint64_t hi;
+
+    bool operator==(const Fingerprint& other) const { return lo == other.lo && hi == other.hi; }
+};
+
+// Cell keys of the key fields, or for a whole-record key (no fields) each
+// non-absent column's name and cell key in name order, so records key the
+// same however their batch's columns are laid out. Holds pointers into
+// batch, which must outlive it.
+class KeyEncoder {
+public:
+    KeyEncoder(const RecordBatch& batch, const std::vector<std::string>& fields);
+
+    // Replaces key with row's key
+    void encode(size_t row, std::string& key) const;
+
+private:
+    bool whole_record_;
+    std::vector<const Column*> columns_;
+};
+
+// MurmurHash3 x64_128; never returns the all-zero value FingerprintTable
+// uses for empty slots
+Fingerprint fingerprintOf(const std::string& key);
+
+// Open-addressing (linear probing) map from fingerprint to a 32-bit value,
+// kept at most 70% full
+class FingerprintTable {
+public:
+    explicit FingerprintTable(size_t initialCapacity = 1024);
+
+    size_t size() const { return size_; }
+    size_t memoryBytes() const { return slots_.size() * sizeof(Slot); }
+    // Memory the table would need after one more insertion
+    size_t memoryBytesForInsert() const;
+
+    // Value stored for fingerprint, or nullptr
+    const uint32_t* find(const Fingerprint& fingerprint) const;
+    // Stores value unless fingerprint is present; returns whether it was added
+    bool insert(const Fingerprint& fingerprint, uint32_t value);
+
+    template <typename F>
+    void forEach(F fn) const {
+        for (const auto& slot : slots_) {
+            if (slot.lo != 0 || slot.hi != 0) {
+                fn(Fingerprint{slot.lo, slot.hi}, slot.value);
+            }
+        }
+    }
+
+private:
+    struct Slot {
+        uint64_t lo;
+        uint64_t hi;
+        uint32_t value;
+    };
+
+    void grow();
+
+    std::vector<Slot> slots_;
+    size_t size_;
+};
+
+// Blocked Bloom filter: each key sets 7 bits within one 512-bit block, so a
+// lookup touches a single cache line. About 1% false positives at the 10
+// bits per key it is sized for.
+class BloomFilter {
+public:
+    explicit BloomFilter(size_t expectedKeys);
+
+    void add(const Fingerprint& fingerprint);
+    bool mayContain(const Fingerprint& fingerprint) const;
+
+    size_t memoryBytes() const { return blocks_.size() * sizeof(uint64_t); }
+
+private:
+    std::vector<uint64_t> blocks_;              // 8 words per block
+    size_t num_blocks_;
+};
+
+// Keeps the first record of each key, reading its input one batch at a time.
+// Only key fingerprints are held in memory. Once the table reaches the
+// budget it stops growing: later records with a known key are dropped, and
+// records with a new key are spilled to hash partitions on disk, each of
+// which is then deduplicated the same way. Output is the records kept in
+// memory, in input order, followed by those of each partition in turn.
+// Empty keyFields means the whole record is the key.
+class StreamingDeduplicator {
+public:
+    StreamingDeduplicator(std::vector<std::string> keyFields, StreamingOptions options = {});
+
+    StreamingStats run(RecordReader& input, JsonLinesWriter& output);
+
+private:
+    void runPass(RecordReader& input, JsonLinesWriter& output, size_t depth, StreamingStats& stats);
+
+    std::vector<std::string> key_fields_;
+    StreamingOptions options_;
+};
+
+// Groups and aggregates like DataTransformer::aggregateData, reading its
+// input one batch at a time. Once the groups reach the budget, records of
+// known groups are still aggregated in memory while records of new groups
+// (just their group-by and aggregated fields) are spilled to hash
+// partitions and aggregated partition by partition afterwards. Output has
+// the in-memory groups in order of first appearance, then each partition's.
+class StreamingAggregator {
+public:
+    StreamingAggregator(std::vector<std::string> groupByFields,
+                        const std::map<std::string, std::string>& aggregations,
+                        StreamingOptions options = {});
+
+    StreamingStats run(RecordReader& input, JsonLinesWriter& output);
+
+private:
+    void runPass(RecordReader& input, JsonLinesWriter& output, size_t depth, StreamingStats& stats);
+
+    std::vector<std::string> group_by_fields_;
+    std::vector<AggregateSpec> specs_;
+    StreamingOptions options_;
+};
+
+} // namespace etl
@@ -1,33 +1,153 @@
 #include "api_client.h"
+#include "json_field_extractor.h"
 #include <iostream>
 #include <sstream>
 #include <thread>
 #include <chrono>
 #include <functional>
-#include <regex>
+#include <deque>
+#include <queue>
+#include <stdexcept>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <strings.h>
 
 namespace etl {
 
+namespace {
+
+using Clock = TokenBucket::Clock;
+
+// Milliseconds to wait for d, rounded up so a timer is never woken early
+int waitMillis(Clock::duration d) {
+    if (d <= Clock::duration::zero()) return 0;
+    auto ms = std::chrono::ceil<std::chrono::milliseconds>(d).count();
+    return static_cast<int>(std::min<decltype(ms)>(ms, 1000));
+}
+
+// Response fields of the API-specific methods, built on first use and shared
+// by every client and thread
+const JsonFieldExtractor& weatherFields() {
+    static const JsonFieldExtractor extractor({"temp", "description", "humidity", "pressure"});
+    return extractor;
+}
+
+const JsonFieldExtractor& stockFields() {
+    static const JsonFieldExtractor extractor({"price", "change"});
+    return extractor;
+}
+
+const JsonFieldExtractor& articleFields() {
+    static const JsonFieldExtractor extractor({"title", "description", "url"});
+    return extractor;
+}
+
+double numberOr(const nlohmann::json& value, double fallback) {
+    return value.is_number() ? value.get<double>() : fallback;
+}
+
+// Cached get() responses: the status code, the header count, each header
+// name and value, then the body, strings prefixed by a 32-bit length
+void appendField(std::string& out, std::string_view field) {
+    uint32_t size = static_cast<uint32_t>(field.size());
+    out.append(reinterpret_cast<const char*>(&size), sizeof(size));
+    out.append(field);
+}
+
+bool readField(std::string_view& in, std::string& field) {
+    uint32_t size;
+    if (in.size() < sizeof(size)) return false;
+    std::memcpy(&size, in.data(), sizeof(size));
+    in.remove_prefix(sizeof(size));
+    if (in.size() < size) return false;
+    field.assign(in.data(), size);
+    in.remove_prefix(size);
+    return true;
+}
+
+std::string encodeResponse(const ApiResponse& response) {
+    std::string out;
+    appendField(out, std::to_string(response.status_code));
+    appendField(out, std::to_string(response.headers.size()));
+    for (const auto& header : response.headers) {
+        appendField(out, header.first);
+        appendField(out, header.second);
+    }
+    appendField(out, response.body);
+    return out;
+}
+
+bool decodeResponse(std::string_view in, ApiResponse& response) {
+    std::string status, count, name, value;
+    if (!readField(in, status) || !readField(in, count)) return false;
+    response.headers.clear();
+    for (unsigned long i = std::stoul(count); i > 0; --i) {
+        if (!readField(in, name) || !readField(in, value)) return false;
+        response.headers[name] = value;
+    }
+    if (!readField(in, response.body)) return false;
+    response.status_code = std::stol(status);
+    response.total_time = 0.0;
+    response.error_message.clear();
+    response.success = true;
+    return true;
+}
+
+// Seconds a response may be cached for under its Cache-Control header:
+// 0 when it must not be stored, -1 when it sets no limit
+long cacheMaxAge(const std::map<std::string, std::string>& headers) {
+    for (const auto& header : headers) {
+        if (header.first.size() != 13 || strncasecmp(header.first.c_str(), "Cache-Control", 13) != 0) continue;
+        std::string value = header.second;
+        std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return std::tolower(c); });
+        if (value.find("no-store") != std::string::npos || value.find("no-cache") != std::string::npos) {
+            return 0;
+        }
+        size_t pos = value.find("max-age=");
+        if (pos != std::string::npos) {
+            return std::strtol(value.c_str() + pos + 8, nullptr, 10);
+        }
+    }
+    return -1;
+}
+
+} // namespace
+
+// Per-request state of a batch, kept across its retries
+struct ApiClient::Transfer {
+    size_t index = 0;
+    int attempts = 0;
+    CURL* handle = nullptr;                 // While in flight
+    struct curl_slist* headers = nullptr;
+    std::string body;
+    std::map<std::string, std::string> response_headers;
+};
+
 ApiClient::ApiClient() 
-    : curl_handle_(nullptr), default_headers_(nullptr), 
+    : curl_handle_(nullptr), multi_handle_(nullptr), default_headers_(nullptr), request_headers_(nullptr),
       timeout_(30), user_agent_("ETL-Pipeline-API-Client/1.0"),
-      rate_limit_(10), delay_ms_(100), max_retries_(3), retry_delay_ms_(1000) {
+      rate_limit_(10), rate_limiter_(10), max_retries_(3), retry_delay_ms_(1000),
+      max_concurrency_(16), max_host_connections_(0), response_cache_ttl_(60) {
     
     curl_global_init(CURL_GLOBAL_DEFAULT);
     curl_handle_ = curl_easy_init();
     
     if (curl_handle_) {
-        curl_easy_setopt(curl_handle_, CURLOPT_WRITEFUNCTION, WriteCallback);
-        curl_easy_setopt(curl_handle_, CURLOPT_HEADERFUNCTION, HeaderCallback);
-        curl_easy_setopt(curl_handle_, CURLOPT_USERAGENT, user_agent_.c_str());
-        curl_easy_setopt(curl_handle_, CURLOPT_TIMEOUT, timeout_);
-        curl_easy_setopt(curl_handle_, CURLOPT_FOLLOWLOCATION, 1L);
-        curl_easy_setopt(curl_handle_, CURLOPT_SSL_VERIFYPEER, 0L);
-        curl_easy_setopt(curl_handle_, CURLOPT_SSL_VERIFYHOST, 0L);
+        applyCommonOptions(curl_handle_);
     }
 }
 
 ApiClient::~ApiClient() {
+    for (CURL* handle : idle_handles_) {
+        curl_easy_cleanup(handle);
+    }
+    if (multi_handle_) {
+        curl_multi_cleanup(multi_handle_);
+    }
+    if (request_headers_) {
+        curl_slist_free_all(request_headers_);
+    }
     if (default_headers_) {
         curl_slist_free_all(default_headers_);
     }
@@ -76,10 +196,22 @@ void ApiClient::setUserAgent(const std::string& userAgent) {
     }
 }
 
-void ApiClient::setRateLimit(int requestsPerSecond) {
+void ApiClient::setResponseCache(std::shared_ptr<ShardedCache> cache, std::chrono::seconds ttl) {
+    response_cache_ = std::move(cache);
+    response_cache_ttl_ = ttl;
+}
+
+void ApiClient::setRateLimit(int requestsPerSecond, int burst) {
     rate_limit_ = requestsPerSecond;
-    if (requestsPerSecond > 0) {
-        delay_ms_ = 1000 / requestsPerSecond;
+    rate_limiter_.setRate(requestsPerSecond, burst);
+}
+
+void ApiClient::setMaxConcurrency(int maxTransfers, int maxHostConnections) {
+    max_concurrency_ = std::max(maxTransfers, 1);
+    max_host_connections_ = std::max(maxHostConnections, 0);
+    if (multi_handle_) {
+        curl_multi_setopt(multi_handle_, CURLMOPT_MAX_HOST_CONNECTIONS, static_cast<long>(max_host_connections_));
+        curl_multi_setopt(multi_handle_, CURLMOPT_MAXCONNECTS, static_cast<long>(max_concurrency_));
     }
 }
 
@@ -116,7 +248,27 @@ size_t ApiClient::HeaderCallback(void* contents, size_t size, size_t nmemb, std:
 }
 
 ApiResponse ApiClient::get(const std::string& endpoint, const std::map<std::string, std::string>& params) {
-    return request(HttpMethod::GET, endpoint, "", {}, params);
+    if (!response_cache_) {
+        return request(HttpMethod::GET, endpoint, "", {}, params);
+    }
+    
+    std::string key = responseCacheKey(buildUrl(endpoint, params));
+    std::string cached;
+    ApiResponse response;
+    if (response_cache_->get(key, cached) && decodeResponse(cached, response)) {
+        return response;
+    }
+    
+    response = request(HttpMethod::GET, endpoint, "", {}, params);
+    long maxAge = cacheMaxAge(response.headers);
+    if (response.success && response.status_code >= 200 && response.status_code < 300 && maxAge != 0) {
+        std::chrono::seconds ttl = response_cache_ttl_;
+        if (maxAge > 0 && (ttl.count() <= 0 || ttl.count() > maxAge)) {
+            ttl = std::chrono::seconds(maxAge);
+        }
+        response_cache_->put(key, encodeResponse(response), ttl);
+    }
+    return response;
 }
 
 ApiResponse ApiClient::post(const std::string& endpoint, const std::string& body, const std::string& contentType) {
@@ -148,39 +300,23 @@ ApiResponse ApiClient::request(HttpMethod method, const std::string& endpoint,
         
         std::string url = buildUrl(endpoint, params);
         setupRequest(url, headers);
-        
-        // Set HTTP method
-        switch (method) {
-            case HttpMethod::GET:
-                curl_easy_setopt(curl_handle_, CURLOPT_HTTPGET, 1L);
-                break;
-            case HttpMethod::POST:
-                curl_easy_setopt(curl_handle_, CURLOPT_POST, 1L);
-                if (!body.empty()) {
-                    curl_easy_setopt(curl_handle_, CURLOPT_POSTFIELDS, body.c_str());
-                }
-                break;
-            case HttpMethod::PUT:
-                curl_easy_setopt(curl_handle_, CURLOPT_CUSTOMREQUEST, "PUT");
-                if (!body.empty()) {
-                    curl_easy_setopt(curl_handle_, CURLOPT_POSTFIELDS, body.c_str());
-                }
-                break;
-            case HttpMethod::DELETE:
-                curl_easy_setopt(curl_handle_, CURLOPT_CUSTOMREQUEST, "DELETE");
-                break;
-            case HttpMethod::PATCH:
-                curl_easy_setopt(curl_handle_, CURLOPT_CUSTOMREQUEST, "PATCH");
-                if (!body.empty()) {
-                    curl_easy_setopt(curl_handle_, CURLOPT_POSTFIELDS, body.c_str());
-                }
-                break;
-        }
+        setMethod(curl_handle_, method, body);
         
         return performRequest();
     });
 }
 
+// Default headers carry the credentials, so clients sharing a cache under
+// different ones never see each other's responses
+std::string ApiClient::responseCacheKey(const std::string& url) const {
+    std::string key = "GET " + url;
+    for (const struct curl_slist* header = default_headers_; header; header = header->next) {
+        key += '\n';
+        key += header->data;
+    }
+    return key;
+}
+
 std::string ApiClient::buildUrl(const std::string& endpoint, const std::map<std::string, std::string>& params) {
     std::string url = base_url_ + endpoint;
     
@@ -204,9 +340,48 @@ std::string ApiClient::urlEncode(const std::string& str) {
     return result;
 }
 
-void ApiClient::setupRequest(const std::string& url, const std::map<std::string, std::string>& headers) {
-    curl_easy_setopt(curl_handle_, CURLOPT_URL, url.c_str());
+void ApiClient::applyCommonOptions(CURL* handle) {
+    curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, WriteCallback);
+    curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION, HeaderCallback);
+    curl_easy_setopt(handle, CURLOPT_USERAGENT, user_agent_.c_str());
+    curl_easy_setopt(handle, CURLOPT_TIMEOUT, timeout_);
+    curl_easy_setopt(handle, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(handle, CURLOPT_SSL_VERIFYPEER, 0L);
+    curl_easy_setopt(handle, CURLOPT_SSL_VERIFYHOST, 0L);
+}
+
+void ApiClient::setMethod(CURL* handle, HttpMethod method, const std::string& body) {
+    // A reused handle keeps the previous request's method and body otherwise
+    curl_easy_setopt(handle, CURLOPT_CUSTOMREQUEST, nullptr);
+    
+    const char* customMethod = nullptr;
+    switch (method) {
+        case HttpMethod::GET:
+            curl_easy_setopt(handle, CURLOPT_HTTPGET, 1L);
+            return;
+        case HttpMethod::DELETE:
+            curl_easy_setopt(handle, CURLOPT_HTTPGET, 1L);
+            curl_easy_setopt(handle, CURLOPT_CUSTOMREQUEST, "DELETE");
+            return;
+        case HttpMethod::POST:
+            break;
+        case HttpMethod::PUT:
+            customMethod = "PUT";
+            break;
+        case HttpMethod::PATCH:
+            customMethod = "PATCH";
+            break;
+    }
     
+    curl_easy_setopt(handle, CURLOPT_POST, 1L);
+    curl_easy_setopt(handle, CURLOPT_POSTFIELDSIZE, static_cast<long>(body.size()));
+    curl_easy_setopt(handle, CURLOPT_POSTFIELDS, body.c_str());
+    if (customMethod) {
+        curl_easy_setopt(handle, CURLOPT_CUSTOMREQUEST, customMethod);
+    }
+}
+
+struct curl_slist* ApiClient::buildHeaders(const std::map<std::string, std::string>& headers) const {
     // Combine default headers with request-specific headers
     struct curl_slist* all_headers = nullptr;
     
@@ -223,7 +398,19 @@ void ApiClient::setupRequest(const std::string& url, const std::map<std::string,
         all_headers = curl_slist_append(all_headers, headerStr.c_str());
     }
     
+    return all_headers;
+}
+
+void ApiClient::setupRequest(const std::string& url, const std::map<std::string, std::string>& headers) {
+    curl_easy_setopt(curl_handle_, CURLOPT_URL, url.c_str());
+    
+    // The previous request's list is no longer referenced once replaced
+    struct curl_slist* all_headers = buildHeaders(headers);
     curl_easy_setopt(curl_handle_, CURLOPT_HTTPHEADER, all_headers);
+    if (request_headers_) {
+        curl_slist_free_all(request_headers_);
+    }
+    request_headers_ = all_headers;
 }
 
 ApiResponse ApiClient::performRequest() {
@@ -255,15 +442,10 @@ ApiResponse ApiClient::performRequest() {
 }
 
 void ApiClient::respectRateLimit() {
-    static auto lastRequest = std::chrono::steady_clock::now();
-    auto now = std::chrono::steady_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastRequest);
-    
-    if (elapsed.count() < delay_ms_) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms_ - elapsed.count()));
+    // A single request has nothing else to do until its token is due
+    while (!rate_limiter_.tryAcquire()) {
+        std::this_thread::sleep_for(rate_limiter_.timeUntilAvailable());
     }
-    
-    lastRequest = std::chrono::steady_clock::now();
 }
 
 ApiResponse ApiClient::retryRequest(const std::function<ApiResponse()>& requestFunc) {
@@ -286,9 +468,194 @@ ApiResponse ApiClient::retryRequest(const std::function<ApiResponse()>& requestF
     return response;
 }
 
+std::vector<ApiResponse> ApiClient::batchRequests(const std::vector<std::pair<HttpMethod, std::string>>& requests) {
+    std::vector<ApiRequest> converted;
+    converted.reserve(requests.size());
+    for (const auto& request : requests) {
+        ApiRequest r;
+        r.method = request.first;
+        r.endpoint = request.second;
+        converted.push_back(std::move(r));
+    }
+    return batchRequests(converted);
+}
+
+std::vector<ApiResponse> ApiClient::batchRequests(const std::vector<ApiRequest>& requests) {
+    std::vector<ApiResponse> responses(requests.size());
+    batchRequests(requests, [&responses](size_t index, ApiResponse& response) {
+        responses[index] = std::move(response);
+    });
+    return responses;
+}
+
+void ApiClient::batchRequests(const std::vector<ApiRequest>& requests,
+                              const std::function<void(size_t index, ApiResponse& response)>& onResponse) {
+    if (requests.empty()) {
+        return;
+    }
+    if (!multi_handle_) {
+        multi_handle_ = curl_multi_init();
+        if (!multi_handle_) {
+            throw std::runtime_error("Failed to create curl multi handle");
+        }
+        curl_multi_setopt(multi_handle_, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+        curl_multi_setopt(multi_handle_, CURLMOPT_MAX_HOST_CONNECTIONS, static_cast<long>(max_host_connections_));
+        // Keep a connection per transfer slot open between batches
+        curl_multi_setopt(multi_handle_, CURLMOPT_MAXCONNECTS, static_cast<long>(max_concurrency_));
+    }
+    
+    std::vector<Transfer> transfers(requests.size());
+    std::deque<size_t> ready;
+    for (size_t i = 0; i < requests.size(); ++i) {
+        transfers[i].index = i;
+        ready.push_back(i);
+    }
+    using Retry = std::pair<Clock::time_point, size_t>;
+    std::priority_queue<Retry, std::vector<Retry>, std::greater<Retry>> retries;
+    int inFlight = 0;
+    
+    // Transfers still on the multi handle when onResponse or curl throws
+    struct Abandon {
+        ApiClient* client;
+        std::vector<Transfer>& transfers;
+        ~Abandon() {
+            for (auto& transfer : transfers) {
+                if (transfer.handle) {
+                    client->finishTransfer(transfer, CURLE_ABORTED_BY_CALLBACK);
+                }
+            }
+        }
+    } abandon{this, transfers};
+    
+    while (!ready.empty() || !retries.empty() || inFlight > 0) {
+        auto now = Clock::now();
+        while (!retries.empty() && retries.top().first <= now) {
+            ready.push_back(retries.top().second);
+            retries.pop();
+        }
+        while (inFlight < max_concurrency_ && !ready.empty() && rate_limiter_.tryAcquire(now)) {
+            startTransfer(requests[ready.front()], transfers[ready.front()]);
+            ready.pop_front();
+            ++inFlight;
+        }
+        
+        int running = 0;
+        CURLMcode mc = curl_multi_perform(multi_handle_, &running);
+        if (mc != CURLM_OK) {
+            throw std::runtime_error(std::string("curl_multi_perform failed: ") + curl_multi_strerror(mc));
+        }
+        
+        CURLMsg* message;
+        int queued;
+        while ((message = curl_multi_info_read(multi_handle_, &queued))) {
+            if (message->msg != CURLMSG_DONE) {
+                continue;
+            }
+            Transfer* transfer = nullptr;
+            curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, &transfer);
+            ApiResponse response = finishTransfer(*transfer, message->data.result);
+            --inFlight;
+            
+            if (!response.success && transfer->attempts < max_retries_) {
+                retries.emplace(Clock::now() + std::chrono::milliseconds(retry_delay_ms_), transfer->index);
+            } else {
+                onResponse(transfer->index, response);
+            }
+        }
+        
+        if (ready.empty() && retries.empty() && inFlight == 0) {
+            break;
+        }
+        
+        // Sleep in curl until a socket is ready, or the next token or retry is due
+        now = Clock::now();
+        int timeoutMs = 1000;
+        if (!ready.empty() && inFlight < max_concurrency_) {
+            timeoutMs = waitMillis(rate_limiter_.timeUntilAvailable(now));
+        }
+        if (!retries.empty()) {
+            timeoutMs = std::min(timeoutMs, waitMillis(retries.top().first - now));
+        }
+        if (timeoutMs > 0) {
+            mc = curl_multi_poll(multi_handle_, nullptr, 0, timeoutMs, nullptr);
+            if (mc != CURLM_OK) {
+                throw std::runtime_error(std::string("curl_multi_poll failed: ") + curl_multi_strerror(mc));
+            }
+        }
+    }
+}
+
+void ApiClient::startTransfer(const ApiRequest& request, Transfer& transfer) {
+    CURL* handle;
+    if (!idle_handles_.empty()) {
+        handle = idle_handles_.back();
+        idle_handles_.pop_back();
+        curl_easy_reset(handle);
+    } else {
+        handle = curl_easy_init();
+        if (!handle) {
+            throw std::runtime_error("Failed to create curl handle");
+        }
+    }
+    
+    transfer.attempts++;
+    transfer.body.clear();
+    transfer.response_headers.clear();
+    transfer.headers = buildHeaders(request.headers);
+    
+    applyCommonOptions(handle);
+    std::string url = buildUrl(request.endpoint, request.params);
+    curl_easy_setopt(handle, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(handle, CURLOPT_HTTPHEADER, transfer.headers);
+    setMethod(handle, request.method, request.body);
+    curl_easy_setopt(handle, CURLOPT_WRITEDATA, &transfer.body);
+    curl_easy_setopt(handle, CURLOPT_HEADERDATA, &transfer.response_headers);
+    curl_easy_setopt(handle, CURLOPT_PRIVATE, &transfer);
+    
+    // HTTP/2 when TLS negotiates it. Such a transfer waits to share a
+    // connection still being set up rather than opening another to the host;
+    // plain http stays on HTTP/1.1, so there is nothing to wait for.
+    curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+    if (url.compare(0, 8, "https://") == 0) {
+        curl_easy_setopt(handle, CURLOPT_PIPEWAIT, 1L);
+    }
+    
+    CURLMcode mc = curl_multi_add_handle(multi_handle_, handle);
+    if (mc != CURLM_OK) {
+        curl_slist_free_all(transfer.headers);
+        transfer.headers = nullptr;
+        idle_handles_.push_back(handle);
+        throw std::runtime_error(std::string("curl_multi_add_handle failed: ") + curl_multi_strerror(mc));
+    }
+    transfer.handle = handle;
+}
+
+ApiResponse ApiClient::finishTransfer(Transfer& transfer, CURLcode result) {
+    ApiResponse response;
+    curl_easy_getinfo(transfer.handle, CURLINFO_TOTAL_TIME, &response.total_time);
+    
+    if (result == CURLE_OK) {
+        curl_easy_getinfo(transfer.handle, CURLINFO_RESPONSE_CODE, &response.status_code);
+        response.success = (response.status_code >= 200 && response.status_code < 300);
+    } else {
+        response.success = false;
+        response.status_code = 0;
+        response.error_message = curl_easy_strerror(result);
+    }
+    response.body = std::move(transfer.body);
+    response.headers = std::move(transfer.response_headers);
+    
+    curl_multi_remove_handle(multi_handle_, transfer.handle);
+    idle_handles_.push_back(transfer.handle);
+    transfer.handle = nullptr;
+    curl_slist_free_all(transfer.headers);
+    transfer.headers = nullptr;
+    return response;
+}
+
 // API-specific implementations
 ApiClient::WeatherData ApiClient::getWeatherData(const std::string& city, const std::string& apiKey) {
-    WeatherData weather;
+    WeatherData weather{};
     
     // Example using OpenWeatherMap API
     std::map<std::string, std::string> params = {
@@ -300,25 +667,13 @@ ApiClient::WeatherData ApiClient::getWeatherData(const std::string& city, const
     ApiResponse response = get("/weather", params);
     
     if (response.success) {
-        // Parse JSON response (simplified - would use proper JSON parser in production)
-        std::regex tempRegex("\"temp\":([0-9.]+)");
-        std::regex descRegex("\"description\":\"([^\"]+)\"");
-        std::regex humidityRegex("\"humidity\":([0-9.]+)");
-        std::regex pressureRegex("\"pressure\":([0-9.]+)");
-        
-        std::smatch match;
-        if (std::regex_search(response.body, match, tempRegex)) {
-            weather.temperature = std::stod(match[1].str());
-        }
-        if (std::regex_search(response.body, match, descRegex)) {
-            weather.description = match[1].str();
-        }
-        if (std::regex_search(response.body, match, humidityRegex)) {
-            weather.humidity = std::stod(match[1].str());
-        }
-        if (std::regex_search(response.body, match, pressureRegex)) {
-            weather.pressure = std::stod(match[1].str());
+        auto fields = weatherFields().extractFirst(response.body);
+        weather.temperature = numberOr(fields[0], weather.temperature);
+        if (fields[1].is_string()) {
+            weather.description = fields[1].get<std::string>();
         }
+        weather.humidity = numberOr(fields[2], weather.humidity);
+        weather.pressure = numberOr(fields[3], weather.pressure);
         
         weather.location = city;
         auto now = std::chrono::system_clock::now();
@@ -330,7 +685,7 @@ ApiClient::WeatherData ApiClient::getWeatherData(const std::string& city, const
 }
 
 ApiClient::StockData ApiClient::getStockPrice(const std::string& symbol, const std::string& apiKey) {
-    StockData stock;
+    StockData stock{};
     stock.symbol = symbol;
     
     // Example implementation - would vary based on actual API
@@ -342,17 +697,9 @@ ApiClient::StockData ApiClient::getStockPrice(const std::string& symbol, const s
     ApiResponse response = get("/quote", params);
     
     if (response.success) {
-        // Parse response (simplified)
-        std::regex priceRegex("\"price\":([0-9.]+)");
-        std::regex changeRegex("\"change\":([0-9.-]+)");
-        
-        std::smatch match;
-        if (std::regex_search(response.body, match, priceRegex)) {
-            stock.price = std::stod(match[1].str());
-        }
-        if (std::regex_search(response.body, match, changeRegex)) {
-            stock.change = std::stod(match[1].str());
-        }
+        auto fields = stockFields().extractFirst(response.body);
+        stock.price = numberOr(fields[0], stock.price);
+        stock.change = numberOr(fields[1], stock.change);
         
         auto now = std::chrono::system_clock::now();
         auto time_t = std::chrono::system_clock::to_time_t(now);
@@ -374,17 +721,18 @@ std::vector<ApiClient::NewsItem> ApiClient::getNews(const std::string& category,
     ApiResponse response = get("/top-headlines", params);
     
     if (response.success) {
-        // Parse JSON array (simplified - would use proper JSON parser)
-        // This is a basic implementation for demonstration
-        std::regex articleRegex("\"title\":\"([^\"]+)\"[^}]*\"description\":\"([^\"]+)\"[^}]*\"url\":\"([^\"]+)\"");
-        std::sregex_iterator iter(response.body.begin(), response.body.end(), articleRegex);
-        std::sregex_iterator end;
-        
-        for (; iter != end && news.size() < static_cast<size_t>(limit); ++iter) {
+        // Every object carrying a title, description and url is an article
+        articleFields().extractObjects(response.body, [&](std::vector<nlohmann::json>& fields) {
+            if (static_cast<int>(news.size()) >= limit) {
+                return false;
+            }
+            if (!fields[0].is_string() || !fields[1].is_string() || !fields[2].is_string()) {
+                return true;
+            }
             NewsItem item;
-            item.title = (*iter)[1].str();
-            item.description = (*iter)[2].str();
-            item.url = (*iter)[3].str();
+            item.title = fields[0].get<std::string>();
+            item.description = fields[1].get<std::string>();
+            item.url = fields[2].get<std::string>();
             item.category = category;
             
             auto now = std::chrono::system_clock::now();
@@ -392,7 +740,8 @@ std::vector<ApiClient::NewsItem> ApiClient::getNews(const std::string& category,
             item.published_at = std::to_string(time_t);
             
             news.push_back(item);
-        }
+            return news.size() < static_cast<size_t>(limit);
+        });
     }
     
     return news;
@@ -5,12 +5,12 @@
 #include <vector>
 #include <chrono>
 #include <functional>
+#include <memory>
 #include <curl/curl.h>
 
 #include <nlohmann/json.hpp>
-#include <vector>
-#include <memory>
-#include <curl/curl.h>
+#include "common/token_bucket.h"
+#include "sharded_cache.h"
 
 namespace etl {
 
@@ -31,6 +31,15 @@ enum class HttpMethod {
     PATCH
 };
 
+// One request of a concurrent batch
+struct ApiRequest {
+    HttpMethod method = HttpMethod::GET;
+    std::string endpoint;
+    std::string body;
+    std::map<std::string, std::string> headers;
+    std::map<std::string, std::string> params;
+};
+
 class ApiClient {
 public:
     ApiClient();
@@ -88,27 +97,59 @@ public:
     StockData getStockPrice(const std::string& symbol, const std::string& apiKey);
     std::vector<NewsItem> getNews(const std::string& category, const std::string& apiKey, int limit = 10);
 
-    // Batch operations
+    // Batch operations. The requests run concurrently on one curl multi
+    // handle, up to setMaxConcurrency at a time, reusing its connections
+    // between batches and multiplexing HTTPS requests over HTTP/2 where the
+    // server supports it. The rate limit delays starting a transfer and a failed one
+    // is retried after the retry delay, neither holding up the others.
+    // Responses are returned in request order.
     std::vector<ApiResponse> batchRequests(const std::vector<std::pair<HttpMethod, std::string>>& requests);
-    
-    // Rate limiting
-    void setRateLimit(int requestsPerSecond);
+    std::vector<ApiResponse> batchRequests(const std::vector<ApiRequest>& requests);
+    // As above, passing each response to onResponse, on the calling thread, as
+    // soon as it is final
+    void batchRequests(const std::vector<ApiRequest>& requests,
+                       const std::function<void(size_t index, ApiResponse& response)>& onResponse);
+
+    // Transfers in flight at once in a batch (default 16), and connections
+    // opened to one host for them (0, the default: no limit)
+    void setMaxConcurrency(int maxTransfers, int maxHostConnections = 0);
+
+    // Rate limiting, shared by single and batch requests; up to burst
+    // requests may start back to back after an idle spell
+    void setRateLimit(int requestsPerSecond, int burst = 1);
     
     // Retry logic
     void setRetryPolicy(int maxRetries, int retryDelayMs);
 
+    // Serve repeat get() calls from cache: a GET of the same URL with the
+    // same default headers (so the same credentials) is answered without a
+    // request while its entry lives. Only 2xx responses are stored, for ttl
+    // (0: the cache's default) or the response's Cache-Control max-age if
+    // shorter, and none marked no-store or no-cache. Clients may share one
+    // cache; nullptr turns caching off.
+    void setResponseCache(std::shared_ptr<ShardedCache> cache, std::chrono::seconds ttl = std::chrono::seconds(60));
+
 private:
+    struct Transfer;
+
     CURL* curl_handle_;
+    CURLM* multi_handle_;                   // Created by the first batch
+    std::vector<CURL*> idle_handles_;       // Easy handles reused by later batch transfers
     struct curl_slist* default_headers_;
+    struct curl_slist* request_headers_;    // Of the current request on curl_handle_
     std::string base_url_;
     std::string auth_type_;
     std::string auth_credentials_;
     long timeout_;
     std::string user_agent_;
     int rate_limit_;
-    int delay_ms_;
+    TokenBucket rate_limiter_;
     int max_retries_;
     int retry_delay_ms_;
+    int max_concurrency_;
+    int max_host_connections_;
+    std::shared_ptr<ShardedCache> response_cache_;
+    std::chrono::seconds response_cache_ttl_;
 
     // Callback functions
     static size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* userp);
@@ -116,11 +157,17 @@ private:
 
     // Helper methods
     std::string buildUrl(const std::string& endpoint, const std::map<std::string, std::string>& params);
+    std::string responseCacheKey(const std::string& url) const;
     std::string urlEncode(const std::string& str);
+    void applyCommonOptions(CURL* handle);
+    struct curl_slist* buildHeaders(const std::map<std::string, std::string>& headers) const;
+    static void setMethod(CURL* handle, HttpMethod method, const std::string& body);
     void setupRequest(const std::string& url, const std::map<std::string, std::string>& headers);
     ApiResponse performRequest();
     void respectRateLimit();
     ApiResponse retryRequest(const std::function<ApiResponse()>& requestFunc);
+    void startTransfer(const ApiRequest& request, Transfer& transfer);
+    ApiResponse finishTransfer(Transfer& transfer, CURLcode result);
 
     // JSON utilities
     std::string createJsonPayload(const std::map<std::string, std::string>& data);
@@ -0,0 +1,204 @@
+#include "html_tokenizer.h"
+#include <algorithm>
+#include <cctype>
+
+namespace etl {
+
+namespace {
+
+// Held back from scanned_ so a terminator cut by a chunk boundary is still found
+constexpr size_t SCAN_OVERLAP = 16;
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+}
+
+// Characters that make '<' open a tag, end tag, comment or declaration
+bool startsMarkup(char c) {
+    return std::isalpha(static_cast<unsigned char>(c)) || c == '/' || c == '!' || c == '?';
+}
+
+// Position of the '>' closing a start tag, skipping quoted attribute values
+size_t findTagEnd(std::string_view data, size_t i) {
+    char quote = 0;
+    char previous = 0;
+    for (; i < data.size(); ++i) {
+        char c = data[i];
+        if (quote) {
+            if (c == quote) quote = 0;
+        } else if (c == '>') {
+            return i;
+        } else if ((c == '"' || c == '\'') && previous == '=') {
+            quote = c;
+        }
+        if (!isSpace(c)) previous = c;
+    }
+    return std::string_view::npos;
+}
+
+void assignLower(std::string& out, std::string_view in) {
+    out.resize(in.size());
+    std::transform(in.begin(), in.end(), out.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+}
+
+} // namespace
+
+bool HtmlTokenizer::iequals(std::string_view a, std::string_view b) {
+    return a.size() == b.size() &&
+           std::equal(a.begin(), a.end(), b.begin(), [](unsigned char x, unsigned char y) {
+               return std::tolower(x) == std::tolower(y);
+           });
+}
+
+std::string_view HtmlTokenizer::attribute(const std::vector<HtmlAttribute>& attributes, std::string_view name) {
+    for (const auto& attribute : attributes) {
+        if (iequals(attribute.name, name)) return attribute.value;
+    }
+    return {};
+}
+
+void HtmlTokenizer::feed(std::string_view data) {
+    if (pending_.empty()) {
+        size_t used = parse(data, false);
+        pending_.assign(data.substr(used));
+    } else {
+        pending_.append(data);
+        size_t used = parse(pending_, false);
+        pending_.erase(0, used);
+    }
+}
+
+void HtmlTokenizer::finish() {
+    parse(pending_, true);
+    pending_.clear();
+    scanned_ = 0;
+    raw_text_tag_.clear();
+}
+
+size_t HtmlTokenizer::parse(std::string_view data, bool final) {
+    const size_t n = data.size();
+    size_t pos = 0;
+    // What an earlier call already scanned applies to the token at the start
+    const size_t hint = scanned_;
+    scanned_ = 0;
+    auto from = [&](size_t minimum) { return pos == 0 ? std::max(minimum, hint) : minimum; };
+    auto suspend = [&]() {
+        scanned_ = n - pos > SCAN_OVERLAP ? n - pos - SCAN_OVERLAP : 0;
+        return pos;
+    };
+
+    while (pos < n) {
+        if (!raw_text_tag_.empty()) {
+            // Skip to the matching end tag; the contents are dropped as they arrive
+            size_t close = std::string_view::npos;
+            for (size_t i = pos; ; ) {
+                size_t lt = data.find("</", i);
+                if (lt == std::string_view::npos) break;
+                size_t after = lt + 2 + raw_text_tag_.size();
+                if (after >= n) {
+                    if (final) break;
+                    return lt;
+                }
+                if (iequals(data.substr(lt + 2, raw_text_tag_.size()), raw_text_tag_) &&
+                    (isSpace(data[after]) || data[after] == '>' || data[after] == '/')) {
+                    close = lt;
+                    break;
+                }
+                i = lt + 2;
+            }
+            if (close == std::string_view::npos) {
+                return final ? n : std::max(pos, n - std::min(n, SCAN_OVERLAP));
+            }
+            raw_text_tag_.clear();
+            pos = close;
+        }
+
+        // Text up to the next '<' that opens markup; a hint left by a
+        // suspended tag must not skip the '<' it starts with
+        size_t lt = data[pos] == '<' ? pos : from(pos);
+        while ((lt = data.find('<', lt)) != std::string_view::npos && lt + 1 < n && !startsMarkup(data[lt + 1])) {
+            ++lt;
+        }
+        if (lt == std::string_view::npos || lt + 1 >= n) {
+            if (!final) return suspend();
+            handler_.text(data.substr(pos));
+            return n;
+        }
+        if (lt > pos) {
+            handler_.text(data.substr(pos, lt - pos));
+            pos = lt;
+        }
+
+        char kind = data[pos + 1];
+        if (kind == '!' || kind == '?') {
+            if (n - pos < 4 && !final) return suspend();
+            bool comment = data.compare(pos, 4, "<!--") == 0;
+            size_t end = comment ? data.find("-->", from(pos + 4)) : data.find('>', from(pos + 2));
+            if (end == std::string_view::npos) return final ? n : suspend();
+            pos = end + (comment ? 3 : 1);
+        } else if (kind == '/') {
+            size_t end = data.find('>', pos + 2);
+            if (end == std::string_view::npos) return final ? n : suspend();
+            std::string_view name = data.substr(pos + 2, end - pos - 2);
+            size_t nameEnd = 0;
+            while (nameEnd < name.size() && !isSpace(name[nameEnd]) && name[nameEnd] != '/') ++nameEnd;
+            if (nameEnd > 0) {
+                assignLower(tag_name_, name.substr(0, nameEnd));
+                handler_.endTag(tag_name_);
+            }
+            pos = end + 1;
+        } else {
+            size_t end = findTagEnd(data, pos + 1);
+            if (end == std::string_view::npos) return final ? n : suspend();
+            emitTag(data.substr(pos + 1, end - pos - 1));
+            pos = end + 1;
+        }
+    }
+    return pos;
+}
+
+void HtmlTokenizer::emitTag(std::string_view tag) {
+    const size_t n = tag.size();
+    size_t i = 0;
+    while (i < n && !isSpace(tag[i]) && tag[i] != '/') ++i;
+    assignLower(tag_name_, tag.substr(0, i));
+    bool selfClosing = n > 0 && tag[n - 1] == '/';
+
+    attributes_.clear();
+    while (i < n) {
+        while (i < n && (isSpace(tag[i]) || tag[i] == '/')) ++i;
+        size_t nameStart = i;
+        while (i < n && !isSpace(tag[i]) && tag[i] != '=' && tag[i] != '/') ++i;
+        std::string_view name = tag.substr(nameStart, i - nameStart);
+        while (i < n && isSpace(tag[i])) ++i;
+
+        std::string_view value;
+        if (i < n && tag[i] == '=') {
+            ++i;
+            while (i < n && isSpace(tag[i])) ++i;
+            if (i < n && (tag[i] == '"' || tag[i] == '\'')) {
+                char quote = tag[i++];
+                size_t end = std::min(tag.find(quote, i), n);
+                value = tag.substr(i, end - i);
+                i = end + 1;
+            } else {
+                size_t valueStart = i;
+                while (i < n && !isSpace(tag[i])) ++i;
+                value = tag.substr(valueStart, i - valueStart);
+            }
+        }
+        if (!name.empty()) {
+            attributes_.push_back({name, value});
+        } else if (i < n && nameStart == i) {
+            ++i;                                // A stray '=' or quote
+        }
+    }
+
+    handler_.startTag(tag_name_, attributes_, selfClosing);
+    if (!selfClosing && (tag_name_ == "script" || tag_name_ == "style")) {
+        raw_text_tag_ = tag_name_;
+    }
+}
+
+} // namespace etl
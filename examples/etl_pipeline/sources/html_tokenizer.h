@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace etl {
+
+struct HtmlAttribute {
+    std::string_view name;                  // As written; compare with iequals
+    std::string_view value;                 // Raw, entities not decoded
+};
+
+// Receives the tokens of a document in order. The views are valid only
+// during the call.
+class HtmlTokenHandler {
+public:
+    virtual ~HtmlTokenHandler() = default;
+
+    // name is lower-case
+    virtual void startTag(std::string_view /*name*/, const std::vector<HtmlAttribute>& /*attributes*/,
+                          bool /*selfClosing*/) {}
+    virtual void endTag(std::string_view /*name*/) {}
+    // A complete run of text between two tags, entities not decoded
+    virtual void text(std::string_view /*text*/) {}
+};
+
+// Splits HTML into tags and text in one forward pass. Input may arrive in
+// chunks cut anywhere, e.g. as curl delivers them; only an incomplete
+// trailing token is held back between feed() calls. Comments, doctypes and
+// the contents of <script> and <style> are skipped. Malformed markup never
+// throws: a stray '<' is text and an unterminated tag is dropped.
+class HtmlTokenizer {
+public:
+    explicit HtmlTokenizer(HtmlTokenHandler& handler) : handler_(handler) {}
+
+    void feed(std::string_view data);
+    // Emits any trailing text; the tokenizer may then be reused
+    void finish();
+
+    // Value of the named attribute (ASCII case-insensitive), or empty
+    static std::string_view attribute(const std::vector<HtmlAttribute>& attributes, std::string_view name);
+    static bool iequals(std::string_view a, std::string_view b);
+
+private:
+    // Emits the complete tokens of data; returns the bytes consumed
+    size_t parse(std::string_view data, bool final);
+    // Parses a start tag given without its '<' and '>'
+    void emitTag(std::string_view tag);
+
+    HtmlTokenHandler& handler_;
+    std::string pending_;                   // Unconsumed tail of earlier input
+    size_t scanned_ = 0;                    // Bytes of pending_ known to hold no terminator
+    std::string raw_text_tag_;              // Inside <script> or <style> while set
+    std::string tag_name_;
+    std::vector<HtmlAttribute> attributes_;
+};
+
+} // namespace etl
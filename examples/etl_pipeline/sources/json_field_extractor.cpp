@@ -0,0 +1,128 @@
+#include "json_field_extractor.h"
+
+namespace etl {
+
+namespace {
+
+constexpr size_t NO_FIELD = static_cast<size_t>(-1);
+
+} // namespace
+
+// nlohmann::json SAX callbacks. Returning false ends the parse.
+class JsonFieldExtractor::Handler {
+public:
+    using json = nlohmann::json;
+
+    Handler(const JsonFieldExtractor& extractor, std::vector<json>* first,
+            const std::function<bool(std::vector<json>&)>* onObject)
+        : extractor_(extractor), first_(first), on_object_(onObject) {}
+
+    bool null() { return value(json()); }
+    bool boolean(bool v) { return value(json(v)); }
+    bool number_integer(json::number_integer_t v) { return value(json(v)); }
+    bool number_unsigned(json::number_unsigned_t v) { return value(json(v)); }
+    bool number_float(json::number_float_t v, const json::string_t&) { return value(json(v)); }
+    bool string(json::string_t& v) { return value(json(std::move(v))); }
+    bool binary(json::binary_t&) { return value(json()); }
+
+    bool start_object(std::size_t) {
+        frames_.push_back({true, NO_FIELD, false, {}});
+        return true;
+    }
+
+    bool key(json::string_t& name) {
+        auto it = extractor_.index_.find(name);
+        frames_.back().field = it == extractor_.index_.end() ? NO_FIELD : it->second;
+        return true;
+    }
+
+    bool end_object() {
+        Frame frame = std::move(frames_.back());
+        frames_.pop_back();
+        endNested();
+        if (on_object_ && frame.found) {
+            return (*on_object_)(frame.values);
+        }
+        return true;
+    }
+
+    bool start_array(std::size_t) {
+        frames_.push_back({false, NO_FIELD, false, {}});
+        return true;
+    }
+
+    bool end_array() {
+        frames_.pop_back();
+        endNested();
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception&) {
+        return false;
+    }
+
+private:
+    struct Frame {
+        bool is_object;
+        size_t field;                           // Of the key whose value comes next
+        bool found;
+        std::vector<json> values;               // extractObjects only
+    };
+
+    // An object or array value ends; it never counts for the key before it
+    void endNested() {
+        if (!frames_.empty()) frames_.back().field = NO_FIELD;
+    }
+
+    bool value(json&& v) {
+        if (frames_.empty()) return true;
+        Frame& frame = frames_.back();
+        size_t field = frame.field;
+        frame.field = NO_FIELD;
+        if (!frame.is_object || field == NO_FIELD || v.is_null()) return true;
+
+        if (first_) {
+            if ((*first_)[field].is_null()) {
+                (*first_)[field] = std::move(v);
+                if (++found_ == first_->size()) return false;
+            }
+            return true;
+        }
+        if (frame.values.empty()) frame.values.resize(extractor_.fields_.size());
+        if (frame.values[field].is_null()) {
+            frame.values[field] = std::move(v);
+            frame.found = true;
+        }
+        return true;
+    }
+
+    const JsonFieldExtractor& extractor_;
+    std::vector<json>* first_;
+    const std::function<bool(std::vector<json>&)>* on_object_;
+    std::vector<Frame> frames_;
+    size_t found_ = 0;
+};
+
+JsonFieldExtractor::JsonFieldExtractor(std::vector<std::string> fields)
+    : fields_(std::move(fields)) {
+    for (size_t i = 0; i < fields_.size(); ++i) {
+        index_.emplace(fields_[i], i);
+    }
+}
+
+std::vector<nlohmann::json> JsonFieldExtractor::extractFirst(const std::string& json) const {
+    std::vector<nlohmann::json> values(fields_.size());
+    if (!fields_.empty()) {
+        Handler handler(*this, &values, nullptr);
+        nlohmann::json::sax_parse(json, &handler);
+    }
+    return values;
+}
+
+void JsonFieldExtractor::extractObjects(
+    const std::string& json, const std::function<bool(std::vector<nlohmann::json>& values)>& onObject) const {
+    Handler handler(*this, nullptr, &onObject);
+    nlohmann::json::sax_parse(json, &handler);
+}
+
+} // namespace etl
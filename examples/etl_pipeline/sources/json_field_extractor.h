@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+
+namespace etl {
+
+// Pulls named scalar fields out of a JSON response in one SAX pass, without
+// building the document. Build one per set of field names and keep it: the
+// lookup table is made once, and the extract calls are const, so threads
+// may share an extractor. Fields whose value is an object or array are
+// ignored; malformed input yields whatever was found before the error.
+class JsonFieldExtractor {
+public:
+    explicit JsonFieldExtractor(std::vector<std::string> fields);
+
+    const std::vector<std::string>& fields() const { return fields_; }
+
+    // The first value of each field at any depth, in document order, or
+    // null where the field never appears. Stops reading once all are found.
+    std::vector<nlohmann::json> extractFirst(const std::string& json) const;
+
+    // Calls onObject for every object holding at least one of the fields,
+    // with that object's own values (null where absent), innermost first.
+    // Returning false from onObject stops the scan.
+    void extractObjects(const std::string& json,
+                        const std::function<bool(std::vector<nlohmann::json>& values)>& onObject) const;
+
+private:
+    class Handler;
+
+    std::vector<std::string> fields_;
+    std::unordered_map<std::string, size_t> index_;
+};
+
+} // namespace etl
@@ -4,42 +4,87 @@
 #include <chrono>
 #include <filesystem>
 #include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
 #include <aws/core/utils/Outcome.h>
+#include <aws/core/utils/stream/PreallocatedStreamBuf.h>
 #include <aws/s3/model/HeadObjectRequest.h>
 #include <aws/s3/model/CreateBucketRequest.h>
 #include <aws/s3/model/DeleteBucketRequest.h>
 #include <aws/s3/model/HeadBucketRequest.h>
+#include <aws/s3/model/CreateMultipartUploadRequest.h>
+#include <aws/s3/model/UploadPartRequest.h>
+#include <aws/s3/model/CompleteMultipartUploadRequest.h>
+#include <aws/s3/model/AbortMultipartUploadRequest.h>
+#include <aws/s3/model/CompletedMultipartUpload.h>
+#include <aws/s3/model/CompletedPart.h>
 
 namespace etl {
 
+namespace {
+
+constexpr size_t MIB = 1024 * 1024;
+// S3's multipart limits: every part but the last at least 5 MiB, at most
+// 5 GiB each and 10,000 parts in all
+constexpr size_t MIN_PART_SIZE = 5 * MIB;
+constexpr size_t MAX_PART_SIZE = 5 * 1024 * MIB;
+constexpr size_t MAX_PARTS = 10000;
+constexpr size_t SINK_CHUNK_SIZE = 256 * 1024;
+
+// configured, or for objects too large for MAX_PARTS of it, the smallest
+// whole number of MiB that fits
+size_t uploadPartSize(size_t size, size_t configured) {
+    size_t needed = (size + MAX_PARTS - 1) / MAX_PARTS;
+    if (needed <= configured) {
+        return configured;
+    }
+    return (needed + MIB - 1) / MIB * MIB;
+}
+
+// Object size from a "bytes first-last/total" Content-Range, else the body length
+size_t objectSize(const Aws::String& contentRange, long long contentLength) {
+    size_t slash = contentRange.rfind('/');
+    if (slash != Aws::String::npos && slash + 1 < contentRange.size() && contentRange[slash + 1] != '*') {
+        return std::strtoull(contentRange.c_str() + slash + 1, nullptr, 10);
+    }
+    return contentLength > 0 ? static_cast<size_t>(contentLength) : 0;
+}
+
+double secondsSince(std::chrono::high_resolution_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+} // namespace
+
 S3Client::S3Client() : initialized_(false) {
     Aws::InitAPI(options_);
+    setTransferConfig(S3TransferConfig{});
 }
 
 S3Client::~S3Client() {
+    // Pools first: their threads may still hold requests on s3_client_
+    part_pool_.reset();
+    object_pool_.reset();
+    s3_client_.reset();
     Aws::ShutdownAPI(options_);
 }
 
 bool S3Client::initialize(const std::string& region) {
     region_ = region;
     
-    Aws::Client::ClientConfiguration config;
-    config.region = region_;
-    
-    s3_client_ = std::make_unique<Aws::S3::S3Client>(config);
+    rebuildClient();
     initialized_ = true;
     
     return true;
 }
 
-void S3Client::setCredentials(const std::string& accessKeyId, const std::string& secretAccessKey, 
+void S3Client::setCredentials(const std::string& accessKeyId, const std::string& secretAccessKey,
                              const std::string& sessionToken) {
-    Aws::Auth::AWSCredentials credentials(accessKeyId, secretAccessKey, sessionToken);
-    
-    Aws::Client::ClientConfiguration config;
-    config.region = region_;
-    
-    s3_client_ = std::make_unique<Aws::S3::S3Client>(credentials, config);
+    credentials_ = std::make_unique<Aws::Auth::AWSCredentials>(accessKeyId, secretAccessKey, sessionToken);
+    rebuildClient();
 }
 
 void S3Client::setBucket(const std::string& bucketName) {
@@ -47,53 +92,139 @@ void S3Client::setBucket(const std::string& bucketName) {
 }
 
 void S3Client::setEndpointUrl(const std::string& endpointUrl) {
+    endpoint_url_ = endpointUrl;
+    rebuildClient();
+}
+
+void S3Client::setTransferConfig(const S3TransferConfig& config) {
+    if (config.part_size < MIN_PART_SIZE) {
+        throw std::invalid_argument("S3 part_size must be at least 5 MiB, got " +
+                                    std::to_string(config.part_size) + " bytes");
+    }
+    transfer_config_ = config;
+    transfer_config_.max_concurrent_parts = std::max(transfer_config_.max_concurrent_parts, 1);
+    transfer_config_.max_concurrent_objects = std::max(transfer_config_.max_concurrent_objects, 1);
+    
+    part_pool_ = std::make_unique<ThreadPool>(transfer_config_.max_concurrent_parts);
+    object_pool_ = std::make_unique<ThreadPool>(transfer_config_.max_concurrent_objects);
+    if (s3_client_) {
+        rebuildClient();
+    }
+}
+
+void S3Client::rebuildClient() {
     Aws::Client::ClientConfiguration config;
     config.region = region_;
-    config.endpointOverride = endpointUrl;
+    if (!endpoint_url_.empty()) {
+        config.endpointOverride = endpoint_url_;
+    }
+    // Every part worker and every batch worker may have a request open
+    config.maxConnections = transfer_config_.max_concurrent_parts + transfer_config_.max_concurrent_objects;
     
-    s3_client_ = std::make_unique<Aws::S3::S3Client>(config);
+    if (credentials_) {
+        s3_client_ = std::make_unique<Aws::S3::S3Client>(*credentials_, config);
+    } else {
+        s3_client_ = std::make_unique<Aws::S3::S3Client>(config);
+    }
 }
 
 S3UploadResult S3Client::uploadFile(const std::string& localFilePath, const std::string& s3Key) {
+    return uploadFileWithProgress(localFilePath, s3Key);
+}
+
+S3UploadResult S3Client::uploadFileWithProgress(const std::string& localFilePath, const std::string& s3Key,
+                                               const std::function<void(size_t, size_t)>& progressCallback) {
     S3UploadResult result;
     result.success = false;
+    result.bytes_transferred = 0;
+    result.upload_time = 0;
     
     if (!initialized_ || bucket_name_.empty()) {
         result.error_message = "S3Client not properly initialized or bucket not set";
         return result;
     }
     
-    std::ifstream file(localFilePath, std::ios::binary);
+    std::ifstream file(localFilePath, std::ios::binary | std::ios::ate);
     if (!file.is_open()) {
         result.error_message = "Cannot open local file: " + localFilePath;
         return result;
     }
+    size_t fileSize = file.tellg();
+    file.close();
     
     auto start = std::chrono::high_resolution_clock::now();
     
-    // Read file content
-    file.seekg(0, std::ios::end);
-    size_t fileSize = file.tellg();
-    file.seekg(0, std::ios::beg);
+    if (fileSize <= transfer_config_.multipart_threshold) {
+        // The SDK reads the body straight from the file
+        auto body = Aws::MakeShared<Aws::FStream>("S3Upload", localFilePath.c_str(),
+                                                  std::ios_base::in | std::ios_base::binary);
+        result = putObject(s3Key, inferContentType(localFilePath), body, fileSize);
+        if (result.success && progressCallback) {
+            progressCallback(fileSize, fileSize);
+        }
+    } else {
+        // Each part opens its own stream, so parts read the file concurrently
+        auto readPart = [&localFilePath](size_t offset, size_t size, char* out) {
+            std::ifstream part(localFilePath, std::ios::binary);
+            part.seekg(offset);
+            return static_cast<bool>(part.read(out, size));
+        };
+        result = uploadParts(s3Key, inferContentType(localFilePath), fileSize, readPart, progressCallback);
+    }
+    
+    result.upload_time = secondsSince(start);
+    return result;
+}
+
+S3UploadResult S3Client::uploadData(const std::string& data, const std::string& s3Key,
+                                   const std::string& contentType) {
+    S3UploadResult result;
+    result.success = false;
+    result.bytes_transferred = 0;
+    result.upload_time = 0;
+    
+    if (!initialized_ || bucket_name_.empty()) {
+        result.error_message = "S3Client not properly initialized or bucket not set";
+        return result;
+    }
+    
+    auto start = std::chrono::high_resolution_clock::now();
+    
+    if (data.length() <= transfer_config_.multipart_threshold) {
+        auto streamBuf = Aws::MakeShared<Aws::StringStream>("S3Upload");
+        streamBuf->str(data);
+        result = putObject(s3Key, contentType, streamBuf, data.length());
+    } else {
+        auto readPart = [&data](size_t offset, size_t size, char* out) {
+            data.copy(out, size, offset);
+            return true;
+        };
+        result = uploadParts(s3Key, contentType, data.length(), readPart, nullptr);
+    }
     
-    auto streamBuf = Aws::MakeShared<Aws::StringStream>("S3Upload");
-    streamBuf->write(reinterpret_cast<char*>(file.rdbuf()), fileSize);
+    result.upload_time = secondsSince(start);
+    return result;
+}
+
+S3UploadResult S3Client::putObject(const std::string& s3Key, const std::string& contentType,
+                                   const std::shared_ptr<Aws::IOStream>& body, size_t size) {
+    S3UploadResult result;
+    result.success = false;
+    result.bytes_transferred = 0;
+    result.upload_time = 0;
     
     Aws::S3::Model::PutObjectRequest request;
     request.SetBucket(bucket_name_);
     request.SetKey(s3Key);
-    request.SetBody(streamBuf);
-    request.SetContentType(inferContentType(localFilePath));
-    request.SetContentLength(fileSize);
+    request.SetBody(body);
+    request.SetContentType(contentType);
+    request.SetContentLength(size);
     
     auto outcome = s3_client_->PutObject(request);
-    auto end = std::chrono::high_resolution_clock::now();
-    
-    result.upload_time = std::chrono::duration<double>(end - start).count();
-    result.bytes_transferred = fileSize;
     
     if (outcome.IsSuccess()) {
         result.success = true;
+        result.bytes_transferred = size;
         result.etag = outcome.GetResult().GetETag();
     } else {
         result.error_message = outcome.GetError().GetMessage();
@@ -102,93 +233,194 @@ S3UploadResult S3Client::uploadFile(const std::string& localFilePath, const std:
     return result;
 }
 
-S3UploadResult S3Client::uploadData(const std::string& data, const std::string& s3Key, 
-                                   const std::string& contentType) {
+S3UploadResult S3Client::uploadParts(const std::string& s3Key, const std::string& contentType, size_t size,
+                                     const std::function<bool(size_t, size_t, char*)>& readPart,
+                                     const std::function<void(size_t, size_t)>& progressCallback) {
     S3UploadResult result;
     result.success = false;
+    result.bytes_transferred = 0;
+    result.upload_time = 0;
     
-    if (!initialized_ || bucket_name_.empty()) {
-        result.error_message = "S3Client not properly initialized or bucket not set";
+    const size_t partSize = uploadPartSize(size, transfer_config_.part_size);
+    if (partSize > MAX_PART_SIZE) {
+        result.error_message = s3Key + " is too large for a multipart upload (" + std::to_string(size) + " bytes)";
         return result;
     }
     
-    auto start = std::chrono::high_resolution_clock::now();
+    Aws::S3::Model::CreateMultipartUploadRequest createRequest;
+    createRequest.SetBucket(bucket_name_);
+    createRequest.SetKey(s3Key);
+    createRequest.SetContentType(contentType);
     
-    auto streamBuf = Aws::MakeShared<Aws::StringStream>("S3Upload");
-    streamBuf->str(data);
+    auto created = s3_client_->CreateMultipartUpload(createRequest);
+    if (!created.IsSuccess()) {
+        result.error_message = created.GetError().GetMessage();
+        return result;
+    }
+    const Aws::String uploadId = created.GetResult().GetUploadId();
+    
+    auto abort = [&]() {
+        Aws::S3::Model::AbortMultipartUploadRequest abortRequest;
+        abortRequest.SetBucket(bucket_name_);
+        abortRequest.SetKey(s3Key);
+        abortRequest.SetUploadId(uploadId);
+        s3_client_->AbortMultipartUpload(abortRequest);
+    };
+    
+    const size_t partCount = (size + partSize - 1) / partSize;
+    std::vector<Aws::String> etags(partCount);
+    std::atomic<bool> failed(false);
+    std::mutex mutex;                       // Guards error, sent and progressCallback
+    std::string error;
+    size_t sent = 0;
+    
+    // Parts run on the part pool, which also bounds how many are buffered
+    part_pool_->forEach(partCount, [&](size_t i) {
+        if (failed) return;
+        size_t offset = i * partSize;
+        size_t length = std::min(partSize, size - offset);
+        std::vector<char> buffer(length);
+        std::string partError;
+    
+        if (!readPart(offset, length, buffer.data())) {
+            partError = "Cannot read part " + std::to_string(i + 1) + " of " + s3Key;
+        } else {
+            Aws::Utils::Stream::PreallocatedStreamBuf streamBuf(
+                reinterpret_cast<unsigned char*>(buffer.data()), length);
+            auto body = Aws::MakeShared<Aws::IOStream>("S3Upload", &streamBuf);
+    
+            Aws::S3::Model::UploadPartRequest request;
+            request.SetBucket(bucket_name_);
+            request.SetKey(s3Key);
+            request.SetUploadId(uploadId);
+            request.SetPartNumber(static_cast<int>(i + 1));
+            request.SetContentLength(length);
+            request.SetBody(body);
+    
+            auto outcome = s3_client_->UploadPart(request);
+            if (outcome.IsSuccess()) {
+                etags[i] = outcome.GetResult().GetETag();
+            } else {
+                partError = outcome.GetError().GetMessage();
+            }
+        }
     
-    Aws::S3::Model::PutObjectRequest request;
-    request.SetBucket(bucket_name_);
-    request.SetKey(s3Key);
-    request.SetBody(streamBuf);
-    request.SetContentType(contentType);
-    request.SetContentLength(data.length());
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!partError.empty()) {
+            if (!failed.exchange(true)) error = partError;
+            return;
+        }
+        sent += length;
+        if (progressCallback) progressCallback(sent, size);
+    });
     
-    auto outcome = s3_client_->PutObject(request);
-    auto end = std::chrono::high_resolution_clock::now();
+    if (failed) {
+        abort();
+        result.error_message = error;
+        return result;
+    }
+    
+    Aws::S3::Model::CompletedMultipartUpload completed;
+    for (size_t i = 0; i < partCount; ++i) {
+        completed.AddParts(Aws::S3::Model::CompletedPart()
+                               .WithPartNumber(static_cast<int>(i + 1))
+                               .WithETag(etags[i]));
+    }
     
-    result.upload_time = std::chrono::duration<double>(end - start).count();
-    result.bytes_transferred = data.length();
+    Aws::S3::Model::CompleteMultipartUploadRequest completeRequest;
+    completeRequest.SetBucket(bucket_name_);
+    completeRequest.SetKey(s3Key);
+    completeRequest.SetUploadId(uploadId);
+    completeRequest.SetMultipartUpload(completed);
     
+    auto outcome = s3_client_->CompleteMultipartUpload(completeRequest);
     if (outcome.IsSuccess()) {
         result.success = true;
+        result.bytes_transferred = size;
         result.etag = outcome.GetResult().GetETag();
+        result.location = outcome.GetResult().GetLocation();
     } else {
+        abort();
         result.error_message = outcome.GetError().GetMessage();
     }
     
     return result;
 }
 
+Aws::S3::Model::GetObjectOutcome S3Client::getRange(const std::string& s3Key, size_t offset, size_t size,
+                                                    const Aws::String& etag) {
+    Aws::S3::Model::GetObjectRequest request;
+    request.SetBucket(bucket_name_);
+    request.SetKey(s3Key);
+    request.SetRange("bytes=" + std::to_string(offset) + "-" + std::to_string(offset + size - 1));
+    // Every part of one download must come from the same version of the object
+    if (!etag.empty()) {
+        request.SetIfMatch(etag);
+    }
+    
+    return s3_client_->GetObject(request);
+}
+
 S3DownloadResult S3Client::downloadFile(const std::string& s3Key, const std::string& localFilePath) {
+    return downloadWithProgress(s3Key, localFilePath);
+}
+
+S3DownloadResult S3Client::downloadWithProgress(const std::string& s3Key, const std::string& localFilePath,
+                                                const std::function<void(size_t, size_t)>& progressCallback) {
     S3DownloadResult result;
     result.success = false;
+    result.bytes_transferred = 0;
+    result.download_time = 0;
     
     if (!initialized_ || bucket_name_.empty()) {
         result.error_message = "S3Client not properly initialized or bucket not set";
         return result;
     }
     
-    auto start = std::chrono::high_resolution_clock::now();
-    
-    Aws::S3::Model::GetObjectRequest request;
-    request.SetBucket(bucket_name_);
-    request.SetKey(s3Key);
-    
-    auto outcome = s3_client_->GetObject(request);
-    auto end = std::chrono::high_resolution_clock::now();
+    std::ofstream outFile(localFilePath, std::ios::binary);
+    if (!outFile.is_open()) {
+        result.error_message = "Cannot create local file: " + localFilePath;
+        return result;
+    }
     
-    result.download_time = std::chrono::duration<double>(end - start).count();
+    result = downloadToSink(s3Key, [&outFile](const char* data, size_t size) {
+        return static_cast<bool>(outFile.write(data, size));
+    }, progressCallback);
+    outFile.close();
     
-    if (outcome.IsSuccess()) {
-        auto& body = outcome.GetResult().GetBody();
-        std::ofstream outFile(localFilePath, std::ios::binary);
-        
-        if (outFile.is_open()) {
-            outFile << body.rdbuf();
-            outFile.close();
-            
-            result.success = true;
-            result.bytes_transferred = std::filesystem::file_size(localFilePath);
-            
-            // Get metadata
-            auto metadata = outcome.GetResult().GetMetadata();
-            for (const auto& pair : metadata) {
-                result.metadata[pair.first] = pair.second;
-            }
-        } else {
-            result.error_message = "Cannot create local file: " + localFilePath;
-        }
-    } else {
-        result.error_message = outcome.GetError().GetMessage();
+    if (result.success && !outFile) {
+        result.success = false;
+        result.error_message = "Cannot write local file: " + localFilePath;
+    }
+    if (!result.success) {
+        std::error_code ec;
+        std::filesystem::remove(localFilePath, ec);
     }
     
     return result;
 }
 
 S3DownloadResult S3Client::downloadToMemory(const std::string& s3Key) {
+    std::string content;
+    auto reserve = [&content](size_t, size_t total) {
+        if (content.capacity() < total) content.reserve(total);
+    };
+    
+    auto result = downloadToSink(s3Key, [&content](const char* data, size_t size) {
+        content.append(data, size);
+        return true;
+    }, reserve);
+    
+    result.content = std::move(content);
+    return result;
+}
+
+S3DownloadResult S3Client::downloadToSink(const std::string& s3Key, const S3DataSink& sink,
+                                          const std::function<void(size_t, size_t)>& progressCallback) {
     S3DownloadResult result;
     result.success = false;
+    result.bytes_transferred = 0;
+    result.download_time = 0;
     
     if (!initialized_ || bucket_name_.empty()) {
         result.error_message = "S3Client not properly initialized or bucket not set";
@@ -196,33 +428,85 @@ S3DownloadResult S3Client::downloadToMemory(const std::string& s3Key) {
     }
     
     auto start = std::chrono::high_resolution_clock::now();
+    const size_t partSize = transfer_config_.part_size;
+    
+    // The first part also tells the object's size and version
+    auto first = getRange(s3Key, 0, partSize, "");
+    if (!first.IsSuccess() &&
+        first.GetError().GetResponseCode() == Aws::Http::HttpResponseCode::REQUESTED_RANGE_NOT_SATISFIABLE) {
+        // An empty object has no range to ask for
+        Aws::S3::Model::GetObjectRequest request;
+        request.SetBucket(bucket_name_);
+        request.SetKey(s3Key);
+        first = s3_client_->GetObject(request);
+    }
+    if (!first.IsSuccess()) {
+        result.error_message = first.GetError().GetMessage();
+        result.download_time = secondsSince(start);
+        return result;
+    }
     
-    Aws::S3::Model::GetObjectRequest request;
-    request.SetBucket(bucket_name_);
-    request.SetKey(s3Key);
-    
-    auto outcome = s3_client_->GetObject(request);
-    auto end = std::chrono::high_resolution_clock::now();
-    
-    result.download_time = std::chrono::duration<double>(end - start).count();
+    auto& head = first.GetResult();
+    const size_t total = objectSize(head.GetContentRange(), head.GetContentLength());
+    const Aws::String etag = head.GetETag();
+    for (const auto& pair : head.GetMetadata()) {
+        result.metadata[pair.first] = pair.second;
+    }
     
-    if (outcome.IsSuccess()) {
-        auto& body = outcome.GetResult().GetBody();
-        std::stringstream ss;
-        ss << body.rdbuf();
-        result.content = ss.str();
-        result.bytes_transferred = result.content.length();
-        result.success = true;
-        
-        // Get metadata
-        auto metadata = outcome.GetResult().GetMetadata();
-        for (const auto& pair : metadata) {
-            result.metadata[pair.first] = pair.second;
+    // The rest is fetched max_concurrent_parts ranges ahead of the sink
+    std::deque<std::future<Aws::S3::Model::GetObjectOutcome>> pending;
+    size_t nextOffset = std::min(partSize, total);
+    auto fillWindow = [&]() {
+        while (nextOffset < total && pending.size() < static_cast<size_t>(transfer_config_.max_concurrent_parts)) {
+            size_t offset = nextOffset;
+            size_t length = std::min(partSize, total - offset);
+            nextOffset += length;
+            pending.push_back(part_pool_->submit([this, s3Key, offset, length, etag] {
+                return getRange(s3Key, offset, length, etag);
+            }));
         }
-    } else {
-        result.error_message = outcome.GetError().GetMessage();
+    };
+    
+    std::vector<char> buffer(SINK_CHUNK_SIZE);
+    auto deliver = [&](Aws::IOStream& body) {
+        while (body.read(buffer.data(), buffer.size()) || body.gcount() > 0) {
+            size_t got = static_cast<size_t>(body.gcount());
+            if (!sink(buffer.data(), got)) {
+                result.error_message = "Download of " + s3Key + " stopped by the sink";
+                return false;
+            }
+            result.bytes_transferred += got;
+            if (progressCallback) progressCallback(result.bytes_transferred, total);
+        }
+        return true;
+    };
+    
+    fillWindow();
+    bool ok = deliver(head.GetBody());
+    while (ok && !pending.empty()) {
+        auto outcome = pending.front().get();
+        pending.pop_front();
+        if (!outcome.IsSuccess()) {
+            result.error_message = outcome.GetError().GetMessage();
+            ok = false;
+            break;
+        }
+        fillWindow();
+        ok = deliver(outcome.GetResult().GetBody());
+    }
+    // Ranges already requested still hold a pool thread each
+    for (auto& part : pending) {
+        part.wait();
+    }
+    
+    if (ok && result.bytes_transferred != total) {
+        result.error_message = "Short read of " + s3Key + ": " + std::to_string(result.bytes_transferred) +
+                               " of " + std::to_string(total) + " bytes";
+        ok = false;
     }
     
+    result.success = ok;
+    result.download_time = secondsSince(start);
     return result;
 }
 
@@ -319,7 +603,7 @@ S3Object S3Client::getObjectInfo(const std::string& s3Key) {
     return obj;
 }
 
-S3Client::BatchUploadResult S3Client::uploadDirectory(const std::string& localDirectory, 
+S3Client::BatchUploadResult S3Client::uploadDirectory(const std::string& localDirectory,
                                                      const std::string& s3Prefix,
                                                      const std::string& filePattern) {
     BatchUploadResult result;
@@ -330,30 +614,32 @@ S3Client::BatchUploadResult S3Client::uploadDirectory(const std::string& localDi
     auto start = std::chrono::high_resolution_clock::now();
     
     auto files = getFilesInDirectory(localDirectory, filePattern);
+    std::vector<S3UploadResult> uploads(files.size());
     
-    for (const auto& filePath : files) {
-        std::filesystem::path path(filePath);
+    object_pool_->forEach(files.size(), [&](size_t i) {
+        std::filesystem::path path(files[i]);
         std::string fileName = path.filename().string();
         std::string s3Key = s3Prefix.empty() ? fileName : s3Prefix + "/" + fileName;
-        
-        auto uploadResult = uploadFile(filePath, s3Key);
-        
-        if (uploadResult.success) {
+    
+        uploads[i] = uploadFile(files[i], s3Key);
+    });
+    
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (uploads[i].success) {
             result.successful_uploads++;
-            result.total_bytes += uploadResult.bytes_transferred;
+            result.total_bytes += uploads[i].bytes_transferred;
         } else {
             result.failed_uploads++;
-            result.failed_files.push_back(filePath);
+            result.failed_files.push_back(files[i]);
         }
     }
     
-    auto end = std::chrono::high_resolution_clock::now();
-    result.total_time = std::chrono::duration<double>(end - start).count();
+    result.total_time = secondsSince(start);
     
     return result;
 }
 
-S3Client::BatchDownloadResult S3Client::downloadObjects(const std::vector<std::string>& s3Keys, 
+S3Client::BatchDownloadResult S3Client::downloadObjects(const std::vector<std::string>& s3Keys,
                                                        const std::string& localDirectory) {
     BatchDownloadResult result;
     result.successful_downloads = 0;
@@ -365,24 +651,26 @@ S3Client::BatchDownloadResult S3Client::downloadObjects(const std::vector<std::s
     // Create directory if it doesn't exist
     std::filesystem::create_directories(localDirectory);
     
-    for (const auto& s3Key : s3Keys) {
-        std::filesystem::path keyPath(s3Key);
+    std::vector<S3DownloadResult> downloads(s3Keys.size());
+    object_pool_->forEach(s3Keys.size(), [&](size_t i) {
+        std::filesystem::path keyPath(s3Keys[i]);
         std::string fileName = keyPath.filename().string();
         std::string localPath = localDirectory + "/" + fileName;
-        
-        auto downloadResult = downloadFile(s3Key, localPath);
-        
-        if (downloadResult.success) {
+    
+        downloads[i] = downloadFile(s3Keys[i], localPath);
+    });
+    
+    for (size_t i = 0; i < s3Keys.size(); ++i) {
+        if (downloads[i].success) {
             result.successful_downloads++;
-            result.total_bytes += downloadResult.bytes_transferred;
+            result.total_bytes += downloads[i].bytes_transferred;
         } else {
             result.failed_downloads++;
-            result.failed_keys.push_back(s3Key);
+            result.failed_keys.push_back(s3Keys[i]);
         }
     }
     
-    auto end = std::chrono::high_resolution_clock::now();
-    result.total_time = std::chrono::duration<double>(end - start).count();
+    result.total_time = secondsSince(start);
     
     return result;
 }
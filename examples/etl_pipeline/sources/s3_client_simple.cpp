@@ -4,6 +4,7 @@
 #include <chrono>
 #include <thread>
 #include <filesystem>
+#include <algorithm>
 
 namespace etl {
 
@@ -15,6 +16,8 @@ S3Client::S3Client(const std::string& bucket, const std::string& region,
     std::cout << "S3Client initialized (simulation mode)" << std::endl;
     std::cout << "  Bucket: " << bucket_name_ << std::endl;
     std::cout << "  Region: " << region_ << std::endl;
+    
+    setTransferConfig(S3TransferConfig{});
 }
 
 S3Client::~S3Client() {
@@ -29,6 +32,13 @@ void S3Client::setEndpointUrl(const std::string& endpointUrl) {
     endpoint_url_ = endpointUrl;
 }
 
+void S3Client::setTransferConfig(const S3TransferConfig& config) {
+    transfer_config_ = config;
+    transfer_config_.part_size = std::max<size_t>(transfer_config_.part_size, 1);
+    transfer_config_.max_concurrent_objects = std::max(transfer_config_.max_concurrent_objects, 1);
+    object_pool_ = std::make_unique<ThreadPool>(transfer_config_.max_concurrent_objects);
+}
+
 S3UploadResult S3Client::uploadFile(const std::string& localFilePath, const std::string& s3Key) {
     simulateOperation("upload", s3Key);
     
@@ -122,6 +132,34 @@ S3DownloadResult S3Client::downloadToMemory(const std::string& s3Key) {
     return result;
 }
 
+S3DownloadResult S3Client::downloadToSink(const std::string& s3Key, const S3DataSink& sink) {
+    simulateOperation("download_sink", s3Key);
+    
+    S3DownloadResult result;
+    result.bytes_transferred = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50)); // Simulate network delay
+    
+    // Handed over in part_size pieces, as the SDK-backed client does
+    std::string mockContent = "Mock S3 content for key: " + s3Key;
+    result.success = true;
+    for (size_t offset = 0; offset < mockContent.size(); offset += transfer_config_.part_size) {
+        size_t size = std::min(transfer_config_.part_size, mockContent.size() - offset);
+        if (!sink(mockContent.data() + offset, size)) {
+            result.success = false;
+            result.error_message = "Download of " + s3Key + " stopped by the sink";
+            break;
+        }
+        result.bytes_transferred += size;
+    }
+    
+    auto end = std::chrono::steady_clock::now();
+    result.download_time = std::chrono::duration<double>(end - start).count();
+    result.metadata = {{"Content-Type", "text/plain"}, {"ETag", "\"mock-etag\""}};
+    
+    return result;
+}
+
 std::vector<S3Object> S3Client::listObjects(const std::string& prefix, int maxKeys) {
     simulateOperation("list", prefix);
     
@@ -191,19 +229,26 @@ S3Client::BatchUploadResult S3Client::uploadDirectory(const std::string& localDi
     std::cout << "Simulating batch upload from directory: " << localDirectory << std::endl;
     
     BatchUploadResult result;
+    result.successful_uploads = 0;
+    result.failed_uploads = 0;
+    result.total_bytes = 0;
     auto start = std::chrono::steady_clock::now();
     
     // Simulate uploading files
     std::vector<std::string> mockFiles = {"file1.json", "file2.csv", "file3.txt"};
+    std::vector<S3UploadResult> uploads(mockFiles.size());
+    
+    object_pool_->forEach(mockFiles.size(), [&](size_t i) {
+        uploads[i] = uploadFile(localDirectory + "/" + mockFiles[i], s3Prefix + mockFiles[i]);
+    });
     
-    for (const auto& file : mockFiles) {
-        auto uploadResult = uploadFile(localDirectory + "/" + file, s3Prefix + file);
-        if (uploadResult.success) {
+    for (size_t i = 0; i < mockFiles.size(); ++i) {
+        if (uploads[i].success) {
             result.successful_uploads++;
-            result.total_bytes += uploadResult.bytes_transferred;
+            result.total_bytes += uploads[i].bytes_transferred;
         } else {
             result.failed_uploads++;
-            result.failed_files.push_back(file);
+            result.failed_files.push_back(mockFiles[i]);
         }
     }
     
@@ -218,18 +263,24 @@ S3Client::BatchDownloadResult S3Client::downloadObjects(const std::vector<std::s
     std::cout << "Simulating batch download to directory: " << localDirectory << std::endl;
     
     BatchDownloadResult result;
+    result.successful_downloads = 0;
+    result.failed_downloads = 0;
+    result.total_bytes = 0;
     auto start = std::chrono::steady_clock::now();
     
-    for (const auto& key : s3Keys) {
-        std::string localPath = localDirectory + "/" + std::filesystem::path(key).filename().string();
-        auto downloadResult = downloadFile(key, localPath);
-        
-        if (downloadResult.success) {
+    std::vector<S3DownloadResult> downloads(s3Keys.size());
+    object_pool_->forEach(s3Keys.size(), [&](size_t i) {
+        std::string localPath = localDirectory + "/" + std::filesystem::path(s3Keys[i]).filename().string();
+        downloads[i] = downloadFile(s3Keys[i], localPath);
+    });
+    
+    for (size_t i = 0; i < s3Keys.size(); ++i) {
+        if (downloads[i].success) {
             result.successful_downloads++;
-            result.total_bytes += downloadResult.bytes_transferred;
+            result.total_bytes += downloads[i].bytes_transferred;
         } else {
             result.failed_downloads++;
-            result.failed_keys.push_back(key);
+            result.failed_keys.push_back(s3Keys[i]);
         }
     }
     
@@ -276,6 +327,7 @@ std::vector<std::string> S3Client::getFilesInDirectory(const std::string& direct
 }
 
 void S3Client::simulateOperation(const std::string& operation, const std::string& key) {
+    std::lock_guard<std::mutex> lock(log_mutex_);
     std::cout << "[S3] " << operation << ": " << key << std::endl;
 }
 
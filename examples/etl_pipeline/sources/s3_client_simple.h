@@ -5,7 +5,9 @@
 #include <vector>
 #include <memory>
 #include <functional>
+#include <mutex>
 #include <chrono>
+#include "../common/thread_pool.h"
 
 // Simplified S3 client for demonstration (without AWS SDK dependency)
 
@@ -37,6 +39,18 @@ struct S3DownloadResult {
     std::map<std::string, std::string> metadata;
 };
 
+// Receives a download's bytes in object order; returning false aborts it
+using S3DataSink = std::function<bool(const char* data, size_t size)>;
+
+// Same fields as the SDK-backed client; only max_concurrent_objects and
+// part_size (the sink chunk size) affect the simulation
+struct S3TransferConfig {
+    size_t part_size = 8 * 1024 * 1024;
+    size_t multipart_threshold = 16 * 1024 * 1024;
+    int max_concurrent_parts = 8;
+    int max_concurrent_objects = 4;                 // Objects in flight in batch operations
+};
+
 class S3Client {
 public:
     S3Client(const std::string& bucket, const std::string& region,
@@ -46,6 +60,7 @@ public:
     // Configuration
     void setBucket(const std::string& bucketName);
     void setEndpointUrl(const std::string& endpointUrl);
+    void setTransferConfig(const S3TransferConfig& config);
     
     // Upload operations (simulated)
     S3UploadResult uploadFile(const std::string& localFilePath, const std::string& s3Key);
@@ -55,6 +70,7 @@ public:
     // Download operations (simulated)
     S3DownloadResult downloadFile(const std::string& s3Key, const std::string& localFilePath);
     S3DownloadResult downloadToMemory(const std::string& s3Key);
+    S3DownloadResult downloadToSink(const std::string& s3Key, const S3DataSink& sink);
     
     // List operations (simulated)
     std::vector<S3Object> listObjects(const std::string& prefix = "", int maxKeys = 1000);
@@ -66,7 +82,7 @@ public:
     bool objectExists(const std::string& s3Key);
     S3Object getObjectInfo(const std::string& s3Key);
     
-    // Batch operations for ETL
+    // Batch operations for ETL; up to max_concurrent_objects objects at once
     struct BatchUploadResult {
         int successful_uploads;
         int failed_uploads;
@@ -98,6 +114,10 @@ private:
     std::string endpoint_url_;
     bool initialized_;
     
+    S3TransferConfig transfer_config_;
+    std::unique_ptr<ThreadPool> object_pool_;
+    std::mutex log_mutex_;                  // Batch workers share std::cout
+    
     // Helper methods
     std::string getFileExtension(const std::string& filename);
     std::string inferContentType(const std::string& filename);
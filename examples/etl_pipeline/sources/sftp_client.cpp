@@ -5,6 +5,8 @@
 #include <filesystem>
 #include <algorithm>
 #include <cstring>
+#include <mutex>
+#include <set>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
@@ -12,12 +14,45 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/stat.h>
+#include "../common/thread_pool.h"
 
 namespace etl {
 
+namespace {
+
+// libssh2 sends at most 32 KB per SFTP request
+constexpr size_t MIN_WINDOW_SIZE = 32 * 1024;
+
+// Bytes before a resume offset compared between source and destination
+constexpr size_t RESUME_CHECK_BYTES = 64 * 1024;
+
+// 0 if the file can't be stat'ed
+time_t localModifiedTime(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? st.st_mtime : 0;
+}
+
+// Transport failures, after which a new session can pick up where this one stopped
+bool isConnectionError(int code) {
+    switch (code) {
+        case LIBSSH2_ERROR_SOCKET_SEND:
+        case LIBSSH2_ERROR_SOCKET_RECV:
+        case LIBSSH2_ERROR_SOCKET_DISCONNECT:
+        case LIBSSH2_ERROR_SOCKET_TIMEOUT:
+        case LIBSSH2_ERROR_TIMEOUT:
+        case LIBSSH2_ERROR_CHANNEL_CLOSED:
+            return true;
+        default:
+            return false;
+    }
+}
+
+} // namespace
+
 SftpClient::SftpClient() 
     : session_(nullptr), sftp_session_(nullptr), socket_(-1), 
-      connected_(false), timeout_seconds_(30), binary_mode_(true) {
+      connected_(false), timeout_seconds_(30), binary_mode_(true), compression_enabled_(false),
+      connection_info_(), key_auth_(false) {
     initializeLibssh2();
 }
 
@@ -53,38 +88,18 @@ bool SftpClient::connect(const SftpConnectionInfo& connInfo) {
     return true;
 }
 
-bool SftpClient::connectWithPassword(const std::string& hostname, int port, 
+bool SftpClient::connectWithPassword(const std::string& hostname, int port,
                                    const std::string& username, const std::string& password) {
     if (connected_) {
         disconnect();
     }
     
-    // Establish socket connection
-    if (!establishSocket(hostname, port)) {
-        return false;
-    }
-    
-    // Create SSH session
-    session_ = libssh2_session_init();
-    if (!session_) {
-        last_error_ = "Failed to create SSH session";
-        closeSocket();
-        return false;
-    }
-    
-    // Set session timeout
-    libssh2_session_set_timeout(session_, timeout_seconds_ * 1000);
-    
-    // Perform SSH handshake
-    int rc = libssh2_session_handshake(session_, socket_);
-    if (rc) {
-        last_error_ = "SSH handshake failed: " + getLibssh2Error();
-        disconnect();
+    if (!openSession(hostname, port)) {
         return false;
     }
     
     // Authenticate with password
-    rc = libssh2_userauth_password(session_, username.c_str(), password.c_str());
+    int rc = libssh2_userauth_password(session_, username.c_str(), password.c_str());
     if (rc) {
         last_error_ = "Password authentication failed: " + getLibssh2Error();
         disconnect();
@@ -99,17 +114,62 @@ bool SftpClient::connectWithPassword(const std::string& hostname, int port,
         return false;
     }
     
+    connection_info_ = SftpConnectionInfo{};
+    connection_info_.hostname = hostname;
+    connection_info_.port = port;
+    connection_info_.username = username;
+    connection_info_.password = password;
+    key_auth_ = false;
+    
     connected_ = true;
     return true;
 }
 
-bool SftpClient::connectWithKeyFile(const std::string& hostname, int port, 
+bool SftpClient::connectWithKeyFile(const std::string& hostname, int port,
                                   const std::string& username, const std::string& privateKeyPath,
                                   const std::string& publicKeyPath, const std::string& passphrase) {
     if (connected_) {
         disconnect();
     }
     
+    if (!openSession(hostname, port)) {
+        return false;
+    }
+    
+    // Authenticate with key file
+    const char* pubkey = publicKeyPath.empty() ? nullptr : publicKeyPath.c_str();
+    const char* phrase = passphrase.empty() ? nullptr : passphrase.c_str();
+    
+    int rc = libssh2_userauth_publickey_fromfile(session_, username.c_str(),
+                                               pubkey, privateKeyPath.c_str(), phrase);
+    if (rc) {
+        last_error_ = "Public key authentication failed: " + getLibssh2Error();
+        disconnect();
+        return false;
+    }
+    
+    // Initialize SFTP session
+    sftp_session_ = libssh2_sftp_init(session_);
+    if (!sftp_session_) {
+        last_error_ = "Failed to initialize SFTP session: " + getLibssh2Error();
+        disconnect();
+        return false;
+    }
+    
+    connection_info_ = SftpConnectionInfo{};
+    connection_info_.hostname = hostname;
+    connection_info_.port = port;
+    connection_info_.username = username;
+    connection_info_.private_key_path = privateKeyPath;
+    connection_info_.public_key_path = publicKeyPath;
+    connection_info_.passphrase = passphrase;
+    key_auth_ = true;
+    
+    connected_ = true;
+    return true;
+}
+
+bool SftpClient::openSession(const std::string& hostname, int port) {
     // Establish socket connection
     if (!establishSocket(hostname, port)) {
         return false;
@@ -123,6 +183,11 @@ bool SftpClient::connectWithKeyFile(const std::string& hostname, int port,
         return false;
     }
     
+    // Compression is negotiated during the handshake
+    if (compression_enabled_) {
+        libssh2_session_flag(session_, LIBSSH2_FLAG_COMPRESS, 1);
+    }
+    
     // Set session timeout
     libssh2_session_set_timeout(session_, timeout_seconds_ * 1000);
     
@@ -134,30 +199,29 @@ bool SftpClient::connectWithKeyFile(const std::string& hostname, int port,
         return false;
     }
     
-    // Authenticate with key file
-    const char* pubkey = publicKeyPath.empty() ? nullptr : publicKeyPath.c_str();
-    const char* phrase = passphrase.empty() ? nullptr : passphrase.c_str();
-    
-    rc = libssh2_userauth_publickey_fromfile(session_, username.c_str(),
-                                           pubkey, privateKeyPath.c_str(), phrase);
-    if (rc) {
-        last_error_ = "Public key authentication failed: " + getLibssh2Error();
-        disconnect();
-        return false;
-    }
-    
-    // Initialize SFTP session
-    sftp_session_ = libssh2_sftp_init(session_);
-    if (!sftp_session_) {
-        last_error_ = "Failed to initialize SFTP session: " + getLibssh2Error();
-        disconnect();
-        return false;
-    }
-    
-    connected_ = true;
     return true;
 }
 
+bool SftpClient::reconnect() {
+    const SftpConnectionInfo info = connection_info_;
+    if (key_auth_) {
+        return connectWithKeyFile(info.hostname, info.port, info.username, info.private_key_path,
+                                  info.public_key_path, info.passphrase);
+    }
+    return connectWithPassword(info.hostname, info.port, info.username, info.password);
+}
+
+std::unique_ptr<SftpClient> SftpClient::makeSibling() const {
+    auto sibling = std::make_unique<SftpClient>();
+    sibling->timeout_seconds_ = timeout_seconds_;
+    sibling->binary_mode_ = binary_mode_;
+    sibling->compression_enabled_ = compression_enabled_;
+    sibling->transfer_options_ = transfer_options_;
+    sibling->connection_info_ = connection_info_;
+    sibling->key_auth_ = key_auth_;
+    return sibling;
+}
+
 void SftpClient::disconnect() {
     if (sftp_session_) {
         libssh2_sftp_shutdown(sftp_session_);
@@ -179,26 +243,34 @@ bool SftpClient::isConnected() const {
 }
 
 bool SftpClient::establishSocket(const std::string& hostname, int port) {
-    struct hostent* host = gethostbyname(hostname.c_str());
-    if (!host) {
-        last_error_ = "Failed to resolve hostname: " + hostname;
+    // getaddrinfo is thread-safe, unlike gethostbyname, so batch sessions
+    // can connect concurrently; it also covers IPv6
+    struct addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* addresses = nullptr;
+    int rc = getaddrinfo(hostname.c_str(), std::to_string(port).c_str(), &hints, &addresses);
+    if (rc != 0) {
+        last_error_ = "Failed to resolve hostname: " + hostname + " - " + gai_strerror(rc);
         return false;
     }
     
-    socket_ = socket(AF_INET, SOCK_STREAM, 0);
-    if (socket_ == -1) {
-        last_error_ = "Failed to create socket";
-        return false;
+    // Try each address in turn until one accepts the connection
+    for (struct addrinfo* address = addresses; address; address = address->ai_next) {
+        socket_ = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (socket_ == -1) {
+            continue;
+        }
+        if (::connect(socket_, address->ai_addr, address->ai_addrlen) == 0) {
+            break;
+        }
+        closeSocket();
     }
+    freeaddrinfo(addresses);
     
-    struct sockaddr_in addr;
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(port);
-    addr.sin_addr = *((struct in_addr*)host->h_addr);
-    
-    if (connect(socket_, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+    if (socket_ == -1) {
         last_error_ = "Failed to connect to " + hostname + ":" + std::to_string(port);
-        closeSocket();
         return false;
     }
     
@@ -220,8 +292,16 @@ std::string SftpClient::getLibssh2Error() {
 }
 
 SftpTransferResult SftpClient::uploadFile(const std::string& localFilePath, const std::string& remoteFilePath) {
+    return uploadFileWithProgress(localFilePath, remoteFilePath, nullptr);
+}
+
+SftpTransferResult SftpClient::uploadFileWithProgress(const std::string& localFilePath,
+                                                     const std::string& remoteFilePath,
+                                                     const std::function<void(size_t, size_t)>& progressCallback) {
     SftpTransferResult result;
     result.success = false;
+    result.bytes_transferred = 0;
+    result.transfer_time = 0;
     result.local_path = localFilePath;
     result.remote_path = remoteFilePath;
     
@@ -243,51 +323,67 @@ SftpTransferResult SftpClient::uploadFile(const std::string& localFilePath, cons
     size_t fileSize = localFile.tellg();
     localFile.seekg(0, std::ios::beg);
     
-    // Open remote file for writing
-    LIBSSH2_SFTP_HANDLE* remoteFile = libssh2_sftp_open(sftp_session_, remoteFilePath.c_str(),
-                                                       LIBSSH2_FXF_WRITE | LIBSSH2_FXF_CREAT | LIBSSH2_FXF_TRUNC,
-                                                       LIBSSH2_SFTP_S_IRUSR | LIBSSH2_SFTP_S_IWUSR |
-                                                       LIBSSH2_SFTP_S_IRGRP | LIBSSH2_SFTP_S_IROTH);
-    if (!remoteFile) {
-        result.error_message = "Cannot open remote file: " + remoteFilePath + " - " + getLibssh2Error();
-        return result;
-    }
-    
-    // Transfer file in chunks
-    const size_t bufferSize = 8192;
-    char buffer[bufferSize];
-    size_t totalTransferred = 0;
-    
-    while (!localFile.eof()) {
-        localFile.read(buffer, bufferSize);
-        size_t bytesRead = localFile.gcount();
-        
-        if (bytesRead > 0) {
-            ssize_t bytesWritten = libssh2_sftp_write(remoteFile, buffer, bytesRead);
-            if (bytesWritten < 0) {
-                result.error_message = "Write error: " + getLibssh2Error();
-                libssh2_sftp_close(remoteFile);
-                return result;
+    // Continue after what an interrupted upload already left on the server
+    size_t offset = 0;
+    LIBSSH2_SFTP_ATTRIBUTES attrs;
+    if (transfer_options_.resume_partial &&
+        libssh2_sftp_stat(sftp_session_, remoteFilePath.c_str(), &attrs) == 0 &&
+        (attrs.flags & LIBSSH2_SFTP_ATTR_SIZE) && attrs.filesize <= fileSize) {
+        offset = attrs.filesize;
+    }
+    if (offset > 0 && !partialMatches(localFilePath, remoteFilePath, offset, true)) {
+        offset = 0;  // Not a copy of this file's start: upload it again
+    }
+    const size_t resumedFrom = offset;
+    
+    for (int attempt = 0; ; ++attempt) {
+        // Once part of the file is there, reopen without truncating it
+        unsigned long flags = LIBSSH2_FXF_WRITE | LIBSSH2_FXF_CREAT | (offset == 0 ? LIBSSH2_FXF_TRUNC : 0);
+        LIBSSH2_SFTP_HANDLE* remoteFile = libssh2_sftp_open(sftp_session_, remoteFilePath.c_str(), flags,
+                                                           LIBSSH2_SFTP_S_IRUSR | LIBSSH2_SFTP_S_IWUSR |
+                                                           LIBSSH2_SFTP_S_IRGRP | LIBSSH2_SFTP_S_IROTH);
+        CopyStatus status = CopyStatus::REMOTE_ERROR;
+        if (remoteFile) {
+            libssh2_sftp_seek64(remoteFile, offset);
+            status = sendFile(localFile, remoteFile, offset, fileSize, progressCallback);
+            if (libssh2_sftp_close(remoteFile) != 0 && status == CopyStatus::COMPLETE) {
+                last_error_ = "Cannot close remote file: " + remoteFilePath + " - " + getLibssh2Error();
+                status = CopyStatus::REMOTE_ERROR;
             }
-            totalTransferred += bytesWritten;
+        } else {
+            last_error_ = "Cannot open remote file: " + remoteFilePath + " - " + getLibssh2Error();
         }
-    }
     
-    libssh2_sftp_close(remoteFile);
-    localFile.close();
+        if (status == CopyStatus::COMPLETE) {
+            result.success = true;
+            break;
+        }
+        if (status == CopyStatus::LOCAL_ERROR || attempt >= transfer_options_.max_resume_attempts ||
+            !isConnectionError(libssh2_session_last_errno(session_)) || !reconnect()) {
+            result.error_message = last_error_;
+            break;
+        }
+    }
     
     auto end = std::chrono::high_resolution_clock::now();
     
-    result.success = true;
-    result.bytes_transferred = totalTransferred;
+    result.bytes_transferred = offset - resumedFrom;
     result.transfer_time = std::chrono::duration<double>(end - start).count();
     
     return result;
 }
 
 SftpTransferResult SftpClient::downloadFile(const std::string& remoteFilePath, const std::string& localFilePath) {
+    return downloadFileWithProgress(remoteFilePath, localFilePath, nullptr);
+}
+
+SftpTransferResult SftpClient::downloadFileWithProgress(const std::string& remoteFilePath,
+                                                       const std::string& localFilePath,
+                                                       const std::function<void(size_t, size_t)>& progressCallback) {
     SftpTransferResult result;
     result.success = false;
+    result.bytes_transferred = 0;
+    result.transfer_time = 0;
     result.local_path = localFilePath;
     result.remote_path = remoteFilePath;
     
@@ -298,54 +394,184 @@ SftpTransferResult SftpClient::downloadFile(const std::string& remoteFilePath, c
     
     auto start = std::chrono::high_resolution_clock::now();
     
-    // Open remote file for reading
-    LIBSSH2_SFTP_HANDLE* remoteFile = libssh2_sftp_open(sftp_session_, remoteFilePath.c_str(),
-                                                       LIBSSH2_FXF_READ, 0);
-    if (!remoteFile) {
-        result.error_message = "Cannot open remote file: " + remoteFilePath + " - " + getLibssh2Error();
-        return result;
-    }
+    size_t fileSize = 0;
+    LIBSSH2_SFTP_ATTRIBUTES attrs;
+    if (libssh2_sftp_stat(sftp_session_, remoteFilePath.c_str(), &attrs) == 0 &&
+        (attrs.flags & LIBSSH2_SFTP_ATTR_SIZE)) {
+        fileSize = attrs.filesize;
+    }
+    
+    // Continue after what an interrupted download already wrote locally
+    size_t offset = 0;
+    std::error_code ec;
+    size_t localSize = std::filesystem::file_size(localFilePath, ec);
+    if (transfer_options_.resume_partial && !ec && localSize <= fileSize) {
+        offset = localSize;
+    }
+    if (offset > 0 && !partialMatches(localFilePath, remoteFilePath, offset, false)) {
+        offset = 0;  // Not a copy of this file's start: download it again
+    }
+    const size_t resumedFrom = offset;
+    
+    for (int attempt = 0; ; ++attempt) {
+        LIBSSH2_SFTP_HANDLE* remoteFile = libssh2_sftp_open(sftp_session_, remoteFilePath.c_str(),
+                                                           LIBSSH2_FXF_READ, 0);
+        CopyStatus status = CopyStatus::REMOTE_ERROR;
+        if (remoteFile) {
+            // Once part of the file has arrived, reopen without truncating it
+            std::ofstream localFile(localFilePath, offset == 0 ? std::ios::binary | std::ios::trunc
+                                                               : std::ios::binary | std::ios::in);
+            if (localFile.is_open()) {
+                localFile.seekp(offset);
+                libssh2_sftp_seek64(remoteFile, offset);
+                status = receiveFile(remoteFile, localFile, offset, fileSize, progressCallback);
+            } else {
+                last_error_ = "Cannot create local file: " + localFilePath;
+                status = CopyStatus::LOCAL_ERROR;
+            }
+            libssh2_sftp_close(remoteFile);
+        } else {
+            last_error_ = "Cannot open remote file: " + remoteFilePath + " - " + getLibssh2Error();
+        }
     
-    // Create local file
-    std::ofstream localFile(localFilePath, std::ios::binary);
-    if (!localFile.is_open()) {
-        result.error_message = "Cannot create local file: " + localFilePath;
-        libssh2_sftp_close(remoteFile);
-        return result;
+        if (status == CopyStatus::COMPLETE) {
+            result.success = true;
+            break;
+        }
+        if (status == CopyStatus::LOCAL_ERROR || attempt >= transfer_options_.max_resume_attempts ||
+            !isConnectionError(libssh2_session_last_errno(session_)) || !reconnect()) {
+            result.error_message = last_error_;
+            break;
+        }
     }
     
-    // Transfer file in chunks
-    const size_t bufferSize = 8192;
-    char buffer[bufferSize];
-    size_t totalTransferred = 0;
+    auto end = std::chrono::high_resolution_clock::now();
+    
+    result.bytes_transferred = offset - resumedFrom;
+    result.transfer_time = std::chrono::duration<double>(end - start).count();
+    
+    return result;
+}
+
+SftpClient::CopyStatus SftpClient::sendFile(std::ifstream& localFile, LIBSSH2_SFTP_HANDLE* remoteFile,
+                                            size_t& offset, size_t total,
+                                            const std::function<void(size_t, size_t)>& progressCallback) {
+    const size_t window = std::max<size_t>(transfer_options_.window_size, MIN_WINDOW_SIZE);
+    std::vector<char> buffer(window);
+    // buffer[begin, end) has been handed to libssh2 but not acknowledged
+    size_t begin = 0;
+    size_t end = 0;
+    
+    localFile.clear();
+    localFile.seekg(offset);
     
     while (true) {
-        ssize_t bytesRead = libssh2_sftp_read(remoteFile, buffer, bufferSize);
+        // Top the window up once half of it is acknowledged. libssh2 may
+        // already have sent the unacknowledged bytes, so they move unchanged.
+        if (begin >= window / 2 || begin == end) {
+            std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+            end -= begin;
+            begin = 0;
+            if (localFile) {
+                localFile.read(buffer.data() + end, window - end);
+                end += localFile.gcount();
+            }
+            if (localFile.bad()) {
+                last_error_ = "Read error on local file";
+                return CopyStatus::LOCAL_ERROR;
+            }
+        }
+        if (begin == end) {
+            return CopyStatus::COMPLETE;
+        }
+    
+        ssize_t bytesWritten = libssh2_sftp_write(remoteFile, buffer.data() + begin, end - begin);
+        if (bytesWritten < 0) {
+            last_error_ = "Write error: " + getLibssh2Error();
+            return CopyStatus::REMOTE_ERROR;
+        }
+        begin += bytesWritten;
+        offset += bytesWritten;
+        if (progressCallback && bytesWritten > 0) {
+            progressCallback(offset, total);
+        }
+    }
+}
+
+SftpClient::CopyStatus SftpClient::receiveFile(LIBSSH2_SFTP_HANDLE* remoteFile, std::ofstream& localFile,
+                                               size_t& offset, size_t total,
+                                               const std::function<void(size_t, size_t)>& progressCallback) {
+    // libssh2 keeps read requests outstanding for as much as the buffer holds
+    std::vector<char> buffer(std::max<size_t>(transfer_options_.window_size, MIN_WINDOW_SIZE));
+    
+    while (true) {
+        ssize_t bytesRead = libssh2_sftp_read(remoteFile, buffer.data(), buffer.size());
         if (bytesRead < 0) {
-            result.error_message = "Read error: " + getLibssh2Error();
-            libssh2_sftp_close(remoteFile);
-            localFile.close();
-            return result;
+            last_error_ = "Read error: " + getLibssh2Error();
+            return CopyStatus::REMOTE_ERROR;
         }
-        
+    
         if (bytesRead == 0) {
-            break; // End of file
+            localFile.flush();
+            if (!localFile) {
+                last_error_ = "Write error on local file";
+                return CopyStatus::LOCAL_ERROR;
+            }
+            return CopyStatus::COMPLETE;
         }
-        
-        localFile.write(buffer, bytesRead);
-        totalTransferred += bytesRead;
-    }
     
-    libssh2_sftp_close(remoteFile);
-    localFile.close();
+        if (!localFile.write(buffer.data(), bytesRead)) {
+            last_error_ = "Write error on local file";
+            return CopyStatus::LOCAL_ERROR;
+        }
+        offset += bytesRead;
+        if (progressCallback) {
+            progressCallback(offset, total);
+        }
+    }
+}
+
+bool SftpClient::partialMatches(const std::string& localFilePath, const std::string& remoteFilePath, size_t offset,
+                                bool localIsSource) {
+    // A source modified after the partial copy was written has moved on from it
+    LIBSSH2_SFTP_ATTRIBUTES attrs;
+    time_t localTime = localModifiedTime(localFilePath);
+    if (localTime != 0 && libssh2_sftp_stat(sftp_session_, remoteFilePath.c_str(), &attrs) == 0 &&
+        (attrs.flags & LIBSSH2_SFTP_ATTR_ACMODTIME)) {
+        time_t remoteTime = static_cast<time_t>(attrs.mtime);
+        time_t sourceTime = localIsSource ? localTime : remoteTime;
+        time_t destinationTime = localIsSource ? remoteTime : localTime;
+        if (sourceTime > destinationTime) {
+            return false;
+        }
+    }
     
-    auto end = std::chrono::high_resolution_clock::now();
+    // The same size and age can still hide different content, so the tail
+    // of the overlap is compared byte for byte
+    const size_t length = std::min(offset, RESUME_CHECK_BYTES);
+    std::vector<char> localTail(length);
+    std::ifstream localFile(localFilePath, std::ios::binary);
+    if (!localFile.seekg(offset - length) || !localFile.read(localTail.data(), length)) {
+        return false;
+    }
     
-    result.success = true;
-    result.bytes_transferred = totalTransferred;
-    result.transfer_time = std::chrono::duration<double>(end - start).count();
+    LIBSSH2_SFTP_HANDLE* remoteFile = libssh2_sftp_open(sftp_session_, remoteFilePath.c_str(), LIBSSH2_FXF_READ, 0);
+    if (!remoteFile) {
+        return false;
+    }
+    libssh2_sftp_seek64(remoteFile, offset - length);
+    std::vector<char> remoteTail(length);
+    size_t received = 0;
+    while (received < length) {
+        ssize_t bytesRead = libssh2_sftp_read(remoteFile, remoteTail.data() + received, length - received);
+        if (bytesRead <= 0) {
+            break;
+        }
+        received += bytesRead;
+    }
+    libssh2_sftp_close(remoteFile);
     
-    return result;
+    return received == length && localTail == remoteTail;
 }
 
 std::vector<SftpFileInfo> SftpClient::listDirectory(const std::string& remotePath) {
@@ -370,14 +596,14 @@ std::vector<SftpFileInfo> SftpClient::listDirectory(const std::string& remotePat
         if (rc <= 0) {
             break;
         }
-        
+    
         std::string filename(buffer, rc);
-        
+    
         // Skip . and ..
         if (filename == "." || filename == "..") {
             continue;
         }
-        
+    
         SftpFileInfo fileInfo;
         fileInfo.name = filename;
         fileInfo.path = remotePath + "/" + filename;
@@ -387,7 +613,7 @@ std::vector<SftpFileInfo> SftpClient::listDirectory(const std::string& remotePat
         fileInfo.permissions = (attrs.flags & LIBSSH2_SFTP_ATTR_PERMISSIONS) ? attrs.permissions : 0;
         fileInfo.modified_time = (attrs.flags & LIBSSH2_SFTP_ATTR_ACMODTIME) ? attrs.mtime : 0;
         fileInfo.access_time = (attrs.flags & LIBSSH2_SFTP_ATTR_ACMODTIME) ? attrs.atime : 0;
-        
+    
         files.push_back(fileInfo);
     }
     
@@ -436,10 +662,81 @@ bool SftpClient::fileExists(const std::string& remoteFilePath) {
     return (rc == 0);
 }
 
-SftpClient::BatchTransferResult SftpClient::uploadDirectory(const std::string& localDirectory, 
+SftpClient::BatchTransferResult SftpClient::uploadDirectory(const std::string& localDirectory,
                                                            const std::string& remoteDirectory,
                                                            const std::string& filePattern,
                                                            bool recursive) {
+    auto files = getFilesInLocalDirectory(localDirectory, filePattern, recursive);
+    std::vector<std::string> remoteFiles;
+    std::set<std::string> remoteParents;
+    
+    for (const auto& localFile : files) {
+        std::filesystem::path localPath(localFile);
+        std::filesystem::path relativePath = std::filesystem::relative(localPath, localDirectory);
+        remoteFiles.push_back(remoteDirectory + "/" + relativePath.string());
+        remoteParents.insert(std::filesystem::path(remoteFiles.back()).parent_path().string());
+    }
+    
+    // Create remote directories up front, once each
+    for (const auto& remoteParent : remoteParents) {
+        createDirectoryRecursive(remoteParent);
+    }
+    
+    return runBatch(files.size(), files, [&](SftpClient& session, size_t i) {
+        return session.uploadFile(files[i], remoteFiles[i]);
+    });
+}
+
+SftpClient::BatchTransferResult SftpClient::downloadDirectory(const std::string& remoteDirectory,
+                                                             const std::string& localDirectory,
+                                                             const std::string& filePattern,
+                                                             bool recursive) {
+    std::vector<std::string> remoteFiles;
+    std::vector<std::string> localFiles;
+    
+    for (const auto& remoteFile : listFiles(remoteDirectory, recursive)) {
+        std::filesystem::path remotePath(remoteFile);
+        if (!matchesPattern(remotePath.filename().string(), filePattern)) {
+            continue;
+        }
+        std::filesystem::path relativePath = std::filesystem::relative(remotePath, remoteDirectory);
+        std::filesystem::path localPath = std::filesystem::path(localDirectory) / relativePath;
+    
+        std::error_code ec;
+        std::filesystem::create_directories(localPath.parent_path(), ec);
+        remoteFiles.push_back(remoteFile);
+        localFiles.push_back(localPath.string());
+    }
+    
+    return runBatch(remoteFiles.size(), remoteFiles, [&](SftpClient& session, size_t i) {
+        return session.downloadFile(remoteFiles[i], localFiles[i]);
+    });
+}
+
+SftpClient::BatchTransferResult SftpClient::uploadFiles(const std::vector<std::string>& localFiles,
+                                                       const std::string& remoteDirectory) {
+    createDirectoryRecursive(remoteDirectory);
+    
+    return runBatch(localFiles.size(), localFiles, [&](SftpClient& session, size_t i) {
+        std::string fileName = std::filesystem::path(localFiles[i]).filename().string();
+        return session.uploadFile(localFiles[i], remoteDirectory + "/" + fileName);
+    });
+}
+
+SftpClient::BatchTransferResult SftpClient::downloadFiles(const std::vector<std::string>& remoteFiles,
+                                                         const std::string& localDirectory) {
+    std::error_code ec;
+    std::filesystem::create_directories(localDirectory, ec);
+    
+    return runBatch(remoteFiles.size(), remoteFiles, [&](SftpClient& session, size_t i) {
+        std::string fileName = std::filesystem::path(remoteFiles[i]).filename().string();
+        return session.downloadFile(remoteFiles[i], localDirectory + "/" + fileName);
+    });
+}
+
+SftpClient::BatchTransferResult SftpClient::runBatch(
+    size_t count, const std::vector<std::string>& names,
+    const std::function<SftpTransferResult(SftpClient&, size_t)>& transfer) {
     BatchTransferResult result;
     result.successful_transfers = 0;
     result.failed_transfers = 0;
@@ -447,25 +744,45 @@ SftpClient::BatchTransferResult SftpClient::uploadDirectory(const std::string& l
     
     auto start = std::chrono::high_resolution_clock::now();
     
-    auto files = getFilesInLocalDirectory(localDirectory, filePattern, recursive);
+    // Extra sessions are opened together; one that fails to connect is left out
+    size_t sessionCount = std::min<size_t>(std::max(transfer_options_.parallel_sessions, 1), count);
+    std::vector<std::unique_ptr<SftpClient>> siblings;
+    for (size_t i = 1; i < sessionCount; ++i) {
+        siblings.push_back(makeSibling());
+    }
+    std::vector<SftpClient*> idle = {this};
+    if (!siblings.empty()) {
+        ThreadPool connector(siblings.size());
+        std::vector<char> connected(siblings.size());
+        connector.forEach(siblings.size(), [&](size_t i) { connected[i] = siblings[i]->reconnect(); });
+        for (size_t i = 0; i < siblings.size(); ++i) {
+            if (connected[i]) idle.push_back(siblings[i].get());
+        }
+    }
     
-    for (const auto& localFile : files) {
-        std::filesystem::path localPath(localFile);
-        std::filesystem::path relativePath = std::filesystem::relative(localPath, localDirectory);
-        std::string remoteFile = remoteDirectory + "/" + relativePath.string();
-        
-        // Create remote directory if needed
-        std::filesystem::path remoteParent = std::filesystem::path(remoteFile).parent_path();
-        createDirectoryRecursive(remoteParent.string());
-        
-        auto transferResult = uploadFile(localFile, remoteFile);
-        
-        if (transferResult.success) {
+    // One worker per session, so a worker always finds one idle
+    std::vector<SftpTransferResult> transfers(count);
+    std::mutex idleMutex;
+    ThreadPool workers(idle.size());
+    workers.forEach(count, [&](size_t i) {
+        SftpClient* session;
+        {
+            std::lock_guard<std::mutex> lock(idleMutex);
+            session = idle.back();
+            idle.pop_back();
+        }
+        transfers[i] = transfer(*session, i);
+        std::lock_guard<std::mutex> lock(idleMutex);
+        idle.push_back(session);
+    });
+    
+    for (size_t i = 0; i < count; ++i) {
+        if (transfers[i].success) {
             result.successful_transfers++;
-            result.total_bytes += transferResult.bytes_transferred;
+            result.total_bytes += transfers[i].bytes_transferred;
         } else {
             result.failed_transfers++;
-            result.failed_files.push_back(localFile);
+            result.failed_files.push_back(names[i]);
         }
     }
     
@@ -554,4 +871,16 @@ void SftpClient::setTimeout(int timeoutSeconds) {
     }
 }
 
+void SftpClient::setTransferOptions(const SftpTransferOptions& options) {
+    transfer_options_ = options;
+}
+
+void SftpClient::setBufferSize(size_t bufferSize) {
+    transfer_options_.window_size = bufferSize;
+}
+
+void SftpClient::enableCompression(bool enable) {
+    compression_enabled_ = enable;
+}
+
 } // namespace etl
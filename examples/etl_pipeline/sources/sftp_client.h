@@ -4,6 +4,7 @@
 #include <vector>
 #include <memory>
 #include <functional>
+#include <fstream>
 #include <libssh2.h>
 #include <libssh2_sftp.h>
 
@@ -39,6 +40,19 @@ struct SftpConnectionInfo {
     int timeout_seconds;
 };
 
+// How transfers keep the link busy and recover. libssh2 splits each buffer
+// handed to it into 32 KB SFTP requests and keeps them all outstanding, so
+// window_size is the amount in flight per file. A transfer that fails
+// mid-file reconnects and continues from the last offset the server
+// acknowledged, up to max_resume_attempts times.
+struct SftpTransferOptions {
+    size_t window_size = 2 * 1024 * 1024;
+    int parallel_sessions = 4;              // Sessions used by directory and batch transfers
+    int max_resume_attempts = 3;
+    bool resume_partial = false;            // Continue from what the destination already holds, if it
+                                            // matches the source; otherwise start over
+};
+
 class SftpClient {
 public:
     SftpClient();
@@ -60,7 +74,7 @@ public:
     SftpTransferResult uploadData(const std::string& data, const std::string& remoteFilePath);
     std::string downloadToMemory(const std::string& remoteFilePath);
     
-    // File operations with progress
+    // File operations with progress; the callback gets (bytes done, file size)
     SftpTransferResult uploadFileWithProgress(const std::string& localFilePath, 
                                              const std::string& remoteFilePath,
                                              const std::function<void(size_t, size_t)>& progressCallback);
@@ -82,7 +96,8 @@ public:
     SftpFileInfo getFileInfo(const std::string& remoteFilePath);
     bool renameFile(const std::string& oldPath, const std::string& newPath);
     
-    // Batch operations for ETL
+    // Batch operations for ETL. Files are spread over parallel_sessions
+    // sessions, this one and extra ones opened with the same credentials.
     struct BatchTransferResult {
         int successful_transfers;
         int failed_transfers;
@@ -110,6 +125,9 @@ public:
     // Utility methods
     void setTimeout(int timeoutSeconds);
     void setTransferMode(bool binaryMode = true);
+    void setTransferOptions(const SftpTransferOptions& options);
+    void setBufferSize(size_t bufferSize);              // Sets window_size
+    void enableCompression(bool enable);                // Applies from the next connect
     std::string getLastError() const;
     
     // ETL-specific methods
@@ -128,8 +146,31 @@ private:
     std::string last_error_;
     int timeout_seconds_;
     bool binary_mode_;
+    bool compression_enabled_;
+    SftpTransferOptions transfer_options_;
+    SftpConnectionInfo connection_info_;    // What the last connect used, for reconnects
+    bool key_auth_;
+    
+    enum class CopyStatus { COMPLETE, LOCAL_ERROR, REMOTE_ERROR };
     
     // Helper methods
+    bool openSession(const std::string& hostname, int port);
+    bool reconnect();
+    // A client with this one's credentials and options, not yet connected
+    std::unique_ptr<SftpClient> makeSibling() const;
+    // Pipelined copy from offset; offset only advances past acknowledged bytes
+    CopyStatus sendFile(std::ifstream& localFile, LIBSSH2_SFTP_HANDLE* remoteFile, size_t& offset, size_t total,
+                        const std::function<void(size_t, size_t)>& progressCallback);
+    CopyStatus receiveFile(LIBSSH2_SFTP_HANDLE* remoteFile, std::ofstream& localFile, size_t& offset, size_t total,
+                     const std::function<void(size_t, size_t)>& progressCallback);
+    // True if a partial destination's first offset bytes can be kept: the
+    // source was not modified after it, and the last bytes before offset
+    // are the same in both files
+    bool partialMatches(const std::string& localFilePath, const std::string& remoteFilePath, size_t offset,
+                        bool localIsSource);
+    // Runs transfer(session, i) for i < count over up to parallel_sessions sessions
+    BatchTransferResult runBatch(size_t count, const std::vector<std::string>& names,
+                                 const std::function<SftpTransferResult(SftpClient&, size_t)>& transfer);
     bool initializeLibssh2();
     void cleanupLibssh2();
     bool establishSocket(const std::string& hostname, int port);
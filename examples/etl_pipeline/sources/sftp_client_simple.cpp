@@ -3,11 +3,12 @@
 #include <thread>
 #include <filesystem>
 #include <fstream>
+#include <algorithm>
 
 namespace etl {
 
 SftpClient::SftpClient() 
-    : port_(22), connected_(false), timeout_(30), buffer_size_(8192), compression_enabled_(false) {
+    : port_(22), connected_(false), timeout_(30), compression_enabled_(false) {
     std::cout << "SftpClient initialized (simulation mode)" << std::endl;
 }
 
@@ -262,6 +263,10 @@ SftpClient::BatchTransferResult SftpClient::uploadDirectory(const std::string& l
     std::cout << "Simulating batch upload: " << localDirectory << " -> " << remoteDirectory << std::endl;
     
     BatchTransferResult result;
+    result.successful_transfers = 0;
+    result.failed_transfers = 0;
+    result.total_bytes = 0;
+    result.total_time = 0;
     
     if (!connected_) {
         return result;
@@ -271,15 +276,20 @@ SftpClient::BatchTransferResult SftpClient::uploadDirectory(const std::string& l
     
     // Simulate uploading files
     std::vector<std::string> mockFiles = {"file1.txt", "file2.json", "file3.csv"};
+    std::vector<SftpTransferResult> uploads(mockFiles.size());
     
-    for (const auto& file : mockFiles) {
-        auto uploadResult = uploadFile(localDirectory + "/" + file, remoteDirectory + "/" + file);
-        if (uploadResult.success) {
+    ThreadPool sessions(std::min<size_t>(std::max(transfer_options_.parallel_sessions, 1), mockFiles.size()));
+    sessions.forEach(mockFiles.size(), [&](size_t i) {
+        uploads[i] = uploadFile(localDirectory + "/" + mockFiles[i], remoteDirectory + "/" + mockFiles[i]);
+    });
+    
+    for (size_t i = 0; i < mockFiles.size(); ++i) {
+        if (uploads[i].success) {
             result.successful_transfers++;
-            result.total_bytes += uploadResult.bytes_transferred;
+            result.total_bytes += uploads[i].bytes_transferred;
         } else {
             result.failed_transfers++;
-            result.failed_files.push_back(file);
+            result.failed_files.push_back(mockFiles[i]);
         }
     }
     
@@ -295,6 +305,10 @@ SftpClient::BatchTransferResult SftpClient::downloadDirectory(const std::string&
     std::cout << "Simulating batch download: " << remoteDirectory << " -> " << localDirectory << std::endl;
     
     BatchTransferResult result;
+    result.successful_transfers = 0;
+    result.failed_transfers = 0;
+    result.total_bytes = 0;
+    result.total_time = 0;
     
     if (!connected_) {
         return result;
@@ -306,20 +320,28 @@ SftpClient::BatchTransferResult SftpClient::downloadDirectory(const std::string&
     createLocalDirectory(localDirectory);
     
     // Get directory listing and download files
-    auto files = listDirectory(remoteDirectory);
-    
-    for (const auto& fileInfo : files) {
+    std::vector<SftpFileInfo> files;
+    for (auto& fileInfo : listDirectory(remoteDirectory)) {
         if (!fileInfo.is_directory) {
-            std::string localPath = localDirectory + "/" + fileInfo.name;
-            auto downloadResult = downloadFile(fileInfo.path, localPath);
-            
-            if (downloadResult.success) {
-                result.successful_transfers++;
-                result.total_bytes += downloadResult.bytes_transferred;
-            } else {
-                result.failed_transfers++;
-                result.failed_files.push_back(fileInfo.name);
-            }
+            files.push_back(std::move(fileInfo));
+        }
+    }
+    std::vector<SftpTransferResult> downloads(files.size());
+    
+    if (!files.empty()) {
+        ThreadPool sessions(std::min<size_t>(std::max(transfer_options_.parallel_sessions, 1), files.size()));
+        sessions.forEach(files.size(), [&](size_t i) {
+            downloads[i] = downloadFile(files[i].path, localDirectory + "/" + files[i].name);
+        });
+    }
+    
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (downloads[i].success) {
+            result.successful_transfers++;
+            result.total_bytes += downloads[i].bytes_transferred;
+        } else {
+            result.failed_transfers++;
+            result.failed_files.push_back(files[i].name);
         }
     }
     
@@ -333,8 +355,12 @@ void SftpClient::setTimeout(int timeoutSeconds) {
     timeout_ = timeoutSeconds;
 }
 
+void SftpClient::setTransferOptions(const SftpTransferOptions& options) {
+    transfer_options_ = options;
+}
+
 void SftpClient::setBufferSize(size_t bufferSize) {
-    buffer_size_ = bufferSize;
+    transfer_options_.window_size = bufferSize;
 }
 
 void SftpClient::enableCompression(bool enable) {
@@ -346,6 +372,7 @@ void SftpClient::setProgressCallback(const std::function<void(size_t, size_t)>&
 }
 
 void SftpClient::simulateOperation(const std::string& operation, const std::string& path) {
+    std::lock_guard<std::mutex> lock(log_mutex_);
     std::cout << "[SFTP] " << operation << ": " << path << std::endl;
 }
 
@@ -5,6 +5,8 @@
 #include <map>
 #include <functional>
 #include <chrono>
+#include <mutex>
+#include "../common/thread_pool.h"
 
 // Simplified SFTP client for demonstration (without libssh2 dependency)
 
@@ -28,6 +30,15 @@ struct SftpTransferResult {
     std::string remote_path;
 };
 
+// Same fields as the libssh2-backed client; the simulation only uses
+// parallel_sessions
+struct SftpTransferOptions {
+    size_t window_size = 2 * 1024 * 1024;
+    int parallel_sessions = 4;              // Sessions used by directory transfers
+    int max_resume_attempts = 3;
+    bool resume_partial = false;
+};
+
 class SftpClient {
 public:
     SftpClient();
@@ -57,7 +68,7 @@ public:
     SftpFileInfo getFileInfo(const std::string& remotePath);
     bool renameFile(const std::string& oldPath, const std::string& newPath);
     
-    // Batch operations
+    // Batch operations, spread over parallel_sessions simulated sessions
     struct BatchTransferResult {
         int successful_transfers;
         int failed_transfers;
@@ -76,7 +87,8 @@ public:
     
     // Configuration
     void setTimeout(int timeoutSeconds);
-    void setBufferSize(size_t bufferSize);
+    void setTransferOptions(const SftpTransferOptions& options);
+    void setBufferSize(size_t bufferSize);              // Sets window_size
     void enableCompression(bool enable);
     
     // Progress callback for transfers
@@ -90,8 +102,9 @@ private:
     std::string private_key_path_;
     bool connected_;
     int timeout_;
-    size_t buffer_size_;
+    SftpTransferOptions transfer_options_;
     bool compression_enabled_;
+    std::mutex log_mutex_;                  // Batch workers share std::cout
     
     std::function<void(size_t, size_t)> progress_callback_;
     
@@ -1,13 +1,244 @@
 #include "web_scraper.h"
 #include <iostream>
-#include <regex>
 #include <thread>
 #include <chrono>
 #include <algorithm>
 #include <cctype>
+#include <deque>
+#include <queue>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <stdexcept>
+#include "common/thread_pool.h"
+#include "html_tokenizer.h"
 
 namespace etl {
 
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Lower-cased authority of an absolute URL, or "" if there is none
+std::string hostOf(const std::string& url) {
+    size_t start = url.find("://");
+    if (start == std::string::npos) return "";
+    start += 3;
+    size_t end = url.find_first_of("/?#", start);
+    std::string host = url.substr(start, end == std::string::npos ? std::string::npos : end - start);
+    std::transform(host.begin(), host.end(), host.begin(), [](unsigned char c) { return std::tolower(c); });
+    return host;
+}
+
+// True for links a crawler can fetch: relative paths and http(s) URLs
+bool isFollowable(const std::string& link) {
+    if (link.empty() || link[0] == '#') return false;
+    size_t colon = link.find(':');
+    if (colon == std::string::npos || link.find_first_of("/?#") < colon) return true;
+    std::string scheme = link.substr(0, colon);
+    std::transform(scheme.begin(), scheme.end(), scheme.begin(), [](unsigned char c) { return std::tolower(c); });
+    return scheme == "http" || scheme == "https";
+}
+
+// End of an entity ("&name;" or "&#123;") starting at text[i], or 0
+size_t entityEnd(const std::string& text, size_t i) {
+    size_t j = i + 1;
+    if (j < text.size() && text[j] == '#') {
+        ++j;
+        while (j < text.size() && std::isdigit(static_cast<unsigned char>(text[j]))) ++j;
+        if (j == i + 2) return 0;
+    } else {
+        while (j < text.size() && std::isalpha(static_cast<unsigned char>(text[j]))) ++j;
+        if (j == i + 1) return 0;
+    }
+    return j < text.size() && text[j] == ';' ? j + 1 : 0;
+}
+
+bool isPriceChar(char c) {
+    return std::isdigit(static_cast<unsigned char>(c)) || c == ',';
+}
+
+// End of [0-9,]+\.?[0-9]* at text[i], or i if there is none
+size_t priceNumberEnd(std::string_view text, size_t i) {
+    size_t j = i;
+    while (j < text.size() && isPriceChar(text[j])) ++j;
+    if (j == i) return i;
+    if (j < text.size() && text[j] == '.') ++j;
+    while (j < text.size() && std::isdigit(static_cast<unsigned char>(text[j]))) ++j;
+    return j;
+}
+
+// First "$1,299.00" or "1299 USD" in text
+std::string_view findPrice(std::string_view text) {
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '$') {
+            size_t end = priceNumberEnd(text, i + 1);
+            if (end > i + 1) return text.substr(i, end - i);
+        } else if (isPriceChar(text[i]) && (i == 0 || !isPriceChar(text[i - 1]))) {
+            size_t end = priceNumberEnd(text, i);
+            while (end < text.size() && std::isspace(static_cast<unsigned char>(text[end]))) ++end;
+            if (HtmlTokenizer::iequals(text.substr(end, 3), "USD")) return text.substr(i, end + 3 - i);
+        }
+    }
+    return {};
+}
+
+} // namespace
+
+enum PageField : unsigned {
+    PAGE_TITLE = 1,
+    PAGE_TEXT = 2,
+    PAGE_LINKS = 4,
+    PAGE_IMAGES = 8,
+    PAGE_PRODUCT = 16,
+    PAGE_SCRAPED = PAGE_TITLE | PAGE_TEXT | PAGE_LINKS | PAGE_IMAGES
+};
+
+// Collects the requested fields from one tokenizer pass. Text is gathered
+// raw and cleaned by the caller.
+class WebScraper::PageCollector : public HtmlTokenHandler {
+public:
+    explicit PageCollector(unsigned fields) : fields_(fields) {}
+
+    void startTag(std::string_view name, const std::vector<HtmlAttribute>& attributes, bool selfClosing) override {
+        if (fields_ & PAGE_TEXT) content += ' ';   // Tags separate words
+        if (name == "title") {
+            in_title_ = !title_done_ && !selfClosing;
+        } else if (name == "a") {
+            addUrl(PAGE_LINKS, links, HtmlTokenizer::attribute(attributes, "href"));
+        } else if (name == "img") {
+            addUrl(PAGE_IMAGES, images, HtmlTokenizer::attribute(attributes, "src"));
+        } else if (fields_ & PAGE_PRODUCT) {
+            if ((name == "h1" || name == "h2") && heading_tag_.empty() && !selfClosing) {
+                heading_tag_.assign(name);
+            } else if (name == "meta" && description.empty() &&
+                       HtmlTokenizer::iequals(HtmlTokenizer::attribute(attributes, "name"), "description")) {
+                description.assign(HtmlTokenizer::attribute(attributes, "content"));
+            }
+        }
+    }
+
+    void endTag(std::string_view name) override {
+        if (fields_ & PAGE_TEXT) content += ' ';
+        if (in_title_ && name == "title") {
+            in_title_ = false;
+            title_done_ = true;
+        } else if (!heading_done_ && name == heading_tag_) {
+            heading_done_ = true;
+        }
+    }
+
+    void text(std::string_view text) override {
+        if (in_title_) title.append(text);
+        if (fields_ & PAGE_TEXT) content.append(text);
+        if (fields_ & PAGE_PRODUCT) {
+            if (!heading_tag_.empty() && !heading_done_) heading.append(text);
+            if (price.empty()) price.assign(findPrice(text));
+        }
+    }
+
+    std::string title;
+    std::string content;
+    std::vector<std::string> links;
+    std::vector<std::string> images;
+    std::string heading;                    // Of the first <h1> or <h2>
+    std::string price;
+    std::string description;
+
+private:
+    void addUrl(unsigned field, std::vector<std::string>& urls, std::string_view url) {
+        if ((fields_ & field) && !url.empty()) urls.emplace_back(url);
+    }
+
+    unsigned fields_;
+    bool in_title_ = false;
+    bool title_done_ = false;
+    std::string heading_tag_;
+    bool heading_done_ = false;
+};
+
+namespace {
+
+// Runs one tokenizer pass over html
+void collectPage(const std::string& html, HtmlTokenHandler& page) {
+    HtmlTokenizer tokenizer(page);
+    tokenizer.feed(html);
+    tokenizer.finish();
+}
+
+} // namespace
+
+// State of one crawl. The frontier, the per-host queues and the curl
+// handles belong to the thread calling run(); parser workers only hand
+// finished pages back through parsed_.
+class WebScraper::CrawlSession {
+public:
+    CrawlSession(WebScraper& scraper, const CrawlOptions& options,
+                 const std::function<void(ScrapedData& page)>& onPage);
+    ~CrawlSession();
+
+    // Queues url unless it was queued before
+    void add(const std::string& url, int depth);
+    void run();
+
+private:
+    struct Page {
+        std::string url;
+        int depth;
+    };
+    struct Host {
+        std::deque<Page> queue;
+        size_t active = 0;
+        Clock::time_point next_start;
+        bool scheduled = false;                 // In due_
+    };
+    struct Fetch {
+        Page page;
+        std::string host;
+        std::string body;
+        CURL* handle;
+    };
+    struct Parsed {
+        ScrapedData data;
+        int depth;
+    };
+    using Due = std::pair<Clock::time_point, std::string>;
+
+    bool budgetExhausted() const { return options_.max_pages > 0 && started_ >= options_.max_pages; }
+    bool canStart() const {
+        return in_flight_ < options_.max_concurrent_fetches && pending_parses_ < options_.max_pending_pages &&
+               !budgetExhausted();
+    }
+    bool finished() const { return in_flight_ == 0 && pending_parses_ == 0 && (due_.empty() || budgetExhausted()); }
+
+    void schedule(const std::string& name, Host& host);
+    void startFetches(Clock::time_point now);
+    void startFetch(Page page, const std::string& host);
+    void finishFetch(CURL* handle, CURLcode result);
+    void deliverParsed();
+    void deliver(ScrapedData& data, int depth);
+
+    WebScraper& scraper_;
+    CrawlOptions options_;
+    std::function<void(ScrapedData& page)> on_page_;
+    Clock::duration host_delay_;
+
+    std::unordered_set<size_t> seen_;           // Hashes of queued URLs
+    std::unordered_map<std::string, Host> hosts_;
+    std::priority_queue<Due, std::vector<Due>, std::greater<Due>> due_;    // Hosts that may start a fetch
+    size_t started_ = 0;
+    size_t in_flight_ = 0;
+    size_t pending_parses_ = 0;
+
+    CURLM* multi_;
+    std::unordered_map<CURL*, std::unique_ptr<Fetch>> fetches_;
+    std::vector<CURL*> idle_handles_;
+
+    std::mutex mutex_;
+    std::vector<Parsed> parsed_;                // Filled by parser workers
+    std::unique_ptr<ThreadPool> parsers_;
+};
+
 WebScraper::WebScraper() 
     : curl_handle_(nullptr), headers_(nullptr), 
       user_agent_("ETL-Pipeline/1.0 (Educational Example)"),
@@ -81,6 +312,16 @@ size_t WebScraper::WriteCallback(void* contents, size_t size, size_t nmemb, std:
     return totalSize;
 }
 
+size_t WebScraper::TokenizeCallback(void* contents, size_t size, size_t nmemb, HtmlTokenizer* tokenizer) {
+    size_t totalSize = size * nmemb;
+    try {
+        tokenizer->feed(std::string_view(static_cast<char*>(contents), totalSize));
+    } catch (...) {
+        return 0;                               // Fails the transfer
+    }
+    return totalSize;
+}
+
 std::string WebScraper::performRequest(const std::string& url) {
     if (!curl_handle_) {
         throw std::runtime_error("CURL not initialized");
@@ -100,26 +341,63 @@ std::string WebScraper::performRequest(const std::string& url) {
     return response_data;
 }
 
+void WebScraper::streamRequest(const std::string& url, HtmlTokenizer& tokenizer) {
+    if (!curl_handle_) {
+        throw std::runtime_error("CURL not initialized");
+    }
+
+    respectRateLimit();
+
+    curl_easy_setopt(curl_handle_, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl_handle_, CURLOPT_WRITEFUNCTION, TokenizeCallback);
+    curl_easy_setopt(curl_handle_, CURLOPT_WRITEDATA, &tokenizer);
+
+    CURLcode res = curl_easy_perform(curl_handle_);
+    curl_easy_setopt(curl_handle_, CURLOPT_WRITEFUNCTION, WriteCallback);
+    if (res != CURLE_OK) {
+        throw std::runtime_error("CURL request failed: " + std::string(curl_easy_strerror(res)));
+    }
+    tokenizer.finish();
+}
+
+void WebScraper::extractPage(const std::string& html, ScrapedData& data) {
+    PageCollector page(PAGE_SCRAPED);
+    collectPage(html, page);
+    fillPage(page, data);
+}
+
+void WebScraper::fillPage(PageCollector& page, ScrapedData& data) {
+    data.title = cleanText(page.title);
+    data.content = cleanText(page.content);
+    data.links = std::move(page.links);
+    data.images = std::move(page.images);
+    for (auto& link : data.links) {
+        link = resolveUrl(link, data.url);
+    }
+    for (auto& image : data.images) {
+        image = resolveUrl(image, data.url);
+    }
+    
+    // Add timestamp
+    auto now = std::chrono::system_clock::now();
+    auto time_t = std::chrono::system_clock::to_time_t(now);
+    data.timestamp = std::to_string(time_t);
+}
+
 ScrapedData WebScraper::scrapeUrl(const std::string& url) {
     ScrapedData data;
     data.url = url;
     
     try {
-        std::string html = performRequest(url);
+        // The page is parsed as it arrives
+        PageCollector page(PAGE_SCRAPED);
+        HtmlTokenizer tokenizer(page);
+        streamRequest(url, tokenizer);
         
         // Get response code
         curl_easy_getinfo(curl_handle_, CURLINFO_RESPONSE_CODE, &data.response_code);
         
-        // Extract data
-        data.title = extractTitle(html);
-        data.content = extractText(html);
-        data.links = extractLinks(html, url);
-        data.images = extractImages(html, url);
-        
-        // Add timestamp
-        auto now = std::chrono::system_clock::now();
-        auto time_t = std::chrono::system_clock::to_time_t(now);
-        data.timestamp = std::to_string(time_t);
+        fillPage(page, data);
         
     } catch (const std::exception& e) {
         std::cerr << "Error scraping " << url << ": " << e.what() << std::endl;
@@ -129,138 +407,367 @@ ScrapedData WebScraper::scrapeUrl(const std::string& url) {
     return data;
 }
 
-std::vector<ScrapedData> WebScraper::scrapeUrls(const std::vector<std::string>& urls) {
-    std::vector<ScrapedData> results;
-    results.reserve(urls.size());
-    
-    for (const auto& url : urls) {
-        results.push_back(scrapeUrl(url));
+std::vector<ScrapedData> WebScraper::scrapeUrls(const std::vector<std::string>& urls, const CrawlOptions& options) {
+    std::vector<ScrapedData> results(urls.size());
+    std::unordered_map<std::string, std::vector<size_t>> positions;
+    for (size_t i = 0; i < urls.size(); ++i) {
+        positions[urls[i]].push_back(i);
     }
     
+    CrawlOptions seedsOnly = options;
+    seedsOnly.max_depth = 0;
+    seedsOnly.max_pages = 0;
+    crawl(urls, seedsOnly, [&](ScrapedData& page) {
+        // A URL listed more than once is fetched once
+        const auto& where = positions[page.url];
+        for (size_t i = 1; i < where.size(); ++i) {
+            results[where[i]] = page;
+        }
+        results[where[0]] = std::move(page);
+    });
+    
     return results;
 }
 
-std::string WebScraper::extractTitle(const std::string& html) {
-    std::regex titleRegex("<title[^>]*>([^<]+)</title>", std::regex_constants::icase);
-    std::smatch match;
+void WebScraper::crawl(const std::vector<std::string>& seeds, const CrawlOptions& options,
+                       const std::function<void(ScrapedData& page)>& onPage) {
+    CrawlSession session(*this, options, onPage);
+    for (const auto& url : seeds) {
+        session.add(url, 0);
+    }
+    session.run();
+}
+
+WebScraper::CrawlSession::CrawlSession(WebScraper& scraper, const CrawlOptions& options,
+                                       const std::function<void(ScrapedData& page)>& onPage)
+    : scraper_(scraper), options_(options), on_page_(onPage) {
+    options_.max_concurrent_fetches = std::max<size_t>(options_.max_concurrent_fetches, 1);
+    options_.max_requests_per_host = std::max<size_t>(options_.max_requests_per_host, 1);
+    if (options_.parser_threads == 0) {
+        options_.parser_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (options_.max_pending_pages == 0) {
+        options_.max_pending_pages = 4 * options_.parser_threads;
+    }
+    host_delay_ = std::chrono::milliseconds(options_.host_delay_ms >= 0 ? options_.host_delay_ms : scraper.delay_ms_);
     
-    if (std::regex_search(html, match, titleRegex)) {
-        return cleanText(match[1].str());
+    multi_ = curl_multi_init();
+    if (!multi_) {
+        throw std::runtime_error("Failed to create curl multi handle");
     }
-    return "";
+    curl_multi_setopt(multi_, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    curl_multi_setopt(multi_, CURLMOPT_MAX_HOST_CONNECTIONS, static_cast<long>(options_.max_requests_per_host));
+    curl_multi_setopt(multi_, CURLMOPT_MAXCONNECTS, static_cast<long>(options_.max_concurrent_fetches));
+    parsers_.reset(new ThreadPool(options_.parser_threads));
 }
 
-std::string WebScraper::extractText(const std::string& html) {
-    // Remove script and style tags
-    std::regex scriptRegex("<script[^>]*>.*?</script>", std::regex_constants::icase);
-    std::regex styleRegex("<style[^>]*>.*?</style>", std::regex_constants::icase);
+WebScraper::CrawlSession::~CrawlSession() {
+    parsers_.reset();                           // Waits for pages still being parsed
+    for (auto& fetch : fetches_) {
+        curl_multi_remove_handle(multi_, fetch.first);
+        curl_easy_cleanup(fetch.first);
+    }
+    for (CURL* handle : idle_handles_) {
+        curl_easy_cleanup(handle);
+    }
+    curl_multi_cleanup(multi_);
+}
+
+void WebScraper::CrawlSession::add(const std::string& url, int depth) {
+    if (!seen_.insert(std::hash<std::string>{}(url)).second) {
+        return;
+    }
+    std::string name = hostOf(url);
+    Host& host = hosts_[name];
+    host.queue.push_back({url, depth});
+    schedule(name, host);
+}
+
+void WebScraper::CrawlSession::schedule(const std::string& name, Host& host) {
+    if (!host.scheduled && !host.queue.empty() && host.active < options_.max_requests_per_host) {
+        due_.emplace(host.next_start, name);
+        host.scheduled = true;
+    }
+}
+
+void WebScraper::CrawlSession::run() {
+    while (true) {
+        deliverParsed();
+        startFetches(Clock::now());
+        if (finished()) {
+            break;
+        }
+        
+        int running = 0;
+        CURLMcode mc = curl_multi_perform(multi_, &running);
+        if (mc != CURLM_OK) {
+            throw std::runtime_error(std::string("curl_multi_perform failed: ") + curl_multi_strerror(mc));
+        }
+        CURLMsg* message;
+        int queued;
+        while ((message = curl_multi_info_read(multi_, &queued))) {
+            if (message->msg == CURLMSG_DONE) {
+                finishFetch(message->easy_handle, message->data.result);
+            }
+        }
+        if (finished()) {
+            continue;
+        }
+        
+        // Sleep in curl until a socket is ready, a parser is done or a host is due
+        int timeoutMs = 1000;
+        if (!due_.empty() && canStart()) {
+            auto wait = due_.top().first - Clock::now();
+            timeoutMs = wait <= Clock::duration::zero()
+                ? 0 : static_cast<int>(std::min<long long>(std::chrono::ceil<std::chrono::milliseconds>(wait).count(), 1000));
+        }
+        if (timeoutMs > 0) {
+            mc = curl_multi_poll(multi_, nullptr, 0, timeoutMs, nullptr);
+            if (mc != CURLM_OK) {
+                throw std::runtime_error(std::string("curl_multi_poll failed: ") + curl_multi_strerror(mc));
+            }
+        }
+    }
+}
+
+void WebScraper::CrawlSession::startFetches(Clock::time_point now) {
+    while (!due_.empty() && due_.top().first <= now && canStart()) {
+        std::string name = due_.top().second;
+        due_.pop();
+        Host& host = hosts_[name];
+        host.scheduled = false;
+        
+        Page page = std::move(host.queue.front());
+        host.queue.pop_front();
+        host.active++;
+        host.next_start = now + host_delay_;
+        startFetch(std::move(page), name);
+        schedule(name, host);
+    }
+}
+
+void WebScraper::CrawlSession::startFetch(Page page, const std::string& host) {
+    CURL* handle;
+    if (!idle_handles_.empty()) {
+        handle = idle_handles_.back();
+        idle_handles_.pop_back();
+        curl_easy_reset(handle);
+    } else {
+        handle = curl_easy_init();
+        if (!handle) {
+            throw std::runtime_error("Failed to create curl handle");
+        }
+    }
     
-    std::string cleanedHtml = std::regex_replace(html, scriptRegex, "");
-    cleanedHtml = std::regex_replace(cleanedHtml, styleRegex, "");
+    std::unique_ptr<Fetch> fetch(new Fetch{std::move(page), host, std::string(), handle});
+    curl_easy_setopt(handle, CURLOPT_URL, fetch->page.url.c_str());
+    curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, WriteCallback);
+    curl_easy_setopt(handle, CURLOPT_WRITEDATA, &fetch->body);
+    curl_easy_setopt(handle, CURLOPT_USERAGENT, scraper_.user_agent_.c_str());
+    curl_easy_setopt(handle, CURLOPT_TIMEOUT, scraper_.timeout_);
+    curl_easy_setopt(handle, CURLOPT_FOLLOWLOCATION, scraper_.follow_redirects_ ? 1L : 0L);
+    curl_easy_setopt(handle, CURLOPT_SSL_VERIFYPEER, 0L);
+    curl_easy_setopt(handle, CURLOPT_SSL_VERIFYHOST, 0L);
+    curl_easy_setopt(handle, CURLOPT_ACCEPT_ENCODING, "");
+    if (scraper_.headers_) {
+        curl_easy_setopt(handle, CURLOPT_HTTPHEADER, scraper_.headers_);
+    }
+    // HTTP/2 when TLS negotiates it, sharing one connection per host
+    curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+    if (fetch->page.url.compare(0, 8, "https://") == 0) {
+        curl_easy_setopt(handle, CURLOPT_PIPEWAIT, 1L);
+    }
+    
+    CURLMcode mc = curl_multi_add_handle(multi_, handle);
+    if (mc != CURLM_OK) {
+        idle_handles_.push_back(handle);
+        throw std::runtime_error(std::string("curl_multi_add_handle failed: ") + curl_multi_strerror(mc));
+    }
+    fetches_[handle] = std::move(fetch);
+    in_flight_++;
+    started_++;
+}
+
+void WebScraper::CrawlSession::finishFetch(CURL* handle, CURLcode result) {
+    auto it = fetches_.find(handle);
+    std::unique_ptr<Fetch> fetch = std::move(it->second);
+    fetches_.erase(it);
+    curl_multi_remove_handle(multi_, handle);
+    idle_handles_.push_back(handle);
+    in_flight_--;
     
-    // Remove HTML tags
-    std::regex tagRegex("<[^>]*>");
-    std::string text = std::regex_replace(cleanedHtml, tagRegex, " ");
+    Host& host = hosts_[fetch->host];
+    host.active--;
+    schedule(fetch->host, host);
     
-    return cleanText(text);
+    ScrapedData data;
+    data.url = std::move(fetch->page.url);
+    data.response_code = 0;
+    if (result != CURLE_OK) {
+        data.metadata["error"] = curl_easy_strerror(result);
+        deliver(data, fetch->page.depth);
+        return;
+    }
+    curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &data.response_code);
+    
+    pending_parses_++;
+    int depth = fetch->page.depth;
+    parsers_->submit([this, depth, data = std::move(data), body = std::move(fetch->body)]() mutable {
+        try {
+            scraper_.extractPage(body, data);
+        } catch (const std::exception& e) {
+            data.metadata["error"] = e.what();
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            parsed_.push_back({std::move(data), depth});
+        }
+        curl_multi_wakeup(multi_);
+    });
+}
+
+void WebScraper::CrawlSession::deliverParsed() {
+    std::vector<Parsed> parsed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        parsed.swap(parsed_);
+    }
+    for (auto& page : parsed) {
+        pending_parses_--;
+        deliver(page.data, page.depth);
+    }
+}
+
+void WebScraper::CrawlSession::deliver(ScrapedData& data, int depth) {
+    if (depth < options_.max_depth) {
+        std::string host = hostOf(data.url);
+        for (std::string link : data.links) {
+            if (!isFollowable(link)) continue;
+            link = link.substr(0, link.find('#'));
+            if (options_.same_host_only && hostOf(link) != host) continue;
+            add(link, depth + 1);
+        }
+    }
+    on_page_(data);
+}
+
+std::string WebScraper::extractTitle(const std::string& html) {
+    PageCollector page(PAGE_TITLE);
+    collectPage(html, page);
+    return cleanText(page.title);
+}
+
+std::string WebScraper::extractText(const std::string& html) {
+    // Script and style contents are skipped by the tokenizer
+    PageCollector page(PAGE_TEXT);
+    collectPage(html, page);
+    return cleanText(page.content);
 }
 
 std::vector<std::string> WebScraper::extractLinks(const std::string& html, const std::string& baseUrl) {
-    std::vector<std::string> links;
-    std::regex linkRegex("<a[^>]+href\\s*=\\s*[\"']([^\"']+)[\"']", std::regex_constants::icase);
-    std::sregex_iterator iter(html.begin(), html.end(), linkRegex);
-    std::sregex_iterator end;
+    PageCollector page(PAGE_LINKS);
+    collectPage(html, page);
     
-    for (; iter != end; ++iter) {
-        std::string link = (*iter)[1].str();
-        if (!baseUrl.empty()) {
+    if (!baseUrl.empty()) {
+        for (auto& link : page.links) {
             link = resolveUrl(link, baseUrl);
         }
-        links.push_back(link);
     }
-    
-    return links;
+    return std::move(page.links);
 }
 
 std::vector<std::string> WebScraper::extractImages(const std::string& html, const std::string& baseUrl) {
-    std::vector<std::string> images;
-    std::regex imgRegex("<img[^>]+src\\s*=\\s*[\"']([^\"']+)[\"']", std::regex_constants::icase);
-    std::sregex_iterator iter(html.begin(), html.end(), imgRegex);
-    std::sregex_iterator end;
+    PageCollector page(PAGE_IMAGES);
+    collectPage(html, page);
     
-    for (; iter != end; ++iter) {
-        std::string src = (*iter)[1].str();
-        if (!baseUrl.empty()) {
+    if (!baseUrl.empty()) {
+        for (auto& src : page.images) {
             src = resolveUrl(src, baseUrl);
         }
-        images.push_back(src);
     }
-    
-    return images;
+    return std::move(page.images);
 }
 
 WebScraper::ProductData WebScraper::extractProductData(const std::string& html) {
-    ProductData product;
-    
-    // Extract product name (try common selectors)
-    std::regex nameRegex("<h1[^>]*>([^<]+)</h1>|<h2[^>]*>([^<]+)</h2>", std::regex_constants::icase);
-    std::smatch match;
-    if (std::regex_search(html, match, nameRegex)) {
-        product.name = cleanText(match[1].str().empty() ? match[2].str() : match[1].str());
-    }
-    
-    // Extract price (basic patterns)
-    std::regex priceRegex("\\$([0-9,]+\\.?[0-9]*)|([0-9,]+\\.?[0-9]*)\\s*USD", std::regex_constants::icase);
-    if (std::regex_search(html, match, priceRegex)) {
-        product.price = match[0].str();
-    }
-    
-    // Extract description (look for meta description or first paragraph)
-    std::regex descRegex("<meta[^>]+name\\s*=\\s*[\"']description[\"'][^>]+content\\s*=\\s*[\"']([^\"']+)[\"']", std::regex_constants::icase);
-    if (std::regex_search(html, match, descRegex)) {
-        product.description = cleanText(match[1].str());
-    }
+    PageCollector page(PAGE_PRODUCT);
+    collectPage(html, page);
     
+    ProductData product;
+    product.name = cleanText(page.heading);
+    product.price = page.price;
+    product.description = cleanText(page.description);
     return product;
 }
 
 std::string WebScraper::cleanText(const std::string& text) {
-    std::string cleaned = text;
+    // Entities become spaces, runs of whitespace a single space, and the
+    // ends are trimmed
+    std::string cleaned;
+    cleaned.reserve(text.size());
+    bool space = false;
     
-    // Replace HTML entities
-    std::regex entityRegex("&([a-zA-Z]+|#[0-9]+);");
-    cleaned = std::regex_replace(cleaned, entityRegex, " ");
-    
-    // Replace multiple whitespace with single space
-    std::regex whitespaceRegex("\\s+");
-    cleaned = std::regex_replace(cleaned, whitespaceRegex, " ");
-    
-    // Trim leading and trailing whitespace
-    cleaned.erase(0, cleaned.find_first_not_of(" \t\n\r"));
-    cleaned.erase(cleaned.find_last_not_of(" \t\n\r") + 1);
+    for (size_t i = 0; i < text.size(); ) {
+        char c = text[i];
+        if (c == '&') {
+            size_t end = entityEnd(text, i);
+            if (end > 0) {
+                space = true;
+                i = end;
+                continue;
+            }
+        }
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            space = true;
+            ++i;
+            continue;
+        }
+        if (space && !cleaned.empty()) {
+            cleaned += ' ';
+        }
+        space = false;
+        cleaned += c;
+        ++i;
+    }
     
     return cleaned;
 }
 
 std::string WebScraper::resolveUrl(const std::string& url, const std::string& baseUrl) {
-    if (url.substr(0, 7) == "http://" || url.substr(0, 8) == "https://") {
-        return url;  // Already absolute
+    if (url.empty()) {
+        return baseUrl;
+    }
+    size_t colon = url.find(':');
+    if (colon != std::string::npos && url.find_first_of("/?#") > colon) {
+        return url;  // Already absolute (http:, mailto:, ...)
     }
     
+    size_t schemeEnd = baseUrl.find("://");
+    if (url.compare(0, 2, "//") == 0) {
+        // Relative to the scheme
+        return (schemeEnd != std::string::npos ? baseUrl.substr(0, schemeEnd + 1) : "http:") + url;
+    }
+    size_t pathStart = schemeEnd == std::string::npos ? 0 : baseUrl.find_first_of("/?#", schemeEnd + 3);
+    std::string root = baseUrl.substr(0, pathStart);
     if (url[0] == '/') {
         // Relative to domain root
-        size_t pos = baseUrl.find("://");
-        if (pos != std::string::npos) {
-            pos = baseUrl.find('/', pos + 3);
-            if (pos != std::string::npos) {
-                return baseUrl.substr(0, pos) + url;
-            }
-        }
-        return baseUrl + url;
+        return root + url;
+    }
+    
+    std::string base = baseUrl.substr(0, baseUrl.find('#'));
+    if (url[0] == '#') {
+        return base + url;
+    }
+    base = base.substr(0, base.find('?'));
+    if (url[0] == '?') {
+        return base + url;
     }
     
     // Relative to current directory
-    return baseUrl + "/" + url;
+    size_t slash = base.rfind('/');
+    if (slash == std::string::npos || slash < root.size()) {
+        return root + "/" + url;
+    }
+    return base.substr(0, slash + 1) + url;
 }
 
 void WebScraper::respectRateLimit() {
@@ -4,10 +4,13 @@
 #include <vector>
 #include <memory>
 #include <map>
+#include <functional>
 #include <curl/curl.h>
 
 namespace etl {
 
+class HtmlTokenizer;
+
 struct ScrapedData {
     std::string url;
     std::string title;
@@ -19,6 +22,19 @@ struct ScrapedData {
     std::string timestamp;
 };
 
+struct CrawlOptions {
+    size_t max_concurrent_fetches = 64;     // Downloads in flight across all hosts
+    size_t max_requests_per_host = 2;       // Downloads in flight to one host
+    int host_delay_ms = -1;                 // Between starting requests to one host;
+                                            // negative: the scraper's setDelay/setRateLimit
+    size_t parser_threads = 0;              // HTML extraction workers; 0: one per core
+    size_t max_pending_pages = 0;           // Downloaded pages waiting for a parser before
+                                            // fetching pauses; 0: 4 per parser thread
+    int max_depth = 0;                      // Link hops followed from the seeds; 0: seeds only
+    size_t max_pages = 0;                   // Pages fetched in total; 0: no limit
+    bool same_host_only = true;             // Follow links only to the host of their page
+};
+
 class WebScraper {
 public:
     WebScraper();
@@ -32,9 +48,22 @@ public:
 
     // Core scraping functionality
     ScrapedData scrapeUrl(const std::string& url);
-    std::vector<ScrapedData> scrapeUrls(const std::vector<std::string>& urls);
+    // Fetches the urls concurrently as a crawl of depth 0; results are in
+    // input order
+    std::vector<ScrapedData> scrapeUrls(const std::vector<std::string>& urls, const CrawlOptions& options = {});
 
-    // HTML parsing utilities
+    // Crawls from seeds. Downloads are multiplexed on one curl multi handle,
+    // with each host's requests limited and spaced by options; pages are
+    // parsed on a worker pool while further downloads proceed. Links found
+    // are followed up to max_depth, each URL fetched at most once. onPage
+    // receives every page, on the calling thread, in completion order;
+    // a failed download has response_code 0 and metadata["error"].
+    void crawl(const std::vector<std::string>& seeds, const CrawlOptions& options,
+               const std::function<void(ScrapedData& page)>& onPage);
+
+    // HTML parsing utilities. Each makes one pass over html; extracting
+    // several things from a page is cheaper through scrapeUrl or crawl,
+    // which collect them all in a single pass.
     std::string extractTitle(const std::string& html);
     std::string extractText(const std::string& html);
     std::vector<std::string> extractLinks(const std::string& html, const std::string& baseUrl = "");
@@ -60,6 +89,9 @@ public:
     void setDelay(int milliseconds);
 
 private:
+    class CrawlSession;
+    class PageCollector;
+
     CURL* curl_handle_;
     struct curl_slist* headers_;
     std::string user_agent_;
@@ -70,9 +102,16 @@ private:
     
     // Callback for writing received data
     static size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* userp);
+    static size_t TokenizeCallback(void* contents, size_t size, size_t nmemb, HtmlTokenizer* tokenizer);
     
-    // HTTP request helper
+    // HTTP request helpers
     std::string performRequest(const std::string& url);
+    // Tokenizes the body as it is received instead of returning it
+    void streamRequest(const std::string& url, HtmlTokenizer& tokenizer);
+    
+    // Fills title, content, links, images and timestamp from html
+    void extractPage(const std::string& html, ScrapedData& data);
+    void fillPage(PageCollector& page, ScrapedData& data);
     
     // HTML utility functions
     std::string cleanText(const std::string& text);
@@ -0,0 +1,14 @@
+# Adds the shared in-memory cache (sharded_cache.h/cpp) to a target.
+#
+#   include(path/to/in_memory/cache.cmake)
+#   target_add_sharded_cache(my_target)
+
+find_package(Threads REQUIRED)
+
+set(SHARDED_CACHE_SOURCE_DIR ${CMAKE_CURRENT_LIST_DIR})
+
+function(target_add_sharded_cache target)
+    target_sources(${target} PRIVATE ${SHARDED_CACHE_SOURCE_DIR}/sharded_cache.cpp)
+    target_include_directories(${target} PRIVATE ${SHARDED_CACHE_SOURCE_DIR})
+    target_link_libraries(${target} Threads::Threads)
+endfunction()
@@ -0,0 +1,162 @@
+#include "sharded_cache.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Samples key ranks 0..n-1 with probability proportional to 1 / (rank+1)^s
+class ZipfGenerator {
+private:
+    std::vector<double> cdf;
+
+public:
+    ZipfGenerator(size_t n, double s) : cdf(n) {
+        double sum = 0;
+        for (size_t i = 0; i < n; ++i) {
+            sum += 1.0 / std::pow(static_cast<double>(i + 1), s);
+            cdf[i] = sum;
+        }
+        for (double& value : cdf) value /= sum;
+    }
+
+    size_t operator()(std::mt19937_64& rng) {
+        double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        return std::lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin();
+    }
+};
+
+std::string keyFor(size_t rank) {
+    return "user:" + std::to_string(rank);
+}
+
+void printStats(const std::string& label, const CacheStats& stats) {
+    std::cout << std::left << std::setw(24) << label << std::right << std::fixed << std::setprecision(1)
+              << " hit ratio " << std::setw(5) << stats.hitRatio() * 100 << "%"
+              << "  entries " << std::setw(7) << stats.entries
+              << "  evictions " << std::setw(8) << stats.evictions
+              << "  rejected " << std::setw(8) << stats.rejections
+              << "  charged " << std::setw(6) << stats.bytes / 1024 << " KB"
+              << "  slabs " << std::setw(6) << stats.slab_bytes / 1024 << " KB" << std::endl;
+}
+
+void basicUsage() {
+    std::cout << "=== Basic Usage ===" << std::endl;
+
+    CacheConfig config;
+    config.capacity_bytes = 4 * 1024 * 1024;
+    ShardedCache cache(config);
+
+    cache.put("greeting", "hello world");
+    cache.put("session:42", "alice", std::chrono::milliseconds(50));
+
+    std::string value;
+    if (cache.get("greeting", value)) {
+        std::cout << "greeting -> " << value << std::endl;
+    }
+    std::cout << "session:42 present: " << (cache.get("session:42", value) ? "yes" : "no") << std::endl;
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    std::cout << "session:42 present after its 50 ms TTL: " << (cache.get("session:42", value) ? "yes" : "no")
+              << std::endl;
+
+    cache.erase("greeting");
+    std::cout << "greeting present after erase: " << (cache.get("greeting", value) ? "yes" : "no") << std::endl;
+    std::cout << "shards: " << cache.shardCount() << ", capacity " << cache.capacity() / 1024 << " KB" << std::endl;
+}
+
+// Cache-aside reads over a skewed key space, with a one-off scan of cold
+// keys halfway through. CLOCK alone lets the scan push out hot entries;
+// the TinyLFU filter turns most of the scanned keys away at the door.
+void hitRatioComparison() {
+    std::cout << "\n=== Hit Ratio: Zipf(0.9) Reads With a Scan ===" << std::endl;
+
+    const size_t keyCount = 200000;
+    const size_t operations = 1000000;
+    const std::string value(200, 'v');
+    ZipfGenerator zipf(keyCount, 0.9);
+
+    for (bool admission : {false, true}) {
+        CacheConfig config;
+        config.capacity_bytes = 8 * 1024 * 1024;
+        config.admission_filter = admission;
+        ShardedCache cache(config);
+
+        std::mt19937_64 rng(7);
+        std::string out;
+        size_t hitsAfterScan = 0;
+        for (size_t i = 0; i < operations; ++i) {
+            if (i == operations / 2) {
+                for (size_t cold = 0; cold < keyCount; ++cold) {
+                    std::string key = "scan:" + std::to_string(cold);
+                    if (!cache.get(key, out)) cache.put(key, value);
+                }
+            }
+            std::string key = keyFor(zipf(rng));
+            if (cache.get(key, out)) {
+                hitsAfterScan += i >= operations / 2;
+            } else {
+                cache.put(key, value);
+            }
+        }
+        printStats(admission ? "CLOCK + TinyLFU" : "CLOCK", cache.stats());
+        std::cout << std::setw(24) << "" << " hit ratio of the Zipf reads after the scan "
+                  << std::setprecision(1) << 100.0 * hitsAfterScan / (operations - operations / 2) << "%"
+                  << std::endl;
+    }
+}
+
+// 90% reads, 10% writes over a key set that fits the cache
+void throughputComparison() {
+    std::cout << "\n=== Throughput: 90% get / 10% put ===" << std::endl;
+
+    const size_t keyCount = 100000;
+    const size_t opsPerThread = 500000;
+    const std::string value(100, 'v');
+    unsigned maxThreads = std::max(2u, std::thread::hardware_concurrency());
+
+    for (size_t shards : {size_t(1), size_t(0)}) {
+        CacheConfig config;
+        config.capacity_bytes = 64 * 1024 * 1024;
+        config.shards = shards;
+        ShardedCache cache(config);
+        for (size_t i = 0; i < keyCount; ++i) cache.put(keyFor(i), value);
+
+        for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+            std::vector<std::thread> workers;
+            auto start = std::chrono::high_resolution_clock::now();
+            for (unsigned t = 0; t < threads; ++t) {
+                workers.emplace_back([&, t] {
+                    std::mt19937_64 rng(t + 1);
+                    std::uniform_int_distribution<size_t> pick(0, keyCount - 1);
+                    std::string out;
+                    for (size_t i = 0; i < opsPerThread; ++i) {
+                        std::string key = keyFor(pick(rng));
+                        if (i % 10 == 0) {
+                            cache.put(key, value);
+                        } else {
+                            cache.get(key, out);
+                        }
+                    }
+                });
+            }
+            for (auto& worker : workers) worker.join();
+            double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+            std::cout << std::setw(4) << cache.shardCount() << " shard(s), " << std::setw(2) << threads
+                      << " thread(s): " << std::fixed << std::setprecision(2)
+                      << threads * opsPerThread / seconds / 1e6 << " M ops/s" << std::endl;
+        }
+    }
+}
+
+int main() {
+    basicUsage();
+    hitRatioComparison();
+    throughputComparison();
+    return 0;
+}
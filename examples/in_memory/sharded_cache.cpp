@@ -0,0 +1,465 @@
+#include "sharded_cache.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t PAGE_SIZE = 64 * 1024;        // Slab page, carved into chunks of one size
+constexpr size_t MIN_CHUNK = 64;
+constexpr size_t ENTRY_OVERHEAD = 96;          // Slot and index node, charged per entry
+constexpr size_t SKETCH_ENTRY_BYTES = 256;     // Assumed mean charge when sizing the sketch
+constexpr unsigned SKETCH_ROWS = 4;
+constexpr uint8_t SKETCH_MAX = 15;             // 4-bit saturating counters
+constexpr uint64_t SKETCH_SEEDS[SKETCH_ROWS] = {
+    0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL, 0x9ae16a3b2f90404fULL, 0xcbf29ce484222325ULL};
+
+// std::hash<std::string_view> is not guaranteed to spread its top bits,
+// which pick the shard, so finish it with the murmur3 mixer
+uint64_t hashKey(std::string_view key) {
+    uint64_t h = std::hash<std::string_view>{}(key);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+size_t nextPowerOfTwo(size_t n) {
+    size_t power = 1;
+    while (power < n) power <<= 1;
+    return power;
+}
+
+int64_t now() {
+    return Clock::now().time_since_epoch().count();
+}
+
+// Chunk sizes grow by about 1.25x from MIN_CHUNK, 8-byte aligned, so a
+// value wastes at most a fifth of its chunk
+const std::vector<size_t>& chunkSizes() {
+    static const std::vector<size_t> sizes = [] {
+        std::vector<size_t> result;
+        for (size_t size = MIN_CHUNK; size < PAGE_SIZE; size = (size * 5 / 4 + 7) & ~size_t(7)) {
+            result.push_back(size);
+        }
+        result.push_back(PAGE_SIZE);
+        return result;
+    }();
+    return sizes;
+}
+
+// Index into chunkSizes(), or chunkSizes().size() for a dedicated page
+size_t sizeClass(size_t size) {
+    const auto& sizes = chunkSizes();
+    return std::lower_bound(sizes.begin(), sizes.end(), size) - sizes.begin();
+}
+
+size_t chunkSize(size_t size) {
+    size_t cls = sizeClass(size);
+    return cls < chunkSizes().size() ? chunkSizes()[cls] : (size + 7) & ~size_t(7);
+}
+
+// Per-shard slab allocator. Pages of PAGE_SIZE are carved into chunks of
+// one size class on demand; anything larger than a page gets a page of its
+// own. Freed chunks go on their page's free list, and a page that empties
+// goes back to the heap unless it is the last one with room in its class.
+// Not thread-safe: the shard's exclusive lock covers it.
+class SlabAllocator {
+public:
+    struct Page {
+        std::unique_ptr<char[]> memory;
+        size_t size_class;
+        size_t chunk_size;
+        size_t chunk_count;
+        size_t carved = 0;                      // Chunks handed out at least once
+        size_t used = 0;
+        char* free_list = nullptr;              // Next pointer stored in the chunk
+    };
+
+    SlabAllocator() : partial_(chunkSizes().size()) {}
+
+    ~SlabAllocator() { clear(); }
+
+    SlabAllocator(const SlabAllocator&) = delete;
+    SlabAllocator& operator=(const SlabAllocator&) = delete;
+
+    char* allocate(size_t size, Page*& owner) {
+        size_t cls = sizeClass(size);
+        if (cls == chunkSizes().size()) {
+            owner = newPage(cls, chunkSize(size), 1);
+        } else if (partial_[cls].empty()) {
+            owner = newPage(cls, chunkSizes()[cls], PAGE_SIZE / chunkSizes()[cls]);
+            partial_[cls].insert(owner);
+        } else {
+            owner = *partial_[cls].begin();
+        }
+
+        Page* page = owner;
+        char* chunk;
+        if (page->free_list) {
+            chunk = page->free_list;
+            std::memcpy(&page->free_list, chunk, sizeof(char*));
+        } else {
+            chunk = page->memory.get() + page->carved++ * page->chunk_size;
+        }
+        if (++page->used == page->chunk_count && page->size_class < partial_.size()) {
+            partial_[page->size_class].erase(page);
+        }
+        return chunk;
+    }
+
+    void release(char* chunk, Page* page) {
+        bool dedicated = page->size_class == partial_.size();
+        if (--page->used == 0 && (dedicated || partial_[page->size_class].size() > 1)) {
+            if (!dedicated) partial_[page->size_class].erase(page);
+            deletePage(page);
+            return;
+        }
+        std::memcpy(chunk, &page->free_list, sizeof(char*));
+        page->free_list = chunk;
+        if (page->used + 1 == page->chunk_count) {
+            partial_[page->size_class].insert(page);
+        }
+    }
+
+    void clear() {
+        for (Page* page : pages_) delete page;
+        pages_.clear();
+        for (auto& partial : partial_) partial.clear();
+        page_bytes_ = 0;
+    }
+
+    size_t pageBytes() const { return page_bytes_; }
+
+private:
+    Page* newPage(size_t cls, size_t chunkSize, size_t chunkCount) {
+        Page* page = new Page{std::unique_ptr<char[]>(new char[chunkSize * chunkCount]), cls, chunkSize, chunkCount};
+        pages_.insert(page);
+        page_bytes_ += chunkSize * chunkCount;
+        return page;
+    }
+
+    void deletePage(Page* page) {
+        page_bytes_ -= page->chunk_size * page->chunk_count;
+        pages_.erase(page);
+        delete page;
+    }
+
+    std::unordered_set<Page*> pages_;
+    std::vector<std::unordered_set<Page*>> partial_;  // Pages with a free chunk, per class
+    size_t page_bytes_ = 0;
+};
+
+// Count-min sketch of recent key popularity for TinyLFU admission: four
+// rows of 4-bit saturating counters (a byte each here), all halved every
+// ten increments per counter so old popularity fades. Updated without a
+// lock; a racing increment may be lost, which only blurs the estimate.
+class FrequencySketch {
+public:
+    explicit FrequencySketch(size_t expectedEntries)
+        : width_(nextPowerOfTwo(std::max<size_t>(expectedEntries, 64))),
+          counters_(new std::atomic<uint8_t>[width_ * SKETCH_ROWS]),
+          sample_size_(10 * width_) {
+        for (size_t i = 0; i < width_ * SKETCH_ROWS; ++i) {
+            counters_[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void increment(uint64_t hash) {
+        for (unsigned row = 0; row < SKETCH_ROWS; ++row) {
+            auto& counter = counters_[row * width_ + index(hash, row)];
+            uint8_t count = counter.load(std::memory_order_relaxed);
+            if (count < SKETCH_MAX) counter.store(count + 1, std::memory_order_relaxed);
+        }
+        if (samples_.fetch_add(1, std::memory_order_relaxed) + 1 == sample_size_) {
+            age();
+        }
+    }
+
+    uint8_t frequency(uint64_t hash) const {
+        uint8_t result = SKETCH_MAX;
+        for (unsigned row = 0; row < SKETCH_ROWS; ++row) {
+            result = std::min(result, counters_[row * width_ + index(hash, row)].load(std::memory_order_relaxed));
+        }
+        return result;
+    }
+
+    void clear() {
+        for (size_t i = 0; i < width_ * SKETCH_ROWS; ++i) {
+            counters_[i].store(0, std::memory_order_relaxed);
+        }
+        samples_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    size_t index(uint64_t hash, unsigned row) const {
+        return static_cast<size_t>(((hash ^ SKETCH_SEEDS[row]) * 0x9e3779b97f4a7c15ULL) >> 32) & (width_ - 1);
+    }
+
+    void age() {
+        for (size_t i = 0; i < width_ * SKETCH_ROWS; ++i) {
+            counters_[i].store(counters_[i].load(std::memory_order_relaxed) >> 1, std::memory_order_relaxed);
+        }
+        samples_.fetch_sub(sample_size_ / 2, std::memory_order_relaxed);
+    }
+
+    size_t width_;
+    std::unique_ptr<std::atomic<uint8_t>[]> counters_;
+    size_t sample_size_;
+    std::atomic<size_t> samples_{0};
+};
+
+} // namespace
+
+// One stripe of the cache. Lookups hold the lock shared and only write the
+// entry's atomic reference bit and the atomic counters; everything else
+// changes under the exclusive lock.
+class ShardedCache::Shard {
+public:
+    Shard(size_t capacity, bool admissionFilter) : capacity_(capacity) {
+        if (admissionFilter) {
+            sketch_ = std::make_unique<FrequencySketch>(capacity / SKETCH_ENTRY_BYTES);
+        }
+    }
+
+    bool get(std::string_view key, uint64_t hash, std::string& value) {
+        if (sketch_) sketch_->increment(hash);
+
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = index_.find(key);
+        if (it == index_.end() || expired(slots_[it->second], now())) {
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        Entry& entry = slots_[it->second];
+        if (!entry.referenced.load(std::memory_order_relaxed)) {
+            entry.referenced.store(true, std::memory_order_relaxed);
+        }
+        value.assign(entry.data + entry.key_size, entry.value_size);
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool put(std::string_view key, uint64_t hash, std::string_view value, int64_t expires) {
+        size_t size = key.size() + value.size();
+        if (chunkSize(size) + ENTRY_OVERHEAD > capacity_) return false;
+
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        auto it = index_.find(key);
+        bool replacing = it != index_.end();
+        if (replacing) remove(it->second);
+
+        if (!makeRoom(chunkSize(size) + ENTRY_OVERHEAD, hash, !replacing)) {
+            rejections_++;
+            return false;
+        }
+
+        uint32_t slot;
+        if (free_slots_.empty()) {
+            slot = static_cast<uint32_t>(slots_.size());
+            slots_.emplace_back();
+        } else {
+            slot = free_slots_.back();
+            free_slots_.pop_back();
+        }
+        Entry& entry = slots_[slot];
+        entry.data = slabs_.allocate(size, entry.page);
+        std::memcpy(entry.data, key.data(), key.size());
+        std::memcpy(entry.data + key.size(), value.data(), value.size());
+        entry.key_size = key.size();
+        entry.value_size = value.size();
+        entry.hash = hash;
+        entry.expires = expires;
+        entry.referenced.store(false, std::memory_order_relaxed);
+        entry.live = true;
+
+        index_.emplace(entry.key(), slot);
+        bytes_ += entry.charge();
+        inserts_++;
+        return true;
+    }
+
+    bool erase(std::string_view key) {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        auto it = index_.find(key);
+        if (it == index_.end()) return false;
+        remove(it->second);
+        return true;
+    }
+
+    void clear() {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        index_.clear();
+        slots_.clear();
+        free_slots_.clear();
+        slabs_.clear();
+        if (sketch_) sketch_->clear();
+        hand_ = 0;
+        bytes_ = 0;
+    }
+
+    void addStats(CacheStats& stats) const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        stats.hits += hits_.load(std::memory_order_relaxed);
+        stats.misses += misses_.load(std::memory_order_relaxed);
+        stats.inserts += inserts_;
+        stats.evictions += evictions_;
+        stats.expirations += expirations_;
+        stats.rejections += rejections_;
+        stats.entries += index_.size();
+        stats.bytes += bytes_;
+        stats.slab_bytes += slabs_.pageBytes();
+    }
+
+private:
+    struct Entry {
+        char* data = nullptr;                   // Key bytes, then value bytes
+        SlabAllocator::Page* page = nullptr;
+        size_t key_size = 0;
+        size_t value_size = 0;
+        uint64_t hash = 0;
+        int64_t expires = 0;                    // steady_clock ticks; 0 never
+        std::atomic<bool> referenced{false};
+        bool live = false;
+
+        std::string_view key() const { return {data, key_size}; }
+        size_t charge() const { return page->chunk_size + ENTRY_OVERHEAD; }
+    };
+
+    static bool expired(const Entry& entry, int64_t time) {
+        return entry.expires != 0 && time >= entry.expires;
+    }
+
+    // Evicts until charge fits. With admit set, the first live victim is
+    // weighed against the incoming key, which is refused if it is the
+    // less popular of the two.
+    bool makeRoom(size_t charge, uint64_t hash, bool admit) {
+        int64_t time = now();
+        while (bytes_ + charge > capacity_) {
+            uint32_t victim = advanceHand(time);
+            bool stale = expired(slots_[victim], time);
+            if (!stale && admit && sketch_) {
+                if (sketch_->frequency(hash) < sketch_->frequency(slots_[victim].hash)) return false;
+                admit = false;
+            }
+            remove(victim);
+            stale ? expirations_++ : evictions_++;
+        }
+        return true;
+    }
+
+    // CLOCK: the next live entry that is expired or has not been read since
+    // the hand last passed it. Terminates within two sweeps while any entry is live.
+    uint32_t advanceHand(int64_t time) {
+        for (;;) {
+            if (hand_ >= slots_.size()) hand_ = 0;
+            uint32_t slot = static_cast<uint32_t>(hand_++);
+            Entry& entry = slots_[slot];
+            if (!entry.live) continue;
+            if (expired(entry, time)) return slot;
+            if (entry.referenced.load(std::memory_order_relaxed)) {
+                entry.referenced.store(false, std::memory_order_relaxed);
+                continue;
+            }
+            return slot;
+        }
+    }
+
+    void remove(uint32_t slot) {
+        Entry& entry = slots_[slot];
+        index_.erase(entry.key());
+        bytes_ -= entry.charge();
+        slabs_.release(entry.data, entry.page);
+        entry.data = nullptr;
+        entry.page = nullptr;
+        entry.live = false;
+        free_slots_.push_back(slot);
+    }
+
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string_view, uint32_t> index_;  // Keys view into the slab chunks
+    std::deque<Entry> slots_;                   // CLOCK ring; a deque so entries never move
+    std::vector<uint32_t> free_slots_;
+    size_t hand_ = 0;
+    SlabAllocator slabs_;
+    std::unique_ptr<FrequencySketch> sketch_;
+    size_t capacity_;
+    size_t bytes_ = 0;
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    uint64_t inserts_ = 0;
+    uint64_t evictions_ = 0;
+    uint64_t expirations_ = 0;
+    uint64_t rejections_ = 0;
+};
+
+ShardedCache::ShardedCache(const CacheConfig& config) : config_(config) {
+    size_t count = config.shards;
+    if (count == 0) {
+        count = 4 * std::max(1u, std::thread::hardware_concurrency());
+    }
+    count = nextPowerOfTwo(count);
+    // A shard smaller than a slab page would spend its whole budget on one page
+    while (count > 1 && config.capacity_bytes / count < 4 * PAGE_SIZE) {
+        count >>= 1;
+    }
+
+    shard_shift_ = 64;
+    for (size_t n = count; n > 1; n >>= 1) shard_shift_--;
+
+    for (size_t i = 0; i < count; ++i) {
+        shards_.push_back(std::make_unique<Shard>(config.capacity_bytes / count, config.admission_filter));
+    }
+}
+
+ShardedCache::~ShardedCache() = default;
+
+ShardedCache::Shard& ShardedCache::shardFor(uint64_t hash) const {
+    return *shards_[shard_shift_ == 64 ? 0 : hash >> shard_shift_];
+}
+
+bool ShardedCache::get(std::string_view key, std::string& value) {
+    uint64_t hash = hashKey(key);
+    return shardFor(hash).get(key, hash, value);
+}
+
+bool ShardedCache::put(std::string_view key, std::string_view value) {
+    return put(key, value, std::chrono::milliseconds(0));
+}
+
+bool ShardedCache::put(std::string_view key, std::string_view value, std::chrono::milliseconds ttl) {
+    if (ttl.count() <= 0) ttl = config_.default_ttl;
+    int64_t expires = 0;
+    if (ttl.count() > 0) {
+        expires = (Clock::now() + ttl).time_since_epoch().count();
+    }
+    uint64_t hash = hashKey(key);
+    return shardFor(hash).put(key, hash, value, expires);
+}
+
+bool ShardedCache::erase(std::string_view key) {
+    uint64_t hash = hashKey(key);
+    return shardFor(hash).erase(key);
+}
+
+void ShardedCache::clear() {
+    for (auto& shard : shards_) shard->clear();
+}
+
+CacheStats ShardedCache::stats() const {
+    CacheStats stats;
+    for (const auto& shard : shards_) shard->addStats(stats);
+    return stats;
+}
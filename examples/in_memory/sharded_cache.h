@@ -0,0 +1,73 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+struct CacheConfig {
+    size_t capacity_bytes = 256 * 1024 * 1024;
+    size_t shards = 0;                          // 0: 4 per hardware thread; rounded up to a power of two
+    std::chrono::milliseconds default_ttl{0};   // 0: entries do not expire
+    // TinyLFU admission: when the cache is full, a new key only displaces
+    // the eviction victim if it has been asked for at least as often
+    bool admission_filter = true;
+};
+
+struct CacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t inserts = 0;
+    uint64_t evictions = 0;
+    uint64_t expirations = 0;
+    uint64_t rejections = 0;                    // New keys turned away by the admission filter
+    size_t entries = 0;
+    size_t bytes = 0;                           // Charged against capacity_bytes
+    size_t slab_bytes = 0;                      // Heap held by slab pages, free chunks included
+
+    double hitRatio() const { return hits + misses ? static_cast<double>(hits) / (hits + misses) : 0.0; }
+};
+
+// Byte-budgeted key/value cache safe to share between threads. Keys hash to
+// one of a power-of-two number of shards, each with its own reader/writer
+// lock, so lookups on one shard never wait for each other and writers only
+// block their own shard. Each entry's key and value are stored together in
+// a chunk of the shard's slab allocator. Eviction is CLOCK: a hit sets the
+// entry's reference bit, and the hand skips referenced entries once,
+// clearing the bit, before evicting. Expired entries read as misses and
+// are reclaimed when overwritten or reached by the hand.
+class ShardedCache {
+public:
+    explicit ShardedCache(const CacheConfig& config = {});
+    ~ShardedCache();
+
+    ShardedCache(const ShardedCache&) = delete;
+    ShardedCache& operator=(const ShardedCache&) = delete;
+
+    // Copies the value into value; false on a miss or an expired entry
+    bool get(std::string_view key, std::string& value);
+
+    // Inserts or replaces; a ttl of 0 uses default_ttl. Returns false when the
+    // entry was not stored: larger than a shard's budget, or not admitted.
+    bool put(std::string_view key, std::string_view value);
+    bool put(std::string_view key, std::string_view value, std::chrono::milliseconds ttl);
+
+    bool erase(std::string_view key);
+    void clear();
+
+    CacheStats stats() const;
+    size_t capacity() const { return config_.capacity_bytes; }
+    size_t shardCount() const { return shards_.size(); }
+
+private:
+    class Shard;
+
+    Shard& shardFor(uint64_t hash) const;
+
+    CacheConfig config_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    unsigned shard_shift_;                      // Top bits of the hash pick the shard
+};
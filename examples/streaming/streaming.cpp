@@ -0,0 +1,176 @@
+#include "processors/stream_engine.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace etl;
+
+int64_t nowMillis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Sensors report readings stamped up to 300 ms before they arrive, out of
+// order; a few are lost in transit for seconds and arrive too late
+void produceReadings(StreamPipeline& pipeline, int producer, int sensors, int64_t runMs, int ratePerSecond) {
+    std::mt19937 rng(producer + 1);
+    std::uniform_int_distribution<int> sensor(0, sensors - 1);
+    std::uniform_int_distribution<int> delay(0, 300);
+    std::normal_distribution<double> temperature(21.0, 2.5);
+    std::uniform_real_distribution<double> humidity(30.0, 60.0);
+    std::uniform_int_distribution<int> straggler(0, 999);
+
+    auto interval = std::chrono::nanoseconds(1000000000LL / ratePerSecond);
+    auto next = std::chrono::steady_clock::now();
+    int64_t end = nowMillis() + runMs;
+    while (nowMillis() < end) {
+        int64_t eventTime = nowMillis() - delay(rng);
+        if (straggler(rng) == 0) eventTime -= 5000;
+
+        nlohmann::json reading = {
+            {"sensor", "sensor-" + std::to_string(sensor(rng))},
+            {"temp", temperature(rng)},
+            {"humidity", humidity(rng)},
+            {"ts", eventTime}
+        };
+        if (!pipeline.push(std::move(reading))) return;
+
+        next += interval;
+        std::this_thread::sleep_until(next);
+    }
+}
+
+// Prints sensor-0's row of each window, and how long after the window's
+// end it came out
+void printWindows(const StreamBatch& batch, std::mutex& outputMutex) {
+    int64_t now = nowMillis();
+    std::lock_guard<std::mutex> lock(outputMutex);
+    for (size_t row = 0; row < batch.records.numRows(); ++row) {
+        nlohmann::json record = batch.records.recordAt(row);
+        if (record["sensor"] != "sensor-0") continue;
+
+        int64_t windowEnd = record["window_end"].get<int64_t>();
+        std::cout << "  [" << record["window_start"].get<int64_t>() % 100000 << ", " << windowEnd % 100000 << ")";
+        for (const auto& field : {"temp_avg", "humidity_max", "humidity_count"}) {
+            if (record.contains(field)) {
+                std::cout << "  " << field << " " << std::fixed << std::setprecision(2) << record[field].get<double>();
+            }
+        }
+        if (now >= windowEnd) {
+            std::cout << "  out " << now - windowEnd << " ms after its end" << std::endl;
+        } else {
+            std::cout << "  (still open, flushed by finish)" << std::endl;
+        }
+    }
+}
+
+// Per-sensor averages over 1 s tumbling windows, written to a JSON lines
+// file as each window closes
+void tumblingWindows() {
+    std::cout << "=== Tumbling 1 s Windows (event time) ===" << std::endl;
+
+    StreamPipelineOptions options;
+    options.time_field = "ts";
+    options.max_out_of_order_ms = 400;
+    options.idle_timeout_ms = 1000;
+
+    FileWriter::StreamWriter writer("sensor_metrics.json", OutputFormat::JSON);
+    std::mutex outputMutex;
+
+    StreamPipeline pipeline(options);
+    pipeline.filter([](const RecordBatch& batch, size_t row) {
+                const Column* temp = batch.findColumn("temp");
+                double value;
+                return temp && temp->numberAt(row, value) && value > -40 && value < 85;
+            })
+            .window(WindowSpec::tumbling(1000), {"sensor"}, {{"temp", "avg"}, {"humidity", "max"}})
+            .sink([&](const StreamBatch& batch) { printWindows(batch, outputMutex); })
+            .sink(writer);
+    pipeline.start();
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < 4; ++p) {
+        producers.emplace_back(produceReadings, std::ref(pipeline), p, 8, 4000, 5000);
+    }
+    for (auto& producer : producers) producer.join();
+    pipeline.finish();
+    writer.close();
+
+    StreamPipelineStats stats = pipeline.stats();
+    std::cout << "records in " << stats.records_in << ", late " << stats.late_records
+              << ", windows " << stats.windows_emitted << ", rows written " << writer.getRecordCount()
+              << " (sensor_metrics.json)" << std::endl;
+}
+
+// 3 s windows every 1 s, over arrival time; each record updates a single
+// 1 s pane however many windows it falls in
+void slidingWindows() {
+    std::cout << "\n=== Sliding 3 s / 1 s Windows (arrival time) ===" << std::endl;
+
+    std::mutex outputMutex;
+    StreamPipeline pipeline;
+    pipeline.window(WindowSpec::sliding(3000, 1000), {"sensor"}, {{"temp", "avg"}, {"humidity", "count"}})
+            .sink([&](const StreamBatch& batch) { printWindows(batch, outputMutex); });
+    pipeline.start();
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < 2; ++p) {
+        producers.emplace_back(produceReadings, std::ref(pipeline), p, 4, 3500, 2000);
+    }
+    for (auto& producer : producers) producer.join();
+    pipeline.finish();
+}
+
+// Records pushed as fast as two threads can, through a filter and 100 ms
+// tumbling windows over arrival time
+void throughput() {
+    std::cout << "\n=== Throughput ===" << std::endl;
+
+    const size_t perProducer = 500000;
+    const int producerCount = 2;
+    std::atomic<size_t> rows{0};
+
+    StreamPipeline pipeline;
+    pipeline.filter([](const RecordBatch& batch, size_t row) {
+                const Column* temp = batch.findColumn("temp");
+                double value;
+                return temp && temp->numberAt(row, value) && value > -40;
+            })
+            .window(WindowSpec::tumbling(100), {"sensor"}, {{"temp", "avg"}})
+            .sink([&](const StreamBatch& batch) { rows += batch.records.numRows(); });
+    pipeline.start();
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> producers;
+    for (int p = 0; p < producerCount; ++p) {
+        producers.emplace_back([&pipeline, p] {
+            for (size_t i = 0; i < perProducer; ++i) {
+                pipeline.push({{"sensor", "sensor-" + std::to_string(i % 16)},
+                               {"temp", 20.0 + static_cast<double>(i % 100) / 10}});
+            }
+        });
+    }
+    for (auto& producer : producers) producer.join();
+    pipeline.finish();
+    double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+    StreamPipelineStats stats = pipeline.stats();
+    std::cout << stats.records_in << " records in " << std::fixed << std::setprecision(2) << seconds << " s ("
+              << stats.records_in / seconds / 1e6 << " M records/s), " << stats.batches << " batches, "
+              << stats.windows_emitted << " windows, " << rows << " rows out, " << stats.late_records << " late"
+              << std::endl;
+}
+
+int main() {
+    tumblingWindows();
+    slidingWindows();
+    throughput();
+    return 0;
+}